@@ -10,6 +10,25 @@ static const char *TAG = "SPEAKER";
 
 #define PLAY_BUFFER_SIZE 4096
 
+// 逐块跳过 RIFF 头，停在 data 块数据起点；返回 data 块长度，失败返回 0
+// （LIST / fact 等块在 data 前面时，不能按固定 44 字节跳）
+static uint32_t seek_to_data(FILE *fp)
+{
+    uint8_t hdr[12];
+    if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) ||
+        memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        return 0;
+    }
+
+    uint8_t ck[8];
+    while (fread(ck, 1, sizeof(ck), fp) == sizeof(ck)) {
+        uint32_t len = ck[4] | ck[5] << 8 | ck[6] << 16 | (uint32_t)ck[7] << 24;
+        if (memcmp(ck, "data", 4) == 0) return len ? len : UINT32_MAX;
+        if (fseek(fp, len + (len & 1), SEEK_CUR) != 0) break;
+    }
+    return 0;
+}
+
 void wav_player_play(const char *path)
 {
     FILE *fp = fopen(path, "rb");
@@ -19,7 +38,12 @@ void wav_player_play(const char *path)
     }
 
     // 跳过 WAV 头
-    fseek(fp, 44, SEEK_SET);
+    uint32_t remaining = seek_to_data(fp);
+    if (remaining == 0) {
+        ESP_LOGE(TAG, "❌ 不是有效的 WAV 文件: %s", path);
+        fclose(fp);
+        return;
+    }
 
     uint8_t *buf = malloc(PLAY_BUFFER_SIZE);
     if (!buf) {
@@ -31,7 +55,9 @@ void wav_player_play(const char *path)
     size_t bytes_read, bytes_written;
     ESP_LOGI(TAG, "🔊 开始播放: %s", path);
 
-    while ((bytes_read = fread(buf, 1, PLAY_BUFFER_SIZE, fp)) > 0) {
+    while (remaining > 0 &&
+           (bytes_read = fread(buf, 1, remaining < PLAY_BUFFER_SIZE ? remaining : PLAY_BUFFER_SIZE, fp)) > 0) {
+        remaining -= bytes_read;
         if (i2s_channel_write(tx_chan, buf, bytes_read, &bytes_written, portMAX_DELAY) != ESP_OK) {
             ESP_LOGE(TAG, "I2S 写入失败");
             break;
@@ -10,6 +10,7 @@
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lvgl_port.h"
+#include "esp_timer.h"
 #include "ui.h"  // 引入 UI 头文件
 #include "ctp_cst816d.h"
 
@@ -37,6 +38,22 @@ static esp_lcd_panel_io_handle_t lcd_io = NULL;
 static esp_lcd_panel_handle_t lcd_panel = NULL;
 static lv_display_t *lvgl_disp = NULL;
 
+/* UI 帧时间统计：刷新耗时 + LVGL 线程卡顿（看门定时器两次回调的最大间隔） */
+#define FRAME_STATS_REPORT_MS   10000   // 打印周期，0 为关闭
+#define FRAME_STATS_PROBE_MS    10      // 看门定时器周期
+
+typedef struct {
+    int64_t refr_start_us;
+    int64_t refr_sum_us;
+    int64_t refr_max_us;
+    uint32_t refr_count;
+    int64_t probe_last_us;
+    int64_t probe_max_gap_us;
+    int64_t report_us;
+} frame_stats_t;
+
+static frame_stats_t frame_stats;
+
 /* 初始化 LCD */
 esp_err_t app_lcd_init(void)
 {
@@ -105,6 +122,47 @@ err:
 
 
 
+/* 刷新开始 / 结束（LVGL 线程） */
+static void frame_refr_cb(lv_event_t *e)
+{
+    frame_stats_t *fs = &frame_stats;
+    int64_t now = esp_timer_get_time();
+
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+        fs->refr_start_us = now;
+        return;
+    }
+    if (fs->refr_start_us == 0) return;
+    int64_t dt = now - fs->refr_start_us;
+    fs->refr_sum_us += dt;
+    if (dt > fs->refr_max_us) fs->refr_max_us = dt;
+    fs->refr_count++;
+}
+
+/* 看门定时器：LVGL 线程被阻塞时两次回调的间隔会变长 */
+static void frame_probe_cb(lv_timer_t *t)
+{
+    frame_stats_t *fs = &frame_stats;
+    int64_t now = esp_timer_get_time();
+
+    if (fs->probe_last_us) {
+        int64_t gap = now - fs->probe_last_us;
+        if (gap > fs->probe_max_gap_us) fs->probe_max_gap_us = gap;
+    }
+    fs->probe_last_us = now;
+
+    if (now - fs->report_us < FRAME_STATS_REPORT_MS * 1000LL) return;
+    ESP_LOGI(TAG, "UI: %lu refreshes, avg %lld us, max %lld us; max loop stall %lld us",
+             (unsigned long)fs->refr_count,
+             (long long)(fs->refr_count ? fs->refr_sum_us / fs->refr_count : 0),
+             (long long)fs->refr_max_us, (long long)fs->probe_max_gap_us);
+    fs->refr_sum_us = 0;
+    fs->refr_max_us = 0;
+    fs->refr_count = 0;
+    fs->probe_max_gap_us = 0;
+    fs->report_us = now;
+}
+
 /* 初始化 LVGL */
  esp_err_t app_lvgl_init(void)
 {
@@ -140,6 +198,14 @@ err:
 
     ctp_register_lvgl(lvgl_disp); 
 
+    if (FRAME_STATS_REPORT_MS > 0 && lvgl_port_lock(0)) {
+        frame_stats.report_us = esp_timer_get_time();
+        lv_display_add_event_cb(lvgl_disp, frame_refr_cb, LV_EVENT_REFR_START, NULL);
+        lv_display_add_event_cb(lvgl_disp, frame_refr_cb, LV_EVENT_REFR_READY, NULL);
+        lv_timer_create(frame_probe_cb, FRAME_STATS_PROBE_MS, NULL);
+        lvgl_port_unlock();
+    }
+
 
     return ESP_OK;
 }
@@ -18,6 +18,7 @@
 #include "esp_log.h"
 #include "recorder.h"
 #include "ctp_cst816d.h"
+#include "vu_meter.h"
 
 // 测试代码开始
 
@@ -49,12 +50,22 @@ void app_main(void)
 
   ui_init();
 
+  // 电平表挂在录音页上；eez_flow_init 会一次性创建所有页面，这里 recording_page 已存在
+  lv_obj_t *vu = vu_meter_create(objects.recording_page);
+  if (vu) {
+    lv_obj_set_pos(vu, 40, 30);
+    lv_obj_set_size(vu, 240, 16);
+  }
+
+  // 播放器常驻：刷卡提示音和卡片播放不依赖先在界面里点过文件
+  if (!wav_player_init()) {
+    ESP_LOGE(TAG, "播放器初始化失败");
+  }
 
   // sd_init();
   // // sd_wr_test() ;
   // // ui_tick() ;
 
-  // wav_player_init();
   // // wav_player_play("/sdcard/canon.wav") ;
 
   // rc522_reader_init();
@@ -0,0 +1,120 @@
+#include "capture_dsp.h"
+#include <string.h>
+
+#if defined(__XTENSA__)
+#include "xtensa/config/core-isa.h"
+#endif
+
+#if defined(__XTENSA__) && XCHAL_HAVE_CLAMPS
+static inline int32_t sat_s16(int32_t x)
+{
+    int32_t r;
+    __asm__ ("clamps %0, %1, 15" : "=a"(r) : "a"(x));
+    return r;
+}
+#else
+static inline int32_t sat_s16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return x;
+}
+#endif
+
+#define DC_POLE_Q30       1072668082          // 0.999 * 2^30
+#define ENV_RELEASE_SHIFT 9                   // 包络释放：约 512 个子块（≈ 340 ms）
+#define GAIN_DOWN_SHIFT   3                   // AGC 增益下降：约 8 个子块
+#define GAIN_UP_SHIFT     11                  // AGC 增益上升：约 2048 个子块（≈ 1.4 s）
+
+void capture_dsp_init(capture_dsp_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->gain_agc = CAPTURE_DSP_GAIN_FIXED;
+    d->gain = CAPTURE_DSP_GAIN_FIXED;
+}
+
+//--------------------------------------------------------
+// 子块边界：更新 AGC，并计算接下来一个子块的增益斜坡
+//
+// 即将输出的子块峰值为 peak_prev，刚收进来的子块峰值为 peak_acc。
+// 目标增益同时满足两者的限幅要求：上一轮斜坡结束时增益已满足
+// peak_prev，本轮斜坡在两端之间线性变化，整个子块都不会超过限幅。
+//--------------------------------------------------------
+static void update_gain(capture_dsp_t *d)
+{
+    int32_t pk = d->peak_acc;
+
+    // 峰值包络：立即上升，缓慢释放
+    if (pk > d->env) {
+        d->env = pk;
+    } else {
+        d->env -= (d->env - pk) >> ENV_RELEASE_SHIFT;
+    }
+
+    if (d->env > 0) {
+        int64_t want = ((int64_t)CAPTURE_DSP_TARGET << 24) / d->env;
+        if (want > CAPTURE_DSP_GAIN_MAX) want = CAPTURE_DSP_GAIN_MAX;
+        if (want < CAPTURE_DSP_GAIN_MIN) want = CAPTURE_DSP_GAIN_MIN;
+
+        if (want < d->gain_agc) {
+            d->gain_agc -= (d->gain_agc - (int32_t)want) >> GAIN_DOWN_SHIFT;
+        } else if (d->env > CAPTURE_DSP_NOISE_FLOOR) {
+            d->gain_agc += ((int32_t)want - d->gain_agc) >> GAIN_UP_SHIFT;
+        }
+    }
+
+    int32_t target = d->gain_agc;
+    int32_t peak = pk > d->peak_prev ? pk : d->peak_prev;
+    if ((int64_t)peak * target > ((int64_t)CAPTURE_DSP_LIMIT << 24)) {
+        target = (int32_t)(((int64_t)CAPTURE_DSP_LIMIT << 24) / peak);
+    }
+
+    // 步进向下取整：斜坡终点不高于目标，下降时不会因为取整超出限幅
+    int32_t delta = target - d->gain;
+    d->step = delta >= 0 ? delta / CAPTURE_DSP_SUBBLOCK
+                         : -((-delta + CAPTURE_DSP_SUBBLOCK - 1) / CAPTURE_DSP_SUBBLOCK);
+    d->peak_prev = pk;
+    d->peak_acc = 0;
+}
+
+void capture_dsp_process(capture_dsp_t *d, const int32_t *in, int16_t *out, size_t n)
+{
+    int32_t x1 = d->x1, y1 = d->y1;
+    int32_t gain = d->gain, step = d->step;
+    int32_t peak = d->peak_acc;
+    uint32_t pos = d->pos;
+
+    for (size_t i = 0; i < n; i++) {
+        // 去直流
+        int32_t x = in[i] >> 8;
+        int32_t y = x - x1 + (int32_t)(((int64_t)y1 * DC_POLE_Q30 + (1 << 29)) >> 30);
+        x1 = x;
+        y1 = y;
+
+        int32_t a = y < 0 ? -y : y;
+        if (a > peak) peak = a;
+
+        // 前视延迟线：取出 CAPTURE_DSP_DELAY 个样点之前的值施加增益
+        int32_t s = d->delay[pos];
+        d->delay[pos] = y;
+        out[i] = (int16_t)sat_s16((int32_t)(((int64_t)s * gain) >> 24));
+        gain += step;
+
+        pos = (pos + 1) & (CAPTURE_DSP_DELAY - 1);
+        if ((pos & (CAPTURE_DSP_SUBBLOCK - 1)) == 0) {
+            d->gain = gain;
+            d->peak_acc = peak;
+            update_gain(d);
+            gain = d->gain;
+            step = d->step;
+            peak = 0;
+        }
+    }
+
+    d->x1 = x1;
+    d->y1 = y1;
+    d->gain = gain;
+    d->step = step;
+    d->peak_acc = peak;
+    d->pos = pos;
+}
@@ -0,0 +1,55 @@
+#ifndef CAPTURE_DSP_H
+#define CAPTURE_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 采集路径定点 DSP：去直流 + 前视 AGC / 限幅，输出 16 bit
+//
+// - 输入为 I2S 原始 32 bit 槽（24 bit 数据左对齐）
+// - 去直流：一阶高通 y = x - x1 + a·y1，a = 0.999（约 7.6 Hz @ 48 kHz）
+// - AGC：按子块峰值包络把输出峰值拉向 CAPTURE_DSP_TARGET，
+//   增益下降快、上升慢，包络低于噪声门限时不再提升
+// - 限幅：延迟两个子块输出，增益在峰值到达前线性降到位，不削波
+// - 全整数运算，延迟 2 × CAPTURE_DSP_SUBBLOCK 个样点
+//--------------------------------------------------------
+
+#define CAPTURE_DSP_SUBBLOCK   32              // 增益更新周期（样点）
+#define CAPTURE_DSP_DELAY      (2 * CAPTURE_DSP_SUBBLOCK)
+#define CAPTURE_DSP_TARGET     16384           // AGC 目标峰值（-6 dBFS）
+#define CAPTURE_DSP_LIMIT      32000           // 限幅阈值（约 -0.2 dBFS）
+
+// 增益为 Q24：out = x24 * gain >> 24，(1 << 16) 表示 24 bit 满幅对应 16 bit 满幅
+#define CAPTURE_DSP_GAIN_FIXED (1 << 21)       // 与原来的 raw >> 11 等价
+#define CAPTURE_DSP_GAIN_MIN   (1 << 15)
+#define CAPTURE_DSP_GAIN_MAX   (1 << 23)
+#define CAPTURE_DSP_NOISE_FLOOR 2048           // 24 bit 域包络低于此值视为静音
+
+typedef struct {
+    int32_t x1, y1;                            // 去直流状态
+    int32_t delay[CAPTURE_DSP_DELAY];          // 前视延迟线
+    uint16_t pos;
+    int32_t peak_acc;                          // 当前子块峰值
+    int32_t peak_prev;                         // 上一子块峰值
+    int32_t env;                               // AGC 峰值包络
+    int32_t gain_agc;                          // AGC 增益（Q24）
+    int32_t gain;                              // 当前施加的增益（Q24）
+    int32_t step;                              // 每样点增益步进
+} capture_dsp_t;
+
+// 初始化（增益从 CAPTURE_DSP_GAIN_FIXED 开始）
+void capture_dsp_init(capture_dsp_t *d);
+
+// 处理 n 个 32 bit 样点，输出 n 个 16 bit 样点；out 可以与 in 相同（原地处理）
+void capture_dsp_process(capture_dsp_t *d, const int32_t *in, int16_t *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURE_DSP_H */
@@ -0,0 +1,44 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 定点 FIR 抽取器（48 kHz → 16 / 8 kHz）
+//
+// 只在输出时刻计算卷积，等价于多相分解：每个输出只做一次 taps 点乘加。
+// 系数为 Q15，直流增益 1.0；通带 0 ~ 0.4 × 输出采样率纹波 < 0.02 dB，
+// 0.6 × 输出采样率以上衰减约 57 dB（tools/host_sim/bench_decimator 校验）。
+//--------------------------------------------------------
+
+#define DECIMATOR_MAX_TAPS  108
+
+typedef struct {
+    const int16_t *coeffs;
+    uint16_t taps;
+    uint8_t factor;                       // 抽取倍数
+    uint8_t phase;                        // 距下一个输出还差几个输入
+    uint16_t pos;                         // 历史缓冲区写位置
+    int16_t hist[2 * DECIMATOR_MAX_TAPS]; // 双份历史，保证窗口连续
+} decimator_t;
+
+// 初始化；factor 只支持 1（直通）、3、6，其它值返回 -1
+int decimator_init(decimator_t *d, int factor);
+
+// 清空历史
+void decimator_reset(decimator_t *d);
+
+// 处理 n 个输入样点，返回输出样点数（≤ n / factor + 1）
+// out 可以与 in 相同（原地处理）
+size_t decimator_process(decimator_t *d, const int16_t *in, size_t n, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECIMATOR_H */
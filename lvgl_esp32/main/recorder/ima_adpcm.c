@@ -0,0 +1,119 @@
+#include "ima_adpcm.h"
+
+static const int16_t s_step_table[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t s_index_table[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+//--------------------------------------------------------
+// 用 4 bit 码更新状态（编码器和解码器共用，保证重建一致）
+//--------------------------------------------------------
+static inline int16_t ima_step(ima_adpcm_state_t *st, uint8_t code)
+{
+    int32_t step = s_step_table[st->index];
+    int32_t diff = step >> 3;
+
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+
+    int32_t pred = st->predictor;
+    pred += (code & 8) ? -diff : diff;
+    if (pred > INT16_MAX) pred = INT16_MAX;
+    if (pred < INT16_MIN) pred = INT16_MIN;
+    st->predictor = (int16_t)pred;
+
+    int idx = st->index + s_index_table[code & 7];
+    if (idx < 0) idx = 0;
+    if (idx > 88) idx = 88;
+    st->index = (uint8_t)idx;
+
+    return st->predictor;
+}
+
+static inline uint8_t ima_encode_sample(ima_adpcm_state_t *st, int16_t sample)
+{
+    int32_t step = s_step_table[st->index];
+    int32_t diff = sample - st->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; }
+
+    ima_step(st, code);
+    return code;
+}
+
+uint32_t ima_adpcm_samples_per_block(uint32_t block_align, uint32_t channels)
+{
+    if (channels == 0 || block_align < 4 * channels) return 0;
+    return (block_align - 4 * channels) * 2 / channels + 1;
+}
+
+void ima_adpcm_encode_block(ima_adpcm_state_t *st, const int16_t *pcm,
+                            uint8_t *out, uint32_t block_align)
+{
+    // 块头：第一个样点原样保存，作为本块的初始预测值
+    st->predictor = pcm[0];
+    out[0] = (uint8_t)(pcm[0] & 0xFF);
+    out[1] = (uint8_t)((uint16_t)pcm[0] >> 8);
+    out[2] = st->index;
+    out[3] = 0;
+
+    const int16_t *p = pcm + 1;
+    for (uint32_t i = 4; i < block_align; i++) {
+        uint8_t lo = ima_encode_sample(st, *p++);
+        uint8_t hi = ima_encode_sample(st, *p++);
+        out[i] = (uint8_t)(lo | (hi << 4));
+    }
+}
+
+uint32_t ima_adpcm_decode_block(const uint8_t *in, uint32_t len,
+                                uint32_t channels, int16_t *out)
+{
+    ima_adpcm_state_t st[2];
+
+    if (channels == 0 || channels > 2 || len < 4 * channels) return 0;
+
+    for (uint32_t ch = 0; ch < channels; ch++) {
+        const uint8_t *h = in + 4 * ch;
+        st[ch].predictor = (int16_t)(h[0] | (h[1] << 8));
+        st[ch].index = h[2] > 88 ? 88 : h[2];
+        out[ch] = st[ch].predictor;
+    }
+
+    const uint8_t *p = in + 4 * channels;
+    uint32_t groups = (len - 4 * channels) / (4 * channels);  // 每组每声道 8 个样点
+    uint32_t frame = 1;
+
+    for (uint32_t g = 0; g < groups; g++) {
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            int16_t *o = out + frame * channels + ch;
+            for (int b = 0; b < 4; b++) {
+                uint8_t byte = *p++;
+                o[0]        = ima_step(&st[ch], byte & 0x0F);
+                o[channels] = ima_step(&st[ch], byte >> 4);
+                o += 2 * channels;
+            }
+        }
+        frame += 8;
+    }
+
+    return frame;
+}
@@ -0,0 +1,41 @@
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// IMA-ADPCM（WAV 格式标签 0x11）编解码
+//
+// 块结构（每声道）：4 字节头（int16 预测值 + uint8 步长索引 + 保留）
+// 之后是 4 bit 样点；多声道时每 4 字节（8 个样点）交错一次。
+//--------------------------------------------------------
+
+#define WAVE_FORMAT_IMA_ADPCM   0x0011
+
+typedef struct {
+    int16_t predictor;   // 上一个重建样点
+    uint8_t index;       // 步长表索引 0..88
+} ima_adpcm_state_t;
+
+// 给定块大小和声道数，每块包含的样点数（每声道）
+uint32_t ima_adpcm_samples_per_block(uint32_t block_align, uint32_t channels);
+
+// 编码一个单声道块：pcm 必须包含 samples_per_block 个样点，out 写满 block_align 字节
+void ima_adpcm_encode_block(ima_adpcm_state_t *st, const int16_t *pcm,
+                            uint8_t *out, uint32_t block_align);
+
+// 解码一个块（len 可小于 block_align，用于文件末尾的短块）
+// 输出交错 PCM，返回每声道解码出的样点数
+uint32_t ima_adpcm_decode_block(const uint8_t *in, uint32_t len,
+                                uint32_t channels, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMA_ADPCM_H */
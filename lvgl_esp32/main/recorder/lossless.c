@@ -0,0 +1,242 @@
+#include "lossless.h"
+#include <string.h>
+
+#define SYNC0   0xF5
+#define SYNC1   0x4C
+#define MAX_ORDER 3
+#define MAX_RICE_K 15
+
+//--------------------------------------------------------
+// 固定预测器残差
+//--------------------------------------------------------
+static inline int32_t fixed_residual(const int16_t *x, uint32_t i, int order)
+{
+    switch (order) {
+    case 0:  return x[i];
+    case 1:  return x[i] - x[i - 1];
+    case 2:  return x[i] - 2 * x[i - 1] + x[i - 2];
+    default: return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+    }
+}
+
+static inline int32_t fixed_predict(const int16_t *x, uint32_t i, int order)
+{
+    switch (order) {
+    case 0:  return 0;
+    case 1:  return x[i - 1];
+    case 2:  return 2 * x[i - 1] - x[i - 2];
+    default: return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+    }
+}
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+//--------------------------------------------------------
+// 位写入 / 读取（MSB 先）
+//--------------------------------------------------------
+typedef struct {
+    uint8_t *buf;
+    uint32_t cap;       // 字节
+    uint32_t pos;       // 已写完整字节
+    uint32_t acc;
+    int bits;
+} bit_writer_t;
+
+static inline bool bw_put(bit_writer_t *bw, uint32_t val, int n)
+{
+    // n ≤ 16
+    bw->acc = (bw->acc << n) | (val & ((1u << n) - 1));
+    bw->bits += n;
+    while (bw->bits >= 8) {
+        if (bw->pos >= bw->cap) return false;
+        bw->bits -= 8;
+        bw->buf[bw->pos++] = (uint8_t)(bw->acc >> bw->bits);
+    }
+    return true;
+}
+
+static inline bool bw_flush(bit_writer_t *bw)
+{
+    if (bw->bits > 0) return bw_put(bw, 0, 8 - bw->bits);
+    return true;
+}
+
+typedef struct {
+    const uint8_t *buf;
+    uint32_t len;
+    uint32_t bitpos;
+} bit_reader_t;
+
+static inline int br_bit(bit_reader_t *br)
+{
+    if (br->bitpos >= br->len * 8) return -1;
+    int b = (br->buf[br->bitpos >> 3] >> (7 - (br->bitpos & 7))) & 1;
+    br->bitpos++;
+    return b;
+}
+
+static inline bool br_bits(bit_reader_t *br, int n, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < n; i++) {
+        int b = br_bit(br);
+        if (b < 0) return false;
+        v = (v << 1) | (uint32_t)b;
+    }
+    *out = v;
+    return true;
+}
+
+//--------------------------------------------------------
+// 选择阶数：残差绝对值和最小者；Rice 参数由平均值估计
+//--------------------------------------------------------
+static int choose_order(const int16_t *pcm, uint32_t n, uint64_t *best_sum)
+{
+    uint64_t sum[MAX_ORDER + 1] = {0};
+
+    for (uint32_t i = MAX_ORDER; i < n; i++) {
+        for (int o = 0; o <= MAX_ORDER; o++) {
+            int32_t r = fixed_residual(pcm, i, o);
+            sum[o] += (uint32_t)(r < 0 ? -r : r);
+        }
+    }
+
+    int best = 0;
+    for (int o = 1; o <= MAX_ORDER; o++) {
+        if (sum[o] < sum[best]) best = o;
+    }
+    *best_sum = sum[best];
+    return best;
+}
+
+static int choose_rice_k(uint64_t abs_sum, uint32_t count)
+{
+    if (count == 0) return 0;
+    // zigzag 后均值约为 2 * |r|
+    uint64_t mean = (2 * abs_sum) / count;
+    int k = 0;
+    while (k < MAX_RICE_K && (1ull << (k + 1)) <= mean) k++;
+    return k;
+}
+
+static uint32_t write_verbatim(const int16_t *pcm, uint32_t n, uint8_t *out)
+{
+    out[4] = LOSSLESS_ORDER_VERBATIM;
+    out[5] = 0;
+    out[6] = (uint8_t)((n * 2) & 0xFF);
+    out[7] = (uint8_t)((n * 2) >> 8);
+    uint8_t *p = out + LOSSLESS_HEADER_BYTES;
+    for (uint32_t i = 0; i < n; i++) {
+        *p++ = (uint8_t)(pcm[i] & 0xFF);
+        *p++ = (uint8_t)((uint16_t)pcm[i] >> 8);
+    }
+    return LOSSLESS_HEADER_BYTES + n * 2;
+}
+
+//--------------------------------------------------------
+// 编码
+//--------------------------------------------------------
+uint32_t lossless_encode_block(const int16_t *pcm, uint32_t n, uint8_t *out)
+{
+    if (n > LOSSLESS_BLOCK_SAMPLES) n = LOSSLESS_BLOCK_SAMPLES;
+
+    out[0] = SYNC0;
+    out[1] = SYNC1;
+    out[2] = (uint8_t)(n & 0xFF);
+    out[3] = (uint8_t)(n >> 8);
+
+    if (n <= MAX_ORDER) {
+        return write_verbatim(pcm, n, out);
+    }
+
+    uint64_t abs_sum;
+    int order = choose_order(pcm, n, &abs_sum);
+    int k = choose_rice_k(abs_sum, n - MAX_ORDER);
+
+    // 块体不超过未压缩大小，超出即放弃，保证耗时有上界
+    bit_writer_t bw = {
+        .buf = out + LOSSLESS_HEADER_BYTES,
+        .cap = n * 2,
+    };
+
+    for (int i = 0; i < order; i++) {
+        if (!bw_put(&bw, (uint16_t)pcm[i], 16)) return write_verbatim(pcm, n, out);
+    }
+
+    for (uint32_t i = order; i < n; i++) {
+        uint32_t u = zigzag(fixed_residual(pcm, i, order));
+        uint32_t q = u >> k;
+
+        // 一元码：q 个 0 + 1 个 1
+        if (q >= bw.cap * 8) return write_verbatim(pcm, n, out);
+        while (q >= 16) {
+            if (!bw_put(&bw, 0, 16)) return write_verbatim(pcm, n, out);
+            q -= 16;
+        }
+        if (!bw_put(&bw, 1, q + 1)) return write_verbatim(pcm, n, out);
+        if (k > 0 && !bw_put(&bw, u, k)) return write_verbatim(pcm, n, out);
+    }
+    if (!bw_flush(&bw)) return write_verbatim(pcm, n, out);
+
+    out[4] = (uint8_t)order;
+    out[5] = (uint8_t)k;
+    out[6] = (uint8_t)(bw.pos & 0xFF);
+    out[7] = (uint8_t)(bw.pos >> 8);
+    return LOSSLESS_HEADER_BYTES + bw.pos;
+}
+
+//--------------------------------------------------------
+// 解码
+//--------------------------------------------------------
+bool lossless_parse_header(const uint8_t *hdr, lossless_block_info_t *info)
+{
+    if (hdr[0] != SYNC0 || hdr[1] != SYNC1) return false;
+
+    info->num_samples = (uint16_t)(hdr[2] | (hdr[3] << 8));
+    info->order = hdr[4];
+    info->rice_k = hdr[5];
+    info->body_bytes = (uint16_t)(hdr[6] | (hdr[7] << 8));
+
+    if (info->num_samples == 0 || info->num_samples > LOSSLESS_BLOCK_SAMPLES) return false;
+    if (info->body_bytes > LOSSLESS_MAX_BODY_BYTES) return false;
+    if (info->order == LOSSLESS_ORDER_VERBATIM) {
+        return info->body_bytes == info->num_samples * 2;
+    }
+    return info->order <= MAX_ORDER && info->order < info->num_samples &&
+           info->rice_k <= MAX_RICE_K;
+}
+
+uint32_t lossless_decode_block(const lossless_block_info_t *info, const uint8_t *body, int16_t *out)
+{
+    uint32_t n = info->num_samples;
+
+    if (info->order == LOSSLESS_ORDER_VERBATIM) {
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = (int16_t)(body[2 * i] | (body[2 * i + 1] << 8));
+        }
+        return n;
+    }
+
+    bit_reader_t br = { .buf = body, .len = info->body_bytes };
+    uint32_t v;
+
+    for (uint32_t i = 0; i < info->order; i++) {
+        if (!br_bits(&br, 16, &v)) return 0;
+        out[i] = (int16_t)v;
+    }
+
+    for (uint32_t i = info->order; i < n; i++) {
+        uint32_t q = 0;
+        int b;
+        while ((b = br_bit(&br)) == 0) q++;
+        if (b < 0) return 0;
+        uint32_t lo = 0;
+        if (info->rice_k > 0 && !br_bits(&br, info->rice_k, &lo)) return 0;
+
+        int32_t s = fixed_predict(out, i, info->order) + unzigzag((q << info->rice_k) | lo);
+        if (s < INT16_MIN || s > INT16_MAX) return 0;
+        out[i] = (int16_t)s;
+    }
+    return n;
+}
@@ -0,0 +1,54 @@
+#ifndef LOSSLESS_H
+#define LOSSLESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 无损压缩（固定线性预测 + Rice 编码残差，类似 FLAC 的 fixed 子帧）
+//
+// 数据放在 WAV 的 data 块里，由一串自描述的块组成：
+//
+//   0..1  同步字 0xF5 0x4C
+//   2..3  本块样点数（≤ LOSSLESS_BLOCK_SAMPLES）
+//   4     预测阶数 0..3，LOSSLESS_ORDER_VERBATIM 表示未压缩
+//   5     Rice 参数 k
+//   6..7  块体字节数
+//   块体：order 个 int16 预热样点 + Rice 码流（MSB 先）
+//
+// 目前只支持单声道 16-bit。
+//--------------------------------------------------------
+
+#define WAVE_FORMAT_TINY_LOSSLESS   0x544C      // 私有格式标签
+#define LOSSLESS_BLOCK_SAMPLES      1024
+#define LOSSLESS_HEADER_BYTES       8
+#define LOSSLESS_ORDER_VERBATIM     0xFF
+#define LOSSLESS_MAX_BODY_BYTES     (LOSSLESS_BLOCK_SAMPLES * 2)
+#define LOSSLESS_MAX_BLOCK_BYTES    (LOSSLESS_HEADER_BYTES + LOSSLESS_MAX_BODY_BYTES)
+
+typedef struct {
+    uint16_t num_samples;
+    uint8_t order;
+    uint8_t rice_k;
+    uint16_t body_bytes;
+} lossless_block_info_t;
+
+// 编码一块（n ≤ LOSSLESS_BLOCK_SAMPLES），out 至少 LOSSLESS_MAX_BLOCK_BYTES
+// 返回写出的字节数。压缩后比原始数据大时自动退回未压缩块，耗时与输出都有上界。
+uint32_t lossless_encode_block(const int16_t *pcm, uint32_t n, uint8_t *out);
+
+// 解析块头；同步字或字段非法时返回 false
+bool lossless_parse_header(const uint8_t *hdr, lossless_block_info_t *info);
+
+// 解码块体，返回样点数；数据损坏时返回 0
+uint32_t lossless_decode_block(const lossless_block_info_t *info, const uint8_t *body, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOSSLESS_H */
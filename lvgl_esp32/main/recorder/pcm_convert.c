@@ -0,0 +1,57 @@
+#include "pcm_convert.h"
+
+#if defined(__XTENSA__)
+#include "xtensa/config/core-isa.h"
+#endif
+
+#if defined(__XTENSA__) && XCHAL_HAVE_CLAMPS
+// CLAMPS a, b, 15：把 b 饱和到 16 位有符号范围，单周期
+static inline int32_t sat_s16(int32_t x)
+{
+    int32_t r;
+    __asm__ ("clamps %0, %1, 15" : "=a"(r) : "a"(x));
+    return r;
+}
+#else
+static inline int32_t sat_s16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return x;
+}
+#endif
+
+//--------------------------------------------------------
+// 标量参考实现
+//--------------------------------------------------------
+void pcm_s32_to_s16_ref(const int32_t *restrict in, int16_t *restrict out, size_t n, int shift)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = in[i] >> shift;
+        if (s > INT16_MAX) s = INT16_MAX;
+        if (s < INT16_MIN) s = INT16_MIN;
+        out[i] = (int16_t)s;
+    }
+}
+
+//--------------------------------------------------------
+// 优化实现：4 路展开，先读后写
+//--------------------------------------------------------
+void pcm_s32_to_s16(const int32_t *restrict in, int16_t *restrict out, size_t n, int shift)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int32_t a = in[i + 0] >> shift;
+        int32_t b = in[i + 1] >> shift;
+        int32_t c = in[i + 2] >> shift;
+        int32_t d = in[i + 3] >> shift;
+        out[i + 0] = (int16_t)sat_s16(a);
+        out[i + 1] = (int16_t)sat_s16(b);
+        out[i + 2] = (int16_t)sat_s16(c);
+        out[i + 3] = (int16_t)sat_s16(d);
+    }
+    for (; i < n; i++) {
+        out[i] = (int16_t)sat_s16(in[i] >> shift);
+    }
+}
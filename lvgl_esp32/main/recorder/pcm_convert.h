@@ -0,0 +1,28 @@
+#ifndef PCM_CONVERT_H
+#define PCM_CONVERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 32bit → 16bit PCM 转换：右移 shift 位后饱和到 int16
+//
+// in 和 out 不能重叠：两者类型不同，按严格别名规则编译器可以
+// 把 int16 的写入排到 int32 的读取之前，原地转换结果没有保证。
+//--------------------------------------------------------
+
+// 可移植的标量参考实现
+void pcm_s32_to_s16_ref(const int32_t *in, int16_t *out, size_t n, int shift);
+
+// 优化实现（ESP32-S3 上使用 CLAMPS 指令，其它平台回退到参考实现）
+void pcm_s32_to_s16(const int32_t *in, int16_t *out, size_t n, int shift);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PCM_CONVERT_H */
@@ -0,0 +1,241 @@
+#include "peak_file.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put_u32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static inline uint16_t get_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static inline uint32_t get_u32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+void peak_file_path(const char *wav_path, char *out, size_t out_len)
+{
+    const char *dot = strrchr(wav_path, '.');
+    const char *slash = strrchr(wav_path, '/');
+    int base = (dot && (!slash || dot > slash)) ? (int)(dot - wav_path) : (int)strlen(wav_path);
+    snprintf(out, out_len, "%.*s.pk", base, wav_path);
+}
+
+bool peak_writer_open(peak_writer_t *w, const char *path, uint32_t sample_rate)
+{
+    memset(w, 0, sizeof(*w));
+    w->fp = fopen(path, "wb");
+    if (!w->fp) return false;
+
+    // 先写空文件头，关闭时回填
+    uint8_t hdr[PEAK_HEADER_BYTES] = {0};
+    fwrite(hdr, 1, sizeof(hdr), w->fp);
+    w->sample_rate = sample_rate;
+    w->cur_min = INT16_MAX;
+    w->cur_max = INT16_MIN;
+    return true;
+}
+
+//--------------------------------------------------------
+// 一项完成：写入第 0 层缓冲，并逐层向上合并
+//--------------------------------------------------------
+static void push_level(peak_writer_t *w, int lv, peak_entry_t e);
+
+static void merge_up(peak_writer_t *w, int lv, peak_entry_t e)
+{
+    if (lv >= PEAK_MAX_LEVELS) return;
+
+    peak_entry_t *a = &w->acc[lv];
+    if (w->acc_n[lv] == 0) {
+        *a = e;
+    } else {
+        if (e.min < a->min) a->min = e.min;
+        if (e.max > a->max) a->max = e.max;
+    }
+    if (++w->acc_n[lv] == PEAK_LEVEL_FACTOR) {
+        push_level(w, lv, *a);
+        w->acc_n[lv] = 0;
+    }
+}
+
+static void push_level(peak_writer_t *w, int lv, peak_entry_t e)
+{
+    if (w->level_n[lv] == w->level_cap[lv]) {
+        uint32_t cap = w->level_cap[lv] ? w->level_cap[lv] * 2 : 256;
+        peak_entry_t *p = realloc(w->level[lv], cap * sizeof(peak_entry_t));
+        if (!p) return;   // 内存不足：该层截断，第 0 层不受影响
+        w->level[lv] = p;
+        w->level_cap[lv] = cap;
+    }
+    w->level[lv][w->level_n[lv]++] = e;
+    merge_up(w, lv + 1, e);
+}
+
+static void flush_base(peak_writer_t *w)
+{
+    if (w->buf_n) {
+        fwrite(w->buf, sizeof(peak_entry_t), w->buf_n, w->fp);
+        w->buf_n = 0;
+    }
+}
+
+static void finish_entry(peak_writer_t *w)
+{
+    // 向外取整，保证小信号不会被量化成 0
+    int hi = (w->cur_max + 255) >> 8;
+    peak_entry_t e = {
+        .min = (int8_t)(w->cur_min >> 8),
+        .max = (int8_t)(hi > INT8_MAX ? INT8_MAX : hi),
+    };
+    w->buf[w->buf_n++] = e;
+    w->count0++;
+    if (w->buf_n == PEAK_WRITE_ENTRIES) {
+        flush_base(w);
+    }
+    merge_up(w, 1, e);
+
+    w->cur_min = INT16_MAX;
+    w->cur_max = INT16_MIN;
+    w->cur_n = 0;
+}
+
+void peak_writer_feed(peak_writer_t *w, const int16_t *pcm, size_t n)
+{
+    if (!w->fp) return;
+
+    int16_t mn = w->cur_min, mx = w->cur_max;
+    uint32_t cur = w->cur_n;
+    w->total_samples += n;
+
+    for (size_t i = 0; i < n; i++) {
+        int16_t s = pcm[i];
+        if (s < mn) mn = s;
+        if (s > mx) mx = s;
+        if (++cur == PEAK_BASE_SAMPLES) {
+            w->cur_min = mn;
+            w->cur_max = mx;
+            finish_entry(w);
+            mn = INT16_MAX;
+            mx = INT16_MIN;
+            cur = 0;
+        }
+    }
+    w->cur_min = mn;
+    w->cur_max = mx;
+    w->cur_n = cur;
+}
+
+bool peak_writer_close(peak_writer_t *w)
+{
+    if (!w->fp) return false;
+
+    // 不满的尾项照样输出，各层不满的合并项也输出
+    if (w->cur_n) {
+        finish_entry(w);
+    }
+    flush_base(w);
+    // 自下而上输出：本层尾项会继续合并进上一层的尾项
+    for (int lv = 1; lv < PEAK_MAX_LEVELS; lv++) {
+        if (w->acc_n[lv]) {
+            w->acc_n[lv] = 0;
+            push_level(w, lv, w->acc[lv]);
+        }
+    }
+
+    uint8_t hdr[PEAK_HEADER_BYTES] = {0};
+    memcpy(hdr, PEAK_MAGIC, 4);
+    put_u16(hdr + 4, PEAK_VERSION);
+    put_u16(hdr + 6, PEAK_MAX_LEVELS);
+    put_u32(hdr + 8, w->sample_rate);
+    put_u32(hdr + 12, PEAK_BASE_SAMPLES);
+    put_u32(hdr + 16, PEAK_LEVEL_FACTOR);
+    put_u32(hdr + 20, w->total_samples);
+
+    uint32_t off = PEAK_HEADER_BYTES;
+    put_u32(hdr + 24, off);
+    put_u32(hdr + 28, w->count0);
+    off += w->count0 * sizeof(peak_entry_t);
+    for (int lv = 1; lv < PEAK_MAX_LEVELS; lv++) {
+        fwrite(w->level[lv], sizeof(peak_entry_t), w->level_n[lv], w->fp);
+        put_u32(hdr + 24 + lv * 8, off);
+        put_u32(hdr + 28 + lv * 8, w->level_n[lv]);
+        off += w->level_n[lv] * sizeof(peak_entry_t);
+        free(w->level[lv]);
+        w->level[lv] = NULL;
+    }
+
+    fseek(w->fp, 0, SEEK_SET);
+    bool ok = fwrite(hdr, 1, sizeof(hdr), w->fp) == sizeof(hdr);
+    ok = (fclose(w->fp) == 0) && ok;
+    w->fp = NULL;
+    return ok;
+}
+
+bool peak_file_info(FILE *fp, peak_info_t *info)
+{
+    uint8_t hdr[PEAK_HEADER_BYTES];
+    if (fseek(fp, 0, SEEK_SET) != 0 || fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) return false;
+    if (memcmp(hdr, PEAK_MAGIC, 4) != 0 || get_u16(hdr + 4) != PEAK_VERSION) return false;
+
+    info->levels = get_u16(hdr + 6);
+    if (info->levels == 0 || info->levels > PEAK_MAX_LEVELS) return false;
+    info->sample_rate = get_u32(hdr + 8);
+    info->total_samples = get_u32(hdr + 20);
+    for (int lv = 0; lv < info->levels; lv++) {
+        info->offset[lv] = get_u32(hdr + 24 + lv * 8);
+        info->count[lv] = get_u32(hdr + 28 + lv * 8);
+    }
+    return true;
+}
+
+size_t peak_file_thumbnail(const char *path, size_t width, peak_entry_t *out)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+
+    peak_info_t info;
+    if (!peak_file_info(fp, &info) || width == 0) {
+        fclose(fp);
+        return 0;
+    }
+
+    // 最粗的、项数仍不少于 width 的层（都不够时用第 0 层）
+    int lv = 0;
+    for (int i = info.levels - 1; i >= 0; i--) {
+        if (info.count[i] >= width) {
+            lv = i;
+            break;
+        }
+    }
+    uint32_t n = info.count[lv];
+    if (n == 0) {
+        fclose(fp);
+        return 0;
+    }
+
+    // 每列合并约 n / width 项（该层比 width 多不到 PEAK_LEVEL_FACTOR 倍），顺序分块读取
+    size_t cols = n < width ? n : width;
+    peak_entry_t chunk[64];
+    uint32_t idx = 0, have = 0, pos = 0;
+    fseek(fp, info.offset[lv], SEEK_SET);
+
+    for (size_t c = 0; c < cols; c++) {
+        uint32_t end = (uint32_t)((uint64_t)(c + 1) * n / cols);
+        peak_entry_t e = { .min = INT8_MAX, .max = INT8_MIN };
+        while (idx < end) {
+            if (pos == have) {
+                uint32_t want = n - idx < 64 ? n - idx : 64;
+                have = fread(chunk, sizeof(peak_entry_t), want, fp);
+                pos = 0;
+                if (have == 0) break;
+            }
+            if (chunk[pos].min < e.min) e.min = chunk[pos].min;
+            if (chunk[pos].max > e.max) e.max = chunk[pos].max;
+            pos++;
+            idx++;
+        }
+        if (e.min > e.max) e.min = e.max = 0;
+        out[c] = e;
+        if (have == 0 && idx < end) {
+            cols = c + 1;
+            break;
+        }
+    }
+
+    fclose(fp);
+    return cols;
+}
@@ -0,0 +1,92 @@
+#ifndef PEAK_FILE_H
+#define PEAK_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 波形峰值金字塔旁路文件（xxx.pk，与 xxx.wav 同目录）
+//
+// 文件布局（小端）：
+//   0   "TRPK"
+//   4   u16 版本 / u16 层数
+//   8   u32 采样率 / u32 第 0 层每项样点数（256）/ u32 层间倍数（16）
+//   20  u32 总样点数
+//   24  每层 u32 偏移 + u32 项数（PEAK_MAX_LEVELS 层）
+//   64  第 0 层，其后依次是更粗的各层
+// 每项为 int8 min / int8 max（16 bit 样点的高 8 位）。
+// 录音时第 0 层边录边写，更粗的层在内存中累积，关闭时追加并回填文件头；
+// 文件头未回填（录音中断）的旁路文件视为无效。
+// 本模块只依赖 stdio，主机工具可直接复用。
+//--------------------------------------------------------
+
+#define PEAK_MAGIC          "TRPK"
+#define PEAK_VERSION        1
+#define PEAK_HEADER_BYTES   64
+#define PEAK_BASE_SAMPLES   256
+#define PEAK_LEVEL_FACTOR   16
+#define PEAK_MAX_LEVELS     4
+#define PEAK_WRITE_ENTRIES  256      // 第 0 层写缓冲（项）
+
+typedef struct {
+    int8_t min;
+    int8_t max;
+} peak_entry_t;
+
+typedef struct {
+    FILE *fp;
+    uint32_t sample_rate;
+    uint32_t total_samples;
+
+    int16_t cur_min, cur_max;                 // 第 0 层当前项
+    uint32_t cur_n;
+
+    peak_entry_t buf[PEAK_WRITE_ENTRIES];     // 第 0 层写缓冲
+    uint32_t buf_n;
+    uint32_t count0;                          // 第 0 层已完成项数
+
+    peak_entry_t acc[PEAK_MAX_LEVELS];        // 各层正在合并的项
+    uint32_t acc_n[PEAK_MAX_LEVELS];
+    peak_entry_t *level[PEAK_MAX_LEVELS];     // 第 1 层起的内存数据（level[0] 不用）
+    uint32_t level_n[PEAK_MAX_LEVELS];
+    uint32_t level_cap[PEAK_MAX_LEVELS];
+} peak_writer_t;
+
+// wav 路径 → 旁路文件路径（扩展名换成 .pk）
+void peak_file_path(const char *wav_path, char *out, size_t out_len);
+
+// 创建旁路文件；失败返回 false
+bool peak_writer_open(peak_writer_t *w, const char *path, uint32_t sample_rate);
+
+// 输入写入 WAV 的 16 bit 单声道样点
+void peak_writer_feed(peak_writer_t *w, const int16_t *pcm, size_t n);
+
+// 补齐各层、回填文件头并关闭
+bool peak_writer_close(peak_writer_t *w);
+
+// 读取文件头，返回 false 表示文件不存在或无效
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t total_samples;
+    uint16_t levels;
+    uint32_t offset[PEAK_MAX_LEVELS];
+    uint32_t count[PEAK_MAX_LEVELS];
+} peak_info_t;
+
+bool peak_file_info(FILE *fp, peak_info_t *info);
+
+// 生成 width 列的缩略波形（每列 min/max），选择项数不少于 width 的最粗层，
+// 读取量为 O(width)；返回实际列数（录音短于 width 项时更少）
+size_t peak_file_thumbnail(const char *path, size_t width, peak_entry_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEAK_FILE_H */
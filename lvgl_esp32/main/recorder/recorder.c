@@ -1,109 +1,1078 @@
 #include "recorder.h"
+#include "pcm_convert.h"
+#include "capture_dsp.h"
+#include "vad.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
+#include "wav_info.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "INMP441_REC";
 
 //--------------------------------------------------------
-// 写 WAV 文件头
+// 写 WAV 文件头，返回 data 块数据起始位置；fact 样点数字段位置（无则为 0）
+// 写入 fact_offset，停止时据此回填
 //--------------------------------------------------------
-static void write_wav_header(FILE *f, int sample_rate, int bits_per_sample, int num_channels) {
-    uint8_t header[44];
-    int byte_rate = sample_rate * num_channels * bits_per_sample / 8;
-    int block_align = num_channels * bits_per_sample / 8;
+static uint32_t write_wav_header(sd_direct_file_t *f, rec_format_t format, int sample_rate,
+                                 int num_channels, uint32_t *fact_offset)
+{
+    uint8_t header[60] __attribute__((aligned(4)));
+    uint32_t len;
     memset(header, 0, sizeof(header));
 
     memcpy(header, "RIFF", 4);
     *(uint32_t *)(header + 4) = 0;  // 先填 0，最后更新文件大小
     memcpy(header + 8, "WAVEfmt ", 8);
-    *(uint32_t *)(header + 16) = 16;
-    *(uint16_t *)(header + 20) = 1;  // PCM
     *(uint16_t *)(header + 22) = num_channels;
     *(uint32_t *)(header + 24) = sample_rate;
-    *(uint32_t *)(header + 28) = byte_rate;
-    *(uint16_t *)(header + 32) = block_align;
-    *(uint16_t *)(header + 34) = bits_per_sample;
-    memcpy(header + 36, "data", 4);
-    *(uint32_t *)(header + 40) = 0;  // data size (稍后更新)
 
-    fwrite(header, 1, sizeof(header), f);
+    if (format != REC_FORMAT_PCM16) {
+        uint32_t spb, block_align, bits, tag, byte_rate;
+        if (format == REC_FORMAT_IMA_ADPCM) {
+            tag = WAVE_FORMAT_IMA_ADPCM;
+            spb = ima_adpcm_samples_per_block(ADPCM_BLOCK_ALIGN, num_channels);
+            block_align = ADPCM_BLOCK_ALIGN;
+            bits = 4;
+            byte_rate = (uint32_t)((uint64_t)sample_rate * ADPCM_BLOCK_ALIGN / spb);
+        } else {
+            // 变长块：block_align / byte_rate 只是名义值，解码以块头为准
+            tag = WAVE_FORMAT_TINY_LOSSLESS;
+            spb = LOSSLESS_BLOCK_SAMPLES;
+            block_align = num_channels * 2;
+            bits = 16;
+            byte_rate = sample_rate * num_channels * 2;
+        }
+        *(uint32_t *)(header + 16) = 20;
+        *(uint16_t *)(header + 20) = tag;
+        *(uint32_t *)(header + 28) = byte_rate;
+        *(uint16_t *)(header + 32) = block_align;
+        *(uint16_t *)(header + 34) = bits;
+        *(uint16_t *)(header + 36) = 2;    // cbSize
+        *(uint16_t *)(header + 38) = spb;
+        memcpy(header + 40, "fact", 4);
+        *(uint32_t *)(header + 44) = 4;
+        *(uint32_t *)(header + 48) = 0;    // 样点数（稍后更新）
+        memcpy(header + 52, "data", 4);
+        *(uint32_t *)(header + 56) = 0;    // data size (稍后更新)
+        *fact_offset = 48;
+        len = 60;
+    } else {
+        *(uint32_t *)(header + 16) = 16;
+        *(uint16_t *)(header + 20) = 1;    // PCM
+        *(uint32_t *)(header + 28) = sample_rate * num_channels * 2;
+        *(uint16_t *)(header + 32) = num_channels * 2;
+        *(uint16_t *)(header + 34) = 16;
+        memcpy(header + 36, "data", 4);
+        *(uint32_t *)(header + 40) = 0;    // data size (稍后更新)
+        *fact_offset = 0;
+        len = 44;
+    }
+
+    sd_direct_write(f, header, len);
+    return len;
 }
 
 //--------------------------------------------------------
-// 录音任务（后台执行）
+// 预录：采集任务此时兼任消费者，丢弃最旧的数据，
+// 环形缓冲区中只保留最近 preroll_bytes 字节
 //--------------------------------------------------------
-static void inmp441_record_task(void *param)
+static void preroll_push(inmp441_recorder_t *rec, const void *data, uint32_t len)
+{
+    uint32_t used = ring_buffer_used(&rec->ring);
+    if (used + len > rec->preroll_bytes) {
+        uint32_t drop = used + len - rec->preroll_bytes;
+        ring_buffer_consume(&rec->ring, drop < used ? drop : used);
+    }
+    ring_buffer_write(&rec->ring, data, len);
+}
+
+//--------------------------------------------------------
+// 电平表：每块计算峰值和 RMS，打包成一个 32 位字原子发布，
+// UI 任意时刻读取都是同一块的一对值，无需加锁或拷贝
+//--------------------------------------------------------
+static uint32_t isqrt32(uint32_t x)
+{
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+static void publish_level(inmp441_recorder_t *rec, const int16_t *pcm, size_t n)
+{
+    uint32_t peak = 0, acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = pcm[i];
+        uint32_t a = s < 0 ? -s : s;
+        if (a > peak) peak = a;
+        acc += (uint32_t)(s * s) >> 8;
+    }
+    uint32_t rms = n ? isqrt32(acc / n << 8) : 0;
+    if (peak > INT16_MAX) peak = INT16_MAX;
+    __atomic_store_n(&rec->level, REC_LEVEL_PACK(peak, rms), __ATOMIC_RELAXED);
+}
+
+//--------------------------------------------------------
+// 录音中：采集数据写入环形缓冲区（写卡任务跟不上时丢弃本块）
+//--------------------------------------------------------
+static void capture_push(inmp441_recorder_t *rec, const void *data, uint32_t len)
+{
+    if (!ring_buffer_write(&rec->ring, data, len)) {
+        // 写卡任务跟不上：丢弃本块，但不阻塞 I2S DMA
+        rec->stats.overruns++;
+        rec->stats.dropped_bytes += len;
+        return;
+    }
+    uint32_t used = ring_buffer_used(&rec->ring);
+    if (used > rec->stats.high_water) {
+        rec->stats.high_water = used;
+    }
+    if (used >= SD_WRITE_CHUNK) {
+        xEventGroupSetBits(rec->events, REC_EVT_DATA);
+    }
+}
+
+//--------------------------------------------------------
+// 静音自动停止：抢占会话状态，采集任务随后结束本段，写卡任务负责收尾
+//--------------------------------------------------------
+static void request_auto_stop(inmp441_recorder_t *rec)
+{
+    rec_state_t expected = REC_STATE_RECORDING;
+    if (__atomic_compare_exchange_n(&rec->state, &expected, REC_STATE_STOPPING,
+                                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        ESP_LOGI(TAG, "Silence for %lu s, stopping", (unsigned long)rec->vad_auto_stop_s);
+        rec->auto_stopped = true;
+        rec->is_recording = false;
+    }
+}
+
+//--------------------------------------------------------
+// 语音门控：静音帧先存进起音缓冲区（只保留最近 VAD_ONSET_MS），
+// 检测到语音时连同起音缓冲一起写入，词首不被切掉
+//--------------------------------------------------------
+static void capture_gate(inmp441_recorder_t *rec, const int16_t *pcm, uint32_t len)
+{
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    bool active = vad_process(&rec->vad, pcm, len / sizeof(int16_t));
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    rec->stats.vad_cycles_total += cycles;
+    if (cycles > rec->stats.vad_cycles_max) {
+        rec->stats.vad_cycles_max = cycles;
+    }
+
+    if (active) {
+        // 最旧的帧先写
+        while (rec->onset_count > 0) {
+            uint32_t slot = (rec->onset_head + VAD_ONSET_FRAMES - rec->onset_count) % VAD_ONSET_FRAMES;
+            capture_push(rec, rec->onset_buf + slot * VAD_FRAME_SAMPLES, rec->onset_len[slot]);
+            rec->stats.vad_skipped_bytes -= rec->onset_len[slot];
+            rec->onset_count--;
+        }
+        rec->silent_samples = 0;
+        capture_push(rec, pcm, len);
+        return;
+    }
+
+    // 静音：存入起音缓冲区，满时覆盖最旧的帧（被覆盖的帧不再写卡）
+    uint32_t slot = rec->onset_head;
+    memcpy(rec->onset_buf + slot * VAD_FRAME_SAMPLES, pcm, len);
+    rec->onset_len[slot] = len;
+    rec->onset_head = (slot + 1) % VAD_ONSET_FRAMES;
+    if (rec->onset_count < VAD_ONSET_FRAMES) {
+        rec->onset_count++;
+    }
+    rec->stats.vad_skipped_bytes += len;
+
+    rec->silent_samples += len / sizeof(int16_t);
+    if (rec->vad_auto_stop_s && rec->silent_samples >= rec->vad_auto_stop_s * SAMPLE_RATE_HZ) {
+        request_auto_stop(rec);
+    }
+}
+
+//--------------------------------------------------------
+// 采集任务：只负责 I2S 读取和格式转换，写入环形缓冲区
+// 开启预录时常驻运行，未录音期间把音频保存在环形缓冲区中
+//--------------------------------------------------------
+static void inmp441_capture_task(void *param)
 {
     inmp441_recorder_t *rec = (inmp441_recorder_t *)param;
     uint8_t *buf = malloc(BUFFER_SIZE);
     int16_t *out_buf = malloc(BUFFER_SIZE / 2);
     size_t bytes_read = 0;
-    size_t samples_out = 0;
+    bool live = false;   // 是否正在为写卡任务生产数据
+    bool gate = false;   // 本段录音是否启用语音门控
 
     if (!buf || !out_buf) {
         ESP_LOGE(TAG, "Buffer malloc failed");
+        free(buf);
+        free(out_buf);
+        rec->capture_running = false;
+        xEventGroupSetBits(rec->events, REC_EVT_CAPTURE_LIVE | REC_EVT_CAPTURE_DONE | REC_EVT_CAPTURE_EXIT);
         vTaskDelete(NULL);
         return;
     }
 
-    ESP_LOGI(TAG, "Recording task started...");
+    ESP_LOGI(TAG, "Capture task started on core %d", xPortGetCoreID());
+
+    while (true) {
+        bool recording = rec->is_recording;
+
+        if (live && !recording) {
+            // 录音结束：通知写卡任务收尾
+            live = false;
+            xEventGroupSetBits(rec->events, REC_EVT_CAPTURE_DONE);
+        }
+        if (!recording && rec->preroll_bytes == 0) {
+            break;
+        }
 
-    while (rec->is_recording) {
         esp_err_t ret = i2s_channel_read(rec->rx_chan, buf, BUFFER_SIZE, &bytes_read, 1000);
-        if (ret == ESP_OK && bytes_read > 0) {
-            int32_t *p = (int32_t *)buf;
-            size_t frames = bytes_read / 4;
-            samples_out = 0;
-
-            // 转换 32bit → 16bit
-            for (size_t i = 0; i < frames; i++) {
-                int32_t raw = p[i];
-                int16_t pcm = (int16_t)(raw >> 11);  // 右移 11 位缩放
-                out_buf[samples_out++] = pcm;
+        if (ret != ESP_OK || bytes_read == 0) {
+            ESP_LOGW(TAG, "I2S read timeout");
+            continue;
+        }
+
+        // 读完再决定这一块的去向。先取事件位再取录音标志：启动录音时先置 is_recording
+        // 再清 WRITER_DONE，所以看到 WRITER_DONE 已清就一定也看到 recording，
+        // 读取期间开始的录音不会让这一块既不进预录也不进实时数据
+        EventBits_t bits = xEventGroupGetBits(rec->events);
+        recording = rec->is_recording;
+        if (recording && !live) {
+            // 从这一块开始不再丢弃旧数据，预录内容交给写卡任务
+            live = true;
+            gate = rec->vad_enabled && rec->onset_buf;
+            if (gate) {
+                vad_init(&rec->vad, VAD_HANGOVER_FRAMES);
+                rec->onset_head = 0;
+                rec->onset_count = 0;
+                rec->silent_samples = 0;
             }
+            xEventGroupSetBits(rec->events, REC_EVT_CAPTURE_LIVE);
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        size_t frames = bytes_read / 4;
 
-            fwrite(out_buf, sizeof(int16_t), samples_out, rec->file);
+        if (rec->dsp_enabled) {
+            // 去直流 + AGC / 限幅，直接输出 16 bit
+            uint32_t c0 = esp_cpu_get_cycle_count();
+            capture_dsp_process(&rec->dsp, (const int32_t *)buf, out_buf, frames);
+            uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+            rec->stats.dsp_cycles_total += cycles;
+            if (cycles > rec->stats.dsp_cycles_max) {
+                rec->stats.dsp_cycles_max = cycles;
+            }
+            if (cycles > DSP_CYCLE_BUDGET) {
+                rec->stats.dsp_over_budget++;
+            }
         } else {
-            ESP_LOGW(TAG, "I2S read timeout");
+            // 转换 32bit → 16bit（右移 11 位缩放，饱和）
+            pcm_s32_to_s16((const int32_t *)buf, out_buf, frames, PCM_SHIFT);
         }
+        uint32_t len = frames * sizeof(int16_t);
+
+        if (live) {
+            rec->stats.captured_bytes += len;
+            if (gate) {
+                capture_gate(rec, out_buf, len);
+            } else {
+                capture_push(rec, out_buf, len);
+            }
+        } else if (bits & REC_EVT_WRITER_DONE) {
+            preroll_push(rec, out_buf, len);
+        }
+        // 否则上一段录音的写卡任务还在收尾，本块丢弃
+
+        publish_level(rec, out_buf, frames);
+
+        rec->stats.capture_blocks++;
+        rec->stats.capture_busy_us += esp_timer_get_time() - t0;
     }
 
-    ESP_LOGI(TAG, "Recording task exiting...");
+    ESP_LOGI(TAG, "Capture task exiting...");
+    __atomic_store_n(&rec->level, 0, __ATOMIC_RELAXED);
     free(buf);
     free(out_buf);
+    rec->capture_running = false;
+    xEventGroupSetBits(rec->events, REC_EVT_CAPTURE_EXIT);
     vTaskDelete(NULL);
 }
 
+//--------------------------------------------------------
+// 写文件并统计耗时
+//--------------------------------------------------------
+static void rec_file_write(inmp441_recorder_t *rec, const void *data, uint32_t len)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = sd_direct_write(&rec->file, data, len);
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+    rec->stats.write_count++;
+    rec->stats.write_last_us = dt;
+    rec->stats.write_total_us += dt;
+    if (dt > rec->stats.write_max_us) {
+        rec->stats.write_max_us = dt;
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "write failed (%lu bytes)", (unsigned long)len);
+    }
+}
+
+//--------------------------------------------------------
+// 从环形缓冲区取出最多 max 个 48 kHz 样点，按档位抽取后写入 out
+// 返回输出样点数
+//--------------------------------------------------------
+static uint32_t writer_pull(inmp441_recorder_t *rec, int16_t *out, uint32_t max)
+{
+    uint32_t factor = rec->decim.factor;
+    uint32_t got = 0;
+
+    if (factor == 1) {
+        return ring_buffer_read(&rec->ring, out, max * sizeof(int16_t)) / sizeof(int16_t);
+    }
+
+    while (got < max) {
+        uint32_t in_n = (max - got) * factor;
+        if (in_n > DEC_SCRATCH_SAMPLES) in_n = DEC_SCRATCH_SAMPLES;
+        uint32_t n = ring_buffer_read(&rec->ring, rec->dec_in, in_n * sizeof(int16_t)) / sizeof(int16_t);
+        if (n == 0) break;
+        got += decimator_process(&rec->decim, rec->dec_in, n, out + got);
+    }
+    return got;
+}
+
+//--------------------------------------------------------
+// PCM：48 kHz 直接从环形缓冲区零拷贝写入，其它档位抽取后写入
+//--------------------------------------------------------
+static void writer_write_pcm(inmp441_recorder_t *rec)
+{
+    // 按时长分段时正好写到段尾，下一次写入进入新段
+    uint32_t room = UINT32_MAX;
+    if (rec->seg_samples) {
+        room = rec->seg_samples - rec->samples_written;
+    }
+
+    if (rec->decim.factor == 1) {
+        const uint8_t *ptr;
+        uint32_t len = ring_buffer_peek(&rec->ring, &ptr);
+        if (len > SD_WRITE_CHUNK) len = SD_WRITE_CHUNK;
+        if (len / sizeof(int16_t) > room) len = room * sizeof(int16_t);
+
+        rec_file_write(rec, ptr, len);
+        if (rec->peaks_enabled) {
+            peak_writer_feed(&rec->peaks, (const int16_t *)ptr, len / sizeof(int16_t));
+        }
+        ring_buffer_consume(&rec->ring, len);
+        rec->samples_written += len / sizeof(int16_t);
+        return;
+    }
+
+    int16_t *out = (int16_t *)rec->enc_out;
+    uint32_t max = ENC_OUT_SIZE / sizeof(int16_t);
+    if (max > room) max = room;
+    uint32_t n = writer_pull(rec, out, max);
+    if (n > 0) {
+        rec_file_write(rec, out, n * sizeof(int16_t));
+        if (rec->peaks_enabled) {
+            peak_writer_feed(&rec->peaks, out, n);
+        }
+        rec->samples_written += n;
+    }
+}
+
+//--------------------------------------------------------
+// 压缩格式每块的样点数 / 编码输出上限
+//--------------------------------------------------------
+static uint32_t encoder_block_samples(rec_format_t format)
+{
+    switch (format) {
+    case REC_FORMAT_IMA_ADPCM: return ima_adpcm_samples_per_block(ADPCM_BLOCK_ALIGN, 1);
+    case REC_FORMAT_LOSSLESS:  return LOSSLESS_BLOCK_SAMPLES;
+    default:                   return 0;
+    }
+}
+
+static uint32_t encoder_max_block_bytes(rec_format_t format)
+{
+    return format == REC_FORMAT_IMA_ADPCM ? ADPCM_BLOCK_ALIGN : LOSSLESS_MAX_BLOCK_BYTES;
+}
+
+//--------------------------------------------------------
+// 压缩格式：每次编码一个块，攒满 ENC_OUT_SIZE 再写卡
+// ADPCM 最后一个不完整的块用末尾样点补齐，保证文件按块对齐；
+// 无损块自带样点数，不需要补齐
+//--------------------------------------------------------
+static void writer_write_encoded(inmp441_recorder_t *rec)
+{
+    uint32_t spb = encoder_block_samples(rec->format);
+    uint32_t n = writer_pull(rec, rec->enc_pcm, spb);
+    if (n == 0) return;
+
+    uint8_t *out = rec->enc_out + rec->enc_out_len;
+    rec->samples_written += n;
+    if (rec->peaks_enabled) {
+        peak_writer_feed(&rec->peaks, rec->enc_pcm, n);   // 补齐前的真实样点
+    }
+
+    if (rec->format == REC_FORMAT_IMA_ADPCM) {
+        for (uint32_t i = n; i < spb; i++) {
+            rec->enc_pcm[i] = rec->enc_pcm[n - 1];
+        }
+        ima_adpcm_encode_block(&rec->adpcm, rec->enc_pcm, out, ADPCM_BLOCK_ALIGN);
+        rec->enc_out_len += ADPCM_BLOCK_ALIGN;
+    } else {
+        rec->enc_out_len += lossless_encode_block(rec->enc_pcm, n, out);
+    }
+
+    if (rec->enc_out_len + encoder_max_block_bytes(rec->format) > ENC_OUT_SIZE) {
+        rec_file_write(rec, rec->enc_out, rec->enc_out_len);
+        rec->enc_out_len = 0;
+    }
+}
+
+//--------------------------------------------------------
+// 按当前写入长度回填 RIFF / data / fact 字段
+//--------------------------------------------------------
+static void patch_wav_header(sd_direct_file_t *f, uint32_t data_offset, uint32_t fact_offset,
+                             uint32_t samples)
+{
+    uint32_t file_size = f->pos;
+    uint32_t riff_size = file_size - 8;
+    uint32_t data_size = file_size - data_offset;
+
+    sd_direct_pwrite(f, 4, &riff_size, 4);
+    sd_direct_pwrite(f, data_offset - 4, &data_size, 4);
+    if (fact_offset) {
+        sd_direct_pwrite(f, fact_offset, &samples, 4);
+    }
+}
+
+//--------------------------------------------------------
+// 检查点：回填文件头并 fsync，掉电后文件仍是合法 WAV
+// 只在写卡任务中执行，采集任务继续往环形缓冲区写，不受影响
+//--------------------------------------------------------
+static void rec_checkpoint(inmp441_recorder_t *rec)
+{
+    int64_t t0 = esp_timer_get_time();
+
+    patch_wav_header(&rec->file, rec->data_offset, rec->fact_offset, rec->samples_written);
+    if (sd_direct_sync(&rec->file) != ESP_OK) {
+        ESP_LOGE(TAG, "Checkpoint failed");
+    }
+
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+    rec->stats.checkpoint_count++;
+    rec->stats.checkpoint_total_us += dt;
+    if (dt > rec->stats.checkpoint_max_us) {
+        rec->stats.checkpoint_max_us = dt;
+    }
+}
+
+//--------------------------------------------------------
+// 分段录音
+//
+// 写卡任务只负责切换：把写满的段交给收尾任务，换上收尾任务预先打开的下一段，
+// 整个过程只是交换结构体，不碰文件系统元数据。收尾任务（低优先级）负责
+// 回填文件头、截断、关闭、追加清单，然后打开再下一段备用。
+// 环形缓冲区里的数据按顺序写进各段，段与段之间不丢、不重样点。
+//--------------------------------------------------------
+typedef enum {
+    SEG_JOB_CLOSE = 0,           // 收尾 seg 并释放
+    SEG_JOB_OPEN,                // 预先打开第 index 段到 rec->seg_next
+} seg_job_kind_t;
+
+typedef struct {
+    seg_job_kind_t kind;
+    uint16_t index;
+    rec_segment_t *seg;
+} seg_job_t;
+
+static esp_err_t open_record_file(const inmp441_recorder_t *rec, sd_direct_file_t *f, const char *path);
+static void open_peak_file(const inmp441_recorder_t *rec, peak_writer_t *pw, const char *wav_path);
+static void close_peak_file(peak_writer_t *pw, const char *wav_path);
+
+static bool is_segmented(const inmp441_recorder_t *rec)
+{
+    return rec->seg_bytes != 0;
+}
+
+static void segment_path(const inmp441_recorder_t *rec, uint16_t index, char *out, size_t len)
+{
+    snprintf(out, len, "%s_%03u.wav", rec->seg_base, index);
+}
+
+static void manifest_path(const inmp441_recorder_t *rec, char *out, size_t len)
+{
+    snprintf(out, len, "%s.m3u", rec->seg_base);
+}
+
+// 清单每行一个段文件名（与清单同目录），按段顺序追加
+static void manifest_append(const inmp441_recorder_t *rec, const char *seg_path)
+{
+    char path[sizeof(rec->seg_base) + 8];
+    manifest_path(rec, path, sizeof(path));
+
+    FILE *fp = fopen(path, "a");
+    if (!fp) {
+        ESP_LOGW(TAG, "Failed to update manifest %s", path);
+        return;
+    }
+    const char *name = strrchr(seg_path, '/');
+    fprintf(fp, "%s\n", name ? name + 1 : seg_path);
+    fclose(fp);
+}
+
+// 创建一段：打开文件、写文件头、打开峰值旁路文件
+static esp_err_t segment_open(const inmp441_recorder_t *rec, rec_segment_t *seg, uint16_t index)
+{
+    uint32_t fact_offset;
+
+    seg->index = index;
+    seg->samples = 0;
+    segment_path(rec, index, seg->path, sizeof(seg->path));
+    ESP_RETURN_ON_ERROR(open_record_file(rec, &seg->file, seg->path), TAG, "open %s failed", seg->path);
+    write_wav_header(&seg->file, rec->format, rec->sample_rate, 1, &fact_offset);
+    open_peak_file(rec, &seg->peaks, seg->path);
+    return ESP_OK;
+}
+
+// 收尾一段：回填文件头、关闭、追加到清单
+static void segment_close(const inmp441_recorder_t *rec, rec_segment_t *seg)
+{
+    int64_t t0 = esp_timer_get_time();
+    uint32_t size = seg->file.pos;
+
+    patch_wav_header(&seg->file, rec->data_offset, rec->fact_offset, seg->samples);
+    if (sd_direct_close(&seg->file) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to finalize %s", seg->path);
+    }
+    close_peak_file(&seg->peaks, seg->path);
+    manifest_append(rec, seg->path);
+
+    ESP_LOGI(TAG, "Segment %u saved: %s, %lu bytes, %lu samples (%lld us)",
+             seg->index, seg->path, (unsigned long)size, (unsigned long)seg->samples,
+             (long long)(esp_timer_get_time() - t0));
+}
+
+// 丢弃预先打开但没有用上的段
+static void segment_discard(rec_segment_t *seg)
+{
+    char pk[sizeof(seg->path)];
+
+    sd_direct_close(&seg->file);
+    remove(seg->path);
+    wav_info_forget(seg->path);
+    if (seg->peaks.fp) {
+        peak_writer_close(&seg->peaks);
+        peak_file_path(seg->path, pk, sizeof(pk));
+        remove(pk);
+    }
+}
+
+static void inmp441_segment_task(void *param)
+{
+    inmp441_recorder_t *rec = (inmp441_recorder_t *)param;
+    seg_job_t job;
+
+    while (true) {
+        xQueueReceive(rec->seg_queue, &job, portMAX_DELAY);
+
+        if (job.kind == SEG_JOB_CLOSE) {
+            segment_close(rec, job.seg);
+            free(job.seg);
+        } else if (segment_open(rec, &rec->seg_next, job.index) == ESP_OK) {
+            xEventGroupSetBits(rec->events, REC_EVT_SEG_NEXT);
+        }
+
+        if (__atomic_sub_fetch(&rec->seg_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+            xEventGroupSetBits(rec->events, REC_EVT_SEG_IDLE);
+        }
+    }
+}
+
+static void segment_submit(inmp441_recorder_t *rec, seg_job_kind_t kind, uint16_t index, rec_segment_t *seg)
+{
+    seg_job_t job = { .kind = kind, .index = index, .seg = seg };
+
+    xEventGroupClearBits(rec->events, REC_EVT_SEG_IDLE);
+    __atomic_add_fetch(&rec->seg_pending, 1, __ATOMIC_ACQ_REL);
+    xQueueSend(rec->seg_queue, &job, portMAX_DELAY);
+}
+
+// 当前段是否已写满（在写入下一单元之前检查，避免停止时留下空段）
+static bool segment_full(const inmp441_recorder_t *rec)
+{
+    if (!is_segmented(rec)) {
+        return false;
+    }
+    if (rec->seg_samples && rec->samples_written >= rec->seg_samples) {
+        return true;
+    }
+    return rec->file.pos + rec->enc_out_len + SD_WRITE_CHUNK > rec->seg_bytes;
+}
+
+//--------------------------------------------------------
+// 切换到下一段（写卡任务中执行）
+//--------------------------------------------------------
+static void rotate_segment(inmp441_recorder_t *rec)
+{
+    int64_t t0 = esp_timer_get_time();
+
+    // 攒着的压缩块属于当前段
+    if (rec->enc_out_len > 0) {
+        rec_file_write(rec, rec->enc_out, rec->enc_out_len);
+        rec->enc_out_len = 0;
+    }
+
+    rec_segment_t *old = malloc(sizeof(*old));
+    if (!old) {
+        ESP_LOGE(TAG, "No memory to rotate, continuing in %s", rec->filepath);
+        rec->seg_samples = 0;
+        rec->seg_bytes = 0;
+        return;
+    }
+    old->file = rec->file;
+    old->peaks = rec->peaks;
+    old->samples = rec->samples_written;
+    old->index = rec->seg_index;
+    memcpy(old->path, rec->filepath, sizeof(old->path));
+
+    if (xEventGroupClearBits(rec->events, REC_EVT_SEG_NEXT) & REC_EVT_SEG_NEXT) {
+        // 正常路径：收尾任务已经打开好了
+    } else {
+        // 收尾任务落后（卡很慢或段很短）：自己打开，这一次会有文件系统延迟
+        rec->stats.segment_late_opens++;
+        xEventGroupWaitBits(rec->events, REC_EVT_SEG_IDLE, pdFALSE, pdTRUE, portMAX_DELAY);
+        if (xEventGroupClearBits(rec->events, REC_EVT_SEG_NEXT) & REC_EVT_SEG_NEXT) {
+            // 等待期间打开完成
+        } else if (segment_open(rec, &rec->seg_next, rec->seg_index + 1) != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot open next segment, continuing in %s", rec->filepath);
+            free(old);
+            rec->seg_samples = 0;
+            rec->seg_bytes = 0;
+            return;
+        }
+    }
+
+    rec->file = rec->seg_next.file;
+    rec->peaks = rec->seg_next.peaks;
+    rec->seg_index = rec->seg_next.index;
+    memcpy(rec->filepath, rec->seg_next.path, sizeof(rec->filepath));
+    rec->samples_written = 0;
+
+    segment_submit(rec, SEG_JOB_CLOSE, 0, old);
+    segment_submit(rec, SEG_JOB_OPEN, rec->seg_index + 1, NULL);
+
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+    rec->stats.segments++;
+    if (dt > rec->stats.segment_switch_max_us) {
+        rec->stats.segment_switch_max_us = dt;
+    }
+}
+
+static void finalize_recording(inmp441_recorder_t *rec, int64_t t0);
+
+static void set_idle(inmp441_recorder_t *rec)
+{
+    rec->state = REC_STATE_IDLE;
+    xEventGroupSetBits(rec->events, REC_EVT_IDLE);
+}
+
+//--------------------------------------------------------
+// 写卡任务：攒够一个写入单元再写，采集结束后写空缓冲区
+// 环形缓冲区中的数据始终是 48 kHz，抽取在这里完成，
+// 这样预录数据和实时数据经过同一个滤波器，衔接处无跳变
+//--------------------------------------------------------
+static void inmp441_writer_task(void *param)
+{
+    inmp441_recorder_t *rec = (inmp441_recorder_t *)param;
+    uint32_t out_samples = SD_WRITE_CHUNK / sizeof(int16_t);
+
+    if (rec->format != REC_FORMAT_PCM16) {
+        out_samples = encoder_block_samples(rec->format);
+    }
+    uint32_t unit = out_samples * rec->decim.factor * sizeof(int16_t);
+    if (unit > rec->ring.size / 2) unit = rec->ring.size / 2;
+
+    // 预分配的文件长度从一开始就是分配长度：先提交一次文件头，
+    // 恢复扫描据此区分已写数据和预分配区中的旧数据
+    int64_t next_checkpoint = esp_timer_get_time();
+    if (!rec->file.alloc_end) {
+        next_checkpoint += (int64_t)rec->checkpoint_ms * 1000;
+    }
+
+    ESP_LOGI(TAG, "Writer task started on core %d", xPortGetCoreID());
+
+    while (true) {
+        if (rec->checkpoint_ms && esp_timer_get_time() >= next_checkpoint) {
+            rec_checkpoint(rec);
+            next_checkpoint = esp_timer_get_time() + (int64_t)rec->checkpoint_ms * 1000;
+        }
+
+        bool draining = xEventGroupGetBits(rec->events) & REC_EVT_CAPTURE_DONE;
+        uint32_t used = ring_buffer_used(&rec->ring);
+
+        if (used == 0 && draining) {
+            break;
+        }
+        if (used < unit && !draining) {
+            // 等事件位而不是任务通知：采集任务不持有写卡任务的句柄，
+            // 写卡任务看到 CAPTURE_DONE 后随时可能退出，不能再往它的 TCB 上发通知
+            xEventGroupWaitBits(rec->events, REC_EVT_DATA | REC_EVT_CAPTURE_DONE, pdFALSE, pdFALSE,
+                                pdMS_TO_TICKS(100));
+            xEventGroupClearBits(rec->events, REC_EVT_DATA);
+            continue;
+        }
+
+        if (segment_full(rec)) {
+            rotate_segment(rec);
+            next_checkpoint = esp_timer_get_time();
+            if (!rec->file.alloc_end) {
+                next_checkpoint += (int64_t)rec->checkpoint_ms * 1000;
+            }
+        }
+
+        if (rec->format != REC_FORMAT_PCM16) {
+            writer_write_encoded(rec);
+        } else {
+            writer_write_pcm(rec);
+        }
+    }
+
+    if (rec->enc_out_len > 0) {
+        rec_file_write(rec, rec->enc_out, rec->enc_out_len);
+        rec->enc_out_len = 0;
+    }
+
+    // 静音自动停止时没有调用方在等，由写卡任务自己关闭文件
+    bool finalize = rec->auto_stopped;
+    if (finalize) {
+        finalize_recording(rec, esp_timer_get_time());
+    }
+
+    ESP_LOGI(TAG, "Writer task exiting...");
+    rec->writer_task = NULL;
+    xEventGroupSetBits(rec->events, REC_EVT_WRITER_DONE);
+    if (finalize) {
+        set_idle(rec);
+    }
+    vTaskDelete(NULL);
+}
+
+//--------------------------------------------------------
+// 分配编码器 / 抽取缓冲区（首次录音时分配）
+//--------------------------------------------------------
+static esp_err_t alloc_encoder(inmp441_recorder_t *rec)
+{
+    rec->enc_out_len = 0;
+    rec->adpcm.predictor = 0;
+    rec->adpcm.index = 0;
+
+    if (rec->enc_pcm) {
+        return ESP_OK;
+    }
+
+    // 按最大的块分配，之后切换格式无需重新分配
+    uint32_t spb = encoder_block_samples(REC_FORMAT_IMA_ADPCM);
+    if (spb < LOSSLESS_BLOCK_SAMPLES) spb = LOSSLESS_BLOCK_SAMPLES;
+    rec->enc_pcm = malloc(spb * sizeof(int16_t));
+    rec->enc_out = malloc(ENC_OUT_SIZE);
+    rec->dec_in = malloc(DEC_SCRATCH_SAMPLES * sizeof(int16_t));
+    if (!rec->enc_pcm || !rec->enc_out || !rec->dec_in) {
+        free(rec->enc_pcm);
+        free(rec->enc_out);
+        free(rec->dec_in);
+        rec->enc_pcm = NULL;
+        rec->enc_out = NULL;
+        rec->dec_in = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 分配环形缓冲区（优先 PSRAM），容量至少 min_size
+//--------------------------------------------------------
+static esp_err_t alloc_ring_buffer(inmp441_recorder_t *rec, uint32_t min_size)
+{
+    if (rec->ring_storage && rec->ring.size >= min_size) {
+        ring_buffer_reset(&rec->ring);
+        return ESP_OK;
+    }
+
+    heap_caps_free(rec->ring_storage);
+    rec->ring_storage = NULL;
+
+    uint32_t size = RING_BUFFER_SIZE;
+    while (size < min_size) size <<= 1;
+
+    rec->ring_storage = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    rec->ring_in_psram = rec->ring_storage != NULL;
+    if (!rec->ring_storage && min_size <= RING_BUFFER_SIZE_INTERNAL) {
+        ESP_LOGW(TAG, "PSRAM ring alloc failed, falling back to internal RAM");
+        size = RING_BUFFER_SIZE_INTERNAL;
+        rec->ring_storage = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!rec->ring_storage) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring_buffer_init(&rec->ring, rec->ring_storage, size);
+    ESP_LOGI(TAG, "Ring buffer: %lu bytes (%s)", (unsigned long)size, rec->ring_in_psram ? "PSRAM" : "internal");
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 分配语音门控的起音缓冲区（首次开启门控时，优先 PSRAM）
+//--------------------------------------------------------
+static void alloc_onset_buffer(inmp441_recorder_t *rec)
+{
+    if (rec->onset_buf || !rec->vad_enabled) {
+        return;
+    }
+    size_t size = VAD_ONSET_FRAMES * VAD_FRAME_SAMPLES * sizeof(int16_t);
+    rec->onset_buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!rec->onset_buf) {
+        rec->onset_buf = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!rec->onset_buf) {
+        ESP_LOGW(TAG, "No memory for VAD onset buffer, gating disabled");
+    }
+}
+
+//--------------------------------------------------------
+// 启动采集任务（I2S 通道未开启时先开启）
+//--------------------------------------------------------
+static esp_err_t start_capture(inmp441_recorder_t *rec)
+{
+    if (!rec->rx_enabled) {
+        ESP_RETURN_ON_ERROR(i2s_channel_enable(rec->rx_chan), TAG, "i2s enable failed");
+        rec->rx_enabled = true;
+    }
+    capture_dsp_init(&rec->dsp);
+    rec->capture_running = true;
+    xEventGroupClearBits(rec->events, REC_EVT_CAPTURE_EXIT);
+    if (xTaskCreatePinnedToCore(inmp441_capture_task, "inmp441_capture", 4096, rec, 6,
+                                &rec->capture_task, CAPTURE_TASK_CORE) != pdPASS) {
+        rec->capture_running = false;
+        xEventGroupSetBits(rec->events, REC_EVT_CAPTURE_EXIT);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void stop_capture_channel(inmp441_recorder_t *rec)
+{
+    if (rec->rx_enabled) {
+        i2s_channel_disable(rec->rx_chan);
+        rec->rx_enabled = false;
+    }
+}
+
+//--------------------------------------------------------
+// 预估写入速率（字节/秒，取上限）
+//--------------------------------------------------------
+static uint32_t estimate_byte_rate(const inmp441_recorder_t *rec)
+{
+    if (rec->format == REC_FORMAT_IMA_ADPCM) {
+        return (uint32_t)((uint64_t)rec->sample_rate * ADPCM_BLOCK_ALIGN /
+                          encoder_block_samples(REC_FORMAT_IMA_ADPCM)) + 1;
+    }
+    return rec->sample_rate * sizeof(int16_t);
+}
+
+//--------------------------------------------------------
+// 打开录音文件；开启预分配时按预计时长分配一段连续簇
+//--------------------------------------------------------
+static esp_err_t open_record_file(const inmp441_recorder_t *rec, sd_direct_file_t *f, const char *path)
+{
+    uint32_t prealloc = 0;
+    if (rec->prealloc_seconds > 0) {
+        uint64_t size = (uint64_t)rec->prealloc_seconds * estimate_byte_rate(rec) + 64;
+        // 分段时不超过一段的长度
+        if (is_segmented(rec) && size > rec->seg_bytes) size = rec->seg_bytes;
+        prealloc = size > UINT32_MAX / 2 ? UINT32_MAX / 2 : (uint32_t)size;
+    }
+    // 覆盖同名文件：播放器缓存的旧文件头描述作废
+    wav_info_forget(path);
+    return sd_direct_open(f, path, prealloc);
+}
+
+//--------------------------------------------------------
+// 波形峰值旁路文件（xxx.pk）：写卡任务随 WAV 一起生成，失败不影响录音
+//--------------------------------------------------------
+static void open_peak_file(const inmp441_recorder_t *rec, peak_writer_t *pw, const char *wav_path)
+{
+    pw->fp = NULL;
+    if (!rec->peaks_enabled) return;
+
+    char path[sizeof(rec->filepath)];
+    peak_file_path(wav_path, path, sizeof(path));
+    if (!peak_writer_open(pw, path, rec->sample_rate)) {
+        ESP_LOGW(TAG, "Failed to create peak file %s", path);
+    }
+}
+
+static void close_peak_file(peak_writer_t *pw, const char *wav_path)
+{
+    if (pw->fp && !peak_writer_close(pw)) {
+        ESP_LOGW(TAG, "Failed to finalize peak file for %s", wav_path);
+    }
+}
+
+//--------------------------------------------------------
+// 分段设置：计算每段上限，生成段文件名前缀并新建清单
+//--------------------------------------------------------
+static esp_err_t setup_segments(inmp441_recorder_t *rec, const char *filename)
+{
+    rec->seg_index = 0;
+    rec->seg_samples = 0;
+    rec->seg_bytes = 0;
+    if (rec->segment_minutes == 0 && rec->segment_mb == 0) {
+        snprintf(rec->filepath, sizeof(rec->filepath), REC_BASE_PATH "/%s", filename);
+        return ESP_OK;
+    }
+
+    if (!rec->seg_task) {
+        rec->seg_queue = xQueueCreate(SEG_QUEUE_LEN, sizeof(seg_job_t));
+        ESP_RETURN_ON_FALSE(rec->seg_queue, ESP_ERR_NO_MEM, TAG, "segment queue alloc failed");
+        if (xTaskCreatePinnedToCore(inmp441_segment_task, "inmp441_seg", 4096, rec, SEG_TASK_PRIO,
+                                    &rec->seg_task, WRITER_TASK_CORE) != pdPASS) {
+            vQueueDelete(rec->seg_queue);
+            rec->seg_queue = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+        xEventGroupSetBits(rec->events, REC_EVT_SEG_IDLE);
+    }
+
+    uint64_t samples = (uint64_t)rec->segment_minutes * 60 * rec->sample_rate;
+    rec->seg_samples = samples > UINT32_MAX ? UINT32_MAX : (uint32_t)samples;
+    uint32_t mb = rec->segment_mb && rec->segment_mb < REC_SEGMENT_MAX_MB ? rec->segment_mb : REC_SEGMENT_MAX_MB;
+    rec->seg_bytes = mb * 1024u * 1024u;
+
+    const char *dot = strrchr(filename, '.');
+    int base_len = dot ? (int)(dot - filename) : (int)strlen(filename);
+    snprintf(rec->seg_base, sizeof(rec->seg_base), REC_BASE_PATH "/%.*s", base_len, filename);
+    segment_path(rec, 0, rec->filepath, sizeof(rec->filepath));
+
+    char path[sizeof(rec->seg_base) + 8];
+    manifest_path(rec, path, sizeof(path));
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs("#EXTM3U\n", fp);
+        fclose(fp);
+    } else {
+        ESP_LOGW(TAG, "Failed to create manifest %s", path);
+    }
+    return ESP_OK;
+}
+
 //--------------------------------------------------------
 // 启动录音
 //--------------------------------------------------------
-esp_err_t inmp441_start_record(inmp441_recorder_t *rec, const char *filename)
+esp_err_t inmp441_start_record(inmp441_recorder_t *rec, const char *filename, rec_profile_t profile)
 {
-    if (rec->is_recording) {
-        ESP_LOGW(TAG, "Already recording!");
-        return ESP_FAIL;
+    static const uint8_t factors[] = {
+        [REC_PROFILE_48K] = 1,
+        [REC_PROFILE_16K] = 3,
+        [REC_PROFILE_8K]  = 6,
+    };
+
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Recorder busy (state %d)", rec->state);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if ((unsigned)profile >= sizeof(factors) || decimator_init(&rec->decim, factors[profile]) != 0) {
+        ESP_LOGE(TAG, "Invalid profile %d", profile);
+        return ESP_ERR_INVALID_ARG;
     }
+    rec->profile = profile;
+    rec->sample_rate = SAMPLE_RATE_HZ / factors[profile];
 
-    snprintf(rec->filepath, sizeof(rec->filepath), "/sdcard/%s", filename);
-    rec->file = fopen(rec->filepath, "wb");
-    if (!rec->file) {
+    // 预录运行中时环形缓冲区里是预录数据，不能清空
+    if (!rec->capture_running) {
+        ESP_RETURN_ON_ERROR(alloc_ring_buffer(rec, 0), TAG, "ring buffer alloc failed");
+    }
+    ESP_RETURN_ON_ERROR(alloc_encoder(rec), TAG, "encoder alloc failed");
+    alloc_onset_buffer(rec);
+
+    ESP_RETURN_ON_ERROR(setup_segments(rec, filename), TAG, "segment setup failed");
+    if (open_record_file(rec, &rec->file, rec->filepath) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to open %s", rec->filepath);
         return ESP_FAIL;
     }
 
-    write_wav_header(rec->file, SAMPLE_RATE_HZ, 16, 1);
+    rec->data_offset = write_wav_header(&rec->file, rec->format, rec->sample_rate, 1, &rec->fact_offset);
+    open_peak_file(rec, &rec->peaks, rec->filepath);
 
-    ESP_ERROR_CHECK(i2s_channel_enable(rec->rx_chan));
+    memset(&rec->stats, 0, sizeof(rec->stats));
+    rec->samples_written = 0;
+    xEventGroupClearBits(rec->events, REC_EVT_CAPTURE_LIVE | REC_EVT_CAPTURE_DONE | REC_EVT_IDLE | REC_EVT_DATA);
+    rec->auto_stopped = false;
+    rec->writer_task = NULL;
+    // 先发布 is_recording 再清 WRITER_DONE：采集任务按相反顺序读取，
+    // 预录期间读到的每一块要么进预录，要么进实时数据
     rec->is_recording = true;
+    xEventGroupClearBits(rec->events, REC_EVT_WRITER_DONE);
 
-    // 启动后台录音任务
-    xTaskCreate(inmp441_record_task, "inmp441_record_task", 4096, rec, 5, NULL);
+    if (rec->capture_running) {
+        // 等采集任务停止丢弃旧数据（最多一个 DMA 块），之后环形缓冲区只有一个消费者
+        xEventGroupWaitBits(rec->events, REC_EVT_CAPTURE_LIVE, pdFALSE, pdTRUE, portMAX_DELAY);
+        rec->stats.preroll_committed = ring_buffer_used(&rec->ring);
+    } else {
+        esp_err_t err = start_capture(rec);
+        if (err != ESP_OK) {
+            rec->is_recording = false;
+            xEventGroupSetBits(rec->events, REC_EVT_WRITER_DONE | REC_EVT_IDLE);
+            sd_direct_close(&rec->file);
+            close_peak_file(&rec->peaks, rec->filepath);
+            return err;
+        }
+    }
+
+    if (xTaskCreatePinnedToCore(inmp441_writer_task, "inmp441_writer", 4096, rec, 4,
+                                &rec->writer_task, WRITER_TASK_CORE) != pdPASS) {
+        // 回到空闲：采集任务退回预录（或退出），没有写卡任务时由这里置 WRITER_DONE
+        ESP_LOGE(TAG, "Writer task create failed");
+        rec->writer_task = NULL;
+        rec->is_recording = false;
+        if (rec->preroll_bytes == 0) {
+            xEventGroupWaitBits(rec->events, REC_EVT_CAPTURE_EXIT, pdFALSE, pdTRUE, portMAX_DELAY);
+            stop_capture_channel(rec);
+        }
+        sd_direct_close(&rec->file);
+        close_peak_file(&rec->peaks, rec->filepath);
+        xEventGroupSetBits(rec->events, REC_EVT_WRITER_DONE | REC_EVT_IDLE);
+        return ESP_ERR_NO_MEM;
+    }
+    rec->state = REC_STATE_RECORDING;
 
-    ESP_LOGI(TAG, "Recording started: %s", rec->filepath);
+    if (is_segmented(rec)) {
+        rec->stats.segments = 1;
+        segment_submit(rec, SEG_JOB_OPEN, 1, NULL);
+    }
+
+    ESP_LOGI(TAG, "Recording started: %s (%lu Hz, pre-roll %lu bytes)", rec->filepath,
+             (unsigned long)rec->sample_rate, (unsigned long)rec->stats.preroll_committed);
     return ESP_OK;
 }
 
@@ -112,24 +1081,294 @@ esp_err_t inmp441_start_record(inmp441_recorder_t *rec, const char *filename)
 //--------------------------------------------------------
 void inmp441_stop_record(inmp441_recorder_t *rec)
 {
-    if (!rec->is_recording) return;
+    rec_state_t expected = REC_STATE_RECORDING;
+    if (!__atomic_compare_exchange_n(&rec->state, &expected, REC_STATE_STOPPING,
+                                     false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        if (expected == REC_STATE_STOPPING) {
+            // 静音自动停止正在收尾，等它完成
+            xEventGroupWaitBits(rec->events, REC_EVT_IDLE, pdFALSE, pdTRUE, portMAX_DELAY);
+        }
+        return;
+    }
 
+    int64_t t0 = esp_timer_get_time();
     rec->is_recording = false;
-    vTaskDelay(pdMS_TO_TICKS(100)); // 等待缓冲区写完
-    i2s_channel_disable(rec->rx_chan);
 
-    long file_size = ftell(rec->file);
-    fseek(rec->file, 4, SEEK_SET);
-    uint32_t riff_size = file_size - 8;
-    fwrite(&riff_size, 4, 1, rec->file);
-    fseek(rec->file, 40, SEEK_SET);
-    uint32_t data_size = file_size - 44;
-    fwrite(&data_size, 4, 1, rec->file);
+    // 采集任务在当前 DMA 块结束后置 CAPTURE_DONE 并唤醒写卡任务，
+    // 写卡任务写空缓冲区、刷出最后不满的一块后置 WRITER_DONE
+    EventBits_t bits = xEventGroupWaitBits(rec->events, REC_EVT_WRITER_DONE, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(REC_STOP_WARN_MS));
+    if (!(bits & REC_EVT_WRITER_DONE)) {
+        // 卡写入异常缓慢：文件仍由写卡任务持有，不能提前关闭
+        ESP_LOGW(TAG, "Writer still busy after %d ms, waiting", REC_STOP_WARN_MS);
+        xEventGroupWaitBits(rec->events, REC_EVT_WRITER_DONE, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    finalize_recording(rec, t0);
+    set_idle(rec);
+}
+
+//--------------------------------------------------------
+// 收尾：关通道、回填文件头、关闭文件并打印统计
+//--------------------------------------------------------
+static void finalize_recording(inmp441_recorder_t *rec, int64_t t0)
+{
+    // 不开预录时采集任务随后退出，等它退出再关通道，避免与下一次录音的采集任务并存
+    if (rec->preroll_bytes == 0) {
+        xEventGroupWaitBits(rec->events, REC_EVT_CAPTURE_EXIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        stop_capture_channel(rec);
+    }
+
+    long file_size = rec->file.pos;
+    patch_wav_header(&rec->file, rec->data_offset, rec->fact_offset, rec->samples_written);
+
+    bool prealloc = rec->file.alloc_end != 0;
+    rec->stats.prealloc_grows = rec->file.grows;
+    if (sd_direct_close(&rec->file) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to finalize %s", rec->filepath);
+    }
+    close_peak_file(&rec->peaks, rec->filepath);
+
+    // 分段：等前面的段收尾完（清单按顺序追加），再追加最后一段，丢弃备用段
+    if (is_segmented(rec)) {
+        xEventGroupWaitBits(rec->events, REC_EVT_SEG_IDLE, pdFALSE, pdTRUE, portMAX_DELAY);
+        manifest_append(rec, rec->filepath);
+        if (xEventGroupClearBits(rec->events, REC_EVT_SEG_NEXT) & REC_EVT_SEG_NEXT) {
+            segment_discard(&rec->seg_next);
+        }
+    }
+
+    rec->stats.stop_us = (uint32_t)(esp_timer_get_time() - t0);
+
+    ESP_LOGI(TAG, "Recording saved to %s, size: %ld bytes, stop took %lu us",
+             rec->filepath, file_size, (unsigned long)rec->stats.stop_us);
+    ESP_LOGI(TAG, "Stats: prealloc=%s grows=%lu pre-roll=%lu overruns=%lu dropped=%lu high_water=%lu/%lu writes=%lu max=%luus avg=%luus",
+             prealloc ? "on" : "off",
+             (unsigned long)rec->stats.prealloc_grows,
+             (unsigned long)rec->stats.preroll_committed,
+             (unsigned long)rec->stats.overruns,
+             (unsigned long)rec->stats.dropped_bytes,
+             (unsigned long)rec->stats.high_water,
+             (unsigned long)rec->ring.size,
+             (unsigned long)rec->stats.write_count,
+             (unsigned long)rec->stats.write_max_us,
+             (unsigned long)(rec->stats.write_count ?
+                             rec->stats.write_total_us / rec->stats.write_count : 0));
+    if (rec->dsp_enabled && rec->stats.capture_blocks) {
+        ESP_LOGI(TAG, "DSP: max %lu cycles/block (budget %d), avg %lu cycles/sample, %lu over budget",
+                 (unsigned long)rec->stats.dsp_cycles_max, DSP_CYCLE_BUDGET,
+                 (unsigned long)(rec->stats.dsp_cycles_total /
+                                 ((uint64_t)rec->stats.capture_blocks * (BUFFER_SIZE / 4))),
+                 (unsigned long)rec->stats.dsp_over_budget);
+    }
+    if (rec->vad_enabled && rec->stats.capture_blocks) {
+        ESP_LOGI(TAG, "VAD: skipped %lu of %lu bytes (%lu%%)%s, %lu cycles/frame avg, %lu max",
+                 (unsigned long)rec->stats.vad_skipped_bytes,
+                 (unsigned long)rec->stats.captured_bytes,
+                 (unsigned long)(rec->stats.captured_bytes ?
+                                 (uint64_t)rec->stats.vad_skipped_bytes * 100 / rec->stats.captured_bytes : 0),
+                 rec->auto_stopped ? ", auto-stopped" : "",
+                 (unsigned long)(rec->stats.vad_cycles_total / rec->stats.capture_blocks),
+                 (unsigned long)rec->stats.vad_cycles_max);
+    }
+    if (is_segmented(rec)) {
+        ESP_LOGI(TAG, "Segments: %lu (limit %lu samples / %lu bytes), late opens=%lu, max switch=%luus",
+                 (unsigned long)rec->stats.segments,
+                 (unsigned long)rec->seg_samples,
+                 (unsigned long)rec->seg_bytes,
+                 (unsigned long)rec->stats.segment_late_opens,
+                 (unsigned long)rec->stats.segment_switch_max_us);
+    }
+    ESP_LOGI(TAG, "Checkpoints: every %lu ms, count=%lu max=%luus total=%lluus (%lu.%lu%% of write time)",
+             (unsigned long)rec->checkpoint_ms,
+             (unsigned long)rec->stats.checkpoint_count,
+             (unsigned long)rec->stats.checkpoint_max_us,
+             (unsigned long long)rec->stats.checkpoint_total_us,
+             (unsigned long)(rec->stats.write_total_us ?
+                             rec->stats.checkpoint_total_us * 100 / rec->stats.write_total_us : 0),
+             (unsigned long)(rec->stats.write_total_us ?
+                             rec->stats.checkpoint_total_us * 1000 / rec->stats.write_total_us % 10 : 0));
+}
+
+//--------------------------------------------------------
+// 开启预录：I2S 常开，采集任务把最近 ms 毫秒的音频保存在环形缓冲区中
+//--------------------------------------------------------
+esp_err_t inmp441_preroll_enable(inmp441_recorder_t *rec, uint32_t ms)
+{
+    if (rec->state != REC_STATE_IDLE || rec->capture_running) {
+        ESP_LOGW(TAG, "Pre-roll can only be enabled while idle");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t bytes = (uint32_t)((uint64_t)ms * SAMPLE_RATE_HZ / 1000) * sizeof(int16_t);
+    if (bytes == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 至少留一半容量给录音开始后的实时数据
+    ESP_RETURN_ON_ERROR(alloc_ring_buffer(rec, bytes * 2), TAG, "ring buffer alloc failed");
+
+    memset(&rec->stats, 0, sizeof(rec->stats));
+    rec->preroll_bytes = bytes;
+    rec->writer_task = NULL;
+
+    esp_err_t err = start_capture(rec);
+    if (err != ESP_OK) {
+        rec->preroll_bytes = 0;
+        stop_capture_channel(rec);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Pre-roll enabled: %lu ms, %lu bytes in a %lu-byte %s ring",
+             (unsigned long)ms, (unsigned long)bytes, (unsigned long)rec->ring.size,
+             rec->ring_in_psram ? "PSRAM" : "internal");
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 关闭预录，并报告空闲采集的 CPU 开销
+//--------------------------------------------------------
+void inmp441_preroll_disable(inmp441_recorder_t *rec)
+{
+    if (rec->preroll_bytes == 0) return;
+
+    rec->preroll_bytes = 0;
+    if (rec->state != REC_STATE_IDLE) {
+        return;  // 采集任务在本段录音结束后退出，由停止流程关通道
+    }
+
+    xEventGroupWaitBits(rec->events, REC_EVT_CAPTURE_EXIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    stop_capture_channel(rec);
+    ring_buffer_reset(&rec->ring);
+
+    // 每个 DMA 块对应的音频时长（微秒）
+    uint32_t block_us = (uint32_t)((uint64_t)(BUFFER_SIZE / 4) * 1000000 / SAMPLE_RATE_HZ);
+    uint32_t blocks = rec->stats.capture_blocks;
+    uint32_t avg_us = blocks ? (uint32_t)(rec->stats.capture_busy_us / blocks) : 0;
+    ESP_LOGI(TAG, "Pre-roll disabled: %lu blocks, %lu us/block of %lu us (%lu.%02lu%% CPU)",
+             (unsigned long)blocks, (unsigned long)avg_us, (unsigned long)block_us,
+             (unsigned long)(avg_us * 100 / block_us),
+             (unsigned long)(avg_us * 10000 / block_us % 100));
+}
+
+//--------------------------------------------------------
+// 设置录音格式（下一次录音生效）
+//--------------------------------------------------------
+esp_err_t inmp441_set_format(inmp441_recorder_t *rec, rec_format_t format)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change format while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->format = format;
+    return ESP_OK;
+}
 
-    fclose(rec->file);
-    rec->file = NULL;
+//--------------------------------------------------------
+// 设置预分配时长（秒，0 为关闭，下一次录音生效）
+//--------------------------------------------------------
+esp_err_t inmp441_set_prealloc(inmp441_recorder_t *rec, uint32_t seconds)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change pre-allocation while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->prealloc_seconds = seconds;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 设置检查点间隔（毫秒，0 为关闭，下一次录音生效）
+//--------------------------------------------------------
+esp_err_t inmp441_set_checkpoint(inmp441_recorder_t *rec, uint32_t interval_ms)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change checkpoint interval while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->checkpoint_ms = interval_ms;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 分段录音（minutes / mb 都为 0 时关闭）
+//--------------------------------------------------------
+esp_err_t inmp441_set_segment(inmp441_recorder_t *rec, uint32_t minutes, uint32_t mb)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change segmenting while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->segment_minutes = minutes;
+    rec->segment_mb = mb;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 开关采集 DSP（去直流 + AGC）；关闭时退回固定 raw >> PCM_SHIFT
+//--------------------------------------------------------
+esp_err_t inmp441_set_agc(inmp441_recorder_t *rec, bool enable)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change AGC while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (enable && !rec->dsp_enabled) {
+        capture_dsp_init(&rec->dsp);
+    }
+    rec->dsp_enabled = enable;
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG, "Recording saved to %s, size: %ld bytes", rec->filepath, file_size);
+//--------------------------------------------------------
+// 语音门控：跳过持续静音，auto_stop_s > 0 时静音超过该秒数自动停止
+//--------------------------------------------------------
+esp_err_t inmp441_set_vad(inmp441_recorder_t *rec, bool enable, uint32_t auto_stop_s)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change VAD while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->vad_enabled = enable;
+    rec->vad_auto_stop_s = enable ? auto_stop_s : 0;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 波形峰值旁路文件开关
+//--------------------------------------------------------
+esp_err_t inmp441_set_peaks(inmp441_recorder_t *rec, bool enable)
+{
+    if (rec->state != REC_STATE_IDLE) {
+        ESP_LOGW(TAG, "Cannot change peak file while recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+    rec->peaks_enabled = enable;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 查询会话状态
+//--------------------------------------------------------
+rec_state_t inmp441_get_state(const inmp441_recorder_t *rec)
+{
+    return rec->state;
+}
+
+//--------------------------------------------------------
+// 读取最近一块的电平（REC_LEVEL_PEAK / REC_LEVEL_RMS 解包）
+//--------------------------------------------------------
+uint32_t inmp441_get_level(const inmp441_recorder_t *rec)
+{
+    return __atomic_load_n(&rec->level, __ATOMIC_RELAXED);
+}
+
+//--------------------------------------------------------
+// 读取写卡统计
+//--------------------------------------------------------
+void inmp441_get_stats(const inmp441_recorder_t *rec, inmp441_rec_stats_t *out)
+{
+    *out = rec->stats;
 }
 
 //--------------------------------------------------------
@@ -158,6 +1397,12 @@ esp_err_t inmp441_init(inmp441_recorder_t *rec)
     std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT; // INMP441 输出左声道数据
     ESP_RETURN_ON_ERROR(i2s_channel_init_std_mode(rec->rx_chan, &std_cfg), TAG, "i2s std init failed");
 
+    rec->events = xEventGroupCreate();
+    ESP_RETURN_ON_FALSE(rec->events, ESP_ERR_NO_MEM, TAG, "event group alloc failed");
+    // 尚无写卡任务 / 采集任务
+    xEventGroupSetBits(rec->events, REC_EVT_WRITER_DONE | REC_EVT_CAPTURE_EXIT | REC_EVT_IDLE);
+    rec->state = REC_STATE_IDLE;
+
     ESP_LOGI(TAG, "INMP441 initialized on I2S%d", I2S_PORT);
     return ESP_OK;
 }
@@ -5,7 +5,20 @@
 #include "driver/i2s_std.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
 #include "pin_cfg.h"
+#include "ring_buffer.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
+#include "decimator.h"
+#include "capture_dsp.h"
+#include "vad.h"
+#include "peak_file.h"
+#include "sdcard.h"
+#include "sd_direct.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,23 +28,201 @@ extern "C" {
 // 配置参数（可按需修改）
 //--------------------------------------------------------
 #define I2S_PORT            I2S_NUM_0
-#define SAMPLE_RATE_HZ      48000
+#define REC_BASE_PATH       SD_MOUNT_POINT
+#define SAMPLE_RATE_HZ      48000         // 麦克风 I2S 采样率（存储采样率由录音档位决定）
 #define SAMPLE_BITS         I2S_DATA_BIT_WIDTH_32BIT
 #define CHANNEL_MODE          I2S_SLOT_MODE_MONO
 #define BUFFER_SIZE         1024
+#define PCM_SHIFT           11            // 32bit 原始数据右移位数
 
+#define RING_BUFFER_SIZE    (256 * 1024)  // 采集→写卡 环形缓冲区（PSRAM，2 的幂）
+#define RING_BUFFER_SIZE_INTERNAL (32 * 1024) // PSRAM 不可用时的内部 RAM 回退大小
+#define SD_WRITE_CHUNK      (16 * 1024)   // 写卡任务每次写入量（与簇大小一致）
+#define ADPCM_BLOCK_ALIGN   1024          // IMA-ADPCM 块大小（字节）
+#define DEC_SCRATCH_SAMPLES 1536          // 写卡任务抽取时每次读取的样点数（6 的倍数）
+#define ENC_OUT_SIZE        SD_WRITE_CHUNK // 压缩数据攒满多少字节写一次卡
 
+#define CHECKPOINT_INTERVAL_MS 5000       // 默认每 5 秒回填文件头并 fsync
+
+#define REC_STOP_WARN_MS    3000          // 停止时写卡任务超过此时间未完成则告警
+
+#define REC_SEGMENT_MAX_MB  3900          // 分段录音单段上限（FAT32 单文件 < 4 GB）
+#define SEG_TASK_PRIO       2             // 分段收尾任务优先级（低于写卡任务）
+#define SEG_QUEUE_LEN       4
+
+// 采集 DSP 每个 DMA 块的周期预算（64 周期/样点，240 MHz 下约 68 us / 5.3 ms）
+#define DSP_CYCLE_BUDGET    (64 * (BUFFER_SIZE / 4))
+
+// 语音门控：帧 = 一个 DMA 块
+#define VAD_FRAME_SAMPLES   (BUFFER_SIZE / 4)
+#define VAD_FRAME_US        (VAD_FRAME_SAMPLES * 1000000 / SAMPLE_RATE_HZ)
+#define VAD_ONSET_MS        200           // 语音开始前补写的静音时长
+#define VAD_HANGOVER_MS     400           // 语音结束后继续写入的时长
+#define VAD_ONSET_FRAMES    ((VAD_ONSET_MS * 1000 + VAD_FRAME_US - 1) / VAD_FRAME_US)
+#define VAD_HANGOVER_FRAMES ((VAD_HANGOVER_MS * 1000 + VAD_FRAME_US - 1) / VAD_FRAME_US)
+
+#define CAPTURE_TASK_CORE   1             // 采集任务所在核心
+#define WRITER_TASK_CORE    0             // 写卡任务所在核心
+
+
+//--------------------------------------------------------
+// 录音文件格式
+//--------------------------------------------------------
+typedef enum {
+    REC_FORMAT_PCM16 = 0,        // 16-bit PCM WAV
+    REC_FORMAT_IMA_ADPCM,        // IMA-ADPCM WAV（4 bit，约为 PCM 的 1/4）
+    REC_FORMAT_LOSSLESS,         // 无损压缩（固定预测 + Rice，私有格式标签）
+} rec_format_t;
+
+//--------------------------------------------------------
+// 录音档位：麦克风始终 48 kHz 采集，写入前按档位抽取
+//--------------------------------------------------------
+typedef enum {
+    REC_PROFILE_48K = 0,         // 48 kHz 原始采样
+    REC_PROFILE_16K,             // 语音 16 kHz（÷3）
+    REC_PROFILE_8K,              // 语音 8 kHz（÷6）
+} rec_profile_t;
+
+//--------------------------------------------------------
+// 录音会话状态
+//
+// IDLE ──start──▶ RECORDING ──stop──▶ STOPPING ──文件收尾完成──▶ IDLE
+// 只有 IDLE 可以开始新录音；stop 返回时已回到 IDLE，可立即再次 start
+//--------------------------------------------------------
+typedef enum {
+    REC_STATE_IDLE = 0,
+    REC_STATE_RECORDING,
+    REC_STATE_STOPPING,
+} rec_state_t;
+
+// 任务间同步事件位（rec->events）
+#define REC_EVT_CAPTURE_LIVE  (1 << 0) // 采集任务已进入录音状态（不再丢弃旧数据）
+#define REC_EVT_CAPTURE_DONE  (1 << 1) // 本段录音的采集已结束
+#define REC_EVT_WRITER_DONE   (1 << 2) // 写卡任务已把缓冲区写空并退出
+#define REC_EVT_CAPTURE_EXIT  (1 << 3) // 采集任务已退出（或未运行）
+#define REC_EVT_IDLE          (1 << 4) // 会话已回到 IDLE
+#define REC_EVT_SEG_IDLE      (1 << 5) // 分段收尾任务没有待处理的工作
+#define REC_EVT_SEG_NEXT      (1 << 6) // 下一段文件已由收尾任务打开（rec->seg_next 可用）
+#define REC_EVT_DATA          (1 << 7) // 环形缓冲区攒够一个写卡单元（采集任务置位，写卡任务清除）
+
+// 电平快照：高 16 位峰值，低 16 位 RMS（16 bit 满幅 32767）
+#define REC_LEVEL_PACK(peak, rms)  (((uint32_t)(peak) << 16) | ((rms) & 0xFFFF))
+#define REC_LEVEL_PEAK(level)      ((uint16_t)((level) >> 16))
+#define REC_LEVEL_RMS(level)       ((uint16_t)((level) & 0xFFFF))
+
+//--------------------------------------------------------
+// 写卡统计
+//--------------------------------------------------------
+typedef struct {
+    uint32_t overruns;           // 环形缓冲区满而丢弃的 DMA 块数
+    uint32_t dropped_bytes;      // 丢弃的 PCM 字节数
+    uint32_t high_water;         // 环形缓冲区最高占用（字节）
+    uint32_t write_count;        // 写入次数
+    uint32_t write_last_us;      // 最近一次写入耗时（含落盘）
+    uint32_t write_max_us;       // 最大写入耗时
+    uint64_t write_total_us;     // 写入总耗时
+    uint32_t checkpoint_count;   // 检查点次数
+    uint32_t checkpoint_max_us;  // 单次检查点最大耗时
+    uint64_t checkpoint_total_us;// 检查点总耗时
+    uint32_t prealloc_grows;     // 预分配区扩展次数
+    uint32_t preroll_committed;  // 录音开始时写入文件的预录字节数（48 kHz）
+    uint32_t capture_blocks;     // 采集任务处理的 DMA 块数
+    uint64_t capture_busy_us;    // 采集任务处理耗时（不含等待 I2S）
+    uint32_t dsp_cycles_max;     // 采集 DSP 单块最大周期数
+    uint64_t dsp_cycles_total;   // 采集 DSP 总周期数
+    uint32_t dsp_over_budget;    // 超出 DSP_CYCLE_BUDGET 的块数
+    uint32_t captured_bytes;     // 录音期间采集的字节数（48 kHz）
+    uint32_t vad_skipped_bytes;  // 语音门控跳过的字节数（48 kHz）
+    uint32_t vad_cycles_max;     // VAD 单帧最大周期数
+    uint64_t vad_cycles_total;   // VAD 总周期数
+    uint32_t stop_us;            // 停止录音耗时（调用到文件关闭）
+    uint32_t segments;           // 分段数
+    uint32_t segment_late_opens; // 切换时下一段尚未预先打开、由写卡任务自己打开的次数
+    uint32_t segment_switch_max_us; // 写卡任务切换分段的最大耗时
+} inmp441_rec_stats_t;
+
+//--------------------------------------------------------
+// 分段录音中一段文件的状态：写完的段交给收尾任务回填文件头并关闭，
+// 收尾任务同时预先打开下一段，写卡任务切换时只需交换结构体
+//--------------------------------------------------------
+typedef struct {
+    sd_direct_file_t file;
+    peak_writer_t peaks;
+    uint32_t samples;            // 本段样点数
+    uint16_t index;              // 段序号
+    char path[128];
+} rec_segment_t;
 
 //--------------------------------------------------------
 // 录音器结构体定义
 //--------------------------------------------------------
 typedef struct {
     i2s_chan_handle_t rx_chan;   // I2S 接收通道句柄
-    FILE *file;                  // 当前 WAV 文件
-    bool is_recording;           // 是否正在录音
+    sd_direct_file_t file;       // 当前 WAV 文件（簇对齐直写）
+    volatile rec_state_t state;  // 会话状态
+    volatile bool is_recording;  // 采集任务是否为本段录音生产数据
     char filepath[128];          // 文件路径
+    rec_format_t format;         // 录音格式
+    rec_profile_t profile;       // 本次录音档位
+    uint32_t sample_rate;        // 写入文件的采样率
+    decimator_t decim;           // 采集路径中的抽取滤波器
+    capture_dsp_t dsp;           // 去直流 + AGC / 限幅
+    bool dsp_enabled;
+    vad_t vad;                   // 语音活动检测
+    bool vad_enabled;
+    uint32_t vad_auto_stop_s;    // 静音自动停止秒数（0 表示关闭）
+    volatile bool auto_stopped;  // 本段录音因静音自动停止
+    int16_t *onset_buf;          // 起音缓冲区（VAD_ONSET_FRAMES 帧）
+    uint16_t onset_len[VAD_ONSET_FRAMES];
+    uint16_t onset_head;
+    uint16_t onset_count;
+    uint32_t silent_samples;     // 连续静音样点数
+    peak_writer_t peaks;         // 波形峰值旁路文件
+    bool peaks_enabled;
+    uint32_t level;              // 电平快照（REC_LEVEL_PACK），采集任务原子写
+    uint32_t data_offset;        // data 块数据起始位置
+    uint32_t fact_offset;        // fact 样点数字段位置（0 表示无）
+    uint32_t samples_written;    // 已写入的样点数
+    uint32_t prealloc_seconds;   // 预分配时长（0 表示关闭）
+    uint32_t checkpoint_ms;      // 检查点间隔（0 表示关闭）
+
+    uint32_t segment_minutes;    // 分段时长设置（0 表示不按时长分段）
+    uint32_t segment_mb;         // 分段大小设置（0 表示不按大小分段）
+    uint32_t seg_samples;        // 本次录音每段样点上限（0 表示不限）
+    uint32_t seg_bytes;          // 本次录音每段字节上限（0 表示不分段）
+    uint16_t seg_index;          // 当前段序号
+    char seg_base[112];          // 分段文件名前缀（不含扩展名，留出 "_000.wav"）
+    rec_segment_t seg_next;      // 收尾任务预先打开的下一段
+    QueueHandle_t seg_queue;     // 写卡任务 → 收尾任务
+    TaskHandle_t seg_task;
+    volatile uint32_t seg_pending; // 已提交未完成的收尾工作数
+
+    ring_buffer_t ring;          // 采集任务 → 写卡任务（48 kHz PCM）
+    uint8_t *ring_storage;       // 环形缓冲区存储（首次录音时分配）
+    bool ring_in_psram;
+    bool rx_enabled;             // I2S 接收通道是否已开启
+    uint32_t preroll_bytes;      // 预录长度（0 表示关闭）
+    TaskHandle_t capture_task;
+    TaskHandle_t writer_task;    // 写卡任务（退出时自己清空；其他任务不向它发通知，只看 REC_EVT_* 事件位）
+    volatile bool capture_running; // 采集任务存活
+    EventGroupHandle_t events;   // REC_EVT_* 事件位
+
+    ima_adpcm_state_t adpcm;     // ADPCM 编码器状态
+    int16_t *enc_pcm;            // 编码输入（一块 PCM）
+    uint8_t *enc_out;            // 编码输出暂存
+    int16_t *dec_in;             // 抽取输入暂存
+    uint32_t enc_out_len;
+    inmp441_rec_stats_t stats;
 } inmp441_recorder_t;
 
+// 设置项的默认值，录音实例静态初始化时使用；inmp441_init 不碰这些字段，
+// 初始化之前调用 inmp441_set_* 设置的值不会被覆盖
+#define INMP441_RECORDER_DEFAULTS { \
+    .checkpoint_ms = CHECKPOINT_INTERVAL_MS, \
+    .dsp_enabled = true, \
+    .peaks_enabled = true, \
+}
+
 //--------------------------------------------------------
 // 函数声明
 //--------------------------------------------------------
@@ -39,12 +230,49 @@ typedef struct {
 // 初始化 I2S + 麦克风通道
 esp_err_t inmp441_init(inmp441_recorder_t *rec);
 
-// 启动录音任务（异步）
-esp_err_t inmp441_start_record(inmp441_recorder_t *rec, const char *filename);
+// 启动录音任务（异步），profile 决定写入文件的采样率
+esp_err_t inmp441_start_record(inmp441_recorder_t *rec, const char *filename, rec_profile_t profile);
 
 // 停止录音任务并保存文件
 void inmp441_stop_record(inmp441_recorder_t *rec);
 
+// 开启预录：I2S 常开，录音开始时先写入最近 ms 毫秒的音频
+esp_err_t inmp441_preroll_enable(inmp441_recorder_t *rec, uint32_t ms);
+
+// 关闭预录
+void inmp441_preroll_disable(inmp441_recorder_t *rec);
+
+// 设置录音格式（录音中不可修改）
+esp_err_t inmp441_set_format(inmp441_recorder_t *rec, rec_format_t format);
+
+// 设置连续预分配时长（秒，0 为关闭，录音中不可修改）
+esp_err_t inmp441_set_prealloc(inmp441_recorder_t *rec, uint32_t seconds);
+
+// 设置检查点间隔（毫秒，0 为关闭，录音中不可修改）
+esp_err_t inmp441_set_checkpoint(inmp441_recorder_t *rec, uint32_t interval_ms);
+
+// 分段录音：每 minutes 分钟或 mb MB 换一个文件（都为 0 时不分段，录音中不可修改）
+// 文件名为 xxx_000.wav、xxx_001.wav ...，xxx.m3u 按顺序列出各段
+esp_err_t inmp441_set_segment(inmp441_recorder_t *rec, uint32_t minutes, uint32_t mb);
+
+// 开关采集 DSP（去直流 + AGC / 限幅，默认开启；录音中不可修改）
+esp_err_t inmp441_set_agc(inmp441_recorder_t *rec, bool enable);
+
+// 语音门控：跳过持续静音；auto_stop_s > 0 时静音超过该秒数自动停止（录音中不可修改）
+esp_err_t inmp441_set_vad(inmp441_recorder_t *rec, bool enable, uint32_t auto_stop_s);
+
+// 录音时同时生成波形峰值旁路文件 xxx.pk（默认开启；录音中不可修改）
+esp_err_t inmp441_set_peaks(inmp441_recorder_t *rec, bool enable);
+
+// 查询会话状态
+rec_state_t inmp441_get_state(const inmp441_recorder_t *rec);
+
+// 读取最近一个 DMA 块的电平快照（无锁，可在 LVGL 任务中调用）
+uint32_t inmp441_get_level(const inmp441_recorder_t *rec);
+
+// 读取当前（或上一次）录音的写卡统计
+void inmp441_get_stats(const inmp441_recorder_t *rec, inmp441_rec_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
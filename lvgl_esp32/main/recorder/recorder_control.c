@@ -4,47 +4,56 @@
 #include "freertos/task.h"
 #include <time.h>
 #include "esp_check.h"
+#include "esp_timer.h"
 
 static const char *TAG = "RECORDER_CTRL";
 
 // 全局录音实例（模块级单例）
-static inmp441_recorder_t s_recorder = {0};
+static inmp441_recorder_t s_recorder = INMP441_RECORDER_DEFAULTS;
 
-// 状态标志
-static bool s_is_running = false;
+// 状态标志（录音状态以 s_recorder.state 为准，静音自动停止也会回到 IDLE）
 static bool s_is_initialized = false;  // 只初始化一次 I2S
 
 
 //--------------------------------------------------------
-// 启动录音
+// 首次使用时初始化 I2S
 //--------------------------------------------------------
-void recorder_start(const char* filename)
+static bool recorder_ensure_init(void)
 {
-    if (s_is_running) {
-        ESP_LOGW(TAG, "Recorder already running");
-        return;
-    }
-
-    // ✅ 初始化一次
     if (!s_is_initialized) {
         ESP_LOGI(TAG, "Initializing INMP441...");
         esp_err_t err = inmp441_init(&s_recorder);
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Failed to init INMP441 (%s)", esp_err_to_name(err));
-            return;
+            return false;
         }
         s_is_initialized = true;
     }
+    return true;
+}
+
+//--------------------------------------------------------
+// 启动录音
+//--------------------------------------------------------
+void recorder_start(const char* filename, rec_profile_t profile)
+{
+    if (recorder_is_running()) {
+        ESP_LOGW(TAG, "Recorder already running");
+        return;
+    }
+
+    // ✅ 初始化一次
+    if (!recorder_ensure_init()) {
+        return;
+    }
 
     // ✅ 自动生成文件名（防止覆盖）
     
 
     // ✅ 启动录音任务
     ESP_LOGI(TAG, "Starting record -> %s", filename);
-    esp_err_t ret = inmp441_start_record(&s_recorder, filename);
-    if (ret == ESP_OK) {
-        s_is_running = true;
-    } else {
+    esp_err_t ret = inmp441_start_record(&s_recorder, filename, profile);
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start record (%s)", esp_err_to_name(ret));
     }
 }
@@ -54,19 +63,19 @@ void recorder_start(const char* filename)
 //--------------------------------------------------------
 void recorder_stop(void)
 {
-    if (!s_is_running) {
+    if (!s_is_initialized || inmp441_get_state(&s_recorder) == REC_STATE_IDLE) {
         ESP_LOGW(TAG, "Recorder not running");
         return;
     }
 
     ESP_LOGI(TAG, "Stopping record...");
-    inmp441_stop_record(&s_recorder);
-    s_is_running = false;
+    int64_t t0 = esp_timer_get_time();
 
-    // 等待缓冲区写完
-    vTaskDelay(pdMS_TO_TICKS(200));
+    // 返回时写卡任务已确认写完、文件已关闭，可以立即开始下一段录音
+    inmp441_stop_record(&s_recorder);
 
-    ESP_LOGI(TAG, "Record stopped and file saved");
+    ESP_LOGI(TAG, "Record stopped and file saved (%lld us)",
+             (long long)(esp_timer_get_time() - t0));
 
     // ⚙️ 可选：是否释放 I2S 资源
     // i2s_del_channel(s_recorder.rx_chan);
@@ -74,12 +83,94 @@ void recorder_stop(void)
     // s_is_initialized = false;
 }
 
+//--------------------------------------------------------
+// 选择录音格式
+//--------------------------------------------------------
+void recorder_set_format(rec_format_t format)
+{
+    inmp441_set_format(&s_recorder, format);
+}
+
+//--------------------------------------------------------
+// 预录开关（ms 为 0 时关闭）
+//--------------------------------------------------------
+void recorder_set_preroll(uint32_t ms)
+{
+    if (ms == 0) {
+        inmp441_preroll_disable(&s_recorder);
+        return;
+    }
+    if (!recorder_ensure_init()) {
+        return;
+    }
+    esp_err_t err = inmp441_preroll_enable(&s_recorder, ms);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable pre-roll (%s)", esp_err_to_name(err));
+    }
+}
+
+//--------------------------------------------------------
+// 连续预分配
+//--------------------------------------------------------
+void recorder_set_prealloc(uint32_t seconds)
+{
+    inmp441_set_prealloc(&s_recorder, seconds);
+}
+
+//--------------------------------------------------------
+// 掉电保护检查点
+//--------------------------------------------------------
+void recorder_set_checkpoint(uint32_t interval_ms)
+{
+    inmp441_set_checkpoint(&s_recorder, interval_ms);
+}
+
+//--------------------------------------------------------
+// 分段录音
+//--------------------------------------------------------
+void recorder_set_segment(uint32_t minutes, uint32_t mb)
+{
+    inmp441_set_segment(&s_recorder, minutes, mb);
+}
+
+//--------------------------------------------------------
+// 自动增益
+//--------------------------------------------------------
+void recorder_set_agc(bool enable)
+{
+    inmp441_set_agc(&s_recorder, enable);
+}
+
+//--------------------------------------------------------
+// 语音门控
+//--------------------------------------------------------
+void recorder_set_vad(bool enable, uint32_t auto_stop_s)
+{
+    inmp441_set_vad(&s_recorder, enable, auto_stop_s);
+}
+
+//--------------------------------------------------------
+// 波形峰值旁路文件
+//--------------------------------------------------------
+void recorder_set_peaks(bool enable)
+{
+    inmp441_set_peaks(&s_recorder, enable);
+}
+
+//--------------------------------------------------------
+// 电平快照（供 UI 电平表读取）
+//--------------------------------------------------------
+uint32_t recorder_get_level(void)
+{
+    return inmp441_get_level(&s_recorder);
+}
+
 //--------------------------------------------------------
 // 查询录音状态
 //--------------------------------------------------------
 bool recorder_is_running(void)
 {
-    return s_is_running;
+    return s_is_initialized && inmp441_get_state(&s_recorder) != REC_STATE_IDLE;
 }
 
 //--------------------------------------------------------
@@ -87,11 +178,11 @@ bool recorder_is_running(void)
 //--------------------------------------------------------
 void recorder_deinit(void)
 {
+    inmp441_preroll_disable(&s_recorder);
     if (s_recorder.rx_chan) {
         i2s_del_channel(s_recorder.rx_chan);
         s_recorder.rx_chan = NULL;
     }
     s_is_initialized = false;
-    s_is_running = false;
     ESP_LOGI(TAG, "Recorder deinitialized");
 }
@@ -8,13 +8,40 @@
 extern "C" {
 #endif
 
-// 启动录音
-void recorder_start(const char* filename) ;
+// 启动录音，profile 选择写入文件的采样率
+void recorder_start(const char* filename, rec_profile_t profile);
+
+// 选择录音格式（下一次录音生效）
+void recorder_set_format(rec_format_t format);
+
+// 预录：保持麦克风常开，录音开始时先写入最近 ms 毫秒（0 为关闭）
+void recorder_set_preroll(uint32_t ms);
+
+// 按预计时长（秒）预分配连续文件空间，避免录音中 FAT 分配卡顿（0 为关闭）
+void recorder_set_prealloc(uint32_t seconds);
+
+// 设置掉电保护检查点间隔（毫秒，0 为关闭）
+void recorder_set_checkpoint(uint32_t interval_ms);
+
+// 分段录音：每 minutes 分钟或 mb MB 换一个文件，xxx.m3u 列出各段（都为 0 关闭）
+void recorder_set_segment(uint32_t minutes, uint32_t mb);
+
+// 开关自动增益（去直流 + AGC / 限幅）
+void recorder_set_agc(bool enable);
+
+// 语音门控：不写持续静音；auto_stop_s > 0 时静音超过该秒数自动停止
+void recorder_set_vad(bool enable, uint32_t auto_stop_s);
+
+// 录音时同时生成波形峰值旁路文件 xxx.pk（默认开启）
+void recorder_set_peaks(bool enable);
+
+// 最近一个 DMA 块的峰值 / RMS（REC_LEVEL_PEAK / REC_LEVEL_RMS 解包，无锁）
+uint32_t recorder_get_level(void);
 
 // 停止录音
 void recorder_stop(void);
 
-// 查询录音是否正在进行
+// 查询录音是否正在进行（静音自动停止后返回 false）
 bool recorder_is_running(void);
 
 // （可选）彻底释放 I2S 通道资源
@@ -0,0 +1,92 @@
+#include "ring_buffer.h"
+#include <string.h>
+
+// 生产者发布 head / 消费者发布 tail 时使用 release，
+// 对端读取时使用 acquire，保证数据拷贝先于索引可见。
+#define LOAD_ACQ(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LOAD_RLX(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STORE_REL(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint32_t size)
+{
+    if (!rb || !storage || size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    rb->buf  = storage;
+    rb->size = size;
+    rb->mask = size - 1;
+    rb->head = 0;
+    rb->tail = 0;
+    return true;
+}
+
+void ring_buffer_reset(ring_buffer_t *rb)
+{
+    STORE_REL(&rb->head, 0);
+    STORE_REL(&rb->tail, 0);
+}
+
+uint32_t ring_buffer_used(const ring_buffer_t *rb)
+{
+    return LOAD_ACQ(&rb->head) - LOAD_ACQ(&rb->tail);
+}
+
+uint32_t ring_buffer_free(const ring_buffer_t *rb)
+{
+    return rb->size - ring_buffer_used(rb);
+}
+
+bool ring_buffer_write(ring_buffer_t *rb, const void *data, uint32_t len)
+{
+    uint32_t head = LOAD_RLX(&rb->head);
+    uint32_t tail = LOAD_ACQ(&rb->tail);
+
+    if (rb->size - (head - tail) < len) {
+        return false;
+    }
+
+    uint32_t off   = head & rb->mask;
+    uint32_t first = rb->size - off;
+    if (first > len) first = len;
+
+    memcpy(rb->buf + off, data, first);
+    memcpy(rb->buf, (const uint8_t *)data + first, len - first);
+
+    STORE_REL(&rb->head, head + len);
+    return true;
+}
+
+uint32_t ring_buffer_read(ring_buffer_t *rb, void *out, uint32_t max_len)
+{
+    uint32_t tail = LOAD_RLX(&rb->tail);
+    uint32_t head = LOAD_ACQ(&rb->head);
+    uint32_t len  = head - tail;
+    if (len > max_len) len = max_len;
+
+    uint32_t off   = tail & rb->mask;
+    uint32_t first = rb->size - off;
+    if (first > len) first = len;
+
+    memcpy(out, rb->buf + off, first);
+    memcpy((uint8_t *)out + first, rb->buf, len - first);
+
+    STORE_REL(&rb->tail, tail + len);
+    return len;
+}
+
+uint32_t ring_buffer_peek(const ring_buffer_t *rb, const uint8_t **ptr)
+{
+    uint32_t tail = LOAD_RLX(&rb->tail);
+    uint32_t head = LOAD_ACQ(&rb->head);
+    uint32_t used = head - tail;
+    uint32_t off  = tail & rb->mask;
+    uint32_t contig = rb->size - off;
+
+    *ptr = rb->buf + off;
+    return used < contig ? used : contig;
+}
+
+void ring_buffer_consume(ring_buffer_t *rb, uint32_t len)
+{
+    STORE_REL(&rb->tail, LOAD_RLX(&rb->tail) + len);
+}
@@ -0,0 +1,53 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 单生产者 / 单消费者无锁环形缓冲区
+//
+// - 只允许一个任务写入（生产者）、一个任务读取（消费者）
+// - head 只由生产者修改，tail 只由消费者修改，无需互斥锁
+// - 容量必须是 2 的幂，索引自由递增，用掩码取模
+// - 存储区由调用方提供（可放在 PSRAM）
+//--------------------------------------------------------
+typedef struct {
+    uint8_t *buf;                 // 存储区
+    uint32_t size;                // 容量（字节，2 的幂）
+    uint32_t mask;                // size - 1
+    volatile uint32_t head;       // 写索引（生产者）
+    volatile uint32_t tail;       // 读索引（消费者）
+} ring_buffer_t;
+
+// 初始化；size 不是 2 的幂时返回 false
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint32_t size);
+
+// 清空（仅在生产者和消费者都停止时调用）
+void ring_buffer_reset(ring_buffer_t *rb);
+
+// 当前已占用 / 剩余空间（字节）
+uint32_t ring_buffer_used(const ring_buffer_t *rb);
+uint32_t ring_buffer_free(const ring_buffer_t *rb);
+
+// 生产者：整块写入，空间不足时不写入任何数据并返回 false
+bool ring_buffer_write(ring_buffer_t *rb, const void *data, uint32_t len);
+
+// 消费者：拷贝读取最多 max_len 字节，返回实际读取字节数
+uint32_t ring_buffer_read(ring_buffer_t *rb, void *out, uint32_t max_len);
+
+// 消费者：零拷贝读取，返回从 *ptr 开始的连续可读字节数
+uint32_t ring_buffer_peek(const ring_buffer_t *rb, const uint8_t **ptr);
+
+// 消费者：释放 peek 得到的 len 字节
+void ring_buffer_consume(ring_buffer_t *rb, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_BUFFER_H */
@@ -0,0 +1,74 @@
+#include "vad.h"
+#include <string.h>
+
+#define ENERGY_SMOOTH_SHIFT 1        // 帧能量平滑：约 2 帧
+#define NOISE_RISE_SHIFT  8          // 噪声底上升：约 256 帧
+#define NOISE_FALL_SHIFT  3          // 噪声底下降：约 8 帧
+#define NOISE_HOLD_SHIFT  11         // 语音期间慢升（约 2048 帧），持续的新噪声几秒内被吸收
+
+void vad_init(vad_t *v, uint16_t hangover_frames)
+{
+    memset(v, 0, sizeof(*v));
+    v->hangover = hangover_frames;
+    // 从很低的噪声底开始：录音开头的声音一律保留，噪声底在约 1 秒内升到实际水平
+    v->noise = VAD_MIN_ENERGY;
+}
+
+bool vad_process(vad_t *v, const int16_t *pcm, size_t n)
+{
+    if (n == 0) return v->hang_left > 0;
+
+    uint32_t acc = 0;
+    uint32_t zc = 0;
+    int32_t prev = v->last;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = pcm[i];
+        acc += (uint32_t)(s * s) >> 8;
+        zc += (uint32_t)((s ^ prev) < 0);
+        prev = s;
+    }
+    v->last = (int16_t)prev;
+
+    uint32_t raw = acc / n;
+    uint32_t zcr = (zc << 8) / n;
+    v->energy = raw;
+    v->zcr_q8 = zcr;
+
+    // 判定和噪声底都用平滑后的能量：逐帧判定时低频噪声的能量起伏超过 9 dB，
+    // 噪声底贴着谷底走，峰值帧不断触发，阶跃后的稳定噪声永远不会被吸收
+    if (raw >= v->smooth) {
+        v->smooth += (raw - v->smooth) >> ENERGY_SMOOTH_SHIFT;
+    } else {
+        v->smooth -= (v->smooth - raw) >> ENERGY_SMOOTH_SHIFT;
+    }
+    uint32_t e = v->smooth;
+
+    bool speech = false;
+    if (e > VAD_MIN_ENERGY) {
+        uint64_t floor = v->noise;
+        if ((uint64_t)e > floor << VAD_LOUD_SHIFT) {
+            speech = true;
+        } else if ((uint64_t)e > floor << VAD_SNR_SHIFT && zcr < VAD_ZCR_MAX_Q8) {
+            speech = true;
+        }
+    }
+
+    // 噪声底：快降慢升，语音及挂起期间上升更慢
+    if (e < v->noise) {
+        v->noise -= (v->noise - e) >> NOISE_FALL_SHIFT;
+    } else {
+        bool hold = speech || v->hang_left > 0;
+        v->noise += ((e - v->noise) >> (hold ? NOISE_HOLD_SHIFT : NOISE_RISE_SHIFT)) + 1;
+    }
+
+    if (speech) {
+        v->hang_left = v->hangover;
+        return true;
+    }
+    if (v->hang_left > 0) {
+        v->hang_left--;
+        return true;
+    }
+    return false;
+}
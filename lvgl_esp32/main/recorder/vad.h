@@ -0,0 +1,48 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 能量 + 过零率语音活动检测（逐 DMA 帧判定）
+//
+// - 能量：帧均方值做两帧平滑后与自适应噪声底比较（噪声底快降慢升）；
+//   平滑去掉低频噪声逐帧能量的起伏，噪声底不会贴着起伏的谷底走
+// - 新出现的稳定声音（噪声阶跃）约 2 ~ 3.5 秒后被噪声底吸收，与电平无关；
+//   代价是没有停顿的持续元音 / 长音也在约 1.5 秒后开始被当作噪声
+// - 过零率：宽带噪声过零率高，能量只略高于噪声底时要求过零率较低
+// - 挂起：语音结束后保持 hangover 帧仍判为有声，避免切掉词尾
+//--------------------------------------------------------
+
+#define VAD_SNR_SHIFT       3        // 能量超过噪声底 8 倍（约 9 dB）判为语音
+#define VAD_LOUD_SHIFT      5        // 超过 32 倍时不看过零率（清辅音）
+#define VAD_ZCR_MAX_Q8      64       // 过零率上限（每样点 0.25，Q8）
+#define VAD_MIN_ENERGY      64       // 绝对能量下限（16 bit 域均方 / 256）
+
+typedef struct {
+    uint32_t noise;                  // 噪声底（均方 / 256）
+    uint32_t energy;                 // 最近一帧能量
+    uint32_t smooth;                 // 两帧平滑后的能量（判定和噪声底都用它）
+    uint32_t zcr_q8;                 // 最近一帧过零率（Q8）
+    uint16_t hangover;               // 挂起帧数
+    uint16_t hang_left;              // 剩余挂起帧数
+    int16_t last;                    // 上一帧最后一个样点（跨帧过零）
+} vad_t;
+
+// 初始化；hangover_frames 为语音结束后继续判为有声的帧数
+void vad_init(vad_t *v, uint16_t hangover_frames);
+
+// 判定一帧，返回 true 表示语音（含挂起）
+bool vad_process(vad_t *v, const int16_t *pcm, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VAD_H */
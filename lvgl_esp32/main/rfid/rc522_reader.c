@@ -80,10 +80,16 @@ static void on_picc_state_changed(void *arg, esp_event_base_t base, int32_t even
             snprintf(&uid_hex[i * 2], sizeof(uid_hex) - i * 2, "%02X", picc->uid.value[i]);
         }
 
-        char filepath[128];
-        snprintf(filepath, sizeof(filepath), "/sdcard/%s.wav", uid_hex);
         set_var_rfid_uid(uid_hex);
 
+        // 刷卡提示音（播放器未初始化时忽略）
+        wav_player_beep(PLAYER_BEEP_CARD);
+
+        // 卡片对应的播放列表：<UID>.m3u、<UID>/ 目录或 <UID>.wav（播放器未初始化时忽略）
+        if (wav_player_play_card(uid_hex) != ESP_OK) {
+            ESP_LOGD("RFID", "卡片 %s 没有可播放的内容", uid_hex);
+        }
+
 
 
         // ESP_LOGI("RFID", "检测到卡片了");
@@ -0,0 +1,285 @@
+#include "sd_direct.h"
+#include "sdcard.h"
+#include "diskio_sdmmc.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "SD_DIRECT";
+
+//--------------------------------------------------------
+// VFS 路径（/sdcard/xxx）→ FatFs 路径（<pdrv>:/xxx）
+//--------------------------------------------------------
+static void to_fatfs_path(const char *path, char *out, size_t out_len)
+{
+    size_t mp_len = strlen(SD_MOUNT_POINT);
+    if (strncmp(path, SD_MOUNT_POINT, mp_len) == 0) {
+        path += mp_len;
+    }
+    snprintf(out, out_len, "%u:%s%s", (unsigned)ff_diskio_get_pdrv_card(card),
+             path[0] == '/' ? "" : "/", path);
+}
+
+//--------------------------------------------------------
+// 卷的簇大小（字节），不超过 SD_DIRECT_MAX_CHUNK
+//--------------------------------------------------------
+static uint32_t volume_chunk(const FIL *fil)
+{
+#if FF_MAX_SS != FF_MIN_SS
+    uint32_t cluster = (uint32_t)fil->obj.fs->csize * fil->obj.fs->ssize;
+#else
+    uint32_t cluster = (uint32_t)fil->obj.fs->csize * FF_MAX_SS;
+#endif
+    return cluster < SD_DIRECT_MAX_CHUNK ? cluster : SD_DIRECT_MAX_CHUNK;
+}
+
+//--------------------------------------------------------
+// 把缓冲区写到当前文件位置（除最后一次和同步外都是整块、按块对齐，不跨簇）
+// 返回后文件位置在写入数据之后
+//--------------------------------------------------------
+static esp_err_t write_buf(sd_direct_file_t *f)
+{
+    FSIZE_t at = f_tell(&f->fil);
+    FRESULT fr;
+
+    // 预分配区不够：lseek 到更远处让 FatFs 一次性挂上一大段簇，再回到写入位置
+    if (f->alloc_end && at + f->buf_len > f->alloc_end) {
+        uint32_t new_end = f->alloc_end + SD_DIRECT_GROW_BYTES;
+        fr = f_lseek(&f->fil, new_end);
+        if (fr == FR_OK && f_tell(&f->fil) == new_end) {
+            f->alloc_end = new_end;
+            f->grows++;
+        } else {
+            ESP_LOGW(TAG, "Extent grow failed (%d)", fr);
+        }
+        f_lseek(&f->fil, at);
+    }
+
+    UINT bw = 0;
+    fr = f_write(&f->fil, f->buf, f->buf_len, &bw);
+    if (fr != FR_OK || bw != f->buf_len) {
+        // 只写出一部分：写入位置退回缓冲区开头，缓冲区原样保留，
+        // 重试时整块重写到原位置，已写出的 bw 字节不会在文件里重复一遍
+        ESP_LOGE(TAG, "f_write failed (%d, %u/%lu)", fr, bw, (unsigned long)f->buf_len);
+        if (bw > 0 && (f_lseek(&f->fil, at) != FR_OK || f_tell(&f->fil) != at)) {
+            ESP_LOGE(TAG, "seek back to %lu failed", (unsigned long)at);
+        }
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t flush_buf(sd_direct_file_t *f)
+{
+    if (f->buf_len == 0) return ESP_OK;
+    ESP_RETURN_ON_ERROR(write_buf(f), TAG, "flush failed");
+    f->buf_len = 0;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 打开
+//--------------------------------------------------------
+esp_err_t sd_direct_open(sd_direct_file_t *f, const char *path, uint32_t prealloc_bytes)
+{
+    char fpath[140];
+
+    memset(f, 0, sizeof(*f));
+    to_fatfs_path(path, fpath, sizeof(fpath));
+    FRESULT fr = f_open(&f->fil, fpath, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK) {
+        ESP_LOGE(TAG, "f_open %s failed (%d)", fpath, fr);
+        return ESP_FAIL;
+    }
+
+    // 缓冲区按卷的簇大小分配；内存不够时减半，仍是簇大小的约数
+    f->chunk = volume_chunk(&f->fil);
+    while (true) {
+        f->buf = heap_caps_aligned_alloc(32, f->chunk, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (f->buf || f->chunk <= SD_DIRECT_MIN_CHUNK) break;
+        f->chunk /= 2;
+    }
+    if (!f->buf) {
+        ESP_LOGE(TAG, "no DMA memory for write buffer");
+        f_close(&f->fil);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (prealloc_bytes > 0) {
+        uint32_t size = (prealloc_bytes + f->chunk - 1) & ~(f->chunk - 1);
+        int64_t t0 = esp_timer_get_time();
+        fr = f_expand(&f->fil, size, 1);
+        if (fr == FR_OK) {
+            f->alloc_end = size;
+            ESP_LOGI(TAG, "Pre-allocated %lu contiguous bytes in %lld us",
+                     (unsigned long)size, (long long)(esp_timer_get_time() - t0));
+        } else {
+            // 没有足够的连续空间：文件仍为空，按普通方式写
+            ESP_LOGW(TAG, "f_expand failed (%d), falling back", fr);
+        }
+    }
+
+    f->is_open = true;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 顺序写入
+//--------------------------------------------------------
+esp_err_t sd_direct_write(sd_direct_file_t *f, const void *data, uint32_t len)
+{
+    const uint8_t *src = data;
+
+    while (len > 0) {
+        uint32_t n = f->chunk - f->buf_len;
+        if (n > len) n = len;
+        memcpy(f->buf + f->buf_len, src, n);
+        f->buf_len += n;
+        f->pos += n;
+        src += n;
+        len -= n;
+
+        if (f->buf_len == f->chunk) {
+            ESP_RETURN_ON_ERROR(flush_buf(f), TAG, "write failed");
+        }
+    }
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 回写：已落盘部分 seek 写入，仍在缓冲区的部分直接改缓冲区
+//--------------------------------------------------------
+esp_err_t sd_direct_pwrite(sd_direct_file_t *f, uint32_t offset, const void *data, uint32_t len)
+{
+    const uint8_t *src = data;
+    uint32_t flushed = f->pos - f->buf_len;
+
+    ESP_RETURN_ON_FALSE(offset + len <= f->pos, ESP_ERR_INVALID_ARG, TAG, "pwrite past end");
+
+    if (offset < flushed) {
+        uint32_t n = flushed - offset;
+        if (n > len) n = len;
+        FRESULT fr = f_lseek(&f->fil, offset);
+        // 只写出一部分：跳过已写出的字节，剩下的接着写，直到写完或不再前进
+        while (fr == FR_OK && n > 0) {
+            UINT bw = 0;
+            fr = f_write(&f->fil, src, n, &bw);
+            if (bw == 0) break;
+            offset += bw;
+            src += bw;
+            len -= bw;
+            n -= bw;
+        }
+        f_lseek(&f->fil, flushed);
+        if (fr != FR_OK || n > 0) {
+            ESP_LOGE(TAG, "pwrite failed (%d, %lu bytes left)", fr, (unsigned long)n);
+            return ESP_FAIL;
+        }
+    }
+    if (len > 0) {
+        memcpy(f->buf + (offset - flushed), src, len);
+    }
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 同步：未满的缓冲区先写到卡上但保留在内存中，写入位置退回，
+// 之后攒满时整块重写，后续写入仍保持对齐
+//--------------------------------------------------------
+esp_err_t sd_direct_sync(sd_direct_file_t *f)
+{
+    if (f->buf_len > 0) {
+        FSIZE_t at = f_tell(&f->fil);
+        ESP_RETURN_ON_ERROR(write_buf(f), TAG, "sync write failed");
+        f_lseek(&f->fil, at);
+    }
+
+    // 预分配的文件在目录项里仍是分配长度，掉电后以文件头中的长度为准
+    FRESULT fr = f_sync(&f->fil);
+    if (fr != FR_OK) {
+        ESP_LOGE(TAG, "f_sync failed (%d)", fr);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 关闭
+//--------------------------------------------------------
+esp_err_t sd_direct_close(sd_direct_file_t *f)
+{
+    if (!f->is_open) return ESP_OK;
+
+    esp_err_t err = flush_buf(f);
+
+    // 预分配（或扩展）过的文件截断到实际长度
+    if (f->alloc_end && f_truncate(&f->fil) != FR_OK) {
+        ESP_LOGE(TAG, "f_truncate failed");
+        err = ESP_FAIL;
+    }
+    if (f_close(&f->fil) != FR_OK) {
+        err = ESP_FAIL;
+    }
+
+    heap_caps_free(f->buf);
+    f->buf = NULL;
+    f->is_open = false;
+    return err;
+}
+
+//--------------------------------------------------------
+// 吞吐量对比：stdio fwrite vs 直写（应用侧都以 4 KB 为单位写入）
+//--------------------------------------------------------
+#define BENCH_UNIT 4096
+
+void sd_direct_benchmark(const char *path, uint32_t total_bytes)
+{
+    uint8_t *pattern = heap_caps_malloc(BENCH_UNIT, MALLOC_CAP_8BIT);
+    if (!pattern) return;
+    for (int i = 0; i < BENCH_UNIT; i++) {
+        pattern[i] = (uint8_t)i;
+    }
+
+    // stdio
+    FILE *fp = fopen(path, "wb");
+    if (fp) {
+        uint32_t max_us = 0;
+        int64_t t0 = esp_timer_get_time();
+        for (uint32_t done = 0; done < total_bytes; done += BENCH_UNIT) {
+            int64_t t1 = esp_timer_get_time();
+            fwrite(pattern, 1, BENCH_UNIT, fp);
+            uint32_t dt = (uint32_t)(esp_timer_get_time() - t1);
+            if (dt > max_us) max_us = dt;
+        }
+        fclose(fp);
+        int64_t us = esp_timer_get_time() - t0 + 1;
+        ESP_LOGI(TAG, "stdio : %lu KB in %lld ms, %lu KB/s, max write %lu us",
+                 (unsigned long)(total_bytes / 1024), (long long)(us / 1000),
+                 (unsigned long)((uint64_t)total_bytes * 1000000 / 1024 / us), (unsigned long)max_us);
+    }
+    remove(path);
+
+    // 直写
+    sd_direct_file_t f;
+    if (sd_direct_open(&f, path, 0) == ESP_OK) {
+        uint32_t max_us = 0;
+        int64_t t0 = esp_timer_get_time();
+        for (uint32_t done = 0; done < total_bytes; done += BENCH_UNIT) {
+            int64_t t1 = esp_timer_get_time();
+            sd_direct_write(&f, pattern, BENCH_UNIT);
+            uint32_t dt = (uint32_t)(esp_timer_get_time() - t1);
+            if (dt > max_us) max_us = dt;
+        }
+        sd_direct_close(&f);
+        int64_t us = esp_timer_get_time() - t0 + 1;
+        ESP_LOGI(TAG, "direct: %lu KB in %lld ms, %lu KB/s, max write %lu us",
+                 (unsigned long)(total_bytes / 1024), (long long)(us / 1000),
+                 (unsigned long)((uint64_t)total_bytes * 1000000 / 1024 / us), (unsigned long)max_us);
+    }
+    remove(path);
+
+    heap_caps_free(pattern);
+}
@@ -0,0 +1,62 @@
+#ifndef SD_DIRECT_H
+#define SD_DIRECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 直写 FatFs 的顺序写文件（绕过 newlib stdio）
+//
+// - 数据先攒进一个 DMA 可用的对齐缓冲区，攒满后一次 f_write，FatFs 直接把整块
+//   交给 SDMMC 多块写。缓冲区大小取打开文件时挂载的卷的实际簇大小（卡可能是
+//   电脑格式化的，簇大小不一定是 SD_ALLOC_UNIT_SIZE），超过 SD_DIRECT_MAX_CHUNK
+//   时取上限；簇大小是 2 的幂，所以文件位置始终按块对齐，整块写入不会跨簇
+// - 可选 f_expand 预分配连续簇，写满后按 SD_DIRECT_GROW_BYTES 扩展，
+//   关闭时截断到实际长度
+// - 同一时间只能由一个任务使用
+//--------------------------------------------------------
+#define SD_DIRECT_MAX_CHUNK   (32 * 1024)          // 缓冲区上限（大簇的卷只取簇的一部分）
+#define SD_DIRECT_MIN_CHUNK   (4 * 1024)           // 内存不够时缓冲区逐次减半的下限
+#define SD_DIRECT_GROW_BYTES  (1024 * 1024)        // 预分配区写满后每次扩展的大小
+
+typedef struct {
+    FIL fil;
+    uint8_t *buf;            // DMA 对齐缓冲区（chunk 字节）
+    uint32_t chunk;          // 缓冲区大小：簇大小，或它的 2 的幂约数
+    uint32_t buf_len;        // 缓冲区中尚未写出的字节数
+    uint32_t pos;            // 逻辑写入位置（= 实际文件长度）
+    uint32_t alloc_end;      // 已分配的文件长度（0 表示未预分配）
+    uint32_t grows;          // 预分配区扩展次数
+    bool is_open;
+} sd_direct_file_t;
+
+// 创建（覆盖）文件；path 为 VFS 路径（如 "/sdcard/a.wav"）
+// prealloc_bytes > 0 时尝试预分配连续空间，失败则退回普通方式
+esp_err_t sd_direct_open(sd_direct_file_t *f, const char *path, uint32_t prealloc_bytes);
+
+// 顺序追加写入
+esp_err_t sd_direct_write(sd_direct_file_t *f, const void *data, uint32_t len);
+
+// 回写已写入范围内的数据（用于回填文件头），不改变写入位置
+esp_err_t sd_direct_pwrite(sd_direct_file_t *f, uint32_t offset, const void *data, uint32_t len);
+
+// 把已写入的数据和文件长度提交到卡上（f_sync），不破坏块对齐
+esp_err_t sd_direct_sync(sd_direct_file_t *f);
+
+// 刷出缓冲区、截断预分配部分并关闭
+esp_err_t sd_direct_close(sd_direct_file_t *f);
+
+// 吞吐量对比：分别用 stdio 与直写方式写 total_bytes 字节到 path，打印 KB/s
+void sd_direct_benchmark(const char *path, uint32_t total_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_DIRECT_H */
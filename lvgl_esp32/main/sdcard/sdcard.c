@@ -2,15 +2,21 @@
 #include <string.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
+#include <dirent.h>
+#include <strings.h>
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_vfs_fat.h"
+#include "esp_timer.h"
 #include "sdmmc_cmd.h"
 #include "driver/sdmmc_host.h"
 #include "driver/gpio.h"
 #include "pin_cfg.h"
+#include "sdcard.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
 #define TAG "SDMMC_TEST"
-#define MOUNT_POINT "/sdcard"
+#define MOUNT_POINT SD_MOUNT_POINT
 #include "esp_vfs.h"
 
 static esp_err_t write_file(const char *path, const char *data)
@@ -44,6 +50,162 @@ static esp_err_t read_file(const char *path)
 
 sdmmc_card_t *card;
 
+//--------------------------------------------------------
+// 掉电恢复：修复文件头长度与文件实际长度不符的 WAV
+//
+// 只处理本录音机写出的文件（布局与 recorder.c 的 write_wav_header 一致）：
+//   PCM：         RIFF / fmt (16) / data，data 从 44 开始
+//   ADPCM / 无损：RIFF / fmt (20, cbSize 2) / fact (4) / data，data 从 60 开始
+// 且长度字段只能是开头的 0 或检查点写入的一对自洽值，其他 WAV 一律不碰
+//
+// - RIFF 长度为 0：录音在第一次检查点之前中断，按文件长度重建
+// - RIFF 长度非 0：以最近一次检查点写入的长度为准，
+//   截掉之后的部分（预分配区里的旧数据 / 未提交的尾巴）
+// fact 样点数按实际数据重算：ADPCM 由块数推出，无损逐块读块头累加
+// 返回 true 表示做了修复
+//--------------------------------------------------------
+#define REC_PCM_DATA_POS    44
+#define REC_ENC_DATA_POS    60
+#define REC_ENC_FACT_POS    48
+
+static bool put_u32(FILE *f, uint32_t pos, uint32_t v)
+{
+    return fseek(f, pos, SEEK_SET) == 0 && fwrite(&v, 4, 1, f) == 1;
+}
+
+// 无损 data 块：从头逐块读块头，走到 limit 之前最后一个完整块为止
+// 返回 false 表示读卡出错
+static bool walk_lossless_blocks(FILE *f, uint32_t data_pos, uint32_t limit, uint32_t *end, uint32_t *samples)
+{
+    uint8_t hdr[LOSSLESS_HEADER_BYTES];
+    lossless_block_info_t info;
+    uint32_t pos = 0, n = 0;
+
+    while (pos + LOSSLESS_HEADER_BYTES <= limit) {
+        if (fseek(f, data_pos + pos, SEEK_SET) != 0 || fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) {
+            return false;
+        }
+        if (!lossless_parse_header(hdr, &info)) break;   // 未提交的尾巴或预分配区里的旧数据
+        uint32_t next = pos + LOSSLESS_HEADER_BYTES + info.body_bytes;
+        if (next > limit) break;
+        n += info.num_samples;
+        pos = next;
+    }
+    *end = pos;
+    *samples = n;
+    return true;
+}
+
+static bool repair_wav_file(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size < REC_PCM_DATA_POS) return false;
+    uint32_t size = st.st_size;
+
+    FILE *f = fopen(path, "r+b");
+    if (!f) return false;
+
+    uint8_t hdr[REC_ENC_DATA_POS] = {0};
+    size_t got = fread(hdr, 1, sizeof(hdr), f);
+    if (got < REC_PCM_DATA_POS || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVEfmt ", 8) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    uint32_t riff_size, fmt_len, data_size, data_pos;
+    uint16_t format_tag, block_align, spb = 0;
+    memcpy(&riff_size, hdr + 4, 4);
+    memcpy(&fmt_len, hdr + 16, 4);
+    memcpy(&format_tag, hdr + 20, 2);
+    memcpy(&block_align, hdr + 32, 2);
+
+    bool ours;
+    if (format_tag == 1) {
+        data_pos = REC_PCM_DATA_POS;
+        ours = fmt_len == 16 && memcmp(hdr + 36, "data", 4) == 0;
+    } else {
+        uint16_t cb_size;
+        uint32_t fact_len;
+        memcpy(&cb_size, hdr + 36, 2);
+        memcpy(&spb, hdr + 38, 2);
+        memcpy(&fact_len, hdr + 44, 4);
+        data_pos = REC_ENC_DATA_POS;
+        ours = (format_tag == WAVE_FORMAT_IMA_ADPCM || format_tag == WAVE_FORMAT_TINY_LOSSLESS) &&
+               got == REC_ENC_DATA_POS && fmt_len == 20 && cb_size == 2 && spb != 0 &&
+               memcmp(hdr + 40, "fact", 4) == 0 && fact_len == 4 && memcmp(hdr + 52, "data", 4) == 0;
+    }
+    memcpy(&data_size, hdr + data_pos - 4, 4);
+
+    // 长度字段：开头的占位 0，或检查点按同一文件长度写入的一对值
+    ours = ours && block_align != 0 &&
+           ((riff_size == 0 && data_size == 0) || (uint64_t)riff_size + 8 == (uint64_t)data_pos + data_size);
+    if (!ours || (uint64_t)riff_size + 8 == size || data_pos > size) {
+        fclose(f);
+        return false;   // 不是本录音机的文件，或者完好
+    }
+
+    uint32_t avail = size - data_pos;
+    if (riff_size == 0 || data_size > avail) {
+        data_size = avail;
+    }
+
+    uint32_t samples = 0;
+    if (format_tag == WAVE_FORMAT_TINY_LOSSLESS) {
+        if (!walk_lossless_blocks(f, data_pos, data_size, &data_size, &samples)) {
+            ESP_LOGE(TAG, "%s: read error while walking lossless blocks", path);
+            fclose(f);
+            return false;
+        }
+    } else {
+        data_size -= data_size % block_align;
+        samples = data_size / block_align * spb;   // ADPCM：由块数推出；PCM 无 fact
+    }
+    uint32_t new_size = data_pos + data_size;
+    riff_size = new_size - 8;
+
+    bool ok = put_u32(f, 4, riff_size) && put_u32(f, data_pos - 4, data_size);
+    if (ok && format_tag != 1) {
+        ok = put_u32(f, REC_ENC_FACT_POS, samples);
+    }
+    ok = fflush(f) == 0 && ok;
+    if (ok && new_size < size && ftruncate(fileno(f), new_size) != 0) {
+        ESP_LOGE(TAG, "%s: truncate to %lu bytes failed", path, (unsigned long)new_size);
+        ok = false;
+    }
+    fclose(f);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "%s: repair failed", path);
+        return false;
+    }
+    ESP_LOGW(TAG, "Repaired %s: %lu -> %lu bytes", path, (unsigned long)size, (unsigned long)new_size);
+    return true;
+}
+
+static void sd_recover_wav_files(void)
+{
+    DIR *dir = opendir(MOUNT_POINT);
+    if (!dir) return;
+
+    int64_t t0 = esp_timer_get_time();
+    int scanned = 0, repaired = 0;
+    char path[300];
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_REG) continue;
+        const char *ext = strrchr(entry->d_name, '.');
+        if (!ext || strcasecmp(ext, ".wav") != 0) continue;
+
+        snprintf(path, sizeof(path), MOUNT_POINT "/%s", entry->d_name);
+        scanned++;
+        if (repair_wav_file(path)) repaired++;
+    }
+    closedir(dir);
+
+    ESP_LOGI(TAG, "Recovery scan: %d WAV files, %d repaired, %lld ms",
+             scanned, repaired, (long long)((esp_timer_get_time() - t0) / 1000));
+}
+
 
 void sd_init(){
  esp_err_t ret;
@@ -72,7 +234,7 @@ void sd_init(){
     esp_vfs_fat_sdmmc_mount_config_t mount_config = {
         .format_if_mount_failed = false,
         .max_files = 5,
-        .allocation_unit_size = 16 * 1024
+        .allocation_unit_size = SD_ALLOC_UNIT_SIZE
     };
 
 
@@ -92,6 +254,8 @@ void sd_init(){
     ESP_LOGI(TAG, "Filesystem mounted successfully");
     sdmmc_card_print_info(stdout, card);
 
+    sd_recover_wav_files();
+
 }
 void sd_wr_test(void)
 {
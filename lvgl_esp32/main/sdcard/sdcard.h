@@ -1,9 +1,16 @@
 #ifndef SDCARD_H
 #define SDCARD_H
 
+#include "sdmmc_cmd.h"
+
+#define SD_MOUNT_POINT      "/sdcard"
+#define SD_ALLOC_UNIT_SIZE  (16 * 1024)   // 驱动自己格式化卡时的簇大小（已有文件系统的卡以卷上的为准）
+
+extern sdmmc_card_t *card;
+
 void sd_init();
 void sd_wr_test(void) ; 
-void sd_list_wav_files(void (*callback)(const char *filename)) ;
+void sd_list_wav_files(void);
 
 
-#endif
\ No newline at end of file
+#endif
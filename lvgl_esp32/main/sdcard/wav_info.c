@@ -0,0 +1,269 @@
+#include "wav_info.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <sys/stat.h>
+
+#define WAVE_FORMAT_IEEE_FLOAT  0x0003
+#define FMT_MAX_BYTES           40      // 带 WAVEFORMATEXTENSIBLE 扩展的 fmt 长度
+
+// KSDATAFORMAT_SUBTYPE_xxx = {0000xxxx-0000-0010-8000-00AA00389B71}，前 2 字节是格式标签
+static const uint8_t s_subformat_tail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+};
+
+static inline uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+//--------------------------------------------------------
+// fmt 块内容（len ≤ FMT_MAX_BYTES，超出部分调用者已丢弃）
+//--------------------------------------------------------
+static esp_err_t parse_fmt(const uint8_t *b, uint32_t len, wav_info_t *info)
+{
+    if (len < 16) return ESP_ERR_NOT_SUPPORTED;
+
+    info->audio_format = rd16(b);
+    info->num_channels = rd16(b + 2);
+    info->sample_rate = rd32(b + 4);
+    info->byte_rate = rd32(b + 8);
+    info->block_align = rd16(b + 12);
+    info->bits_per_sample = rd16(b + 14);
+    info->valid_bits = info->bits_per_sample;
+
+    // cbSize 和块长度不一致时以块长度为准
+    uint32_t cb = len >= 18 ? rd16(b + 16) : 0;
+    if (cb > len - 18) cb = len >= 18 ? len - 18 : 0;
+
+    if (info->audio_format == WAVE_FORMAT_EXTENSIBLE) {
+        if (cb < 22) return ESP_ERR_NOT_SUPPORTED;
+        info->valid_bits = rd16(b + 18);
+        info->channel_mask = rd32(b + 20);
+        if (memcmp(b + 26, s_subformat_tail, sizeof(s_subformat_tail)) != 0) return ESP_ERR_NOT_SUPPORTED;
+        info->audio_format = rd16(b + 24);
+        if (info->audio_format == WAVE_FORMAT_EXTENSIBLE ||
+            info->valid_bits == 0 || info->valid_bits > info->bits_per_sample) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        // 声道掩码可以不填（0），填了就要和声道数一致
+        if (info->channel_mask && (uint32_t)__builtin_popcount(info->channel_mask) != info->num_channels) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    } else if (cb >= 2) {
+        info->samples_per_block = rd16(b + 18);
+    }
+
+    if (info->num_channels == 0 || info->sample_rate == 0 ||
+        info->block_align == 0 || info->bits_per_sample == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if ((info->audio_format == WAVE_FORMAT_PCM || info->audio_format == WAVE_FORMAT_IEEE_FLOAT) &&
+        info->block_align != info->num_channels * ((info->bits_per_sample + 7) / 8)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 逐块解析
+//
+// 块头 8 字节（ID + 小端长度），奇数长度的块后面有 1 字节填充。
+// fmt 一般在 data 之前；少数工具把 fmt 放在后面，data 长度可信时继续往后找。
+//--------------------------------------------------------
+esp_err_t wav_info_parse(FILE *fp, uint32_t file_size, wav_info_t *info)
+{
+    uint8_t buf[FMT_MAX_BYTES];
+    memset(info, 0, sizeof(*info));
+
+    if (fseek(fp, 0, SEEK_SET) != 0 || fread(buf, 1, 12, fp) != 12 ||
+        memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // RIFF 长度不可信（录音中断时为 0），只按文件实际长度判断越界
+    uint64_t pos = 12;
+    uint32_t data_pos = 0, data_len = 0, fact = 0;
+    bool have_fmt = false;
+
+    for (int n = 0; n < WAV_INFO_MAX_CHUNKS && pos + 8 <= file_size; n++) {
+        if (fseek(fp, (long)pos, SEEK_SET) != 0 || fread(buf, 1, 8, fp) != 8) break;
+        uint32_t len = rd32(buf + 4);
+        uint32_t body = (uint32_t)pos + 8;
+        uint32_t avail = file_size - body;
+
+        if (memcmp(buf, "data", 4) == 0) {
+            if (data_pos) break;                    // 第二个 data 块：忽略
+            data_pos = body;
+            // 0 / 越界（包括 0xFFFFFFFF）：长度没有回填，取到文件结尾，后面不会再有块
+            bool open_ended = len == 0 || len > avail;
+            data_len = open_ended ? avail : len;
+            if (have_fmt || open_ended) break;
+        } else if (memcmp(buf, "fmt ", 4) == 0) {
+            if (len > avail) return ESP_ERR_INVALID_SIZE;
+            if (!have_fmt) {
+                uint32_t take = len < sizeof(buf) ? len : sizeof(buf);
+                if (fread(buf, 1, take, fp) != take) return ESP_ERR_INVALID_SIZE;
+                esp_err_t err = parse_fmt(buf, take, info);
+                if (err != ESP_OK) return err;
+                have_fmt = true;
+                if (data_pos) break;
+            }
+        } else if (memcmp(buf, "fact", 4) == 0) {
+            if (len > avail) return ESP_ERR_INVALID_SIZE;
+            if (len >= 4 && fread(buf, 1, 4, fp) == 4) fact = rd32(buf);
+        } else if (len > avail) {
+            // 其余块只跳过；越过文件结尾说明块头已损坏
+            return ESP_ERR_INVALID_SIZE;
+        }
+        pos = (uint64_t)body + len + (len & 1);
+    }
+
+    if (!have_fmt || !data_pos) return ESP_ERR_NOT_FOUND;
+
+    // 定长块格式去掉结尾不完整的块；无损是变长块，以块头为准
+    if (info->audio_format != WAVE_FORMAT_TINY_LOSSLESS) data_len -= data_len % info->block_align;
+    info->data_offset = data_pos;
+    info->data_size = data_len;
+
+    if (info->audio_format == WAVE_FORMAT_PCM || info->audio_format == WAVE_FORMAT_IEEE_FLOAT) {
+        info->frames = data_len / info->block_align;
+    } else if (info->audio_format == WAVE_FORMAT_IMA_ADPCM && info->samples_per_block) {
+        // 最后一块可能没有填满，fact 更准
+        info->frames = data_len / info->block_align * info->samples_per_block;
+        if (fact && fact < info->frames) info->frames = fact;
+    } else {
+        info->frames = fact;                        // 0 = 未知（录音未回填）
+    }
+    info->duration_ms = (uint32_t)((uint64_t)info->frames * 1000 / info->sample_rate);
+
+    return fseek(fp, data_pos, SEEK_SET) == 0 ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+//--------------------------------------------------------
+// 缓存
+//
+// 键是路径 + 文件长度 + 修改时间（stat 只查目录项，不读数据）。路径的 FNV-1a
+// 哈希只用来快速跳过不相干的表项，相等后再比较完整路径：32 位哈希会撞，
+// 撞上的两个文件长度和修改时间又相同时，不能把一个文件的描述当成另一个的。
+// 超过 WAV_INFO_PATH_MAX 的路径不进缓存。
+// 播放任务和 LVGL 线程都会访问，表项很小，用临界区保护。
+//--------------------------------------------------------
+typedef struct {
+    uint32_t hash;                  // 0 = 空
+    char path[WAV_INFO_PATH_MAX];
+    uint32_t size;
+    time_t mtime;
+    uint32_t used;                  // LRU 时间戳
+    wav_info_t info;
+} cache_entry_t;
+
+static cache_entry_t s_cache[WAV_INFO_CACHE_SIZE];
+static uint32_t s_clock = 0;
+static wav_info_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t path_hash(const char *path)
+{
+    uint32_t h = 2166136261u;
+    while (*path) {
+        h ^= (uint8_t)*path++;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static bool entry_is(const cache_entry_t *e, uint32_t hash, const char *path)
+{
+    return e->hash == hash && strcmp(e->path, path) == 0;
+}
+
+static void cache_store(uint32_t hash, const char *path, const struct stat *st, const wav_info_t *info)
+{
+    portENTER_CRITICAL(&s_lock);
+    // 同一路径的旧表项 > 空表项 > 最久未用的表项
+    cache_entry_t *slot = &s_cache[0];
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < WAV_INFO_CACHE_SIZE; i++) {
+        cache_entry_t *e = &s_cache[i];
+        if (entry_is(e, hash, path)) {
+            slot = e;
+            break;
+        }
+        uint32_t age = e->hash ? e->used : 0;
+        if (age < best) {
+            best = age;
+            slot = e;
+        }
+    }
+    slot->hash = hash;
+    strcpy(slot->path, path);
+    slot->size = (uint32_t)st->st_size;
+    slot->mtime = st->st_mtime;
+    slot->used = ++s_clock;
+    slot->info = *info;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t wav_info_load(const char *path, FILE *fp, wav_info_t *info)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return ESP_ERR_NOT_FOUND;
+
+    uint32_t hash = path_hash(path);
+    bool cacheable = strlen(path) < WAV_INFO_PATH_MAX;
+    bool hit = false;
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < WAV_INFO_CACHE_SIZE; i++) {
+        cache_entry_t *e = &s_cache[i];
+        if (cacheable && entry_is(e, hash, path) && e->size == (uint32_t)st.st_size &&
+            e->mtime == st.st_mtime) {
+            *info = e->info;
+            e->used = ++s_clock;
+            hit = true;
+            break;
+        }
+    }
+    if (hit) {
+        s_stats.hits++;
+    } else {
+        s_stats.misses++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (hit) {
+        if (fp && fseek(fp, info->data_offset, SEEK_SET) != 0) return ESP_ERR_INVALID_SIZE;
+        return ESP_OK;
+    }
+
+    FILE *f = fp ? fp : fopen(path, "rb");
+    if (!f) return ESP_ERR_NOT_FOUND;
+    esp_err_t err = wav_info_parse(f, (uint32_t)st.st_size, info);
+    if (!fp) fclose(f);
+    if (err == ESP_OK && cacheable) cache_store(hash, path, &st, info);
+    return err;
+}
+
+void wav_info_forget(const char *path)
+{
+    uint32_t hash = path_hash(path);
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < WAV_INFO_CACHE_SIZE; i++) {
+        if (entry_is(&s_cache[i], hash, path)) s_cache[i].hash = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void wav_info_get_stats(wav_info_stats_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
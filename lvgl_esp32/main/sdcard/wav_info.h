@@ -0,0 +1,71 @@
+#ifndef WAV_INFO_H
+#define WAV_INFO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// RIFF/WAVE 头解析 + 按文件缓存的流描述
+//
+// 解析按块头逐块前进，只读 fmt / fact 的内容，其余块（LIST、cue、PAD ...）
+// 直接跳过；块长度越过文件结尾、fmt 缺字段、WAVE_FORMAT_EXTENSIBLE 的子格式
+// GUID 不对等情况都返回错误，不会把头部字节当成音频。
+// data 块长度为 0 / 0xFFFFFFFF（录音中断、流式写入）时按文件实际长度截取。
+//
+// 缓存以路径 + 文件长度 + 修改时间为键，同一文件再次播放、列表显示时长
+// 都不用再读卡解析；写文件的一方（录音、删除）调用 wav_info_forget 作废。
+//--------------------------------------------------------
+#define WAVE_FORMAT_PCM         0x0001
+#define WAVE_FORMAT_EXTENSIBLE  0xFFFE
+#define WAV_INFO_CACHE_SIZE     32
+#define WAV_INFO_PATH_MAX       128     // 缓存的路径长度上限（含结尾 0），与 PLAYER_PATH_MAX 一致
+#define WAV_INFO_MAX_CHUNKS     64      // data 之前最多跳过的块数，防止畸形文件拖慢解析
+
+typedef struct {
+    uint16_t audio_format;          // EXTENSIBLE 已换成子格式标签
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    uint16_t valid_bits;            // EXTENSIBLE 的有效位数，其余 = bits_per_sample
+    uint16_t samples_per_block;     // fmt 扩展字段（IMA-ADPCM / 无损），没有为 0
+    uint32_t channel_mask;          // 仅 EXTENSIBLE
+    uint32_t data_offset;           // data 块数据在文件中的偏移
+    uint32_t data_size;             // 已截到文件实际长度，定长块格式按 block_align 取整
+    uint32_t frames;                // 每声道样点数，0 表示未知
+    uint32_t duration_ms;
+} wav_info_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+} wav_info_stats_t;
+
+// 从文件头解析（不查缓存）；file_size 为文件长度。
+// 成功返回 ESP_OK，fp 停在 data 块数据起点；
+// ESP_ERR_INVALID_ARG 不是 RIFF/WAVE，ESP_ERR_NOT_FOUND 缺 fmt / data 块，
+// ESP_ERR_INVALID_SIZE 块长度越界，ESP_ERR_NOT_SUPPORTED fmt 字段不合法
+esp_err_t wav_info_parse(FILE *fp, uint32_t file_size, wav_info_t *info);
+
+// 取 path 的描述：缓存命中直接返回，否则解析并放进缓存。
+// fp 非 NULL 时使用调用者已打开的文件，返回后停在 data 块数据起点；
+// 为 NULL 时内部打开、用完关闭
+esp_err_t wav_info_load(const char *path, FILE *fp, wav_info_t *info);
+
+// 文件被改写 / 删除：作废缓存项
+void wav_info_forget(const char *path);
+
+void wav_info_get_stats(wav_info_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAV_INFO_H */
@@ -0,0 +1,713 @@
+#include "mixer.h"
+#include "pcm_gain.h"
+
+#include <string.h>
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "MIXER";
+
+#define RING_MASK           (MIXER_STREAM_FRAMES - 1)
+#define PERIOD_US           ((int64_t)MIXER_PERIOD * 1000000 / MIXER_SAMPLE_RATE)
+#define DUCK_DEFAULT        (PCM_GAIN_UNITY / 4)
+#define DUCK_RELEASE_STEP   (PCM_GAIN_UNITY * MIXER_PERIOD / (MIXER_SAMPLE_RATE / 1000 * MIXER_DUCK_RELEASE_MS))
+#define FADE_FRAMES         MIXER_PERIOD
+
+// 软削波：|x| ≤ CLIP_KNEE 原样输出，超过部分 d 压成 CLIP_ROOM·d / (CLIP_ROOM + d)，趋近满幅
+// 4 个声部满幅叠加时 d < 2^17，CLIP_ROOM·d 不会溢出 int32
+#define CLIP_KNEE           24576
+#define CLIP_ROOM           (INT16_MAX - CLIP_KNEE)
+
+typedef enum {
+    VOICE_FREE,
+    VOICE_CLIP,
+    VOICE_STREAM,
+} voice_kind_t;
+
+typedef struct {
+    voice_kind_t kind;
+    uint8_t gen;                    // 句柄代数，声部重新分配后旧句柄失效
+    uint32_t flags;
+    volatile int32_t gain;          // 目标增益（Q15）
+    int32_t gain_cur;               // 上个周期结束时的增益，只在混音任务里读写
+
+    // 片段
+    const int16_t *pcm;
+    size_t frames;
+    size_t pos;                     // 只在混音任务里读写
+    int64_t t_trigger;
+    bool sounding;                  // 已经混进过 DMA
+    volatile bool stop;
+
+    // 流：rd / wr 是不回绕的帧计数，下标取低位
+    int16_t *ring;
+    volatile uint32_t wr;           // 生产者写
+    volatile uint32_t rd;           // 混音任务写（flush 时生产者也写，带 flush_gen）
+    uint32_t flush_gen;
+    uint32_t flush_to;              // 淡出后丢到这里（flush 时的 wr）
+    uint32_t last_desc;             // 最后一帧所在的 DMA 描述符序号
+    bool started;                   // 攒够数据开始发声，drain 后复位
+    bool flushing;                  // 等混音任务淡出一个周期后丢弃（临界区内读写）
+    volatile bool eos;
+    volatile bool paused;           // gain_cur 降到 0 之后才真正停止取数据
+    SemaphoreHandle_t space;        // 混音任务取走数据后释放，生产者等空间
+} voice_t;
+
+// 一个周期里某个声部的快照（在临界区里取，混音时不再加锁）
+typedef struct {
+    voice_t *v;
+    uint32_t rd;
+    uint32_t avail;
+    uint32_t flush_gen;
+    uint32_t used;                  // 本周期取走的帧数
+    bool flushing;                  // 本周期是停止前的淡出
+} voice_snap_t;
+
+static voice_t s_voices[MIXER_VOICES];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_task = NULL;
+static i2s_chan_handle_t s_tx = NULL;
+static volatile int32_t s_duck_level = DUCK_DEFAULT;
+static int32_t s_duck_cur = PCM_GAIN_UNITY;
+static mixer_stats_t s_stats;
+static bool s_cut_pending = false;  // 临界区内读写
+
+//--------------------------------------------------------
+// 句柄
+//--------------------------------------------------------
+static inline mixer_voice_t make_handle(int idx)
+{
+    return (mixer_voice_t)(s_voices[idx].gen << 8 | idx);
+}
+
+static voice_t *lookup(mixer_voice_t h, voice_kind_t kind)
+{
+    if (h < 0) return NULL;
+    int idx = h & 0xFF;
+    if (idx >= MIXER_VOICES) return NULL;
+    voice_t *v = &s_voices[idx];
+    if (v->kind != kind || v->gen != (uint8_t)(h >> 8)) return NULL;
+    return v;
+}
+
+// 在临界区内调用
+static int alloc_voice(voice_kind_t kind)
+{
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        if (s_voices[i].kind == VOICE_FREE) {
+            s_voices[i].gen++;
+            s_voices[i].kind = kind;
+            return i;
+        }
+    }
+    return -1;
+}
+
+//--------------------------------------------------------
+// 混音内核
+//
+// 增益从 g0 线性过渡到 g1：内部用 Q23（Q15 << 8）累加步长，一个周期内不会溢出
+//--------------------------------------------------------
+static int32_t mix_span(int32_t *acc, const int16_t *src, size_t n, int32_t g, int32_t step)
+{
+    if (step == 0) {
+        int32_t q = g >> 8;
+        for (size_t i = 0; i < n; i++) acc[i] += (src[i] * q) >> 15;
+        return g;
+    }
+    for (size_t i = 0; i < n; i++) {
+        g += step;
+        acc[i] += (src[i] * (g >> 8)) >> 15;
+    }
+    return g;
+}
+
+// 返回进入削波区的样点数
+static uint32_t soft_clip(const int32_t *acc, int16_t *out, size_t n)
+{
+    uint32_t clipped = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t x = acc[i];
+        if (x > CLIP_KNEE) {
+            int32_t d = x - CLIP_KNEE;
+            x = CLIP_KNEE + CLIP_ROOM * d / (CLIP_ROOM + d);
+            clipped++;
+        } else if (x < -CLIP_KNEE) {
+            int32_t d = -CLIP_KNEE - x;
+            x = -CLIP_KNEE - CLIP_ROOM * d / (CLIP_ROOM + d);
+            clipped++;
+        }
+        out[i] = (int16_t)x;
+    }
+    return clipped;
+}
+
+//--------------------------------------------------------
+// 混音任务
+//
+// DMA 按描述符记账：每写满（或开始写）一个描述符 filled 加一，on_sent 中断里
+// 有数据的描述符播完 done 加一，done == filled 时 DMA 里只剩静音。最后一个描述符
+// 播完时中断唤醒任务，通道在这时关闭，不截断、不多等；drain 等到流的最后一帧
+// 所在的描述符播完才返回。流声部数据不够一个周期时，在 DMA 还能撑住的时间内
+// 等生产者，撑不住就把手上的数据先送出去；DMA 播空后关闭通道，流重新攒够数据再发声。
+//--------------------------------------------------------
+static bool s_enabled = false;      // 通道由混音任务预载数据后启用
+static bool s_ever_written = false;
+static uint32_t s_filled = 0;       // 已写入数据的描述符序号（只在任务里写）
+static uint32_t s_fill = 0;         // 当前描述符里已写入的帧
+static volatile uint32_t s_done = 0;    // 已播完的有数据描述符（中断里写，通道关闭时任务里对齐）
+static volatile int64_t s_sent_us = 0;  // 上一个描述符播完（或通道启用）的时刻
+
+static inline uint32_t pending_desc(void)
+{
+    return s_filled - s_done;
+}
+
+// DMA 里已写入的数据全部播完的时刻
+static int64_t play_end_us(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t t = s_sent_us + (int64_t)(s_filled - s_done) * PERIOD_US;
+    portEXIT_CRITICAL(&s_lock);
+    return t;
+}
+
+static inline TickType_t us_to_ticks(int64_t us)
+{
+    return (TickType_t)(us / 1000 / portTICK_PERIOD_MS);
+}
+
+static bool IRAM_ATTR on_sent(i2s_chan_handle_t tx, i2s_event_data_t *event, void *ctx)
+{
+    (void)tx;
+    (void)event;
+    (void)ctx;
+    bool drained = false;
+    portENTER_CRITICAL_ISR(&s_lock);
+    s_sent_us = esp_timer_get_time();
+    if (s_done != s_filled) {
+        s_done++;
+        drained = s_done == s_filled;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    BaseType_t woken = pdFALSE;
+    if (drained) vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+}
+
+// 写进 DMA 的 n 帧记到描述符上（写之前调用，中断看到的 filled 不会落后）
+static void count_written(uint32_t n)
+{
+    portENTER_CRITICAL(&s_lock);
+    while (n > 0) {
+        if (s_fill == 0) s_filled++;
+        uint32_t take = MIXER_PERIOD - s_fill < n ? MIXER_PERIOD - s_fill : n;
+        s_fill = (s_fill + take) % MIXER_PERIOD;
+        n -= take;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void channel_disable(void)
+{
+    i2s_channel_disable(s_tx);
+    s_enabled = false;
+    // 通道关了不会再有 on_sent：没播出的描述符作废
+    portENTER_CRITICAL(&s_lock);
+    s_done = s_filled;
+    s_fill = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// 关闭状态下启用：第一个周期预载进 DMA，启用时刻就是它开始播出的时刻
+static void channel_start(const int16_t *out, uint32_t n)
+{
+    size_t loaded = 0;
+    count_written(n);
+    i2s_channel_preload_data(s_tx, out, n * sizeof(int16_t), &loaded);
+    i2s_channel_enable(s_tx);
+    s_sent_us = esp_timer_get_time();
+    s_enabled = true;
+    if (loaded < n * sizeof(int16_t)) {
+        size_t written = 0;
+        i2s_channel_write(s_tx, (const uint8_t *)out + loaded, n * sizeof(int16_t) - loaded, &written, portMAX_DELAY);
+    }
+    if (s_ever_written) s_stats.restarts++;
+}
+
+// drain 中的流：最后一帧所在的描述符播完了就叫醒生产者
+static void release_drained(void)
+{
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        voice_t *v = &s_voices[i];
+        if (v->kind == VOICE_STREAM && v->eos && v->rd == v->wr && (int32_t)(s_done - v->last_desc) >= 0) {
+            xSemaphoreGive(v->space);
+        }
+    }
+}
+
+// 截断：丢掉 DMA 里还没播出的数据，片段倒回同样多的帧（被截断的流重新攒够数据后淡入）
+static void cut_dma(void)
+{
+    uint32_t unplayed = 0;
+    if (s_enabled) {
+        int64_t left = play_end_us() - esp_timer_get_time();
+        unplayed = left > 0 ? (uint32_t)(left * MIXER_SAMPLE_RATE / 1000000) : 0;
+        channel_disable();
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_cut_pending = false;
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        voice_t *v = &s_voices[i];
+        if (v->kind == VOICE_CLIP) v->pos -= v->pos < unplayed ? v->pos : unplayed;
+    }
+    s_stats.cuts++;
+    s_stats.cut_frames += unplayed;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void mixer_task(void *arg)
+{
+    (void)arg;
+    static int32_t acc[MIXER_PERIOD];
+    static int16_t out[MIXER_PERIOD];
+    voice_snap_t snap[MIXER_VOICES];
+
+    while (true) {
+        if (s_cut_pending) cut_dma();
+        release_drained();
+
+        int count = 0;
+        bool ducking = false, starving = false;
+        uint32_t n = 0, partial = 0;
+        uint32_t flushed = 0;           // 直接丢弃的流声部（位图），出临界区后叫醒生产者
+
+        portENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < MIXER_VOICES; i++) {
+            voice_t *v = &s_voices[i];
+            if (v->kind == VOICE_FREE) continue;
+            voice_snap_t *s = &snap[count];
+            s->v = v;
+            s->used = 0;
+            s->flushing = false;
+            if (v->kind == VOICE_CLIP) {
+                n = MIXER_PERIOD;
+            } else {
+                s->rd = v->rd;
+                s->avail = v->wr - v->rd;
+                s->flush_gen = v->flush_gen;
+                if (v->flushing) {
+                    // 停止：没在发声的直接丢掉，否则本周期淡出，提交时丢到 flush_to
+                    s->avail = v->flush_to - v->rd;
+                    if (!v->started || v->gain_cur == 0 || s->avail == 0) {
+                        v->rd = v->flush_to;
+                        v->flushing = false;
+                        v->started = false;
+                        flushed |= 1u << i;
+                        continue;
+                    }
+                    s->flushing = true;
+                } else {
+                    // 暂停：淡出的那个周期之后才停止取数据
+                    if (v->paused && (v->gain_cur == 0 || !v->started)) continue;
+                    if (!v->started) {
+                        if (s->avail < MIXER_STREAM_START && !(v->eos && s->avail)) continue;
+                        v->started = true;
+                        v->gain_cur = 0;        // 从静音淡入
+                    }
+                }
+                // 空了：eos 时等 drain 复位，否则是生产者没跟上，DMA 播空时再处理
+                if (s->avail == 0) continue;
+                if (s->avail >= MIXER_PERIOD) {
+                    n = MIXER_PERIOD;
+                } else {
+                    if (!v->eos && !s->flushing && !v->paused) starving = true;
+                    if (s->avail > partial) partial = s->avail;
+                }
+            }
+            if (v->flags & MIXER_FLAG_DUCK_OTHERS) ducking = true;
+            count++;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        for (int i = 0; i < MIXER_VOICES; i++) {
+            if (flushed & (1u << i)) xSemaphoreGive(s_voices[i].space);
+        }
+
+        int64_t now = esp_timer_get_time();
+
+        if (count == 0) {
+            // 没有声部：DMA 里最后一个描述符播完时 on_sent 唤醒任务，关闭通道；
+            // 新的触发 / 写入也会唤醒任务
+            if (s_enabled) {
+                if (pending_desc() > 0) {
+                    int64_t left = play_end_us() - now;
+                    TickType_t t = left > 0 ? us_to_ticks(left) : 0;
+                    ulTaskNotifyTake(pdTRUE, t + 1);
+                    continue;
+                }
+                channel_disable();
+
+                // 播空时还在播放的流（没有 eos）算一次欠载，重新攒够数据再发声
+                portENTER_CRITICAL(&s_lock);
+                for (int i = 0; i < MIXER_VOICES; i++) {
+                    voice_t *v = &s_voices[i];
+                    if (v->kind == VOICE_STREAM && v->started && !v->eos && !v->paused) {
+                        v->started = false;
+                        s_stats.underruns++;
+                    }
+                }
+                portEXIT_CRITICAL(&s_lock);
+                release_drained();
+            }
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        if (starving && s_enabled) {
+            // 流声部不够一个周期：DMA 里还有超过一个周期的数据就先等生产者，
+            // 撑不住了才把手上的数据先送出去
+            TickType_t t = us_to_ticks(play_end_us() - now - PERIOD_US);
+            if (t > 0) {
+                ulTaskNotifyTake(pdTRUE, t);
+                continue;
+            }
+        }
+        if (n == 0) n = partial;        // 只剩不足一个周期的尾巴：有多少送多少，不补零
+
+        // 闪避：立刻压下（在本周期的增益过渡里完成），松开时按步长恢复
+        int32_t duck = s_duck_level;
+        if (ducking) {
+            s_duck_cur = duck;
+        } else if (s_duck_cur < PCM_GAIN_UNITY) {
+            s_duck_cur += DUCK_RELEASE_STEP;
+            if (s_duck_cur > PCM_GAIN_UNITY) s_duck_cur = PCM_GAIN_UNITY;
+        }
+
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        memset(acc, 0, n * sizeof(acc[0]));
+        int sounding = 0;
+        bool underrun = false;
+        for (int i = 0; i < count; i++) {
+            voice_snap_t *s = &snap[i];
+            voice_t *v = s->v;
+            int32_t target = v->gain;
+            if (v->flags & MIXER_FLAG_DUCKABLE) target = target * s_duck_cur >> 15;
+
+            const int16_t *src1, *src2 = NULL;
+            uint32_t n1, n2 = 0;
+            if (v->kind == VOICE_CLIP) {
+                if (v->stop) target = 0;
+                src1 = v->pcm + v->pos;
+                n1 = v->frames - v->pos < n ? (uint32_t)(v->frames - v->pos) : n;
+            } else {
+                uint32_t take = s->avail < n ? s->avail : n;
+                uint32_t off = s->rd & RING_MASK;
+                src1 = v->ring + off;
+                n1 = take < MIXER_STREAM_FRAMES - off ? take : MIXER_STREAM_FRAMES - off;
+                src2 = v->ring;
+                n2 = take - n1;
+                s->used = take;
+                if (s->flushing || v->paused) {
+                    target = 0;
+                } else if (v->eos && s->avail - take < FADE_FRAMES) {
+                    // 结尾：最后 FADE_FRAMES 帧内按剩余帧数线性淡出，最后一帧落到 0
+                    target = (int32_t)((int64_t)target * (s->avail - take) / FADE_FRAMES);
+                }
+                if (take < n && !v->eos && !s->flushing && !v->paused) underrun = true;
+            }
+            uint32_t len = n1 + n2;
+            if (len == 0) continue;
+            int32_t step = (target - v->gain_cur) * 256 / (int32_t)len;
+            int32_t g = v->gain_cur * 256;
+            g = mix_span(acc, src1, n1, g, step);
+            if (n2) mix_span(acc + n1, src2, n2, g, step);
+            v->gain_cur = target;
+            sounding++;
+        }
+        uint32_t clipped = soft_clip(acc, out, n);
+        uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+
+        // DMA 已经播空（任务被耽误，或最后一个 on_sent 中断还没到），中断停在哪个描述符
+        // 不确定：重新启用对齐，不往空转的 DMA 后面接着写
+        if (s_enabled && (pending_desc() == 0 || play_end_us() <= esp_timer_get_time())) channel_disable();
+
+        int64_t t_dac;
+        if (!s_enabled) {
+            channel_start(out, n);
+            t_dac = s_sent_us;
+        } else {
+            t_dac = play_end_us();
+            count_written(n);
+            size_t written = 0;
+            esp_err_t err = i2s_channel_write(s_tx, out, n * sizeof(int16_t), &written, portMAX_DELAY);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "I2S 写入失败: %s", esp_err_to_name(err));
+            }
+        }
+        s_ever_written = true;
+
+        // 提交：片段前进、播完释放；流声部取走的数据在期间没被 flush 才算数
+        portENTER_CRITICAL(&s_lock);
+        s_stats.periods++;
+        s_stats.soft_clipped += clipped;
+        if (underrun) s_stats.underruns++;
+        if (sounding > MIXER_VOICES) sounding = MIXER_VOICES;
+        s_stats.mix_cycles[sounding] += cycles;
+        s_stats.mix_periods[sounding]++;
+        for (int i = 0; i < count; i++) {
+            voice_snap_t *s = &snap[i];
+            voice_t *v = s->v;
+            if (v->kind == VOICE_CLIP) {
+                if (!v->sounding) {
+                    v->sounding = true;
+                    uint32_t us = (uint32_t)(t_dac - v->t_trigger);
+                    s_stats.latency_count++;
+                    s_stats.latency_sum_us += us;
+                    if (s_stats.latency_count == 1 || us < s_stats.latency_min_us) s_stats.latency_min_us = us;
+                    if (us > s_stats.latency_max_us) s_stats.latency_max_us = us;
+                }
+                v->pos += n;
+                if (v->pos >= v->frames || v->stop) v->kind = VOICE_FREE;
+            } else if (s->used && v->flush_gen == s->flush_gen) {
+                v->last_desc = s_filled;
+                if (s->flushing) {
+                    v->rd = v->flush_to;
+                    v->flushing = false;
+                    v->started = false;
+                } else {
+                    v->rd = s->rd + s->used;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        for (int i = 0; i < count; i++) {
+            if (snap[i].v->kind == VOICE_STREAM && snap[i].used) xSemaphoreGive(snap[i].v->space);
+        }
+    }
+}
+
+esp_err_t mixer_init(i2s_chan_handle_t tx)
+{
+    if (s_task) return ESP_OK;
+    ESP_RETURN_ON_FALSE(tx, ESP_ERR_INVALID_ARG, TAG, "no I2S channel");
+    s_tx = tx;
+    i2s_event_callbacks_t cbs = { .on_sent = on_sent };
+    ESP_RETURN_ON_ERROR(i2s_channel_register_event_callback(tx, &cbs, NULL), TAG, "failed to register on_sent");
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(mixer_task, "mixer", 3072, NULL, MIXER_TASK_PRIO,
+                                                &s_task, MIXER_TASK_CORE) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "failed to create mixer task");
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 片段
+//--------------------------------------------------------
+mixer_voice_t mixer_play_clip(const int16_t *pcm, size_t frames, int32_t gain, uint32_t flags)
+{
+    if (!s_task || !pcm || frames == 0) return MIXER_VOICE_INVALID;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    int idx = alloc_voice(VOICE_CLIP);
+    if (idx >= 0) {
+        voice_t *v = &s_voices[idx];
+        v->flags = flags;
+        v->gain = gain;
+        v->gain_cur = gain;         // 片段从静音开始，不需要淡入
+        v->pcm = pcm;
+        v->frames = frames;
+        v->pos = 0;
+        v->t_trigger = now;
+        v->sounding = false;
+        v->stop = false;
+        s_stats.triggers++;
+    } else {
+        s_stats.dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (idx < 0) return MIXER_VOICE_INVALID;
+    xTaskNotifyGive(s_task);
+    return make_handle(idx);
+}
+
+void mixer_stop(mixer_voice_t h)
+{
+    portENTER_CRITICAL(&s_lock);
+    voice_t *v = lookup(h, VOICE_CLIP);
+    if (v) v->stop = true;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+//--------------------------------------------------------
+// 流
+//--------------------------------------------------------
+mixer_voice_t mixer_stream_open(int32_t gain, uint32_t flags)
+{
+    int16_t *ring = heap_caps_malloc(MIXER_STREAM_FRAMES * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    SemaphoreHandle_t space = xSemaphoreCreateBinary();
+    if (!ring || !space) {
+        ESP_LOGE(TAG, "no memory for stream voice");
+        heap_caps_free(ring);
+        if (space) vSemaphoreDelete(space);
+        return MIXER_VOICE_INVALID;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    int idx = alloc_voice(VOICE_STREAM);
+    if (idx >= 0) {
+        voice_t *v = &s_voices[idx];
+        v->flags = flags;
+        v->gain = gain;
+        v->gain_cur = gain;
+        v->ring = ring;
+        v->wr = v->rd = 0;
+        v->flush_gen = 0;
+        v->flush_to = 0;
+        v->last_desc = 0;
+        v->started = false;
+        v->flushing = false;
+        v->eos = false;
+        v->paused = false;
+        v->space = space;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (idx < 0) {
+        ESP_LOGE(TAG, "no free voice for stream");
+        heap_caps_free(ring);
+        vSemaphoreDelete(space);
+        return MIXER_VOICE_INVALID;
+    }
+    return make_handle(idx);
+}
+
+size_t mixer_stream_write(mixer_voice_t h, const int16_t *pcm, size_t n, TickType_t timeout)
+{
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) return 0;
+
+    size_t done = 0;
+    bool waited = false;
+    while (done < n) {
+        uint32_t wr = v->wr;
+        uint32_t room = MIXER_STREAM_FRAMES - (wr - v->rd);
+        if (room == 0) {
+            if (waited || xSemaphoreTake(v->space, timeout) != pdTRUE) break;
+            waited = true;
+            continue;
+        }
+        uint32_t m = n - done < room ? (uint32_t)(n - done) : room;
+        uint32_t off = wr & RING_MASK;
+        uint32_t m1 = m < MIXER_STREAM_FRAMES - off ? m : MIXER_STREAM_FRAMES - off;
+        memcpy(v->ring + off, pcm + done, m1 * sizeof(int16_t));
+        memcpy(v->ring, pcm + done + m1, (m - m1) * sizeof(int16_t));
+
+        portENTER_CRITICAL(&s_lock);
+        v->wr = wr + m;
+        portEXIT_CRITICAL(&s_lock);
+        done += m;
+        xTaskNotifyGive(s_task);
+    }
+    return done;
+}
+
+void mixer_stream_drain(mixer_voice_t h)
+{
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) return;
+
+    // eos 让混音任务把不足一个周期的尾巴也送出去（并淡出），再等最后一帧所在的描述符播完
+    v->eos = true;
+    v->paused = false;
+    xTaskNotifyGive(s_task);
+    while (v->rd != v->wr || v->flushing || (int32_t)(s_done - v->last_desc) < 0) {
+        xSemaphoreTake(v->space, portMAX_DELAY);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    v->eos = false;
+    v->started = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mixer_stream_flush(mixer_voice_t h)
+{
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) return;
+
+    // 淡出的那个周期由混音任务做完再丢弃，之后写入的数据不受影响
+    portENTER_CRITICAL(&s_lock);
+    v->flush_to = v->wr;
+    v->flushing = true;
+    portEXIT_CRITICAL(&s_lock);
+    xTaskNotifyGive(s_task);
+}
+
+void mixer_stream_cut(mixer_voice_t h)
+{
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) return;
+
+    portENTER_CRITICAL(&s_lock);
+    v->rd = v->wr;
+    v->flush_gen++;
+    v->started = false;
+    v->flushing = false;
+    s_cut_pending = true;
+    portEXIT_CRITICAL(&s_lock);
+    xSemaphoreGive(v->space);
+    xTaskNotifyGive(s_task);
+}
+
+void mixer_stream_pause(mixer_voice_t h, bool paused)
+{
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) return;
+    // 暂停淡出一个周期后停止取数据；恢复时从静音淡入
+    v->paused = paused;
+    xTaskNotifyGive(s_task);
+}
+
+//--------------------------------------------------------
+// 增益 / 统计
+//--------------------------------------------------------
+void mixer_set_gain(mixer_voice_t h, int32_t gain)
+{
+    if (gain < 0) gain = 0;
+    if (gain > PCM_GAIN_UNITY) gain = PCM_GAIN_UNITY;
+    portENTER_CRITICAL(&s_lock);
+    voice_t *v = lookup(h, VOICE_STREAM);
+    if (!v) v = lookup(h, VOICE_CLIP);
+    if (v) v->gain = gain;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mixer_set_duck_level(int32_t gain)
+{
+    if (gain < 0) gain = 0;
+    if (gain > PCM_GAIN_UNITY) gain = PCM_GAIN_UNITY;
+    s_duck_level = gain;
+}
+
+void mixer_get_stats(mixer_stats_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mixer_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_lock);
+}
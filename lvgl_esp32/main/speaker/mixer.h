@@ -0,0 +1,114 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/i2s_std.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 多声部软件混音（单声道 16-bit，MIXER_SAMPLE_RATE）
+//
+// 混音任务独占 I2S 发送通道，每个周期把所有发声的声部按各自增益累加到 int32，
+// 软削波后写进 DMA。声部有两种：
+//   - 流：生产者（播放任务）把升采样后的 PCM 写进声部自己的环形缓冲区，
+//     缓冲区满时阻塞，播放节拍仍由 DAC 决定
+//   - 片段：内存里的一段 PCM（UI 提示音），触发后从下一个周期开始发声，
+//     播完自动释放声部；数据由调用者保管，播放期间不能释放
+// 增益为 Q15（PCM_GAIN_UNITY = 1.0），每个周期内线性过渡，不会有拉链噪声。
+// 流声部开始 / 恢复时从静音淡入一个周期，停止 / 暂停时淡出一个周期，
+// drain 的最后一个周期淡出到 0，起停都没有爆音。
+// 带 MIXER_FLAG_DUCK_OTHERS 的声部发声时，带 MIXER_FLAG_DUCKABLE 的声部
+// 压低到闪避电平（一个周期内压下，约 MIXER_DUCK_RELEASE_MS 恢复）。
+// 软削波：|x| ≤ 0.75 满幅时原样输出，超过后平滑压向满幅，多个声部叠加不会硬削波。
+// DMA 按描述符记账（on_sent 中断数播完的描述符）：没有声部发声时，最后一个
+// 有数据的描述符播完就关闭通道；再次触发时把第一个周期预载进 DMA 再启用。
+//
+// 触发 → DAC 延迟 ≈ DMA 中排队的数据（最多 MIXER_DMA_DESC × MIXER_PERIOD 帧）
+//                  + 触发时混音任务正在等待的那一个周期
+//--------------------------------------------------------
+#define MIXER_SAMPLE_RATE       48000
+#define MIXER_VOICES            4
+#define MIXER_PERIOD            240           // 每周期帧数（5 ms），等于 DMA 帧数
+#define MIXER_DMA_DESC          4             // DMA 描述符个数：排队 20 ms
+#define MIXER_STREAM_FRAMES     2048          // 流声部环形缓冲区（约 43 ms），2 的幂
+#define MIXER_STREAM_START      (2 * MIXER_PERIOD)  // 攒够这么多帧才开始发声
+#define MIXER_DUCK_RELEASE_MS   150
+#define MIXER_TASK_PRIO         6             // 高于播放任务（5）
+#define MIXER_TASK_CORE         1
+
+#define MIXER_FLAG_DUCK_OTHERS  (1u << 0)     // 发声时压低可闪避的声部（提示音）
+#define MIXER_FLAG_DUCKABLE     (1u << 1)     // 可被闪避（音乐 / 录音回放）
+
+typedef int32_t mixer_voice_t;                // 声部句柄，< 0 无效
+#define MIXER_VOICE_INVALID     (-1)
+
+typedef struct {
+    uint32_t periods;             // 混音周期数
+    uint32_t underruns;           // 流声部没跟上：混音时缺数据的周期 + DMA 因此播空的次数
+    uint32_t triggers;            // 触发的片段数
+    uint32_t dropped;             // 没有空闲声部被丢弃的触发
+    uint32_t soft_clipped;        // 进入软削波区的样点数
+    uint32_t restarts;            // 空闲关闭 / 截断后重新启用通道的次数
+    uint32_t cuts;                // mixer_stream_cut 截断 DMA 的次数
+    uint64_t cut_frames;          // 截断时丢掉的、还没播出的帧
+    uint64_t mix_cycles[MIXER_VOICES + 1];    // 按同时发声的声部数统计的混音 + 削波耗时（CPU 周期）
+    uint32_t mix_periods[MIXER_VOICES + 1];
+    uint32_t latency_count;       // 触发 → 第一帧到达 DAC
+    uint64_t latency_sum_us;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+} mixer_stats_t;
+
+// 创建混音任务并注册 on_sent 回调，此后 tx 通道只由混音任务读写、启用和关闭
+// （调用前通道已初始化、未启用）
+esp_err_t mixer_init(i2s_chan_handle_t tx);
+
+// 触发一次性片段；没有空闲声部时返回 MIXER_VOICE_INVALID
+mixer_voice_t mixer_play_clip(const int16_t *pcm, size_t frames, int32_t gain, uint32_t flags);
+
+// 分配一个流声部（一直保留），缓冲区在这里分配
+mixer_voice_t mixer_stream_open(int32_t gain, uint32_t flags);
+
+// 写入最多 n 帧：先写能放下的部分，一帧都放不下时最多等 timeout（混音任务每个周期
+// 取走数据后唤醒一次）再写一次；返回写入的帧数，没写完时调用者可以先处理别的事再接着写
+size_t mixer_stream_write(mixer_voice_t v, const int16_t *pcm, size_t n, TickType_t timeout);
+
+// 等已写入的数据全部播出（最后一帧所在的 DMA 描述符播完），然后回到“未开始”
+// （下次写入重新攒够 MIXER_STREAM_START 再发声）；会解除暂停
+void mixer_stream_drain(mixer_voice_t v);
+
+// 停止：缓冲区里的数据再淡出一个周期，其余丢弃，DMA 里排队的部分照常播完；
+// 不等待，之后写入的数据不受影响（要等声音停下接着调 mixer_stream_drain）
+void mixer_stream_flush(mixer_voice_t v);
+
+// flush 之后连 DMA 里排队的数据也丢掉（跳转 / 换曲）：混音任务重启通道，
+// 之后写入的数据一个周期内出声，并在第一个周期里淡入；
+// 正在发声的片段倒回被丢掉的部分重新混音
+void mixer_stream_cut(mixer_voice_t v);
+
+// 暂停时声部淡出一个周期后不再取数据，也不算欠载，缓冲区保留；恢复时淡入
+void mixer_stream_pause(mixer_voice_t v, bool paused);
+
+void mixer_set_gain(mixer_voice_t v, int32_t gain);
+
+// 停止片段声部（流声部用 flush）
+void mixer_stop(mixer_voice_t v);
+
+// 闪避电平（Q15），默认约 -12 dB
+void mixer_set_duck_level(int32_t gain);
+
+void mixer_get_stats(mixer_stats_t *out);
+void mixer_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIXER_H */
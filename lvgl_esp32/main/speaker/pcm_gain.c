@@ -0,0 +1,143 @@
+#include "pcm_gain.h"
+
+#if defined(__XTENSA__)
+#include "xtensa/config/core-isa.h"
+#endif
+
+#if defined(__XTENSA__) && XCHAL_HAVE_CLAMPS
+// CLAMPS a, b, 15：把 b 饱和到 16 位有符号范围，单周期
+static inline int32_t sat_s16(int32_t x)
+{
+    int32_t r;
+    __asm__ ("clamps %0, %1, 15" : "=a"(r) : "a"(x));
+    return r;
+}
+#else
+static inline int32_t sat_s16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return x;
+}
+#endif
+
+#define MONO_ROUND      (1 << 14)
+#define STEREO_ROUND    (1 << 15)
+
+//--------------------------------------------------------
+// 标量参考实现
+//--------------------------------------------------------
+void pcm_gain_mono_ref(const int16_t *in, int16_t *out, size_t n, int32_t gain)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = (in[i] * gain + MONO_ROUND) >> 15;
+        if (s > INT16_MAX) s = INT16_MAX;
+        if (s < INT16_MIN) s = INT16_MIN;
+        out[i] = (int16_t)s;
+    }
+}
+
+void pcm_downmix_gain_ref(const int16_t *in, int16_t *out, size_t frames, int32_t gain)
+{
+    for (size_t i = 0; i < frames; i++) {
+        int32_t s = ((in[2 * i] + in[2 * i + 1]) * gain + STEREO_ROUND) >> 16;
+        if (s > INT16_MAX) s = INT16_MAX;
+        if (s < INT16_MIN) s = INT16_MIN;
+        out[i] = (int16_t)s;
+    }
+}
+
+//--------------------------------------------------------
+// 优化实现：4 路展开，先读后写，支持原地处理
+//--------------------------------------------------------
+void pcm_gain_mono(const int16_t *in, int16_t *out, size_t n, int32_t gain)
+{
+    size_t i = 0;
+
+    if (gain == PCM_GAIN_UNITY) {
+        // 1.0：(x * 2^15 + 2^14) >> 15 == x
+        if (out != in) {
+            for (; i < n; i++) out[i] = in[i];
+        }
+        return;
+    }
+    for (; i + 4 <= n; i += 4) {
+        int32_t a = in[i + 0] * gain + MONO_ROUND;
+        int32_t b = in[i + 1] * gain + MONO_ROUND;
+        int32_t c = in[i + 2] * gain + MONO_ROUND;
+        int32_t d = in[i + 3] * gain + MONO_ROUND;
+        out[i + 0] = (int16_t)sat_s16(a >> 15);
+        out[i + 1] = (int16_t)sat_s16(b >> 15);
+        out[i + 2] = (int16_t)sat_s16(c >> 15);
+        out[i + 3] = (int16_t)sat_s16(d >> 15);
+    }
+    for (; i < n; i++) {
+        out[i] = (int16_t)sat_s16((in[i] * gain + MONO_ROUND) >> 15);
+    }
+}
+
+void pcm_downmix_gain(const int16_t *in, int16_t *out, size_t frames, int32_t gain)
+{
+    size_t i = 0;
+
+    // out[i] 只依赖 in[2i] / in[2i+1]，且 i ≤ 2i，原地处理时不会覆盖未读数据
+    for (; i + 4 <= frames; i += 4) {
+        const int16_t *p = in + 2 * i;
+        int32_t a = (p[0] + p[1]) * gain + STEREO_ROUND;
+        int32_t b = (p[2] + p[3]) * gain + STEREO_ROUND;
+        int32_t c = (p[4] + p[5]) * gain + STEREO_ROUND;
+        int32_t d = (p[6] + p[7]) * gain + STEREO_ROUND;
+        out[i + 0] = (int16_t)sat_s16(a >> 16);
+        out[i + 1] = (int16_t)sat_s16(b >> 16);
+        out[i + 2] = (int16_t)sat_s16(c >> 16);
+        out[i + 3] = (int16_t)sat_s16(d >> 16);
+    }
+    for (; i < frames; i++) {
+        out[i] = (int16_t)sat_s16(((in[2 * i] + in[2 * i + 1]) * gain + STEREO_ROUND) >> 16);
+    }
+}
+
+//--------------------------------------------------------
+// 平滑音量
+//--------------------------------------------------------
+static int32_t clamp_gain(int32_t g)
+{
+    if (g < 0) return 0;
+    if (g > PCM_GAIN_UNITY) return PCM_GAIN_UNITY;
+    return g;
+}
+
+void pcm_gain_smoother_init(pcm_gain_smoother_t *s, int32_t gain)
+{
+    s->current = s->target = clamp_gain(gain);
+}
+
+void pcm_gain_smoother_set(pcm_gain_smoother_t *s, int32_t target)
+{
+    s->target = clamp_gain(target);
+}
+
+size_t pcm_mix_to_mono(pcm_gain_smoother_t *s, const int16_t *in, size_t frames, int channels, int16_t *out)
+{
+    size_t done = 0;
+
+    // 增益稳定时整段处理，变化中按子块逐步逼近目标
+    while (done < frames) {
+        size_t n = frames - done;
+        int32_t diff = s->target - s->current;
+        if (diff != 0) {
+            if (n > PCM_GAIN_SUBBLOCK) n = PCM_GAIN_SUBBLOCK;
+            if (diff > PCM_GAIN_STEP) diff = PCM_GAIN_STEP;
+            if (diff < -PCM_GAIN_STEP) diff = -PCM_GAIN_STEP;
+            s->current += diff;
+        }
+
+        if (channels == 2) {
+            pcm_downmix_gain(in + 2 * done, out + done, n, s->current);
+        } else {
+            pcm_gain_mono(in + done, out + done, n, s->current);
+        }
+        done += n;
+    }
+    return frames;
+}
@@ -0,0 +1,57 @@
+#ifndef PCM_GAIN_H
+#define PCM_GAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 播放音量 / 下混（Q15 定点）
+//
+// 增益 g 为 Q15：32768 = 1.0，范围 0 ~ PCM_GAIN_UNITY（只衰减）
+//   单声道：out = sat16((x * g + 2^14) >> 15)
+//   立体声：out = sat16(((L + R) * g + 2^15) >> 16)   （取平均后乘增益）
+// 乘积在 int32 内不会溢出；舍入为四舍五入（向正无穷取半）。
+// out 可以与 in 指向同一块内存。
+//--------------------------------------------------------
+#define PCM_GAIN_UNITY          32768
+#define PCM_GAIN_SUBBLOCK       32        // 平滑时每 32 帧更新一次增益
+#define PCM_GAIN_STEP           1024      // 每个子块增益最多变化量（0 → 1.0 约 1024 帧）
+
+// 百分比音量 → Q15 增益
+static inline int32_t pcm_gain_from_percent(uint32_t percent)
+{
+    if (percent > 100) percent = 100;
+    return (int32_t)(percent * PCM_GAIN_UNITY / 100);
+}
+
+// 可移植的标量参考实现
+void pcm_gain_mono_ref(const int16_t *in, int16_t *out, size_t n, int32_t gain);
+void pcm_downmix_gain_ref(const int16_t *in, int16_t *out, size_t frames, int32_t gain);
+
+// 优化实现（ESP32-S3 上使用 CLAMPS 饱和，其它平台用比较；结果与参考实现逐位一致）
+void pcm_gain_mono(const int16_t *in, int16_t *out, size_t n, int32_t gain);
+void pcm_downmix_gain(const int16_t *in, int16_t *out, size_t frames, int32_t gain);
+
+//--------------------------------------------------------
+// 平滑音量：目标变化后按子块线性逼近，避免“拉链”噪声
+//--------------------------------------------------------
+typedef struct {
+    int32_t current;              // 当前增益（Q15）
+    int32_t target;               // 目标增益（Q15）
+} pcm_gain_smoother_t;
+
+void pcm_gain_smoother_init(pcm_gain_smoother_t *s, int32_t gain);
+void pcm_gain_smoother_set(pcm_gain_smoother_t *s, int32_t target);
+
+// 音量 + 下混为单声道（channels 为 1 或 2），返回输出样点数
+size_t pcm_mix_to_mono(pcm_gain_smoother_t *s, const int16_t *in, size_t frames, int channels, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PCM_GAIN_H */
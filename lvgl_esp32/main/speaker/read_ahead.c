@@ -0,0 +1,258 @@
+#include "read_ahead.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "READ_AHEAD";
+
+// 设置读卡区间（持锁调用）
+static void set_range(read_ahead_t *ra, FILE *fp, uint32_t offset, uint32_t length)
+{
+    ra->fp = fp;
+    ra->pos = offset & ~(uint32_t)(READ_AHEAD_ALIGN - 1);
+    ra->skip = offset - ra->pos;
+    ra->end = length && length <= UINT32_MAX - offset ? offset + length : UINT32_MAX;
+    ra->reposition = true;
+    ra->has_next = false;
+}
+
+//--------------------------------------------------------
+// 预读任务：拿到空闲缓冲区后等待有活动的区间，再读一块
+//--------------------------------------------------------
+static void read_ahead_task(void *arg)
+{
+    read_ahead_t *ra = arg;
+    uint8_t idx;
+
+    while (true) {
+        xQueueReceive(ra->free_q, &idx, portMAX_DELAY);
+
+        xSemaphoreTake(ra->lock, portMAX_DELAY);
+        while (!ra->active) {
+            xSemaphoreGive(ra->lock);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            xSemaphoreTake(ra->lock, portMAX_DELAY);
+        }
+
+        read_ahead_block_t blk = { .idx = idx, .gen = ra->gen, .skip = ra->skip };
+        uint32_t want = ra->end - ra->pos;
+        if (want > READ_AHEAD_BLOCK_BYTES) want = READ_AHEAD_BLOCK_BYTES;
+
+        int64_t t0 = esp_timer_get_time();
+        size_t n = 0;
+        if (ra->reposition && fseek(ra->fp, ra->pos, SEEK_SET) != 0) {
+            want = 0;
+        }
+        ra->reposition = false;
+        if (want > 0) {
+            n = fread(ra->buf[idx], 1, want, ra->fp);
+        }
+        uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+        ra->stats.reads++;
+        if (dt > ra->stats.max_read_us) ra->stats.max_read_us = dt;
+
+        ra->pos += n;
+        ra->skip = 0;
+        blk.len = n;
+        blk.eof = n < want || want == 0 || ra->pos >= ra->end;
+        if (blk.eof) {
+            // 有预约就直接接着读下一段，否则停下
+            ra->active = ra->has_next;
+            if (ra->has_next) set_range(ra, ra->next_fp, ra->next_offset, ra->next_length);
+        }
+        TaskHandle_t waiter = ra->waiter;
+        xSemaphoreGive(ra->lock);
+
+        // full_q 与缓冲区一样多，不会阻塞
+        xQueueSend(ra->full_q, &blk, portMAX_DELAY);
+        if (waiter) xTaskNotifyGive(waiter);
+    }
+}
+
+esp_err_t read_ahead_init(read_ahead_t *ra)
+{
+    if (ra->task) return ESP_OK;
+
+    for (int i = 0; i < READ_AHEAD_BLOCKS; i++) {
+        ra->buf[i] = heap_caps_aligned_alloc(4, READ_AHEAD_BLOCK_BYTES,
+                                             MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_RETURN_ON_FALSE(ra->buf[i], ESP_ERR_NO_MEM, TAG, "no memory for read-ahead buffer");
+    }
+    ra->free_q = xQueueCreate(READ_AHEAD_BLOCKS, sizeof(uint8_t));
+    ra->full_q = xQueueCreate(READ_AHEAD_BLOCKS, sizeof(read_ahead_block_t));
+    ra->lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(ra->free_q && ra->full_q && ra->lock, ESP_ERR_NO_MEM, TAG, "no memory for read-ahead queues");
+
+    for (uint8_t i = 0; i < READ_AHEAD_BLOCKS; i++) {
+        xQueueSend(ra->free_q, &i, 0);
+    }
+    ra->stats.low_water = READ_AHEAD_BLOCKS;
+
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(read_ahead_task, "read_ahead", 3072, ra, READ_AHEAD_TASK_PRIO,
+                                                &ra->task, READ_AHEAD_TASK_CORE) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "failed to create read-ahead task");
+    return ESP_OK;
+}
+
+// 归还当前块
+static void release_current(read_ahead_t *ra)
+{
+    if (ra->have_cur) {
+        xQueueSend(ra->free_q, &ra->cur.idx, portMAX_DELAY);
+        ra->have_cur = false;
+    }
+}
+
+void read_ahead_stop(read_ahead_t *ra)
+{
+    // 拿到锁说明没有正在进行的读卡
+    xSemaphoreTake(ra->lock, portMAX_DELAY);
+    ra->gen++;
+    ra->active = false;
+    ra->has_next = false;
+    xSemaphoreGive(ra->lock);
+
+    ra->queued = false;
+    release_current(ra);
+    read_ahead_block_t blk;
+    while (xQueueReceive(ra->full_q, &blk, 0) == pdTRUE) {
+        xQueueSend(ra->free_q, &blk.idx, portMAX_DELAY);
+    }
+    ra->eof = true;
+}
+
+void read_ahead_start(read_ahead_t *ra, FILE *fp, uint32_t offset, uint32_t length)
+{
+    read_ahead_stop(ra);
+
+    xSemaphoreTake(ra->lock, portMAX_DELAY);
+    set_range(ra, fp, offset, length);
+    ra->gen++;
+    ra->active = true;
+    xSemaphoreGive(ra->lock);
+
+    ra->eof = false;
+    ra->primed = false;
+    ra->filled = false;
+    xTaskNotifyGive(ra->task);
+}
+
+void read_ahead_queue(read_ahead_t *ra, FILE *fp, uint32_t offset, uint32_t length)
+{
+    xSemaphoreTake(ra->lock, portMAX_DELAY);
+    if (ra->active) {
+        ra->next_fp = fp;
+        ra->next_offset = offset;
+        ra->next_length = length;
+        ra->has_next = true;
+    } else {
+        // 当前区间已经读完：结尾块已经（或马上）进入 full_q，新区间的块排在它后面
+        set_range(ra, fp, offset, length);
+        ra->active = true;
+    }
+    xSemaphoreGive(ra->lock);
+    ra->queued = true;
+    xTaskNotifyGive(ra->task);
+}
+
+bool read_ahead_next(read_ahead_t *ra)
+{
+    if (!ra->queued || !ra->eof) return false;
+
+    // 预约区间的块排在当前区间结尾块之后；primed 保持为 true，切换时取不到块也算欠载
+    release_current(ra);
+    ra->queued = false;
+    ra->eof = false;
+    return true;
+}
+
+bool read_ahead_wait_filled(read_ahead_t *ra, TickType_t timeout)
+{
+    TickType_t t0 = xTaskGetTickCount();
+    bool ok;
+
+    while (true) {
+        // 区间读完（短文件）时结尾块可能还没进 full_q，之后的 read 会等它
+        xSemaphoreTake(ra->lock, portMAX_DELAY);
+        ok = uxQueueMessagesWaiting(ra->full_q) >= READ_AHEAD_BLOCKS - 1 || !ra->active;
+        ra->waiter = ok ? NULL : xTaskGetCurrentTaskHandle();
+        xSemaphoreGive(ra->lock);
+
+        TickType_t spent = xTaskGetTickCount() - t0;
+        if (ok || spent >= timeout) break;
+        ulTaskNotifyTake(pdTRUE, timeout - spent);
+    }
+
+    xSemaphoreTake(ra->lock, portMAX_DELAY);
+    ra->waiter = NULL;
+    xSemaphoreGive(ra->lock);
+    return ok;
+}
+
+// 取下一块；返回 false 表示区间已读完
+static bool next_block(read_ahead_t *ra)
+{
+    while (!ra->eof) {
+        // 水位从预读第一次填满之后开始统计，起播时的爬升和读到结尾后的排空都不算；
+        // 刚归还的块正在被预读任务重新填充，所以“满”是 READ_AHEAD_BLOCKS - 1
+        UBaseType_t ready = uxQueueMessagesWaiting(ra->full_q);
+        bool reading = __atomic_load_n(&ra->active, __ATOMIC_RELAXED);
+        if (ready >= READ_AHEAD_BLOCKS - 1) ra->filled = true;
+        if (ra->filled && reading && ready < ra->stats.low_water) ra->stats.low_water = ready;
+
+        int64_t t0 = esp_timer_get_time();
+        read_ahead_block_t blk;
+        xQueueReceive(ra->full_q, &blk, portMAX_DELAY);
+        if (blk.gen != ra->gen) {
+            // stop 之后才送到的旧块
+            xQueueSend(ra->free_q, &blk.idx, portMAX_DELAY);
+            continue;
+        }
+
+        if (ready == 0 && ra->primed) {
+            uint32_t wait = (uint32_t)(esp_timer_get_time() - t0);
+            ra->stats.underruns++;
+            if (wait > ra->stats.max_wait_us) ra->stats.max_wait_us = wait;
+        }
+        ra->primed = true;
+        ra->stats.blocks++;
+
+        ra->cur = blk;
+        ra->cur_off = blk.skip < blk.len ? blk.skip : blk.len;
+        ra->have_cur = true;
+        if (blk.eof) ra->eof = true;
+        return true;
+    }
+    return false;
+}
+
+size_t read_ahead_read(read_ahead_t *ra, void *dst, size_t len)
+{
+    uint8_t *out = dst;
+    size_t done = 0;
+
+    while (done < len) {
+        if (!ra->have_cur && !next_block(ra)) break;
+
+        size_t n = ra->cur.len - ra->cur_off;
+        if (n > len - done) n = len - done;
+        memcpy(out + done, ra->buf[ra->cur.idx] + ra->cur_off, n);
+        ra->cur_off += n;
+        done += n;
+
+        if (ra->cur_off >= ra->cur.len) {
+            release_current(ra);
+        }
+    }
+    return done;
+}
+
+void read_ahead_reset_stats(read_ahead_t *ra)
+{
+    xSemaphoreTake(ra->lock, portMAX_DELAY);
+    memset(&ra->stats, 0, sizeof(ra->stats));
+    ra->stats.low_water = READ_AHEAD_BLOCKS;
+    xSemaphoreGive(ra->lock);
+}
@@ -0,0 +1,113 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 播放预读
+//
+// - 预读任务把文件的一段区间按块读进 READ_AHEAD_BLOCKS 个 DMA 可用缓冲区，
+//   播放任务从已填满的块里按字节取数据，读卡延迟被这几块数据吸收
+// - 读卡地址和长度按扇区对齐（起点向下取整，块头多读的字节交给消费者跳过），
+//   FatFs 可以直接把整扇区读进缓冲区
+// - 可以预约下一段区间（下一首曲目）：当前区间读完后预读任务直接接着读，
+//   消费者读到当前区间结尾后调用 read_ahead_next 继续取，中间没有等待读卡的空档
+// - 只允许一个消费者任务；start / queue / next / stop / read 都在这个任务里调用
+//--------------------------------------------------------
+#define READ_AHEAD_BLOCKS       4
+#define READ_AHEAD_BLOCK_BYTES  8192          // 16 个扇区
+#define READ_AHEAD_ALIGN        512
+#define READ_AHEAD_TASK_PRIO    5
+#define READ_AHEAD_TASK_CORE    1
+
+typedef struct {
+    uint32_t blocks;              // 交付给消费者的块数
+    uint32_t underruns;           // 消费者要数据时没有就绪块、只能等读卡的次数（不含起播 / 跳转后的第一块）
+    uint32_t max_wait_us;         // 欠载时最长等待
+    uint32_t low_water;           // 预读填满之后观察到的最少就绪块数
+    uint32_t reads;               // 读卡次数
+    uint32_t max_read_us;         // 单次读卡最长耗时
+} read_ahead_stats_t;
+
+typedef struct {
+    uint8_t idx;                  // 缓冲区编号
+    bool eof;                     // 区间最后一块（或读卡出错）
+    uint16_t skip;                // 块头对齐多读的字节数
+    uint32_t len;                 // 读到的字节数（含 skip）
+    uint32_t gen;                 // 所属的 start 批次
+} read_ahead_block_t;
+
+typedef struct {
+    uint8_t *buf[READ_AHEAD_BLOCKS];
+    QueueHandle_t free_q;         // 空闲缓冲区编号
+    QueueHandle_t full_q;         // 已填充的块
+    SemaphoreHandle_t lock;       // 预读任务读卡期间持有；保护下面几个字段
+    TaskHandle_t task;
+    TaskHandle_t waiter;          // read_ahead_wait_filled 中等待的消费者，每送出一块通知一次
+
+    FILE *fp;
+    uint32_t pos;                 // 下一次读卡的文件偏移
+    uint32_t skip;                // 下一块开头要跳过的字节
+    uint32_t end;                 // 区间结束偏移
+    uint32_t gen;                 // 每次 start / stop 加一，之前读出的块作废
+    bool active;
+    bool reposition;              // 下一次读卡前需要 fseek
+
+    // 预约的下一段区间
+    FILE *next_fp;
+    uint32_t next_offset;
+    uint32_t next_length;
+    bool has_next;
+
+    // 消费者
+    read_ahead_block_t cur;
+    uint32_t cur_off;
+    bool have_cur;
+    bool eof;
+    bool primed;                  // 已取到本区间第一块
+    bool filled;                  // 本区间预读已经填满过一次
+    bool queued;                  // 已预约下一段区间，还没切过去
+    read_ahead_stats_t stats;
+} read_ahead_t;
+
+// 分配缓冲区并创建预读任务
+esp_err_t read_ahead_init(read_ahead_t *ra);
+
+// 从 offset 开始预读 length 字节（0 为读到文件结尾）；会先停止之前的区间
+void read_ahead_start(read_ahead_t *ra, FILE *fp, uint32_t offset, uint32_t length);
+
+// 预约下一段区间：当前区间读完后接着预读（当前区间已经读完时立即开始）；
+// 再次调用会替换之前的预约
+void read_ahead_queue(read_ahead_t *ra, FILE *fp, uint32_t offset, uint32_t length);
+
+// 当前区间读到结尾（read_ahead_read 返回不足）后切到预约的区间；
+// 没有预约、或当前区间还没读到结尾时返回 false（此时应 read_ahead_start 重新开始）
+bool read_ahead_next(read_ahead_t *ra);
+
+// 停止预读并丢弃已读出的块和预约；返回后预读任务不再访问任何 fp，可以 fseek / fclose
+void read_ahead_stop(read_ahead_t *ra);
+
+// 起播前等预读填满（READ_AHEAD_BLOCKS - 1 块就绪）或区间已经读完；超时返回 false
+bool read_ahead_wait_filled(read_ahead_t *ra, TickType_t timeout);
+
+// 按 fread 语义读取最多 len 字节，阻塞到数据就绪；返回值小于 len 表示到达区间结尾
+size_t read_ahead_read(read_ahead_t *ra, void *dst, size_t len);
+
+void read_ahead_reset_stats(read_ahead_t *ra);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* READ_AHEAD_H */
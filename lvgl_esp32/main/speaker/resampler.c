@@ -0,0 +1,165 @@
+#include "resampler.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PHASE_BITS  7
+#define HALF_TAPS   (RESAMPLER_TAPS / 2)
+#define FIR_CUTOFF  0.45f       // 相对输入采样率
+#define FIR_BETA    9.0f        // Kaiser β，阻带约 90 dB（Q15 量化后实测镜像 < -70 dB）
+
+_Static_assert((1 << PHASE_BITS) == RESAMPLER_PHASES, "RESAMPLER_PHASES must be 2^PHASE_BITS");
+
+// 多出的一行是相位 1.0，插值时不用判断边界；所有实例共用，第一次 init 时生成
+static int16_t s_coeffs[RESAMPLER_PHASES + 1][RESAMPLER_TAPS];
+static bool s_coeffs_ready = false;
+
+// 第一类零阶修正贝塞尔函数（级数展开）
+static float bessel_i0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+        if (term < sum * 1e-9f) break;
+    }
+    return sum;
+}
+
+//--------------------------------------------------------
+// 生成系数表
+//
+// 相位 p 对应输出落在窗口中心样点之后 μ = p / PHASES 处，
+// 第 k 个系数（窗口从旧到新）与输出的距离 d = μ + HALF_TAPS - 1 - k。
+// 每个相位单独归一化到 32768，舍入误差补到最大的系数上。
+//--------------------------------------------------------
+static void build_coeffs(void)
+{
+    const float i0_beta = bessel_i0(FIR_BETA);
+
+    for (int p = 0; p <= RESAMPLER_PHASES; p++) {
+        float h[RESAMPLER_TAPS];
+        float sum = 0.0f;
+        float mu = (float)p / RESAMPLER_PHASES;
+
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            float d = mu + HALF_TAPS - 1 - k;
+            float x = 2.0f * FIR_CUTOFF * d;
+            float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf((float)M_PI * x) / ((float)M_PI * x);
+            float r = d / HALF_TAPS;
+            float w = r * r < 1.0f ? bessel_i0(FIR_BETA * sqrtf(1.0f - r * r)) / i0_beta : 0.0f;
+            h[k] = sinc * w;
+            sum += h[k];
+        }
+
+        int32_t total = 0;
+        int peak = 0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            s_coeffs[p][k] = (int16_t)lrintf(h[k] / sum * 32768.0f);
+            total += s_coeffs[p][k];
+            if (s_coeffs[p][k] > s_coeffs[p][peak]) peak = k;
+        }
+        s_coeffs[p][peak] += (int16_t)(32768 - total);
+    }
+    s_coeffs_ready = true;
+}
+
+int resampler_init(resampler_t *r, uint32_t in_rate, uint32_t out_rate)
+{
+    if (in_rate == 0 || in_rate > out_rate) return -1;
+
+    if (!s_coeffs_ready) build_coeffs();
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    r->phase_mul = (1ull << 48) / out_rate;
+    resampler_reset(r);
+    return 0;
+}
+
+void resampler_reset(resampler_t *r)
+{
+    // 历史里是下标 -TAPS .. -1 的 0；第一个输出（t = 0）要等下标 0 .. HALF_TAPS 都到齐
+    r->frac = 0;
+    r->pending = HALF_TAPS + 1;
+    r->drain = HALF_TAPS;
+    r->pos = 0;
+    memset(r->hist, 0, sizeof(r->hist));
+}
+
+static inline void push(resampler_t *r, int16_t x)
+{
+    // 新样点写到 pos 和 pos + TAPS，之后 hist[pos .. pos+TAPS) 从旧到新
+    r->hist[r->pos] = x;
+    r->hist[r->pos + RESAMPLER_TAPS] = x;
+    r->pos = r->pos + 1 == RESAMPLER_TAPS ? 0 : r->pos + 1;
+}
+
+static inline int16_t interpolate(const resampler_t *r)
+{
+    // frac / out_rate → Q48 → 高 7 位是相位，再往下 15 位是相位间的插值系数
+    uint64_t ph = (uint64_t)r->frac * r->phase_mul;
+    uint32_t idx = (uint32_t)(ph >> (48 - PHASE_BITS));
+    int32_t sub = (int32_t)(ph >> (48 - PHASE_BITS - 15)) & 0x7FFF;
+
+    const int16_t *x = &r->hist[r->pos];
+    const int16_t *h0 = s_coeffs[idx];
+    const int16_t *h1 = s_coeffs[idx + 1];
+
+    // 系数绝对值和 < 2^16，int32 累加不会溢出
+    int32_t a0 = 0, a1 = 0;
+    for (int k = 0; k < RESAMPLER_TAPS; k += 4) {
+        a0 += h0[k + 0] * x[k + 0] + h0[k + 1] * x[k + 1] + h0[k + 2] * x[k + 2] + h0[k + 3] * x[k + 3];
+        a1 += h1[k + 0] * x[k + 0] + h1[k + 1] * x[k + 1] + h1[k + 2] * x[k + 2] + h1[k + 3] * x[k + 3];
+    }
+
+    int64_t acc = (int64_t)a0 * (32768 - sub) + (int64_t)a1 * sub + (1 << 29);
+    int32_t y = (int32_t)(acc >> 30);
+    if (y > INT16_MAX) y = INT16_MAX;
+    if (y < INT16_MIN) y = INT16_MIN;
+    return (int16_t)y;
+}
+
+size_t resampler_process(resampler_t *r, const int16_t *in, size_t n, size_t *consumed,
+                         int16_t *out, size_t cap)
+{
+    if (r->in_rate == r->out_rate) {
+        size_t m = n < cap ? n : cap;
+        if (out != in) memmove(out, in, m * sizeof(int16_t));
+        *consumed = m;
+        return m;
+    }
+
+    size_t used = 0, produced = 0;
+    while (true) {
+        while (r->pending > 0) {
+            if (used == n) goto done;
+            push(r, in[used++]);
+            r->pending--;
+        }
+        if (produced == cap) break;
+
+        out[produced++] = interpolate(r);
+
+        // in_rate ≤ out_rate，每个输出最多前进一个输入
+        r->frac += r->in_rate;
+        if (r->frac >= r->out_rate) {
+            r->frac -= r->out_rate;
+            r->pending = 1;
+        }
+    }
+done:
+    *consumed = used;
+    return produced;
+}
+
+size_t resampler_drain(resampler_t *r, int16_t *out, size_t cap)
+{
+    static const int16_t zeros[HALF_TAPS];
+
+    if (r->in_rate == r->out_rate) return 0;
+
+    size_t used;
+    size_t produced = resampler_process(r, zeros, r->drain, &used, out, cap);
+    r->drain -= used;
+    return produced;
+}
@@ -0,0 +1,54 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 定点流式升采样器（单声道 16-bit，in_rate ≤ out_rate）
+//
+// Kaiser 窗 sinc 原型按 RESAMPLER_PHASES 个相位做多相分解，每个输出取相邻两个相位
+// 各做一次 RESAMPLER_TAPS 点乘加，再按小数相位线性插值。相位用整数分子
+// frac / out_rate 计数，任意整数采样率比都不会累积漂移。
+//   截止 0.45 × in_rate，通带 0 ~ 0.38 × in_rate（纹波 < 0.05 dB），镜像抑制 > 70 dB
+// 系数为 Q15，每个相位的和都是 32768（直流增益 1.0）。
+// in_rate == out_rate 时直通，不引入延迟。
+//--------------------------------------------------------
+#define RESAMPLER_TAPS      32
+#define RESAMPLER_PHASES    128
+
+typedef struct {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t frac;                        // 下一个输出在当前窗口中心之后 frac / out_rate 个输入样点
+    uint32_t pending;                     // 算下一个输出前还要收几个输入
+    uint32_t drain;                       // 收尾时还要补几个 0
+    uint64_t phase_mul;                   // 2^48 / out_rate
+    uint16_t pos;                         // 历史缓冲区写位置
+    int16_t hist[2 * RESAMPLER_TAPS];     // 双份历史，保证窗口连续（从旧到新）
+} resampler_t;
+
+// 初始化；需要 0 < in_rate ≤ out_rate，否则返回 -1
+int resampler_init(resampler_t *r, uint32_t in_rate, uint32_t out_rate);
+
+// 清空历史，从头开始一段新的流
+void resampler_reset(resampler_t *r);
+
+// 处理最多 n 个输入，最多产生 cap 个输出；*consumed 返回用掉的输入数，返回输出数。
+// 输出满时输入可能没有用完，调用者换一块输出缓冲区后接着送剩下的输入。
+size_t resampler_process(resampler_t *r, const int16_t *in, size_t n, size_t *consumed,
+                         int16_t *out, size_t cap);
+
+// 流结束：补零把窗口里剩下的输入推出来，返回输出数，返回 0 表示排空。
+// 排空后总输出数为 ceil(输入数 × out_rate / in_rate)。
+size_t resampler_drain(resampler_t *r, int16_t *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESAMPLER_H */
@@ -0,0 +1,54 @@
+#include "seek_index.h"
+#include <string.h>
+
+void seek_index_reset(seek_index_t *idx)
+{
+    memset(idx, 0, sizeof(*idx));
+    idx->stride = 1;
+}
+
+bool seek_index_add(seek_index_t *idx, uint32_t offset, uint32_t frame, uint32_t bytes, uint32_t frames)
+{
+    if (offset != idx->end_offset || frame != idx->end_frame) return false;
+
+    if (idx->blocks % idx->stride == 0) {
+        if (idx->count == SEEK_INDEX_ENTRIES) {
+            // 表满：保留偶数项，间隔加倍；当前块号正好是新间隔的倍数
+            for (uint16_t i = 0; i < SEEK_INDEX_ENTRIES / 2; i++) {
+                idx->points[i] = idx->points[2 * i];
+            }
+            idx->count = SEEK_INDEX_ENTRIES / 2;
+            idx->stride *= 2;
+        }
+        if (idx->blocks % idx->stride == 0) {
+            idx->points[idx->count].offset = offset;
+            idx->points[idx->count].frame = frame;
+            idx->count++;
+        }
+    }
+    idx->blocks++;
+    idx->end_offset = offset + bytes;
+    idx->end_frame = frame + frames;
+    return true;
+}
+
+void seek_index_lookup(const seek_index_t *idx, uint64_t target, uint32_t *offset, uint32_t *frame)
+{
+    *offset = 0;
+    *frame = 0;
+
+    // 二分：最后一个 frame ≤ target 的项
+    uint16_t lo = 0, hi = idx->count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (idx->points[mid].frame <= target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo > 0) {
+        *offset = idx->points[lo - 1].offset;
+        *frame = idx->points[lo - 1].frame;
+    }
+}
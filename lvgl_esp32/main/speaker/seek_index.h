@@ -0,0 +1,49 @@
+#ifndef SEEK_INDEX_H
+#define SEEK_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//--------------------------------------------------------
+// 变长块的稀疏帧索引（无损格式跳转用）
+//
+// 每个块的字节长度不固定，帧号 → 文件偏移只能逐块累加。索引按文件顺序
+// 记下块的起点（data 块内偏移 + 起始帧号），每 stride 个块留一项；
+// 表满时隔项丢掉一半、stride 加倍，任意长度的文件都只占固定内存。
+// 块必须从头连续送入：frontier 之外的块（跳转后播放的块）直接忽略，
+// 要往更后面跳时由调用者从 frontier 起逐块读块头补齐。
+//--------------------------------------------------------
+#define SEEK_INDEX_ENTRIES      256
+
+typedef struct {
+    uint32_t offset;              // data 块内偏移
+    uint32_t frame;
+} seek_point_t;
+
+typedef struct {
+    seek_point_t points[SEEK_INDEX_ENTRIES];
+    uint16_t count;
+    uint16_t stride;              // 每项相隔的块数（2 的幂）
+    uint32_t blocks;              // 已连续收录的块数
+    uint32_t end_offset;          // frontier：下一个未收录块的偏移
+    uint32_t end_frame;
+} seek_index_t;
+
+void seek_index_reset(seek_index_t *idx);
+
+// 送入一个块（offset 处，起始帧 frame，占 bytes 字节、frames 帧）；
+// 不是紧接 frontier 的块返回 false，不收录
+bool seek_index_add(seek_index_t *idx, uint32_t offset, uint32_t frame, uint32_t bytes, uint32_t frames);
+
+// 起始帧 ≤ target 的最后一个已知块起点（没有收录任何块时为 0 / 0）
+void seek_index_lookup(const seek_index_t *idx, uint64_t target, uint32_t *offset, uint32_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEEK_INDEX_H */
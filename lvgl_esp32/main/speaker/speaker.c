@@ -3,8 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <dirent.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/i2s_std.h"
 #include "driver/gpio.h"
 #include "esp_check.h"
@@ -13,6 +17,14 @@
 #include "driver/spi_common.h"
 #include "pin_cfg.h"
 #include "sdcard.h"
+#include "wav_info.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
+#include "read_ahead.h"
+#include "pcm_gain.h"
+#include "resampler.h"
+#include "mixer.h"
+#include "seek_index.h"
 
 /* ========= 引脚定义 ========= */
 #define I2S_BCLK    13
@@ -20,35 +32,25 @@
 #define I2S_DOUT    12
 // #define AMP_SD_PIN  -1          // 可选：若模块有使能引脚则使用，否则可忽略
 
-#define DEFAULT_SAMPLE_RATE 44100
+#define OUTPUT_SAMPLE_RATE  MIXER_SAMPLE_RATE   // I2S 时钟只配置一次，文件采样率由升采样器转换
 #define BUFFER_SIZE         4096
+#define START_FILL_TIMEOUT_MS 500  // 起播前等预读填满的上限（卡很慢时不无限期等）
 
 static const char* TAG = "NS4168" ; 
 
 static i2s_chan_handle_t tx_chan = NULL;
 
-/* ====== WAV 文件头结构体 ====== */
-typedef struct {
-    char riff[4];
-    uint32_t chunk_size;
-    char wave[4];
-    char fmt[4];
-    uint32_t subchunk1_size;
-    uint16_t audio_format;
-    uint16_t num_channels;
-    uint32_t sample_rate;
-    uint32_t byte_rate;
-    uint16_t block_align;
-    uint16_t bits_per_sample;
-    char data[4];
-    uint32_t data_size;
-} wav_header_t;
+#define ADPCM_MAX_BLOCK_ALIGN 2048
 
 
 /* === I2S 初始化 === */
 static esp_err_t i2s_init(uint32_t sample_rate)
 {
     i2s_chan_config_t tx_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    // DMA 按混音周期分段，排队越短提示音延迟越低；混音任务来不及时 DMA 输出静音，不重复旧数据
+    tx_cfg.dma_desc_num = MIXER_DMA_DESC;
+    tx_cfg.dma_frame_num = MIXER_PERIOD;
+    tx_cfg.auto_clear = true;
     ESP_RETURN_ON_ERROR(i2s_new_channel(&tx_cfg, &tx_chan, NULL), TAG, "创建 I2S 通道失败");
 
     i2s_std_config_t std_cfg = {
@@ -63,111 +65,781 @@ static esp_err_t i2s_init(uint32_t sample_rate)
         },
     };
     ESP_RETURN_ON_ERROR(i2s_channel_init_std_mode(tx_chan, &std_cfg), TAG, "I2S 标准模式初始化失败");
-    ESP_RETURN_ON_ERROR(i2s_channel_enable(tx_chan), TAG, "启用 I2S 通道失败");
+    // 不在这里启用：混音任务有数据时预载第一个周期再启用，播完关闭
     return ESP_OK;
 }
 
-/* === 重新配置采样率（仅时钟）=== */
-static void reconfigure_sample_rate(uint32_t new_rate)
+/* === 读取一个无损压缩块（块头 + 块体），返回总字节数，出错返回 0 === */
+static size_t read_lossless_block(read_ahead_t *ra, uint8_t *buf, lossless_block_info_t *info)
 {
-    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(new_rate);
-    i2s_channel_disable(tx_chan);
-    i2s_channel_reconfig_std_clock(tx_chan, &clk_cfg);
-    i2s_channel_enable(tx_chan);
+    if (read_ahead_read(ra, buf, LOSSLESS_HEADER_BYTES) != LOSSLESS_HEADER_BYTES) return 0;
+    if (!lossless_parse_header(buf, info)) {
+        ESP_LOGE(TAG, "❌ 无损块头损坏");
+        return 0;
+    }
+    uint8_t *body = buf + LOSSLESS_HEADER_BYTES;
+    if (read_ahead_read(ra, body, info->body_bytes) != info->body_bytes) return 0;
+    return LOSSLESS_HEADER_BYTES + info->body_bytes;
 }
 
-/* === 播放 WAV 文件 === */
-/* === 播放 WAV 文件（修复版：使用静态缓冲区，避免堆损坏）=== */
-void wav_player_play(const char *path)
+/* ========= 播放服务 =========
+ * 播放在独立任务里运行，UI / RFID 通过命令队列控制；
+ * 播放中每送出一个读卡块查看一次队列（不等待），等混音器空间时每个混音周期看一眼队首，
+ * 跳转 / 换曲 / 停止不用等这一块写完；暂停时阻塞等待下一条命令。
+ * 每条 PLAY 命令播放一个列表（单个文件也是只有一项的列表），播放当前曲目时
+ * 下一首已经打开、预约在预读后面，曲目之间不停 I2S、不插静音。
+ */
+typedef enum {
+    PLAYER_CMD_PLAY,
+    PLAYER_CMD_PAUSE,
+    PLAYER_CMD_RESUME,
+    PLAYER_CMD_STOP,
+    PLAYER_CMD_SEEK,
+    PLAYER_CMD_SCRUB,
+    PLAYER_CMD_VOLUME,
+    PLAYER_CMD_NEXT,
+} player_cmd_kind_t;
+
+typedef struct {
+    player_cmd_kind_t kind;
+    uint32_t arg;                   // SEEK：毫秒；SCRUB：相对毫秒（int32）；VOLUME：百分比；PLAY：1 表示 path 是卡片映射的前缀
+    TaskHandle_t waiter;            // 仅 PLAY：播放结束时通知（阻塞播放用）
+    char path[PLAYER_PATH_MAX];     // 仅 PLAY
+} player_cmd_t;
+
+/* 一个打开的文件 */
+typedef struct {
+    FILE *fp;
+    wav_info_t fmt;                 // 头解析结果（来自 wav_info 缓存）
+    uint32_t data_start;            // data 块在文件中的偏移
+    uint32_t data_size;
+    uint32_t spb;                   // ADPCM 每块帧数
+    uint64_t frame_pos;             // 下一个要送出的帧号
+    uint32_t skip;                  // 跳转落在块中间：解码后先丢掉的帧数
+    uint32_t block_offset;          // 无损：下一块在 data 块内的偏移和起始帧（建索引用）
+    uint32_t block_frame;
+    seek_index_t index;             // 无损：块起点索引，边播边建，往后跳时补齐
+    char path[PLAYER_PATH_MAX];
+} play_session_t;
+
+static QueueHandle_t s_cmd_queue = NULL;
+static TaskHandle_t s_player_task = NULL;
+static player_state_cb_t s_state_cb = NULL;
+static void *s_state_cb_ctx = NULL;
+static volatile player_state_t s_state = PLAYER_STATE_IDLE;
+static volatile uint32_t s_position_ms = 0;
+static pcm_gain_smoother_t s_gain;                 // 音量（Q15，平滑），只在播放任务里读写
+static resampler_t s_resampler;                    // 文件采样率 → OUTPUT_SAMPLE_RATE
+static read_ahead_t s_read_ahead;                  // data 块由预读任务读卡，播放任务只取数据
+static mixer_voice_t s_stream = MIXER_VOICE_INVALID;   // 播放输出是混音器的一个流声部
+static volatile int32_t s_beep_gain;               // 提示音跟随音量设置
+static char s_list[PLAYER_PLAYLIST_MAX][PLAYER_PATH_MAX];   // 当前播放列表，只在播放任务里读写
+static size_t s_list_len = 0;
+
+static void set_state(player_state_t state, const char *path)
 {
-    // 使用静态缓冲区，确保生命周期覆盖整个播放过程，且位于内部 RAM（DMA-safe）
-    static uint8_t buf[BUFFER_SIZE];
-    static int16_t mono_buf[BUFFER_SIZE / 2];  // 最多处理 BUFFER_SIZE/2 个 16-bit 样点
+    s_state = state;
+    player_state_cb_t cb = s_state_cb;
+    if (cb) cb(state, path, s_state_cb_ctx);
+}
+
+/* === 打开文件：解析头、检查格式（不启动预读，可以在上一首播放时调用）=== */
+static bool session_open(play_session_t *ps, const char *path)
+{
+    memset(ps, 0, sizeof(*ps));
+    seek_index_reset(&ps->index);
+    snprintf(ps->path, sizeof(ps->path), "%s", path);
 
-    FILE *fp = fopen(path, "rb");
-    if (!fp) {
+    ps->fp = fopen(path, "rb");
+    if (!ps->fp) {
         ESP_LOGE(TAG, "❌ 打开文件失败: %s", path);
-        return;
+        return false;
+    }
+
+    // 同一文件再次播放时直接用缓存的描述，不再读卡解析
+    wav_info_t *header = &ps->fmt;
+    esp_err_t err = wav_info_load(path, ps->fp, header);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ 读取 WAV 头失败 (%s)", esp_err_to_name(err));
+        goto fail;
+    }
+    ps->data_start = header->data_offset;
+    ps->data_size = header->data_size;
+
+    ESP_LOGI(TAG, "🎵 WAV: %lu Hz, %u bit, %u ch, format 0x%04x, %lu ms",
+             (unsigned long)header->sample_rate,
+             header->bits_per_sample,
+             header->num_channels,
+             header->audio_format,
+             (unsigned long)header->duration_ms);
+
+    if (header->audio_format == WAVE_FORMAT_TINY_LOSSLESS) {
+        if (header->num_channels != 1 || header->bits_per_sample != 16) {
+            ESP_LOGW(TAG, "⚠️ 无损格式仅支持单声道 16-bit");
+            goto fail;
+        }
+    } else if (header->audio_format == WAVE_FORMAT_IMA_ADPCM) {
+        if (header->bits_per_sample != 4 || header->num_channels < 1 || header->num_channels > 2 ||
+            header->block_align > ADPCM_MAX_BLOCK_ALIGN ||
+            ima_adpcm_samples_per_block(header->block_align, header->num_channels) == 0) {
+            ESP_LOGW(TAG, "⚠️ 不支持的 IMA-ADPCM 参数");
+            goto fail;
+        }
+        ps->spb = ima_adpcm_samples_per_block(header->block_align, header->num_channels);
+    } else if (header->audio_format != 1 || header->bits_per_sample != 16 ||
+               header->num_channels < 1 || header->num_channels > 2) {
+        ESP_LOGW(TAG, "⚠️ 仅支持 16-bit PCM / IMA-ADPCM / 无损 WAV");
+        goto fail;
+    }
+    if (header->sample_rate == 0 || header->sample_rate > OUTPUT_SAMPLE_RATE) {
+        ESP_LOGW(TAG, "⚠️ 不支持的采样率 %lu Hz（最高 %d Hz）",
+                 (unsigned long)header->sample_rate, OUTPUT_SAMPLE_RATE);
+        goto fail;
     }
+    return true;
+
+fail:
+    fclose(ps->fp);
+    ps->fp = NULL;
+    return false;
+}
 
-    wav_header_t header;
-    if (fread(&header, sizeof(wav_header_t), 1, fp) != 1) {
-        ESP_LOGE(TAG, "❌ 读取 WAV 头失败");
-        fclose(fp);
-        return;
+/* === 无损：找到包含 target 的块，返回块在 data 块内的偏移和起始帧；越过结尾返回 false ===
+ * 从索引里起始帧 ≤ target 的最近一项（往后跳出已知范围时从 frontier）起逐块读块头，
+ * 读过的块顺便补进索引，同一段再跳转就不用再读。scratch 用来整段读卡，一次跨过多个块。
+ */
+static bool lossless_locate(play_session_t *ps, uint64_t target, uint8_t *scratch, size_t cap,
+                            uint32_t *offset, uint32_t *frame)
+{
+    seek_index_t *idx = &ps->index;
+    uint32_t off, f;
+    if (target >= idx->end_frame) {
+        off = idx->end_offset;
+        f = idx->end_frame;
+    } else {
+        seek_index_lookup(idx, target, &off, &f);
     }
 
-    ESP_LOGI(TAG, "🎵 WAV: %lu Hz, %u bit, %u ch",
-             (unsigned long)header.sample_rate,
-             header.bits_per_sample,
-             header.num_channels);
+    uint32_t base = 0, len = 0;
+    lossless_block_info_t info;
+    while (true) {
+        if (ps->data_size && off >= ps->data_size) return false;
+        if (off < base || off + LOSSLESS_HEADER_BYTES > base + len) {
+            if (fseek(ps->fp, ps->data_start + off, SEEK_SET) != 0) return false;
+            base = off;
+            len = (uint32_t)fread(scratch, 1, cap, ps->fp);
+            if (len < LOSSLESS_HEADER_BYTES) return false;
+        }
+        if (!lossless_parse_header(scratch + (off - base), &info)) return false;
+        uint32_t bytes = LOSSLESS_HEADER_BYTES + info.body_bytes;
+        seek_index_add(idx, off, f, bytes, info.num_samples);
+        if (f + info.num_samples > target) break;
+        off += bytes;
+        f += info.num_samples;
+    }
+    *offset = off;
+    *frame = f;
+    return true;
+}
+
+/* === 跳转：精确到帧；返回 false 表示已越过结尾 ===
+ * PCM 直接按字节偏移；ADPCM 块长固定，按块号算偏移；无损查块索引。
+ * 压缩格式从块起点开始解码，块内 target 之前的帧解码后丢掉。
+ */
+static bool session_seek(play_session_t *ps, uint32_t ms, uint8_t *scratch, size_t cap)
+{
+    const wav_info_t *h = &ps->fmt;
+    uint64_t target = (uint64_t)ms * h->sample_rate / 1000;
+    uint64_t start = target;
+    uint32_t offset;
 
-    if (header.audio_format != 1 || header.bits_per_sample != 16) {
-        ESP_LOGW(TAG, "⚠️ 仅支持 16-bit PCM WAV");
-        fclose(fp);
-        return;
+    if (h->frames && target >= h->frames) return false;
+
+    // 预读停下后才能直接操作 fp；旧位置还没混音的数据和 DMA 里排队的数据都不要了，
+    // 无损往后跳要读块头时先静音，新位置的第一块数据一到就能听到
+    read_ahead_stop(&s_read_ahead);
+    mixer_stream_cut(s_stream);
+
+    if (h->audio_format == WAVE_FORMAT_TINY_LOSSLESS) {
+        uint32_t frame;
+        if (!lossless_locate(ps, target, scratch, cap, &offset, &frame)) return false;
+        start = frame;
+        ps->block_offset = offset;
+        ps->block_frame = frame;
+    } else if (h->audio_format == WAVE_FORMAT_IMA_ADPCM) {
+        uint64_t block = target / ps->spb;
+        start = block * ps->spb;
+        offset = (uint32_t)(block * h->block_align);
+    } else {
+        offset = (uint32_t)(target * h->num_channels * 2);
     }
 
-    if (header.sample_rate != DEFAULT_SAMPLE_RATE) {
-        reconfigure_sample_rate(header.sample_rate);
-        ESP_LOGI(TAG, "🔧 重新配置 I2S 采样率为 %lu Hz", (unsigned long)header.sample_rate);
+    if (ps->data_size && offset >= ps->data_size) return false;
+    read_ahead_start(&s_read_ahead, ps->fp, ps->data_start + offset, ps->data_size ? ps->data_size - offset : 0);
+    ps->frame_pos = target;
+    ps->skip = (uint32_t)(target - start);
+    resampler_reset(&s_resampler);
+    return true;
+}
+
+/* === 读出并解码下一块，返回帧数，0 为结束 === */
+static size_t session_decode(play_session_t *ps, uint8_t *buf, int16_t *dec_pcm, const int16_t **pcm)
+{
+    const wav_info_t *h = &ps->fmt;
+    *pcm = (const int16_t *)buf;
+
+    if (h->audio_format == WAVE_FORMAT_TINY_LOSSLESS) {
+        lossless_block_info_t info;
+        size_t bytes = read_lossless_block(&s_read_ahead, buf, &info);
+        if (bytes == 0) return 0;
+        // 从头顺序播放时块起点顺便记进索引
+        seek_index_add(&ps->index, ps->block_offset, ps->block_frame, bytes, info.num_samples);
+        ps->block_offset += bytes;
+        ps->block_frame += info.num_samples;
+        *pcm = dec_pcm;
+        return lossless_decode_block(&info, buf + LOSSLESS_HEADER_BYTES, dec_pcm);
     }
 
-    const float volume = 0.6f;
-    size_t bytes_read, bytes_written;
+    size_t read_size = h->audio_format == WAVE_FORMAT_IMA_ADPCM ? h->block_align : BUFFER_SIZE;
+    size_t bytes_read = read_ahead_read(&s_read_ahead, buf, read_size);
+    if (bytes_read == 0) return 0;
+    if (h->audio_format == WAVE_FORMAT_IMA_ADPCM) {
+        *pcm = dec_pcm;
+        return ima_adpcm_decode_block(buf, bytes_read, h->num_channels, dec_pcm);
+    }
+    return bytes_read / (2 * h->num_channels);
+}
 
-    vTaskDelay(pdMS_TO_TICKS(100)); // 给功放/硬件一点启动时间（如有）
+/* === 队首是不是要丢掉已解码数据的命令（跳转 / 换曲 / 停止）=== */
+static bool cmd_interrupts(void)
+{
+    player_cmd_t cmd;
+    if (xQueuePeek(s_cmd_queue, &cmd, 0) != pdTRUE) return false;
+    return cmd.kind == PLAYER_CMD_PLAY || cmd.kind == PLAYER_CMD_STOP || cmd.kind == PLAYER_CMD_NEXT ||
+           cmd.kind == PLAYER_CMD_SEEK || cmd.kind == PLAYER_CMD_SCRUB;
+}
 
-    while ((bytes_read = fread(buf, 1, BUFFER_SIZE, fp)) > 0) {
-        size_t samples_out = 0;
+/* === 单声道样点升采样后写入混音器；drain 为 true 时忽略 mono，把升采样器尾部排空 ===
+ * 被跳转 / 换曲 / 停止打断时返回 ESP_ERR_TIMEOUT（剩下的数据丢掉）
+ */
+static esp_err_t write_output(const int16_t *mono, size_t n, bool drain)
+{
+    static int16_t out_buf[BUFFER_SIZE / 2];
+    const size_t cap = sizeof(out_buf) / sizeof(out_buf[0]);
 
-        if (header.num_channels == 2) {
-            int16_t *p = (int16_t *)buf;
-            size_t frames = bytes_read / 4; // 2 channels × 2 bytes
-            for (size_t i = 0; i < frames && i < BUFFER_SIZE / 4; i++) {
-                float mixed = (p[2 * i] + p[2 * i + 1]) * 0.5f * volume;
-                if (mixed > 32767.0f) mixed = 32767.0f;
-                if (mixed < -32768.0f) mixed = -32768.0f;
-                mono_buf[samples_out++] = (int16_t)mixed;
+    while (true) {
+        size_t used = 0;
+        size_t m = drain ? resampler_drain(&s_resampler, out_buf, cap)
+                         : resampler_process(&s_resampler, mono, n, &used, out_buf, cap);
+        if (!drain) {
+            mono += used;
+            n -= used;
+        }
+        // 阻塞写入：流声部缓冲区满时等混音任务取走，播放节拍仍由 DAC 决定；
+        // 混音任务每个周期取走一次数据，等待期间来了跳转之类的命令就不再写
+        size_t done = 0;
+        while (done < m) {
+            done += mixer_stream_write(s_stream, out_buf + done, m - done, portMAX_DELAY);
+            if (done < m && cmd_interrupts()) return ESP_ERR_TIMEOUT;
+        }
+        if (m < cap) return ESP_OK;     // 输出没写满，说明输入已经用完（或尾部已排空）
+    }
+}
+
+/* === 播放列表 ===
+ * 目录：目录下的 .wav，按文件名排序；.m3u：清单里的文件（相对路径相对清单所在目录）；
+ * 其它路径当作单个文件。超过 PLAYER_PLAYLIST_MAX 项的部分忽略。
+ */
+static bool has_ext(const char *name, const char *ext)
+{
+    const char *dot = strrchr(name, '.');
+    return dot && strcasecmp(dot, ext) == 0;
+}
+
+static int list_cmp(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+static bool list_add(const char *dir, const char *name)
+{
+    if (s_list_len >= PLAYER_PLAYLIST_MAX) return false;
+    int n = dir ? snprintf(s_list[s_list_len], PLAYER_PATH_MAX, "%s/%s", dir, name)
+                : snprintf(s_list[s_list_len], PLAYER_PATH_MAX, "%s", name);
+    if (n <= 0 || n >= PLAYER_PATH_MAX) {
+        ESP_LOGW(TAG, "⚠️ 路径过长，跳过: %s", name);
+        return true;
+    }
+    s_list_len++;
+    return true;
+}
+
+static size_t list_from_dir(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_REG || !has_ext(entry->d_name, ".wav")) continue;
+        if (!list_add(path, entry->d_name)) break;
+    }
+    closedir(dir);
+    qsort(s_list, s_list_len, PLAYER_PATH_MAX, list_cmp);
+    return s_list_len;
+}
+
+static size_t list_from_m3u(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    char dir[PLAYER_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+
+    char line[PLAYER_PATH_MAX];
+    while (fgets(line, sizeof(line), fp)) {
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] != '\n' && !feof(fp)) {
+            // 行太长：丢掉剩下的部分
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n') {}
+            ESP_LOGW(TAG, "⚠️ 清单行过长，跳过");
+            continue;
+        }
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = '\0';
+        }
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '#') continue;
+        if (!list_add(*p == '/' || !slash ? NULL : dir, p)) break;
+    }
+    fclose(fp);
+    return s_list_len;
+}
+
+static size_t list_load(const char *path, bool card)
+{
+    s_list_len = 0;
+
+    if (card) {
+        // 卡片 UID 依次找 <UID>.m3u、<UID>/ 目录、<UID>.wav
+        char alt[PLAYER_PATH_MAX];
+        if (snprintf(alt, sizeof(alt), "%s.m3u", path) < (int)sizeof(alt) && list_from_m3u(alt)) return s_list_len;
+        if (list_from_dir(path)) return s_list_len;
+        if (snprintf(alt, sizeof(alt), "%s.wav", path) < (int)sizeof(alt)) list_add(NULL, alt);
+        return s_list_len;
+    }
+    if (has_ext(path, ".m3u")) return list_from_m3u(path);
+    if (list_from_dir(path)) return s_list_len;
+    list_add(NULL, path);
+    return s_list_len;
+}
+
+/* === 从列表第 *index 项起打开第一个能播放的文件 === */
+static bool open_track(play_session_t *ps, size_t *index)
+{
+    for (size_t i = *index; i < s_list_len; i++) {
+        if (session_open(ps, s_list[i])) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* === 播放 cmd 对应的列表，直到播完 / 停止 / 被新的 PLAY 打断；被打断时返回 true，cmd 中是新命令 === */
+static bool play_list(player_cmd_t *cmd)
+{
+    // 使用静态缓冲区，确保生命周期覆盖整个播放过程，且位于内部 RAM（DMA-safe）
+    static uint8_t buf[BUFFER_SIZE];
+    static int16_t mono_buf[BUFFER_SIZE / 2];  // 最多处理 BUFFER_SIZE/2 个 16-bit 样点
+    static int16_t dec_pcm[BUFFER_SIZE];       // 一个压缩块解码后的交错 PCM
+    static play_session_t sessions[2];
+
+    TaskHandle_t waiter = cmd->waiter;
+    play_session_t *cur = &sessions[0];
+    play_session_t *next = &sessions[1];
+    size_t index = 0;
+
+    s_position_ms = 0;
+    if (list_load(cmd->path, cmd->arg != 0) == 0 || !open_track(cur, &index)) {
+        ESP_LOGW(TAG, "⚠️ 没有可播放的文件: %s", cmd->path);
+        set_state(PLAYER_STATE_IDLE, cmd->path);
+        if (waiter) xTaskNotifyGive(waiter);
+        return false;
+    }
+    resampler_init(&s_resampler, cur->fmt.sample_rate, OUTPUT_SAMPLE_RATE);
+    read_ahead_reset_stats(&s_read_ahead);
+    read_ahead_start(&s_read_ahead, cur->fp, cur->data_start, cur->data_size);
+    // 第一次写混音器之前先让预读攒满，否则起播时预读是空的，开头就欠载
+    if (!read_ahead_wait_filled(&s_read_ahead, pdMS_TO_TICKS(START_FILL_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "⚠️ 预读 %d ms 内没有填满，直接起播", START_FILL_TIMEOUT_MS);
+    }
+    set_state(PLAYER_STATE_PLAYING, cur->path);
+
+    // 下一首先打开，预约在当前曲目的预读后面
+    size_t next_index = index + 1;
+    bool have_next = open_track(next, &next_index);
+    if (have_next) read_ahead_queue(&s_read_ahead, next->fp, next->data_start, next->data_size);
+
+    bool paused = false;
+    bool preempted = false;
+
+    while (true) {
+        bool skip = false;
+
+        // 播放时只查看队列；暂停时阻塞等待，直到恢复 / 停止 / 换曲
+        while (!skip && xQueueReceive(s_cmd_queue, cmd, paused ? portMAX_DELAY : 0) == pdTRUE) {
+            switch (cmd->kind) {
+            case PLAYER_CMD_PLAY:
+                preempted = true;
+                goto done;
+            case PLAYER_CMD_STOP:
+                goto done;
+            case PLAYER_CMD_PAUSE:
+                if (!paused) {
+                    paused = true;
+                    mixer_stream_pause(s_stream, true);
+                    set_state(PLAYER_STATE_PAUSED, cur->path);
+                }
+                break;
+            case PLAYER_CMD_RESUME:
+                if (paused) {
+                    paused = false;
+                    mixer_stream_pause(s_stream, false);
+                    set_state(PLAYER_STATE_PLAYING, cur->path);
+                }
+                break;
+            case PLAYER_CMD_SEEK:
+            case PLAYER_CMD_SCRUB: {
+                int64_t ms = cmd->arg;
+                if (cmd->kind == PLAYER_CMD_SCRUB) {
+                    // 相对当前位置，往回越过开头时从头播
+                    ms = (int64_t)(cur->frame_pos * 1000 / cur->fmt.sample_rate) + (int32_t)cmd->arg;
+                    if (ms < 0) ms = 0;
+                }
+                if (!session_seek(cur, (uint32_t)ms, (uint8_t *)dec_pcm, sizeof(dec_pcm))) {
+                    skip = true;            // 越过结尾：直接切到下一首
+                } else if (have_next) {
+                    // 跳转重启了预读，预约要重新挂上
+                    read_ahead_queue(&s_read_ahead, next->fp, next->data_start, next->data_size);
+                }
+                break;
             }
-        } else {
-            int16_t *p = (int16_t *)buf;
-            size_t samples = bytes_read / 2;
-            for (size_t i = 0; i < samples && i < BUFFER_SIZE / 2; i++) {
-                float s = p[i] * volume;
-                if (s > 32767.0f) s = 32767.0f;
-                if (s < -32768.0f) s = -32768.0f;
-                mono_buf[samples_out++] = (int16_t)s;
+            case PLAYER_CMD_VOLUME:
+                pcm_gain_smoother_set(&s_gain, pcm_gain_from_percent(cmd->arg));
+                break;
+            case PLAYER_CMD_NEXT:
+                skip = true;
+                break;
             }
         }
 
-        // 阻塞写入，等待 DMA 描述符入队（注意：不等于播放完成，但静态 buffer 安全）
-        esp_err_t ret = i2s_channel_write(tx_chan, mono_buf, samples_out * sizeof(int16_t), &bytes_written, portMAX_DELAY);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "I2S 写入失败: %s", esp_err_to_name(ret));
-            break;
+        const int16_t *pcm = NULL;
+        size_t frames = skip ? 0 : session_decode(cur, buf, dec_pcm, &pcm);
+
+        if (frames == 0) {
+            // 当前曲目结束（或被跳过）
+            if (!have_next) break;
+
+            if (skip) {
+                // 跳过：丢掉当前曲目剩下的数据，从下一首开头重新预读
+                read_ahead_stop(&s_read_ahead);
+                mixer_stream_cut(s_stream);
+                resampler_init(&s_resampler, next->fmt.sample_rate, OUTPUT_SAMPLE_RATE);
+                read_ahead_start(&s_read_ahead, next->fp, next->data_start, next->data_size);
+            } else {
+                // 自然播完：下一首的数据已经排在预读里，采样率相同时升采样器状态连续
+                if (next->fmt.sample_rate != cur->fmt.sample_rate) {
+                    write_output(NULL, 0, true);    // 被打断时尾部丢掉即可
+                    resampler_init(&s_resampler, next->fmt.sample_rate, OUTPUT_SAMPLE_RATE);
+                }
+                if (!read_ahead_next(&s_read_ahead)) {
+                    // 当前曲目没读到区间结尾就解码失败，接不上：重新预读下一首
+                    read_ahead_start(&s_read_ahead, next->fp, next->data_start, next->data_size);
+                }
+            }
+            ESP_LOGI(TAG, "⏭️ 下一首: %s", next->path);
+
+            fclose(cur->fp);
+            cur->fp = NULL;
+            play_session_t *t = cur;
+            cur = next;
+            next = t;
+            index = next_index;
+            s_position_ms = 0;
+            set_state(paused ? PLAYER_STATE_PAUSED : PLAYER_STATE_PLAYING, cur->path);
+
+            next_index = index + 1;
+            have_next = open_track(next, &next_index);
+            if (have_next) read_ahead_queue(&s_read_ahead, next->fp, next->data_start, next->data_size);
+            continue;
+        }
+        if (cur->skip) {
+            // 跳转落在压缩块中间：块内目标之前的帧解码后丢掉
+            size_t n = frames < cur->skip ? frames : cur->skip;
+            pcm += n * cur->fmt.num_channels;
+            frames -= n;
+            cur->skip -= (uint32_t)n;
+            if (frames == 0) continue;
         }
+        if (cur->fmt.frames && cur->frame_pos + frames > cur->fmt.frames) {
+            // 最后一个压缩块没填满：fact 之后的填充样点不播
+            frames = cur->frame_pos < cur->fmt.frames ? (size_t)(cur->fmt.frames - cur->frame_pos) : 0;
+            if (frames == 0) continue;
+        }
+        cur->frame_pos += frames;
+
+        // 每次最多送出 mono_buf 能容纳的样点
+        const int channels = cur->fmt.num_channels;
+        while (frames > 0) {
+            size_t n = frames < BUFFER_SIZE / 2 ? frames : BUFFER_SIZE / 2;
+            size_t samples_out = pcm_mix_to_mono(&s_gain, pcm, n, channels, mono_buf);
+            pcm += n * channels;
+            frames -= n;
+
+            if (write_output(mono_buf, samples_out, false) != ESP_OK) break;    // 先去处理命令
+        }
+        s_position_ms = (uint32_t)(cur->frame_pos * 1000 / cur->fmt.sample_rate);
     }
+    // 整个列表正常播完：升采样器窗口里还压着最后几个样点，送完等最后一帧播出（尾部淡出）
+    write_output(NULL, 0, true);
+    mixer_stream_drain(s_stream);
 
-    // 可选：等待传输完成（更严谨）
-    // 注意：ESP-IDF v5.5 的 I2S channel API 暂无直接 flush，但关闭再开启可清空 FIFO
-    i2s_channel_disable(tx_chan);
-    i2s_channel_enable(tx_chan);
+done:
+    // 停止 / 切换：淡出一个周期，其余没混音的数据丢掉，DMA 里排队的照常播完，
+    // 声音停下后才报告空闲；通道由混音任务在最后一个描述符播完时关闭
+    mixer_stream_flush(s_stream);
+    mixer_stream_drain(s_stream);
 
-    fclose(fp);
-    ESP_LOGI(TAG, "✅ 播放结束: %s", path);
+    read_ahead_stop(&s_read_ahead);
+    fclose(cur->fp);
+    cur->fp = NULL;
+    if (have_next) {
+        fclose(next->fp);
+        next->fp = NULL;
+    }
+
+    const read_ahead_stats_t *st = &s_read_ahead.stats;
+    ESP_LOGI(TAG, "✅ 播放结束: %s", cur->path);
+    ESP_LOGI(TAG, "预读: %lu 块, 欠载 %lu 次（最长等待 %lu us）, 最低水位 %lu/%d, 最慢读卡 %lu us",
+             (unsigned long)st->blocks, (unsigned long)st->underruns, (unsigned long)st->max_wait_us,
+             (unsigned long)st->low_water, READ_AHEAD_BLOCKS, (unsigned long)st->max_read_us);
+    set_state(PLAYER_STATE_IDLE, cur->path);
+    if (waiter) xTaskNotifyGive(waiter);
+    return preempted;
+}
+
+static void player_task(void *arg)
+{
+    (void)arg;
+    player_cmd_t cmd;
+
+    while (true) {
+        xQueueReceive(s_cmd_queue, &cmd, portMAX_DELAY);
+
+        if (cmd.kind == PLAYER_CMD_VOLUME) {
+            // 没有在播放，直接跳到新音量
+            pcm_gain_smoother_init(&s_gain, pcm_gain_from_percent(cmd.arg));
+            continue;
+        }
+        if (cmd.kind != PLAYER_CMD_PLAY) {
+            continue;       // 空闲时的暂停 / 恢复 / 停止 / 跳转没有对象
+        }
+
+        while (play_list(&cmd)) {
+            // 播放中收到新的 PLAY：直接切到新列表
+        }
+    }
+}
+
+static esp_err_t post_cmd(const player_cmd_t *cmd)
+{
+    ESP_RETURN_ON_FALSE(s_cmd_queue, ESP_ERR_INVALID_STATE, TAG, "播放器未初始化");
+    // 不等待：调用者可能是 LVGL 线程
+    ESP_RETURN_ON_FALSE(xQueueSend(s_cmd_queue, cmd, 0) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "播放命令队列已满");
+    return ESP_OK;
+}
+
+static esp_err_t post_simple(player_cmd_kind_t kind, uint32_t arg)
+{
+    player_cmd_t cmd = { .kind = kind, .arg = arg };
+    return post_cmd(&cmd);
+}
+
+static esp_err_t post_play(const char *path, bool card, TaskHandle_t waiter)
+{
+    ESP_RETURN_ON_FALSE(path && strlen(path) < PLAYER_PATH_MAX, ESP_ERR_INVALID_ARG, TAG, "路径无效");
+    player_cmd_t cmd = { .kind = PLAYER_CMD_PLAY, .arg = card, .waiter = waiter };
+    snprintf(cmd.path, sizeof(cmd.path), "%s", path);
+    return post_cmd(&cmd);
+}
+
+esp_err_t wav_player_play_async(const char *path)
+{
+    return post_play(path, false, NULL);
+}
+
+esp_err_t wav_player_play_card(const char *uid)
+{
+    if (!s_player_task) return ESP_ERR_INVALID_STATE;      // 未初始化：刷卡不报错，直接忽略
+    ESP_RETURN_ON_FALSE(uid && uid[0] && !strchr(uid, '/'), ESP_ERR_INVALID_ARG, TAG, "UID 无效");
+    char base[PLAYER_PATH_MAX];
+    // 留出 ".m3u" 后缀的位置
+    ESP_RETURN_ON_FALSE(snprintf(base, sizeof(base), "%s/%s", SD_MOUNT_POINT, uid) < PLAYER_PATH_MAX - 4,
+                        ESP_ERR_INVALID_ARG, TAG, "UID 过长");
+    return post_play(base, true, NULL);
+}
+
+esp_err_t wav_player_next(void)
+{
+    return post_simple(PLAYER_CMD_NEXT, 0);
+}
+
+esp_err_t wav_player_pause(void)
+{
+    return post_simple(PLAYER_CMD_PAUSE, 0);
+}
+
+esp_err_t wav_player_resume(void)
+{
+    return post_simple(PLAYER_CMD_RESUME, 0);
+}
+
+esp_err_t wav_player_stop(void)
+{
+    return post_simple(PLAYER_CMD_STOP, 0);
+}
+
+esp_err_t wav_player_seek(uint32_t ms)
+{
+    return post_simple(PLAYER_CMD_SEEK, ms);
+}
+
+esp_err_t wav_player_scrub(int32_t delta_ms)
+{
+    return post_simple(PLAYER_CMD_SCRUB, (uint32_t)delta_ms);
+}
+
+esp_err_t wav_player_set_volume(uint8_t percent)
+{
+    if (percent > 100) percent = 100;
+    s_beep_gain = pcm_gain_from_percent(percent);
+    return post_simple(PLAYER_CMD_VOLUME, percent);
+}
+
+/* === 提示音 ===
+ * 初始化时生成在内存里，触发时直接交给混音器，不经过播放队列、不读卡；
+ * 播放中触发时音乐被压低，提示音结束后约 150 ms 恢复。
+ */
+#define BEEP_CLICK_FRAMES   (OUTPUT_SAMPLE_RATE * 15 / 1000)      // 2 kHz，15 ms
+#define BEEP_CARD_FRAMES    (OUTPUT_SAMPLE_RATE * 80 / 1000)      // 1320 Hz → 1760 Hz，各 40 ms
+#define BEEP_FADE_FRAMES    (OUTPUT_SAMPLE_RATE / 1000)           // 首尾 1 ms 淡入淡出，避免咔嗒声
+#define BEEP_AMPLITUDE      12000
+
+static int16_t s_beep_click[BEEP_CLICK_FRAMES];
+static int16_t s_beep_card[BEEP_CARD_FRAMES];
+
+static void beep_tone(int16_t *out, size_t frames, float hz)
+{
+    for (size_t i = 0; i < frames; i++) {
+        size_t edge = i < frames - 1 - i ? i : frames - 1 - i;
+        float env = edge < BEEP_FADE_FRAMES ? (float)edge / BEEP_FADE_FRAMES : 1.0f;
+        out[i] = (int16_t)(BEEP_AMPLITUDE * env * sinf(2.0f * (float)M_PI * hz * i / OUTPUT_SAMPLE_RATE));
+    }
+}
+
+static void beep_init(void)
+{
+    beep_tone(s_beep_click, BEEP_CLICK_FRAMES, 2000.0f);
+    beep_tone(s_beep_card, BEEP_CARD_FRAMES / 2, 1320.0f);
+    beep_tone(s_beep_card + BEEP_CARD_FRAMES / 2, BEEP_CARD_FRAMES / 2, 1760.0f);
+}
+
+esp_err_t wav_player_beep(player_beep_t kind)
+{
+    if (!s_player_task) return ESP_ERR_INVALID_STATE;      // 未初始化：提示音不报错，直接忽略
+    const int16_t *pcm = kind == PLAYER_BEEP_CARD ? s_beep_card : s_beep_click;
+    size_t frames = kind == PLAYER_BEEP_CARD ? BEEP_CARD_FRAMES : BEEP_CLICK_FRAMES;
+    mixer_voice_t v = mixer_play_clip(pcm, frames, s_beep_gain, MIXER_FLAG_DUCK_OTHERS);
+    return v == MIXER_VOICE_INVALID ? ESP_ERR_NO_MEM : ESP_OK;
+}
+
+void wav_player_set_callback(player_state_cb_t cb, void *ctx)
+{
+    s_state_cb_ctx = ctx;
+    s_state_cb = cb;
+}
+
+player_state_t wav_player_get_state(void)
+{
+    return s_state;
+}
+
+uint32_t wav_player_get_position_ms(void)
+{
+    return s_position_ms;
+}
+
+void wav_player_get_read_stats(read_ahead_stats_t *out)
+{
+    *out = s_read_ahead.stats;
+}
+
+/* === 阻塞播放：入队后等这个列表播完（或被停止 / 切掉）的通知 === */
+void wav_player_play(const char *path)
+{
+    if (post_play(path, false, xTaskGetCurrentTaskHandle()) == ESP_OK) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
 }
 
 /* === 初始化函数 === */
 bool wav_player_init(void)
 {
-   
+    if (s_player_task) {
+        return true;
+    }
 
     printf("🎧 初始化 I2S...\n");
-    if (i2s_init(DEFAULT_SAMPLE_RATE) != ESP_OK) {
+    if (i2s_init(OUTPUT_SAMPLE_RATE) != ESP_OK) {
         printf("❌ I2S 初始化失败\n");
         return false;
     }
+    pcm_gain_smoother_init(&s_gain, pcm_gain_from_percent(PLAYER_DEFAULT_VOLUME));
+    s_beep_gain = pcm_gain_from_percent(PLAYER_DEFAULT_VOLUME);
+    beep_init();
 
+    // 此后 I2S 只由混音任务写入，播放任务写混音器的流声部
+    if (mixer_init(tx_chan) != ESP_OK) {
+        ESP_LOGE(TAG, "❌ 混音器初始化失败");
+        return false;
+    }
+    s_stream = mixer_stream_open(PCM_GAIN_UNITY, MIXER_FLAG_DUCKABLE);
+    if (s_stream == MIXER_VOICE_INVALID) {
+        ESP_LOGE(TAG, "❌ 播放流创建失败");
+        return false;
+    }
+
+    if (read_ahead_init(&s_read_ahead) != ESP_OK) {
+        ESP_LOGE(TAG, "❌ 预读初始化失败");
+        return false;
+    }
+
+    s_cmd_queue = xQueueCreate(PLAYER_QUEUE_LEN, sizeof(player_cmd_t));
+    if (!s_cmd_queue) {
+        ESP_LOGE(TAG, "❌ 播放队列创建失败");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(player_task, "wav_player", 4096, NULL, PLAYER_TASK_PRIO,
+                                &s_player_task, PLAYER_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "❌ 播放任务创建失败");
+        return false;
+    }
     return true;
-}
\ No newline at end of file
+}
@@ -3,20 +3,127 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "esp_err.h"
+#include "read_ahead.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define PLAYER_PATH_MAX     128
+#define PLAYER_TASK_PRIO    5       // 高于 LVGL 任务（4），渲染不会饿死播放
+#define PLAYER_TASK_CORE    1
+#define PLAYER_QUEUE_LEN    8
+#define PLAYER_DEFAULT_VOLUME 60    // 百分比
+#define PLAYER_PLAYLIST_MAX 32      // 目录 / 清单最多取前 32 个文件
+
+typedef enum {
+    PLAYER_STATE_IDLE,
+    PLAYER_STATE_PLAYING,
+    PLAYER_STATE_PAUSED,
+} player_state_t;
+
+typedef enum {
+    PLAYER_BEEP_CLICK,      // 按键（2 kHz，15 ms）
+    PLAYER_BEEP_CARD,       // 刷卡（两声，80 ms）
+} player_beep_t;
+
+/**
+ * @brief 播放状态变化回调
+ *
+ * 在播放任务里调用，必须很快返回，不能阻塞（尤其不能等 LVGL 锁），
+ * UI 应该只把事件转交给自己的线程处理。
+ * @param state 新状态；文件打不开 / 格式不支持时直接回到 IDLE
+ * @param path  相关文件路径
+ */
+typedef void (*player_state_cb_t)(player_state_t state, const char *path, void *ctx);
+
 /**
- * @brief 初始化音频播放系统（SD卡 + I2S）
+ * @brief 初始化音频播放系统（I2S + 播放任务），可重复调用
  * @return true 成功，false 失败
  */
 bool wav_player_init(void);
 
 /**
- * @brief 播放指定路径的 WAV 文件（仅支持 16-bit PCM）
- * @param path 文件路径，如 "/sdcard/test.wav"
+ * @brief 注册状态回调（cb 为 NULL 时取消）
+ */
+void wav_player_set_callback(player_state_cb_t cb, void *ctx);
+
+/**
+ * @brief 异步播放：命令入队后立即返回，正在播放的列表会被切掉
+ *
+ * path 可以是单个 WAV 文件、目录（目录下的 .wav 按文件名排序）或 .m3u 清单
+ * （每行一个路径，# 开头为注释，相对路径相对清单所在目录）。
+ * 列表中的曲目无缝衔接：下一首提前打开并预读，切换时不重启 I2S、不插静音；
+ * 状态回调在每首开始时以新路径报告 PLAYING。
+ *
+ * 以下控制函数都不阻塞，可以在 LVGL 事件回调里直接调用；
+ * 命令队列满时返回 ESP_ERR_TIMEOUT，未初始化时返回 ESP_ERR_INVALID_STATE。
+ * @param path 如 "/sdcard/test.wav"、"/sdcard/stories"、"/sdcard/bedtime.m3u"
+ */
+esp_err_t wav_player_play_async(const char *path);
+
+/**
+ * @brief 播放 RFID 卡片对应的列表：依次查找 /sdcard/<UID>.m3u、/sdcard/<UID>/、/sdcard/<UID>.wav
+ * @param uid 卡片 UID 的十六进制字符串
+ * @return 播放器未初始化时返回 ESP_ERR_INVALID_STATE（不打印错误）
+ */
+esp_err_t wav_player_play_card(const char *uid);
+
+/**
+ * @brief 跳到列表中的下一首（没有下一首时结束播放）
+ */
+esp_err_t wav_player_next(void);
+
+esp_err_t wav_player_pause(void);
+esp_err_t wav_player_resume(void);
+esp_err_t wav_player_stop(void);
+
+/**
+ * @brief 在当前曲目内跳转到 ms 毫秒处（精确到帧），超出结尾则切到下一首
+ *
+ * PCM 按字节偏移，ADPCM 按固定块长，无损格式查边播边建的块索引（往后跳出已知范围时
+ * 只读块头补齐）。已经送进 DMA 的旧数据直接丢掉，新位置的数据读到后一个混音周期内出声。
+ */
+esp_err_t wav_player_seek(uint32_t ms);
+
+/**
+ * @brief 快进 / 快退：相对当前位置跳转 delta_ms 毫秒（负数往回，越过开头从头播）
+ */
+esp_err_t wav_player_scrub(int32_t delta_ms);
+
+/**
+ * @brief 设置音量（0 ~ 100），播放中约 20 ms 内平滑过渡到新音量
+ */
+esp_err_t wav_player_set_volume(uint8_t percent);
+
+/**
+ * @brief 播放提示音，与正在播放的音乐混音（音乐暂时压低），不打断播放
+ *
+ * 不阻塞，可以在 LVGL 事件回调里调用；音量跟随 wav_player_set_volume。
+ * 同时发声的提示音太多（没有空闲声部）时返回 ESP_ERR_NO_MEM；
+ * 播放器未初始化时返回 ESP_ERR_INVALID_STATE（不打印错误）。
+ */
+esp_err_t wav_player_beep(player_beep_t kind);
+
+player_state_t wav_player_get_state(void);
+
+/**
+ * @brief 当前曲目的播放位置（毫秒，按已送进 DMA 的帧计算）
+ */
+uint32_t wav_player_get_position_ms(void);
+
+/**
+ * @brief 预读统计（当前 / 最近一个文件）：读卡欠载次数、最低就绪块数、最慢读卡
+ */
+void wav_player_get_read_stats(read_ahead_stats_t *out);
+
+/**
+ * @brief 播放指定路径（文件 / 目录 / 清单，同 wav_player_play_async），阻塞到整个列表播放结束
+ *
+ * 只给自带任务的调用者使用（RFID、主机仿真），不能在 LVGL 线程或状态回调里调用。
+ * 支持 16-bit PCM / IMA-ADPCM / 无损格式。
+ * @param path 如 "/sdcard/test.wav"
  */
 void wav_player_play(const char *path);
 
@@ -24,4 +131,4 @@ void wav_player_play(const char *path);
 }
 #endif
 
-#endif // WAV_PLAYER_H
\ No newline at end of file
+#endif // WAV_PLAYER_H
@@ -8,6 +8,25 @@
 #include "lvgl.h"
 #include "esp_vfs.h"
 #include "speaker.h"
+#include "wav_info.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#define PLAY_UI_POLL_MS     50          // UI 线程取播放状态的周期
+#define PLAY_BTN_IDLE       0xF5F5F5
+#define PLAY_BTN_PLAYING    0xA0D8FF
+#define PLAY_BTN_PAUSED     0xFFE0A0
+#define PLAY_SCRUB_MS       10000       // 列表上左右滑动一次跳转的时长
+
+// 播放状态：播放任务写入单元素邮箱（只保留最新状态），UI 定时器在 LVGL 线程里取出
+typedef struct {
+    player_state_t state;
+    char name[64];                      // 文件名（不含 /sdcard/）
+} play_ui_evt_t;
+
+static QueueHandle_t s_play_mailbox = NULL;
+static lv_timer_t *s_play_timer = NULL;
+static play_ui_evt_t s_play_ui = { .state = PLAYER_STATE_IDLE };
 
 
 static inmp441_recorder_t recorder;
@@ -37,7 +56,7 @@ void action_start_record(lv_event_t *e) {
     if (!recorder_is_running()) {
             // 开始录音
             ESP_LOGI(TAG, "Record button clicked - start recording");
-            recorder_start("test.wav");
+            recorder_start("test.wav", REC_PROFILE_48K);
 
 
         } else {
@@ -63,6 +82,10 @@ void action_stop_record(lv_event_t *e) {
 
 }
 
+static void file_button_delete_cb(lv_event_t *e) {
+    free(lv_event_get_user_data(e));
+}
+
 static void add_file_to_list(const char *filename) {
     lv_obj_t *list = ui_get_sd_list();
     if (!list) return;
@@ -71,10 +94,26 @@ static void add_file_to_list(const char *filename) {
     lv_obj_t *btn = lv_list_add_btn(list, NULL, filename);
 
     // 2️⃣ 注册点击回调，并把文件名作为 user_data 传入
-    lv_obj_add_event_cb(btn, file_button_event_cb, LV_EVENT_CLICKED, (void *)strdup(filename));
+    char *name = strdup(filename);
+    lv_obj_add_event_cb(btn, file_button_event_cb, LV_EVENT_CLICKED, name);
+    lv_obj_add_event_cb(btn, file_button_delete_cb, LV_EVENT_DELETE, name);
+
+    // 时长放在文件名右边（单独的标签，按钮文字仍是文件名，播放状态按它匹配）
+    // 文件头描述有缓存，再次打开列表不用重新读卡
+    char fullpath[128];
+    wav_info_t info;
+    snprintf(fullpath, sizeof(fullpath), "/sdcard/%s", filename);
+    if (wav_info_load(fullpath, NULL, &info) == ESP_OK && info.duration_ms) {
+        uint32_t sec = (info.duration_ms + 500) / 1000;
+        lv_obj_t *dur = lv_label_create(btn);
+        lv_label_set_text_fmt(dur, "%lu:%02lu", (unsigned long)(sec / 60), (unsigned long)(sec % 60));
+    }
 
     // 3️⃣ 样式优化
-    lv_obj_set_style_bg_color(btn, lv_color_hex(0xF5F5F5), LV_PART_MAIN | LV_STATE_DEFAULT);
+    bool active = s_play_ui.state != PLAYER_STATE_IDLE && strcmp(filename, s_play_ui.name) == 0;
+    uint32_t color = !active ? PLAY_BTN_IDLE :
+                     s_play_ui.state == PLAYER_STATE_PAUSED ? PLAY_BTN_PAUSED : PLAY_BTN_PLAYING;
+    lv_obj_set_style_bg_color(btn, lv_color_hex(color), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_border_width(btn, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_pad_all(btn, 6, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_radius(btn, 4, LV_PART_MAIN | LV_STATE_DEFAULT);
@@ -138,23 +177,91 @@ void action_drop_record_file(lv_event_t *e) {
 // 创建获取表格函数
 static lv_obj_t *g_sd_list = NULL;
 
+// 播放中在列表上左右滑动：快进 / 快退（播放任务里做，按帧对齐）
+static void sd_list_gesture_cb(lv_event_t *e) {
+    if (s_play_ui.state != PLAYER_STATE_PLAYING) return;
+
+    lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_active());
+    if (dir == LV_DIR_RIGHT) {
+        wav_player_scrub(PLAY_SCRUB_MS);
+    } else if (dir == LV_DIR_LEFT) {
+        wav_player_scrub(-PLAY_SCRUB_MS);
+    }
+}
+
 void ui_set_sd_list(lv_obj_t *list) {
     g_sd_list = list;
+    lv_obj_add_event_cb(list, sd_list_gesture_cb, LV_EVENT_GESTURE, NULL);
 }
 
 lv_obj_t *ui_get_sd_list(void) {
     return g_sd_list;
 }
 
-//文件按钮回调
+//--------------------------------------------------------
+// 播放状态回调（播放任务里调用）：只写邮箱，不碰 LVGL
+//--------------------------------------------------------
+static void player_state_cb(player_state_t state, const char *path, void *ctx) {
+    play_ui_evt_t evt = { .state = state };
+    const char *slash = strrchr(path, '/');
+    snprintf(evt.name, sizeof(evt.name), "%s", slash ? slash + 1 : path);
+    xQueueOverwrite(s_play_mailbox, &evt);
+}
+
+// 按最新状态给列表按钮上色（LVGL 线程）
+static void play_ui_timer_cb(lv_timer_t *t) {
+    if (xQueueReceive(s_play_mailbox, &s_play_ui, 0) != pdTRUE) return;
+
+    lv_obj_t *list = ui_get_sd_list();
+    if (!list) return;
+
+    for (uint32_t i = 0; i < lv_obj_get_child_count(list); i++) {
+        lv_obj_t *btn = lv_obj_get_child(list, i);
+        if (!lv_obj_check_type(btn, &lv_list_button_class)) continue;
+
+        const char *text = lv_list_get_button_text(list, btn);
+        bool active = s_play_ui.state != PLAYER_STATE_IDLE && text && strcmp(text, s_play_ui.name) == 0;
+        uint32_t color = !active ? PLAY_BTN_IDLE :
+                         s_play_ui.state == PLAYER_STATE_PAUSED ? PLAY_BTN_PAUSED : PLAY_BTN_PLAYING;
+        lv_obj_set_style_bg_color(btn, lv_color_hex(color), LV_PART_MAIN | LV_STATE_DEFAULT);
+    }
+}
+
+// 首次播放时初始化播放器，并把状态回调接到 UI 定时器
+static bool player_ui_ensure_init(void) {
+    if (s_play_timer) return true;
+
+    if (!wav_player_init()) {
+        ESP_LOGE("SD_LIST", "播放器初始化失败");
+        return false;
+    }
+    s_play_mailbox = xQueueCreate(1, sizeof(play_ui_evt_t));
+    if (!s_play_mailbox) return false;
+    wav_player_set_callback(player_state_cb, NULL);
+    s_play_timer = lv_timer_create(play_ui_timer_cb, PLAY_UI_POLL_MS, NULL);
+    return s_play_timer != NULL;
+}
+
+//文件按钮回调：只发命令，播放在播放任务里进行，不阻塞 LVGL
 static void file_button_event_cb(lv_event_t *e) {
-    lv_obj_t *btn = lv_event_get_target(e);
     const char *fname = (const char *)lv_event_get_user_data(e);
 
     if (!fname) {
         ESP_LOGW("SD_LIST", "⚠️ 文件名为空，无法播放");
         return;
     }
+    if (!player_ui_ensure_init()) return;
+    wav_player_beep(PLAYER_BEEP_CLICK);     // 与正在播放的音乐混音，不打断
+
+    // 再次点击正在播放的文件：暂停 / 继续
+    if (s_play_ui.state != PLAYER_STATE_IDLE && strcmp(fname, s_play_ui.name) == 0) {
+        if (s_play_ui.state == PLAYER_STATE_PLAYING) {
+            wav_player_pause();
+        } else {
+            wav_player_resume();
+        }
+        return;
+    }
 
     // 拼接完整路径
     char fullpath[128];
@@ -162,9 +269,8 @@ static void file_button_event_cb(lv_event_t *e) {
 
     ESP_LOGI("SD_LIST", "▶️ 播放文件: %s", fullpath);
 
-    // ✅ 调用你的播放函数
-    wav_player_play(fullpath);
-
-    // （可选）点击时按钮高亮
-    lv_obj_set_style_bg_color(btn, lv_color_hex(0xA0D8FF), LV_PART_MAIN | LV_STATE_DEFAULT);
+    esp_err_t err = wav_player_play_async(fullpath);
+    if (err != ESP_OK) {
+        ESP_LOGW("SD_LIST", "播放命令发送失败 (%s)", esp_err_to_name(err));
+    }
 }
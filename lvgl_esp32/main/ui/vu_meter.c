@@ -0,0 +1,127 @@
+#include "vu_meter.h"
+#include "recorder_control.h"
+#include <math.h>
+
+#define VU_PERIOD_MS      50      // 20 Hz
+#define VU_DB_RANGE       60      // 显示 -60 ~ 0 dBFS
+#define VU_PEAK_FALL_PX   2       // 峰值保持每次回落像素
+#define VU_PEAK_W         2       // 峰值标记宽度
+
+typedef struct {
+    lv_timer_t *timer;
+    int32_t rms_w;                // 当前 RMS 条宽度（像素）
+    int32_t peak_x;               // 峰值保持标记位置（像素）
+} vu_meter_t;
+
+// 16 bit 幅度 → 条宽（dBFS 线性刻度）
+static int32_t level_to_px(uint16_t v, int32_t width)
+{
+    if (v == 0) return 0;
+    float db = 20.0f * log10f((float)v / 32767.0f);
+    if (db <= -VU_DB_RANGE) return 0;
+    if (db >= 0) return width;
+    return (int32_t)((db + VU_DB_RANGE) * width / VU_DB_RANGE);
+}
+
+// 失效 [x1, x2) 列（相对控件左边）
+static void invalidate_cols(lv_obj_t *obj, int32_t x1, int32_t x2)
+{
+    if (x1 == x2) return;
+    if (x1 > x2) { int32_t t = x1; x1 = x2; x2 = t; }
+
+    lv_area_t a;
+    lv_obj_get_coords(obj, &a);
+    int32_t left = a.x1;
+    a.x1 = left + x1;
+    a.x2 = left + x2 - 1;
+    lv_obj_invalidate_area(obj, &a);
+}
+
+static void vu_timer_cb(lv_timer_t *t)
+{
+    lv_obj_t *obj = lv_timer_get_user_data(t);
+    vu_meter_t *vu = lv_obj_get_user_data(obj);
+
+    // 录音页不在前台时不读不画
+    if (lv_obj_get_screen(obj) != lv_screen_active()) return;
+
+    int32_t w = lv_obj_get_content_width(obj);
+    uint32_t level = recorder_get_level();
+    int32_t rms_w = level_to_px(REC_LEVEL_RMS(level), w);
+    int32_t peak_x = level_to_px(REC_LEVEL_PEAK(level), w);
+
+    // 峰值保持：上升立即跟随，下降逐步回落
+    int32_t held = vu->peak_x - VU_PEAK_FALL_PX;
+    if (peak_x < held) peak_x = held;
+    if (peak_x < 0) peak_x = 0;
+
+    if (rms_w != vu->rms_w) {
+        invalidate_cols(obj, vu->rms_w, rms_w);
+        vu->rms_w = rms_w;
+    }
+    if (peak_x != vu->peak_x) {
+        invalidate_cols(obj, vu->peak_x, vu->peak_x + VU_PEAK_W);
+        invalidate_cols(obj, peak_x, peak_x + VU_PEAK_W);
+        vu->peak_x = peak_x;
+    }
+}
+
+static void vu_event_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_target(e);
+    vu_meter_t *vu = lv_obj_get_user_data(obj);
+
+    if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+        lv_timer_delete(vu->timer);
+        lv_free(vu);
+        return;
+    }
+
+    // LV_EVENT_DRAW_MAIN：背景由控件样式绘制，这里画 RMS 条和峰值标记
+    lv_layer_t *layer = lv_event_get_layer(e);
+    lv_area_t box;
+    lv_obj_get_coords(obj, &box);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+
+    if (vu->rms_w > 0) {
+        lv_area_t bar = box;
+        bar.x2 = box.x1 + vu->rms_w - 1;
+        dsc.bg_color = lv_color_hex(0x2ECC71);
+        lv_draw_rect(layer, &dsc, &bar);
+    }
+    if (vu->peak_x > 0) {
+        lv_area_t mark = box;
+        mark.x1 = box.x1 + vu->peak_x;
+        mark.x2 = mark.x1 + VU_PEAK_W - 1;
+        if (mark.x2 > box.x2) {
+            mark.x2 = box.x2;
+            mark.x1 = box.x2 - VU_PEAK_W + 1;
+        }
+        dsc.bg_color = lv_color_hex(0xE74C3C);
+        lv_draw_rect(layer, &dsc, &mark);
+    }
+}
+
+lv_obj_t *vu_meter_create(lv_obj_t *parent)
+{
+    // parent 为空时 lv_obj_create 会建出一个新屏幕，不是想要的
+    if (!parent) return NULL;
+
+    vu_meter_t *vu = lv_malloc_zeroed(sizeof(vu_meter_t));
+    if (!vu) return NULL;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_style_pad_all(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_radius(obj, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_color(obj, lv_color_hex(0x303030), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_user_data(obj, vu);
+    lv_obj_add_event_cb(obj, vu_event_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, vu_event_cb, LV_EVENT_DELETE, NULL);
+
+    vu->timer = lv_timer_create(vu_timer_cb, VU_PERIOD_MS, obj);
+    return obj;
+}
@@ -0,0 +1,18 @@
+#ifndef VU_METER_H
+#define VU_METER_H
+
+#include <lvgl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 录音页电平表：20 Hz 读取录音电平快照，只重绘变化的条带
+// screens.c 由 EEZ Studio 生成，不要在里面调用；在 ui_init() 之后挂到 objects.recording_page
+lv_obj_t *vu_meter_create(lv_obj_t *parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VU_METER_H */
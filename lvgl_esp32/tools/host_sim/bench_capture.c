@@ -0,0 +1,548 @@
+//--------------------------------------------------------
+// 采集路径：语音活动检测（VAD）场景校验 + 采集 DSP 校验与耗时（主机）
+//
+// 素材为固定种子合成的 48 kHz 单声道信号（仓库里不放录音文件）：
+//   室内底噪（白噪，-66 dBFS）、类语音（基频 + 共振峰谐波的音节，部分音节带擦音）、
+//   低频隆隆声（一阶低通噪声，过零率低）、嘶声（白噪，过零率高）
+//
+// VAD 时间线（按录音任务的帧长逐帧判定，输入即固定增益路径的 16 bit 样点）：
+//   - 底噪：全程不触发
+//   - 起音：语音开始后 ONSET_MAX_FRAMES 帧内判为有声（起音缓冲区补写 200 ms，远大于此）
+//   - 音节间的停顿由挂起覆盖，语音段内不出现空洞
+//   - 收尾：语音结束后约 VAD_HANGOVER_FRAMES 帧回到静音
+//   - 噪声阶跃（隆隆声 / 嘶声）：先判为有声，噪声底跟上后 REQUIET_MAX_S 秒内回到静音并保持
+//   - 噪声中的语音仍能检出；噪声撤掉后不误触发
+//   - 持续元音（无停顿）至少 VOWEL_MIN_S 秒内不被噪声底吸收
+// 门限核对：类语音浊音段、隆隆声、嘶声的过零率与 VAD_ZCR_MAX_Q8 的相对位置；
+//           稳定噪声中不同信噪比下的语音帧检出率（VAD_SNR_SHIFT）
+// 采集 DSP：去直流（输入带 0.5% 满幅直流）、AGC 把小声拉向目标、限幅不超过
+//           CAPTURE_DSP_LIMIT；每样点 / 每 DMA 帧耗时，VAD 每帧耗时
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "capture_dsp.h"
+#include "vad.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 与 recorder.h 一致
+#define RATE                48000
+#define FRAME               256                                 // VAD_FRAME_SAMPLES
+#define FRAME_US            (FRAME * 1000000 / RATE)
+#define HANGOVER_FRAMES     ((400 * 1000 + FRAME_US - 1) / FRAME_US)
+#define DSP_CYCLE_BUDGET    (64 * FRAME)
+
+#define ONSET_MAX_FRAMES    4           // 起音判定最多晚 4 帧（约 21 ms）
+#define REQUIET_MAX_S       4.0         // 噪声阶跃后回到静音的时限
+#define VOWEL_MIN_S         1.5         // 持续元音至少保持有声的时长
+#define MIN_COVERAGE        0.90        // 信噪比 ≥ 12 dB 时语音帧检出率下限
+#define TIMELINE_S          40
+#define N_FRAMES            (TIMELINE_S * RATE / FRAME)
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+// 近似高斯（4 个均匀分布之和），单位方差
+static double gauss(void)
+{
+    double s = 0;
+    for (int i = 0; i < 4; i++) s += (next_rand() >> 8) / 8388608.0 - 1.0;
+    return s * 0.8660254;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double dbfs(double db)
+{
+    return 32768.0 * pow(10, db / 20);
+}
+
+//--------------------------------------------------------
+// 素材：写入浮点暂存区，按目标 RMS 缩放后叠加到时间线
+//--------------------------------------------------------
+static float s_tmp[TIMELINE_S * RATE];
+static float s_line[TIMELINE_S * RATE];
+
+static void mix_in(size_t from, size_t n, double rms)
+{
+    double acc = 0;
+    for (size_t i = 0; i < n; i++) acc += (double)s_tmp[i] * s_tmp[i];
+    double k = acc > 0 ? rms / sqrt(acc / n) : 0;
+    for (size_t i = 0; i < n; i++) s_line[from + i] += (float)(s_tmp[i] * k);
+}
+
+static void gen_white(size_t n)
+{
+    for (size_t i = 0; i < n; i++) s_tmp[i] = (float)gauss();
+}
+
+// 一阶低通（约 150 Hz）噪声：风扇 / 车内隆隆声，过零率低
+static void gen_rumble(size_t n)
+{
+    double y = 0, a = exp(-2 * M_PI * 150.0 / RATE);
+    for (size_t i = 0; i < n; i++) {
+        y = a * y + (1 - a) * gauss();
+        s_tmp[i] = (float)y;
+    }
+}
+
+// 类语音：每 250 ms 一个音节，浊音 170 ms（10 ms 起、30 ms 收），其后 80 ms 停顿；
+// 每第三个音节以 50 ms 擦音（一阶差分白噪）开头。返回最后一个非零样点之后的位置
+static size_t gen_speech(size_t n)
+{
+    static const double formant[][2] = { { 700, 200 }, { 1200, 300 }, { 2600, 400 } };
+    const size_t syll = RATE / 4, voiced = RATE * 170 / 1000;
+    const size_t fric = RATE / 20, attack = RATE / 100, release = RATE * 30 / 1000;
+    double phase = 0, prev = 0;
+    size_t end = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t k = i / syll, t = i % syll;
+        double v = 0;
+        bool has_fric = k % 3 == 0;
+        size_t v0 = has_fric ? fric : 0;
+
+        if (has_fric && t < fric) {
+            double w = gauss();
+            v = 0.5 * (w - prev);
+            prev = w;
+        } else if (t >= v0 && t < v0 + voiced) {
+            size_t u = t - v0;
+            double env = u < attack ? (double)u / attack
+                       : u > voiced - release ? (double)(voiced - u) / release : 1.0;
+            double f0 = 140 + 40 * sin(2 * M_PI * 1.3 * i / RATE) + 15 * (k % 4);
+            phase += 2 * M_PI * f0 / RATE;
+            for (int h = 1; h * f0 < 4000; h++) {
+                double f = h * f0, g = 0.3;
+                for (int m = 0; m < 3; m++) {
+                    double d = (f - formant[m][0]) / formant[m][1];
+                    g += exp(-d * d) / (m + 1);
+                }
+                v += env * g / h * sin(h * phase);
+            }
+        }
+        s_tmp[i] = (float)v;
+        if (v != 0) end = i + 1;
+    }
+    return end;
+}
+
+// 从 at 开始的一帧是否整帧落在浊音稳定段里：每个音节的第 60 ~ 140 ms
+// （有擦音的音节浊音在 50 ~ 220 ms，没有的在 0 ~ 170 ms，去掉起落）
+static bool is_voiced(size_t at)
+{
+    size_t t = at % (RATE / 4);
+    return t >= RATE * 60 / 1000 && t + FRAME <= RATE * 140 / 1000;
+}
+
+//--------------------------------------------------------
+// VAD 逐帧判定
+//--------------------------------------------------------
+static int16_t s_pcm[TIMELINE_S * RATE];
+static bool s_act[N_FRAMES];
+static uint32_t s_zcr[N_FRAMES];
+
+static void to_pcm(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        long v = lrintf(s_line[i]);
+        s_pcm[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+    }
+}
+
+static void run_vad(size_t frames, double *ns_frame)
+{
+    vad_t v;
+    vad_init(&v, HANGOVER_FRAMES);
+    double t0 = now_ns();
+    for (size_t f = 0; f < frames; f++) {
+        s_act[f] = vad_process(&v, s_pcm + f * FRAME, FRAME);
+        s_zcr[f] = v.zcr_q8;
+    }
+    if (ns_frame) *ns_frame = (now_ns() - t0) / frames;
+}
+
+static size_t frame_at(double s)
+{
+    return (size_t)(s * RATE / FRAME);
+}
+
+static uint32_t count_active(size_t f0, size_t f1)
+{
+    uint32_t n = 0;
+    for (size_t f = f0; f < f1; f++) n += s_act[f];
+    return n;
+}
+
+// [f0, f1) 里第一个有声帧，没有时返回 f1
+static size_t first_active(size_t f0, size_t f1)
+{
+    while (f0 < f1 && !s_act[f0]) f0++;
+    return f0;
+}
+
+// [f0, f1) 里最后一个有声帧之后的位置，没有时返回 f0
+static size_t active_end(size_t f0, size_t f1)
+{
+    while (f1 > f0 && !s_act[f1 - 1]) f1--;
+    return f1;
+}
+
+//--------------------------------------------------------
+// 校验：时间线
+//--------------------------------------------------------
+typedef struct {
+    double start, end;              // 语音 / 噪声区间（秒）
+} span_t;
+
+static bool check_speech(const char *name, span_t sp, size_t speech_end, double next_quiet_s)
+{
+    size_t f0 = frame_at(sp.start), f1 = frame_at(sp.end);
+    size_t on = first_active(f0, f1);
+    size_t last = (speech_end + FRAME - 1) / FRAME;          // 语音最后一个样点所在帧之后
+    size_t off = active_end(f0, frame_at(next_quiet_s));
+    uint32_t holes = (uint32_t)((last - on) - count_active(on, last));
+    int release = (int)off - (int)last;
+    bool ok = on - f0 <= ONSET_MAX_FRAMES && holes == 0 &&
+              release >= HANGOVER_FRAMES - 8 && release <= HANGOVER_FRAMES + 1;
+
+    printf("%-8s: onset %zu frames (%.1f ms), %u holes, released %d frames after the last sound "
+           "(hangover %d)\n", name, on - f0, (on - f0) * FRAME * 1000.0 / RATE, holes, release,
+           HANGOVER_FRAMES);
+    return ok;
+}
+
+static bool check_quiet(const char *name, double from, double to)
+{
+    uint32_t n = count_active(frame_at(from), frame_at(to));
+    printf("%-8s: %u active frames in %.1f s\n", name, n, to - from);
+    return n == 0;
+}
+
+// 噪声阶跃：最后一个有声帧之后到区间结束都保持静音，且回到静音不晚于 REQUIET_MAX_S
+static bool check_step(const char *name, double from, double to)
+{
+    size_t f0 = frame_at(from), f1 = frame_at(to);
+    size_t off = active_end(f0, f1);
+    double t = (off - f0) * FRAME / (double)RATE;
+    bool ok = off < f1 && t <= REQUIET_MAX_S;
+    printf("%-8s: active for the first %.2f s after the step, then quiet for %.1f s\n",
+           name, t, (f1 - off) * FRAME / (double)RATE);
+    return ok;
+}
+
+static bool check_timeline(double *ns_frame)
+{
+    //  0 -  3  底噪
+    //  3 -  6  语音 -24 dBFS
+    //  6 -  9  底噪
+    //  9 - 20  隆隆声 -36 dBFS（阶跃）
+    // 20 - 23  隆隆声中的语音 -24 dBFS（信噪比 12 dB）
+    // 23 - 28  隆隆声
+    // 28 - 31  撤掉隆隆声
+    // 31 - 40  嘶声 -42 dBFS（阶跃）
+    const size_t n = TIMELINE_S * RATE;
+    memset(s_line, 0, sizeof(s_line));
+    gen_white(n);
+    mix_in(0, n, dbfs(-66));
+    gen_rumble(19 * RATE);
+    mix_in(9 * RATE, 19 * RATE, dbfs(-36));
+    gen_white(9 * RATE);
+    mix_in(31 * RATE, 9 * RATE, dbfs(-42));
+    size_t end1 = 3 * RATE + gen_speech(3 * RATE);
+    mix_in(3 * RATE, 3 * RATE, dbfs(-24));
+    size_t end2 = 20 * RATE + gen_speech(3 * RATE);
+    mix_in(20 * RATE, 3 * RATE, dbfs(-24));
+    to_pcm(n);
+    run_vad(N_FRAMES, ns_frame);
+
+    bool ok = check_quiet("room", 0, 3);
+    ok = check_speech("speech", (span_t){ 3, 6 }, end1, 9) && ok;
+    ok = check_quiet("room", 6 + 0.5, 9) && ok;
+    ok = check_step("rumble", 9, 20) && ok;
+    ok = check_speech("in noise", (span_t){ 20, 23 }, end2, 28) && ok;
+    ok = check_quiet("rumble", 23 + 0.5, 28) && ok;
+    ok = check_quiet("removed", 28, 31) && ok;
+    ok = check_step("hiss", 31, 40) && ok;
+    return ok;
+}
+
+// 不同强度的隆隆声阶跃：噪声底的上升速度不能随噪声能量线性变慢
+static bool check_steps(void)
+{
+    static const double level_db[] = { -46, -36, -26, -16 };
+    const size_t n = 12 * RATE, frames = n / FRAME;
+    bool ok = true;
+
+    printf("steps   :");
+    for (size_t k = 0; k < sizeof(level_db) / sizeof(level_db[0]); k++) {
+        memset(s_line, 0, n * sizeof(float));
+        s_rand = 4242;
+        gen_white(n);
+        mix_in(0, n, dbfs(-66));
+        gen_rumble(n - 2 * RATE);
+        mix_in(2 * RATE, n - 2 * RATE, dbfs(level_db[k]));
+        to_pcm(n);
+        run_vad(frames, NULL);
+
+        size_t f0 = frame_at(2), off = active_end(f0, frames);
+        double t = (off - f0) * FRAME / (double)RATE;
+        printf(" %.0f dBFS %.2f s%s", level_db[k], t, k + 1 < sizeof(level_db) / sizeof(level_db[0]) ? "," : "");
+        if (count_active(0, f0) || off == frames || t > REQUIET_MAX_S) ok = false;
+    }
+    printf("  (rumble step from the room floor until quiet)\n");
+    return ok;
+}
+
+// 持续元音（没有音节间停顿）：噪声底不能很快把它当成噪声吸收
+static bool check_vowel(void)
+{
+    const size_t n = 14 * RATE;
+    memset(s_line, 0, n * sizeof(float));
+    s_rand = 31;
+    gen_rumble(n);
+    mix_in(0, n, dbfs(-36));
+    double phase = 0;
+    for (size_t i = 0; i < 8 * RATE; i++) {
+        double f0 = 180 + 5 * sin(2 * M_PI * 5 * i / RATE);
+        phase += 2 * M_PI * f0 / RATE;
+        double v = 0;
+        for (int h = 1; h * f0 < 4000; h++) v += sin(h * phase) / h;
+        s_tmp[i] = (float)v;
+    }
+    mix_in(6 * RATE, 8 * RATE, dbfs(-24));
+    to_pcm(n);
+    run_vad(n / FRAME, NULL);
+    size_t f0 = frame_at(6), on = first_active(f0, n / FRAME);
+    size_t q = on; while (q < n / FRAME && s_act[q]) q++;
+    double held = (q - on) * FRAME / (double)RATE;
+    printf("vowel   : onset %zu frames, held %.2f s of 8 s (min %.1f s)\n", on - f0, held, VOWEL_MIN_S);
+    return on - f0 <= ONSET_MAX_FRAMES && held >= VOWEL_MIN_S;
+}
+
+//--------------------------------------------------------
+// 校验：门限
+//--------------------------------------------------------
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t median_zcr(size_t f0, size_t f1)
+{
+    static uint32_t v[N_FRAMES];
+    size_t n = f1 - f0;
+    memcpy(v, s_zcr + f0, n * sizeof(uint32_t));
+    qsort(v, n, sizeof(uint32_t), cmp_u32);
+    return v[n / 2];
+}
+
+// 三种素材单独判定，取过零率中位数（语音只取浊音帧）
+static bool check_zcr(void)
+{
+    const size_t n = 3 * RATE, frames = n / FRAME;
+    uint32_t zcr[3];
+
+    memset(s_line, 0, n * sizeof(float));
+    gen_speech(n);
+    mix_in(0, n, dbfs(-24));
+    to_pcm(n);
+    run_vad(frames, NULL);
+    static uint32_t voiced[N_FRAMES];
+    size_t nv = 0;
+    for (size_t f = 0; f < frames; f++) {
+        if (is_voiced(f * FRAME)) voiced[nv++] = s_zcr[f];
+    }
+    qsort(voiced, nv, sizeof(uint32_t), cmp_u32);
+    zcr[0] = voiced[nv / 2];
+
+    for (int k = 1; k < 3; k++) {
+        memset(s_line, 0, n * sizeof(float));
+        if (k == 1) gen_rumble(n); else gen_white(n);
+        mix_in(0, n, dbfs(-36));
+        to_pcm(n);
+        run_vad(frames, NULL);
+        zcr[k] = median_zcr(0, frames);
+    }
+
+    printf("zcr     : voiced %u, rumble %u, hiss %u (Q8 per sample; VAD_ZCR_MAX_Q8 %d)\n",
+           zcr[0], zcr[1], zcr[2], VAD_ZCR_MAX_Q8);
+    // 浊音在门限下方、嘶声在上方才能靠过零率区分；隆隆声与浊音同侧，只能靠噪声底
+    return zcr[0] < VAD_ZCR_MAX_Q8 && zcr[2] > VAD_ZCR_MAX_Q8;
+}
+
+// 隆隆声稳定 10 s 后叠加 3 s 语音，统计浊音帧的检出率（逐帧判定本身，不算挂起延续的帧）
+static bool check_snr(void)
+{
+    static const double snr_db[] = { 6, 9, 12, 15, 20 };
+    const size_t settle = 10 * RATE, n = 13 * RATE;
+    bool ok = true;
+
+    printf("snr     :");
+    for (size_t k = 0; k < sizeof(snr_db) / sizeof(snr_db[0]); k++) {
+        memset(s_line, 0, n * sizeof(float));
+        s_rand = 777;
+        gen_rumble(n);
+        mix_in(0, n, dbfs(-36));
+        gen_speech(3 * RATE);
+        mix_in(settle, 3 * RATE, dbfs(-36 + snr_db[k]));
+        to_pcm(n);
+
+        vad_t v;
+        vad_init(&v, HANGOVER_FRAMES);
+        uint32_t hit = 0, total = 0, before = 0;
+        for (size_t f = 0; f < n / FRAME; f++) {
+            // 挂起计数刚被重置为满值，说明这一帧本身判为语音
+            bool a = vad_process(&v, s_pcm + f * FRAME, FRAME) && v.hang_left == HANGOVER_FRAMES;
+            size_t at = f * FRAME;
+            if (at < settle) {
+                if (at >= settle - 2 * RATE) before += a;
+                continue;
+            }
+            if (is_voiced(at - settle)) {
+                total++;
+                hit += a;
+            }
+        }
+        double cov = (double)hit / total;
+        printf(" %.0f dB %3.0f%%%s", snr_db[k], cov * 100, k + 1 < sizeof(snr_db) / sizeof(snr_db[0]) ? "," : "");
+        if (before || (snr_db[k] >= 12 && cov < MIN_COVERAGE)) ok = false;
+    }
+    printf("  (voiced frames detected; VAD_SNR_SHIFT %d = %.0f dB)\n", VAD_SNR_SHIFT,
+           10 * log10(1 << VAD_SNR_SHIFT));
+    return ok;
+}
+
+//--------------------------------------------------------
+// 校验：采集 DSP
+//--------------------------------------------------------
+static int32_t s_raw[TIMELINE_S * RATE];
+static int16_t s_out[TIMELINE_S * RATE];
+
+// 16 bit 样点 → I2S 32 bit 槽（24 bit 左对齐），叠加直流
+static void to_raw(size_t n, int32_t dc24)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = (int32_t)lrintf(s_line[i] * 256) + dc24;
+        if (v > 0x7FFFFF) v = 0x7FFFFF;
+        if (v < -0x800000) v = -0x800000;
+        s_raw[i] = (int32_t)((uint32_t)v << 8);
+    }
+}
+
+static void run_dsp(size_t n)
+{
+    capture_dsp_t d;
+    capture_dsp_init(&d);
+    for (size_t i = 0; i < n; i += FRAME) {
+        capture_dsp_process(&d, s_raw + i, s_out + i, FRAME);
+    }
+}
+
+static int peak_abs(size_t from, size_t to)
+{
+    int p = 0;
+    for (size_t i = from; i < to; i++) p = abs(s_out[i]) > p ? abs(s_out[i]) : p;
+    return p;
+}
+
+static bool check_dsp(void)
+{
+    // 0 - 4 s 小声语音 -46 dBFS，4 - 6 s 突然 -6 dBFS；直流 0.5% 满幅
+    const size_t n = 6 * RATE;
+    memset(s_line, 0, n * sizeof(float));
+    s_rand = 99;
+    gen_white(n);
+    mix_in(0, n, dbfs(-70));
+    gen_speech(4 * RATE);
+    mix_in(0, 4 * RATE, dbfs(-46));
+    gen_speech(2 * RATE);
+    mix_in(4 * RATE, 2 * RATE, dbfs(-6));
+    to_raw(n, 0x800000 / 200);
+    run_dsp(n);
+
+    // 去直流：最后 1 秒的均值
+    double mean = 0;
+    for (size_t i = n - RATE; i < n; i++) mean += s_out[i];
+    mean /= RATE;
+
+    int quiet_in = (int)(dbfs(-46) * 2.5), quiet_out = peak_abs(3 * RATE, 4 * RATE);
+    int loud_out = peak_abs(4 * RATE, n);
+    uint32_t clipped = 0;
+    for (size_t i = 0; i < n; i++) clipped += s_out[i] == INT16_MAX || s_out[i] == INT16_MIN;
+
+    printf("dsp     : dc residue %.2f LSB, quiet speech peak %d -> %d (target %d), "
+           "loud onset peak %d (limit %d), %u clipped\n",
+           mean, quiet_in, quiet_out, CAPTURE_DSP_TARGET, loud_out, CAPTURE_DSP_LIMIT, clipped);
+    return fabs(mean) < 4 && quiet_out > CAPTURE_DSP_TARGET / 2 && loud_out <= CAPTURE_DSP_LIMIT &&
+           clipped == 0;
+}
+
+//--------------------------------------------------------
+// 耗时
+//--------------------------------------------------------
+static void bench_dsp(double *ns, double *cyc)
+{
+    const int rounds = 20000;
+    capture_dsp_t d;
+    capture_dsp_init(&d);
+    for (size_t i = 0; i < FRAME; i++) s_raw[i] = (int32_t)(next_rand() & 0xFFFFFF00u) >> 4;
+
+    volatile int16_t sink = 0;
+    double t0 = now_ns();
+    uint64_t c0 = cycles();
+    for (int r = 0; r < rounds; r++) {
+        capture_dsp_process(&d, s_raw, s_out, FRAME);
+        sink += s_out[r % FRAME];
+    }
+    uint64_t c1 = cycles();
+    (void)sink;
+    *ns = (now_ns() - t0) / ((double)rounds * FRAME);
+    *cyc = (double)(c1 - c0) / ((double)rounds * FRAME);
+}
+
+int main(void)
+{
+    double vad_ns;
+    bool ok = check_timeline(&vad_ns);
+    ok = check_steps() && ok;
+    ok = check_vowel() && ok;
+    ok = check_zcr() && ok;
+    ok = check_snr() && ok;
+    ok = check_dsp() && ok;
+
+    double dsp_ns, dsp_cyc;
+    bench_dsp(&dsp_ns, &dsp_cyc);
+    printf("speed   : dsp %.2f ns, %.1f cycles per sample (%.0f per %d-sample frame, "
+           "ESP32 budget %d); vad %.0f ns per frame (host)\n",
+           dsp_ns, dsp_cyc, dsp_cyc * FRAME, FRAME, DSP_CYCLE_BUDGET, vad_ns);
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+//--------------------------------------------------------
+// 采集 32bit → 16bit 转换内核：逐位校验 + 耗时对比（主机）
+//
+// 校验（shift 0 ~ 16，含录音用的 PCM_SHIFT）：
+//   - 优化实现与参考实现、64 位精确结果逐位一致
+//   - 输入：±满幅钳位边界（±32768 << shift 前后各几个值）、INT32_MIN / INT32_MAX、0 / ±1、随机
+//   - 长度 0 ~ 67（覆盖 n % 4 != 0 的收尾），输出末尾之后的哨兵不被改写
+// 耗时：旧的逐样点截断（>> 11 后直接转 int16，会回绕）、参考实现、优化实现，按每样点 ns 计
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "pcm_convert.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PCM_SHIFT       11          // 与 recorder.h 一致
+#define MAX_LEN         67
+#define GUARD           8
+#define BENCH_SAMPLES   1024        // 一个 DMA 块
+#define BENCH_ROUNDS    20000
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int16_t exact(int32_t x, int shift)
+{
+    int64_t v = (int64_t)x >> shift;
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// 旧实现（recorder.c 里的逐样点循环），作为耗时基线
+static void convert_trunc(const int32_t *in, int16_t *out, size_t n, int shift)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (int16_t)(in[i] >> shift);
+    }
+}
+
+//--------------------------------------------------------
+// 校验
+//--------------------------------------------------------
+// 按 shift 生成一组边界输入：钳位阈值两侧、32 位极值、零附近
+static size_t edge_inputs(int shift, int32_t *v)
+{
+    size_t n = 0;
+    int64_t hi = (int64_t)32767 << shift, lo = -((int64_t)32768 << shift);
+    for (int d = -3; d <= 3; d++) {
+        int64_t cand[] = { hi + d, hi + (1LL << shift) + d, lo + d, lo - 1 + d };
+        for (size_t k = 0; k < 4; k++) {
+            if (cand[k] >= INT32_MIN && cand[k] <= INT32_MAX) v[n++] = (int32_t)cand[k];
+        }
+    }
+    static const int32_t fixed[] = { INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX };
+    for (size_t k = 0; k < sizeof(fixed) / sizeof(fixed[0]); k++) v[n++] = fixed[k];
+    return n;
+}
+
+static bool check_shift(int shift, uint64_t *cases)
+{
+    int32_t edge[64];
+    size_t ne = edge_inputs(shift, edge);
+    int32_t in[MAX_LEN];
+    int16_t a[MAX_LEN + GUARD], b[MAX_LEN + GUARD];
+
+    for (int round = 0; round < 2000; round++) {
+        size_t n = round % (MAX_LEN + 1);
+        for (size_t i = 0; i < n; i++) {
+            // 前几轮全是边界值（轮换位置，让每个值都落在展开的各个槽位和收尾里）
+            in[i] = round < 200 || (next_rand() & 3) == 0 ? edge[(i + round) % ne] : (int32_t)next_rand();
+        }
+        for (size_t i = 0; i < MAX_LEN + GUARD; i++) a[i] = b[i] = (int16_t)0x5A5A;
+
+        pcm_s32_to_s16_ref(in, a, n, shift);
+        pcm_s32_to_s16(in, b, n, shift);
+        for (size_t i = 0; i < n; i++) {
+            int16_t e = exact(in[i], shift);
+            if (a[i] != e || b[i] != e) {
+                printf("mismatch: x %ld shift %d at %zu of %zu: ref %d opt %d exact %d\n",
+                       (long)in[i], shift, i, n, a[i], b[i], e);
+                return false;
+            }
+        }
+        for (size_t i = n; i < MAX_LEN + GUARD; i++) {
+            if (a[i] != 0x5A5A || b[i] != 0x5A5A) {
+                printf("overrun: shift %d, length %zu, wrote output[%zu]\n", shift, n, i);
+                return false;
+            }
+        }
+        *cases += n;
+    }
+    return true;
+}
+
+static bool check_all(void)
+{
+    uint64_t cases = 0;
+    for (int shift = 0; shift <= 16; shift++) {
+        if (!check_shift(shift, &cases)) return false;
+    }
+    printf("convert : %llu samples bit-exact (ref, optimized, 64-bit), shift 0..16, lengths 0..%d\n",
+           (unsigned long long)cases, MAX_LEN);
+    return true;
+}
+
+//--------------------------------------------------------
+// 耗时
+//--------------------------------------------------------
+typedef void (*kernel_t)(const int32_t *in, int16_t *out, size_t n, int shift);
+
+static double bench(kernel_t k)
+{
+    static int32_t in[BENCH_SAMPLES];
+    static int16_t out[BENCH_SAMPLES];
+    volatile int16_t sink = 0;
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) in[i] = (int32_t)next_rand() >> 2;
+
+    double t0 = now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        k(in, out, BENCH_SAMPLES, PCM_SHIFT);
+        sink += out[r % BENCH_SAMPLES];
+    }
+    (void)sink;
+    return (now_ns() - t0) / ((double)BENCH_ROUNDS * BENCH_SAMPLES);
+}
+
+int main(void)
+{
+    bool ok = check_all();
+
+    static const struct { const char *name; kernel_t k; } kernels[] = {
+        { "trunc (old)", convert_trunc },
+        { "sat ref", pcm_s32_to_s16_ref },
+        { "sat opt", pcm_s32_to_s16 },
+    };
+    printf("%-12s %10s   (ns per sample, host, %d-sample blocks)\n", "kernel", "ns", BENCH_SAMPLES);
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        printf("%-12s %10.3f\n", kernels[i].name, bench(kernels[i].k));
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+//--------------------------------------------------------
+// 播放音量 / 下混内核：逐位校验 + 耗时对比（主机）
+//
+// 校验：
+//   - 优化实现与参考实现逐位一致（单声道穷举全部输入 × 一组增益，立体声随机 + 边界）
+//   - 参考实现与双精度四舍五入结果一致
+//   - 原地处理结果不变
+//   - 平滑音量单调逼近目标，每个子块变化不超过 PCM_GAIN_STEP
+// 耗时：旧的 float 下混（0.6f 音量 + 两次比较钳位）、参考实现、优化实现，按每样点 ns 计
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "pcm_gain.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_FRAMES    2048
+#define BENCH_ROUNDS    4000
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 旧实现（speaker.c 里的 float 版本），作为耗时基线
+static size_t mix_to_mono_float(const int16_t *p, size_t frames, int channels, float volume, int16_t *out)
+{
+    size_t samples_out = 0;
+
+    if (channels == 2) {
+        for (size_t i = 0; i < frames; i++) {
+            float mixed = (p[2 * i] + p[2 * i + 1]) * 0.5f * volume;
+            if (mixed > 32767.0f) mixed = 32767.0f;
+            if (mixed < -32768.0f) mixed = -32768.0f;
+            out[samples_out++] = (int16_t)mixed;
+        }
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            float s = p[i] * volume;
+            if (s > 32767.0f) s = 32767.0f;
+            if (s < -32768.0f) s = -32768.0f;
+            out[samples_out++] = (int16_t)s;
+        }
+    }
+    return samples_out;
+}
+
+static int16_t exact_mono(int16_t x, int32_t g)
+{
+    double v = floor((double)x * g / 32768.0 + 0.5);
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+static int16_t exact_stereo(int16_t l, int16_t r, int32_t g)
+{
+    double v = floor(((double)l + r) * g / 65536.0 + 0.5);
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+//--------------------------------------------------------
+// 校验
+//--------------------------------------------------------
+static bool check_mono(void)
+{
+    static int16_t in[65536], a[65536], b[65536];
+    for (int i = 0; i < 65536; i++) in[i] = (int16_t)(i - 32768);
+
+    uint64_t cases = 0;
+    for (int32_t g = 0; g <= PCM_GAIN_UNITY; g += (g < 64 || g > PCM_GAIN_UNITY - 64) ? 1 : 61) {
+        pcm_gain_mono_ref(in, a, 65536, g);
+        pcm_gain_mono(in, b, 65536, g);
+        for (int i = 0; i < 65536; i++) {
+            if (a[i] != b[i] || a[i] != exact_mono(in[i], g)) {
+                printf("mono mismatch: x %d gain %ld ref %d opt %d exact %d\n",
+                       in[i], (long)g, a[i], b[i], exact_mono(in[i], g));
+                return false;
+            }
+        }
+        memcpy(b, in, sizeof(b));
+        pcm_gain_mono(b, b, 65536, g);
+        if (memcmp(a, b, sizeof(a)) != 0) {
+            printf("mono in-place mismatch at gain %ld\n", (long)g);
+            return false;
+        }
+        cases += 65536;
+    }
+    printf("mono    : %llu cases bit-exact (ref, optimized, in-place, double)\n", (unsigned long long)cases);
+    return true;
+}
+
+static bool check_stereo(void)
+{
+    enum { N = 65536 };
+    static int16_t in[2 * N], inplace[2 * N], a[N], b[N];
+    static const int16_t edge[] = { -32768, -32767, -1, 0, 1, 32766, 32767 };
+    const size_t ne = sizeof(edge) / sizeof(edge[0]);
+    static const int32_t gains[] = { 0, 1, 2, 3, 19660, 16384, 32767, PCM_GAIN_UNITY };
+
+    uint64_t cases = 0;
+    for (int round = 0; round < 40; round++) {
+        for (size_t i = 0; i < N; i++) {
+            if (i < ne * ne) {
+                in[2 * i] = edge[i / ne];
+                in[2 * i + 1] = edge[i % ne];
+            } else {
+                in[2 * i] = (int16_t)next_rand();
+                in[2 * i + 1] = (int16_t)next_rand();
+            }
+        }
+        int32_t g = round < 8 ? gains[round] : (int32_t)(next_rand() % (PCM_GAIN_UNITY + 1));
+        pcm_downmix_gain_ref(in, a, N, g);
+        pcm_downmix_gain(in, b, N, g);
+        memcpy(inplace, in, sizeof(in));
+        pcm_downmix_gain(inplace, inplace, N, g);
+        for (size_t i = 0; i < N; i++) {
+            int16_t e = exact_stereo(in[2 * i], in[2 * i + 1], g);
+            if (a[i] != b[i] || a[i] != e || inplace[i] != a[i]) {
+                printf("stereo mismatch: %d + %d gain %ld ref %d opt %d in-place %d exact %d\n",
+                       in[2 * i], in[2 * i + 1], (long)g, a[i], b[i], inplace[i], e);
+                return false;
+            }
+        }
+        cases += N;
+    }
+    printf("stereo  : %llu cases bit-exact (ref, optimized, in-place, double)\n", (unsigned long long)cases);
+    return true;
+}
+
+static bool check_smoother(void)
+{
+    static int16_t in[4096], out[4096];
+    for (int i = 0; i < 4096; i++) in[i] = 32767;
+
+    pcm_gain_smoother_t s;
+    pcm_gain_smoother_init(&s, 0);
+    pcm_gain_smoother_set(&s, PCM_GAIN_UNITY);
+    pcm_mix_to_mono(&s, in, 4096, 1, out);
+
+    // 每个子块内增益不变、子块之间单调上升且步长受限，到达目标后保持
+    int prev = -1;
+    size_t reached = 0;
+    for (size_t i = 0; i < 4096; i++) {
+        if (out[i] < prev || (i % PCM_GAIN_SUBBLOCK && out[i] != out[i - 1])) {
+            printf("smoother: not monotonic / not constant within sub-block at %zu\n", i);
+            return false;
+        }
+        if (i % PCM_GAIN_SUBBLOCK == 0 && prev >= 0 && out[i] - prev > PCM_GAIN_STEP + 1) {
+            printf("smoother: step too large at %zu (%d -> %d)\n", i, prev, out[i]);
+            return false;
+        }
+        if (!reached && out[i] == 32767) reached = i;
+        prev = out[i];
+    }
+    size_t expect = (PCM_GAIN_UNITY / PCM_GAIN_STEP - 1) * PCM_GAIN_SUBBLOCK;
+    if (reached != expect || s.current != PCM_GAIN_UNITY) {
+        printf("smoother: reached unity at frame %zu, expected %zu\n", reached, expect);
+        return false;
+    }
+    printf("smoother: 0 -> 1.0 in %zu frames (%.1f ms at 44.1 kHz)\n", reached, reached * 1000.0 / 44100);
+    return true;
+}
+
+//--------------------------------------------------------
+// 耗时
+//--------------------------------------------------------
+typedef void (*kernel_t)(const int16_t *in, int16_t *out, size_t frames, int channels);
+
+static void k_float(const int16_t *in, int16_t *out, size_t frames, int channels)
+{
+    mix_to_mono_float(in, frames, channels, 0.6f, out);
+}
+
+static void k_ref(const int16_t *in, int16_t *out, size_t frames, int channels)
+{
+    if (channels == 2) pcm_downmix_gain_ref(in, out, frames, 19660);
+    else pcm_gain_mono_ref(in, out, frames, 19660);
+}
+
+static void k_opt(const int16_t *in, int16_t *out, size_t frames, int channels)
+{
+    if (channels == 2) pcm_downmix_gain(in, out, frames, 19660);
+    else pcm_gain_mono(in, out, frames, 19660);
+}
+
+static void k_smooth(const int16_t *in, int16_t *out, size_t frames, int channels)
+{
+    static pcm_gain_smoother_t s = { 19660, 19660 };
+    pcm_mix_to_mono(&s, in, frames, channels, out);
+}
+
+static double bench(kernel_t k, int channels)
+{
+    static int16_t in[2 * BENCH_FRAMES], out[BENCH_FRAMES];
+    volatile int16_t sink = 0;
+    for (size_t i = 0; i < 2 * BENCH_FRAMES; i++) in[i] = (int16_t)next_rand();
+
+    double t0 = now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        k(in, out, BENCH_FRAMES, channels);
+        sink += out[r % BENCH_FRAMES];
+    }
+    (void)sink;
+    return (now_ns() - t0) / ((double)BENCH_ROUNDS * BENCH_FRAMES);
+}
+
+int main(void)
+{
+    bool ok = check_mono() && check_stereo() && check_smoother();
+
+    static const struct { const char *name; kernel_t k; } kernels[] = {
+        { "float (old)", k_float },
+        { "q15 ref", k_ref },
+        { "q15 opt", k_opt },
+        { "q15 smooth", k_smooth },
+    };
+    printf("%-12s %10s %10s   (ns per output sample, host)\n", "kernel", "mono", "stereo");
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        printf("%-12s %10.3f %10.3f\n", kernels[i].name, bench(kernels[i].k, 1), bench(kernels[i].k, 2));
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
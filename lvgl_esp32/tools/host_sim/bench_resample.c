@@ -0,0 +1,230 @@
+//--------------------------------------------------------
+// 播放升采样器：质量校验 + 耗时（主机）
+//
+// 对每个支持的输入采样率（→ 48 kHz）：
+//   - 分块：随机的输入块 / 输出容量与一次处理结果逐位一致，总输出数 = ceil(N × 48000 / in)
+//   - THD+N：1 kHz、-1 dBFS 正弦，按已知频率做最小二乘拟合，残差 / 信号
+//   - 通带纹波：0.01 ~ 0.38 × in 扫频，增益最大值 - 最小值
+//   - 镜像抑制：0.3 × in 的正弦，在 in - f 处的残留电平
+//   - 耗时：处理 1 秒音频的主机 CPU 时间
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "resampler.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define OUT_RATE        48000
+#define MAX_THDN_DB     (-80.0)
+#define MAX_RIPPLE_DB   0.1
+#define MAX_IMAGE_DB    (-70.0)
+#define EDGE            64          // 拟合时跳过首尾的输出（补零区）
+
+static const uint32_t s_rates[] = { 8000, 11025, 16000, 22050, 32000, 44100, 48000 };
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 一次处理完整段输入（含排空），返回输出数
+static size_t run(uint32_t rate, const int16_t *in, size_t n, int16_t *out, size_t cap)
+{
+    resampler_t r;
+    resampler_init(&r, rate, OUT_RATE);
+    size_t used, produced = resampler_process(&r, in, n, &used, out, cap);
+    size_t m;
+    while ((m = resampler_drain(&r, out + produced, cap - produced)) > 0) produced += m;
+    return produced;
+}
+
+static int16_t *make_sine(uint32_t rate, double freq, double amp, size_t n)
+{
+    int16_t *x = malloc(n * sizeof(int16_t));
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (int16_t)lrint(amp * 32767.0 * sin(2 * M_PI * freq * i / rate));
+    }
+    return x;
+}
+
+// 在已知频率上拟合 a·sin + b·cos + c，返回幅度；*resid 为残差 RMS
+static double fit_sine(const int16_t *y, size_t n, double freq, double *resid)
+{
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0, s1 = 0, c1 = 0, y1 = 0;
+    for (size_t i = 0; i < n; i++) {
+        double w = 2 * M_PI * freq * (i + EDGE) / OUT_RATE;
+        double s = sin(w), c = cos(w);
+        ss += s * s; cc += c * c; sc += s * c;
+        ys += y[i] * s; yc += y[i] * c;
+        s1 += s; c1 += c; y1 += y[i];
+    }
+    // 3×3 正规方程，克拉默法则
+    double m[3][4] = { { ss, sc, s1, ys }, { sc, cc, c1, yc }, { s1, c1, (double)n, y1 } };
+    double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+               - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+               + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    double coef[3];
+    for (int k = 0; k < 3; k++) {
+        double t[3][3];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) t[i][j] = j == k ? m[i][3] : m[i][j];
+        }
+        coef[k] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1])
+                 - t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0])
+                 + t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+    }
+
+    if (resid) {
+        double e = 0;
+        for (size_t i = 0; i < n; i++) {
+            double w = 2 * M_PI * freq * (i + EDGE) / OUT_RATE;
+            double d = y[i] - coef[0] * sin(w) - coef[1] * cos(w) - coef[2];
+            e += d * d;
+        }
+        *resid = sqrt(e / n);
+    }
+    return hypot(coef[0], coef[1]);
+}
+
+// 输入正弦 → 输出里拟合出的幅度（相对输入幅度），*thdn 为 THD+N（dB）
+static double measure(uint32_t rate, double freq, double amp, double *thdn)
+{
+    size_t n = rate / 2;
+    size_t cap = (size_t)((uint64_t)n * OUT_RATE / rate) + 2;
+    int16_t *x = make_sine(rate, freq, amp, n);
+    int16_t *y = malloc(cap * sizeof(int16_t));
+    size_t m = run(rate, x, n, y, cap);
+
+    double resid;
+    double a = fit_sine(y + EDGE, m - 2 * EDGE, freq, &resid);
+    if (thdn) *thdn = 20 * log10(resid / (a / sqrt(2)));
+    free(x);
+    free(y);
+    return a / (amp * 32767.0);
+}
+
+static bool check_chunking(uint32_t rate)
+{
+    const size_t n = 20000;
+    size_t cap = (size_t)((uint64_t)n * OUT_RATE / rate) + 2;
+    size_t expect = (size_t)(((uint64_t)n * OUT_RATE + rate - 1) / rate);
+    int16_t *x = malloc(n * sizeof(int16_t));
+    int16_t *a = malloc(cap * sizeof(int16_t));
+    int16_t *b = malloc(cap * sizeof(int16_t));
+    for (size_t i = 0; i < n; i++) x[i] = (int16_t)next_rand();
+
+    size_t ma = run(rate, x, n, a, cap);
+
+    resampler_t r;
+    resampler_init(&r, rate, OUT_RATE);
+    size_t fed = 0, mb = 0;
+    while (fed < n) {
+        size_t chunk = 1 + next_rand() % 700, room = 1 + next_rand() % 500;
+        if (chunk > n - fed) chunk = n - fed;
+        if (room > cap - mb) room = cap - mb;
+        size_t used;
+        mb += resampler_process(&r, x + fed, chunk, &used, b + mb, room);
+        fed += used;
+    }
+    size_t m;
+    while ((m = resampler_drain(&r, b + mb, 1 + next_rand() % 7)) > 0) mb += m;
+
+    bool ok = ma == expect && mb == ma && memcmp(a, b, ma * sizeof(int16_t)) == 0;
+    if (!ok) printf("%5lu Hz: chunked %zu / one-shot %zu / expected %zu outputs%s\n", (unsigned long)rate,
+                    mb, ma, expect, mb == ma ? ", contents differ" : "");
+    if (ok && rate == OUT_RATE && memcmp(a, x, n * sizeof(int16_t)) != 0) {
+        printf("%5lu Hz: passthrough is not bit-exact\n", (unsigned long)rate);
+        ok = false;
+    }
+    free(x);
+    free(a);
+    free(b);
+    return ok;
+}
+
+// 处理 1 秒音频的主机 CPU 时间（ms）
+static double bench(uint32_t rate)
+{
+    enum { CHUNK = 2048 };
+    static int16_t in[CHUNK], out[CHUNK];
+    for (int i = 0; i < CHUNK; i++) in[i] = (int16_t)next_rand();
+
+    resampler_t r;
+    resampler_init(&r, rate, OUT_RATE);
+    const int seconds = 20;
+    volatile int16_t sink = 0;
+    double t0 = now_ns();
+    for (uint64_t left = (uint64_t)rate * seconds; left > 0;) {
+        size_t n = left < CHUNK ? left : CHUNK;
+        size_t off = 0;
+        while (off < n) {
+            size_t used;
+            size_t m = resampler_process(&r, in + off, n - off, &used, out, CHUNK);
+            sink += m ? out[m - 1] : 0;
+            off += used;
+        }
+        left -= n;
+    }
+    (void)sink;
+    return (now_ns() - t0) / 1e6 / seconds;
+}
+
+int main(void)
+{
+    bool ok = true;
+
+    printf("%7s %9s %9s %9s %9s %11s\n", "in Hz", "THD+N 1k", "THD+N hi", "ripple", "image", "cpu ms/s");
+    for (size_t i = 0; i < sizeof(s_rates) / sizeof(s_rates[0]); i++) {
+        uint32_t rate = s_rates[i];
+        ok = check_chunking(rate) && ok;
+
+        double thdn_1k, thdn_hi;
+        measure(rate, 1000, 0.891, &thdn_1k);
+        measure(rate, 0.3 * rate, 0.891, &thdn_hi);
+
+        double gmin = 1e9, gmax = 0;
+        for (int k = 0; k <= 40; k++) {
+            double f = rate * (0.01 + (0.38 - 0.01) * k / 40);
+            double g = measure(rate, f, 0.5, NULL);
+            if (g < gmin) gmin = g;
+            if (g > gmax) gmax = g;
+        }
+        double ripple = 20 * log10(gmax / gmin);
+
+        // 0.3 × in 的正弦，镜像在 0.7 × in；48 kHz 直通没有镜像
+        double image = -INFINITY;
+        if (rate < OUT_RATE) {
+            size_t n = rate / 2;
+            size_t cap = (size_t)((uint64_t)n * OUT_RATE / rate) + 2;
+            int16_t *x = make_sine(rate, 0.3 * rate, 0.891, n);
+            int16_t *y = malloc(cap * sizeof(int16_t));
+            size_t m = run(rate, x, n, y, cap);
+            double a = fit_sine(y + EDGE, m - 2 * EDGE, 0.7 * rate, NULL);
+            image = 20 * log10(a / (0.891 * 32767.0));
+            free(x);
+            free(y);
+        }
+
+        double cpu = bench(rate);
+        printf("%7lu %9.1f %9.1f %9.3f %9.1f %11.2f\n", (unsigned long)rate, thdn_1k, thdn_hi, ripple, image, cpu);
+        ok = ok && thdn_1k <= MAX_THDN_DB && ripple <= MAX_RIPPLE_DB && image <= MAX_IMAGE_DB;
+    }
+    printf("limits: THD+N 1k <= %.0f dB, ripple <= %.2f dB (0.01-0.38 x in), image <= %.0f dB\n",
+           MAX_THDN_DB, MAX_RIPPLE_DB, MAX_IMAGE_DB);
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
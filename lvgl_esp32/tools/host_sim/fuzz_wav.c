@@ -0,0 +1,596 @@
+//--------------------------------------------------------
+// WAV 头解析器模糊测试（主机，ASan / UBSan 编译）
+//
+//   - 种子：各种合法 / 非法的文件头（LIST / fact / cue 块、奇数长度填充、
+//     WAVE_FORMAT_EXTENSIBLE、fmt 在 data 之后、data 长度未回填或越界 ...），
+//     逐个核对解析结果
+//   - 变异：随机翻字节、把长度字段改成极端值、截断、插入随机块，
+//     对每个输入检查：不崩溃、不越界，成功时 data 范围在文件内、按块对齐、
+//     帧数 / 时长一致、文件位置停在 data 起点，两次解析结果相同
+//   - 缓存：同一文件第二次命中，文件长度变化或 wav_info_forget 后重新解析；
+//     路径哈希相同、长度和修改时间也相同的两个文件互不命中，forget 一个不影响另一个
+//   - 无损块：编码好的块（压缩 / 未压缩）随机变异后按播放器的方式解析块头、读块体、解码，
+//     块体和输出按实际长度单独分配；检查不越界，返回值只能是 0 或 num_samples，两次结果相同
+// 返回值：0 通过，1 失败，2 参数错误
+//--------------------------------------------------------
+#include "wav_info.h"
+#include "ima_adpcm.h"
+#include "lossless.h"
+#include <math.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define MAX_FILE    4096
+
+typedef struct {
+    uint8_t b[MAX_FILE];
+    size_t len;
+} wav_buf_t;
+
+typedef struct {
+    const char *name;
+    wav_buf_t file;
+    esp_err_t expect;
+    uint16_t format;
+    uint32_t data_offset, data_size, frames;
+} seed_t;
+
+static uint32_t s_rand = 1;
+
+static uint32_t next_rand(void)
+{
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return s_rand;
+}
+
+//--------------------------------------------------------
+// 构造
+//--------------------------------------------------------
+static void put(wav_buf_t *w, const void *p, size_t n)
+{
+    memcpy(w->b + w->len, p, n);
+    w->len += n;
+}
+
+static void put16(wav_buf_t *w, uint16_t v)
+{
+    uint8_t b[2] = { v, v >> 8 };
+    put(w, b, 2);
+}
+
+static void put32(wav_buf_t *w, uint32_t v)
+{
+    uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    put(w, b, 4);
+}
+
+static void riff(wav_buf_t *w)
+{
+    w->len = 0;
+    put(w, "RIFF", 4);
+    put32(w, 0);                // 最后回填
+    put(w, "WAVE", 4);
+}
+
+static void finish(wav_buf_t *w)
+{
+    uint32_t n = (uint32_t)w->len - 8;
+    memcpy(w->b + 4, &n, 4);
+}
+
+// 任意块：长度 len（写进块头的值为 hdr_len），内容为递增字节，奇数长度补 1 字节
+static void chunk(wav_buf_t *w, const char *id, uint32_t len, uint32_t hdr_len)
+{
+    put(w, id, 4);
+    put32(w, hdr_len);
+    for (uint32_t i = 0; i < len; i++) w->b[w->len++] = (uint8_t)i;
+    if (len & 1) w->b[w->len++] = 0;
+}
+
+static void fmt_pcm(wav_buf_t *w, uint16_t ch, uint32_t rate, uint16_t bits)
+{
+    put(w, "fmt ", 4);
+    put32(w, 16);
+    put16(w, WAVE_FORMAT_PCM);
+    put16(w, ch);
+    put32(w, rate);
+    put32(w, rate * ch * bits / 8);
+    put16(w, ch * bits / 8);
+    put16(w, bits);
+}
+
+static void fmt_ext(wav_buf_t *w, uint16_t ch, uint32_t rate, uint16_t bits, uint16_t valid,
+                    uint32_t mask, uint16_t sub, bool good_guid)
+{
+    static const uint8_t tail[14] = { 0, 0, 0, 0, 0x10, 0, 0x80, 0, 0, 0xAA, 0, 0x38, 0x9B, 0x71 };
+    put(w, "fmt ", 4);
+    put32(w, 40);
+    put16(w, WAVE_FORMAT_EXTENSIBLE);
+    put16(w, ch);
+    put32(w, rate);
+    put32(w, rate * ch * bits / 8);
+    put16(w, ch * bits / 8);
+    put16(w, bits);
+    put16(w, 22);
+    put16(w, valid);
+    put32(w, mask);
+    put16(w, sub);
+    put(w, tail, sizeof(tail));
+    if (!good_guid) w->b[w->len - 1] ^= 0xFF;
+}
+
+static void fmt_adpcm(wav_buf_t *w, uint16_t ch, uint32_t rate, uint16_t align)
+{
+    uint16_t spb = (uint16_t)ima_adpcm_samples_per_block(align, ch);
+    put(w, "fmt ", 4);
+    put32(w, 20);
+    put16(w, WAVE_FORMAT_IMA_ADPCM);
+    put16(w, ch);
+    put32(w, rate);
+    put32(w, rate * align / spb);
+    put16(w, align);
+    put16(w, 4);
+    put16(w, 2);
+    put16(w, spb);
+}
+
+static void data(wav_buf_t *w, uint32_t len, uint32_t hdr_len)
+{
+    put(w, "data", 4);
+    put32(w, hdr_len);
+    for (uint32_t i = 0; i < len; i++) w->b[w->len++] = (uint8_t)next_rand();
+}
+
+static int build_seeds(seed_t *s)
+{
+    int n = 0;
+    seed_t *x;
+
+    x = &s[n++];
+    x->name = "plain pcm";
+    riff(&x->file); fmt_pcm(&x->file, 2, 44100, 16); data(&x->file, 800, 800); finish(&x->file);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 44; x->data_size = 800; x->frames = 200;
+
+    x = &s[n++];
+    x->name = "LIST/fact/cue before data, odd padding, trailing id3";
+    riff(&x->file); fmt_pcm(&x->file, 1, 16000, 16);
+    chunk(&x->file, "LIST", 13, 13); chunk(&x->file, "fact", 4, 4); chunk(&x->file, "cue ", 28, 28);
+    data(&x->file, 600, 600); chunk(&x->file, "id3 ", 30, 30); finish(&x->file);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 36 + 22 + 12 + 36 + 8; x->data_size = 600; x->frames = 300;
+
+    x = &s[n++];
+    x->name = "extensible pcm";
+    riff(&x->file); fmt_ext(&x->file, 2, 48000, 16, 16, 0x3, WAVE_FORMAT_PCM, true);
+    data(&x->file, 400, 400); finish(&x->file);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 68; x->data_size = 400; x->frames = 100;
+
+    x = &s[n++];
+    x->name = "ima-adpcm with fact (short last block)";
+    riff(&x->file); fmt_adpcm(&x->file, 1, 16000, 256);
+    put(&x->file, "fact", 4); put32(&x->file, 4); put32(&x->file, 1000);
+    data(&x->file, 1024, 1024); finish(&x->file);
+    x->expect = ESP_OK; x->format = WAVE_FORMAT_IMA_ADPCM; x->data_offset = 60; x->data_size = 1024; x->frames = 1000;
+
+    x = &s[n++];
+    x->name = "fmt after data";
+    riff(&x->file); data(&x->file, 100, 100); fmt_pcm(&x->file, 1, 8000, 16); finish(&x->file);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 20; x->data_size = 100; x->frames = 50;
+
+    x = &s[n++];
+    x->name = "data size 0 (unfinished recording)";
+    riff(&x->file); fmt_pcm(&x->file, 1, 8000, 16); data(&x->file, 301, 0);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 44; x->data_size = 300; x->frames = 150;
+
+    x = &s[n++];
+    x->name = "data size 0xFFFFFFFF (streamed)";
+    riff(&x->file); fmt_pcm(&x->file, 2, 8000, 16); data(&x->file, 400, 0xFFFFFFFF);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 44; x->data_size = 400; x->frames = 100;
+
+    x = &s[n++];
+    x->name = "data size past end of file";
+    riff(&x->file); fmt_pcm(&x->file, 2, 8000, 16); data(&x->file, 402, 100000);
+    x->expect = ESP_OK; x->format = 1; x->data_offset = 44; x->data_size = 400; x->frames = 100;
+
+    x = &s[n++];
+    x->name = "extensible bad guid";
+    riff(&x->file); fmt_ext(&x->file, 2, 48000, 16, 16, 0x3, WAVE_FORMAT_PCM, false);
+    data(&x->file, 400, 400); finish(&x->file);
+    x->expect = ESP_ERR_NOT_SUPPORTED;
+
+    x = &s[n++];
+    x->name = "extensible mask / channel mismatch";
+    riff(&x->file); fmt_ext(&x->file, 2, 48000, 16, 16, 0x7, WAVE_FORMAT_PCM, true);
+    data(&x->file, 400, 400); finish(&x->file);
+    x->expect = ESP_ERR_NOT_SUPPORTED;
+
+    x = &s[n++];
+    x->name = "extensible valid bits > container";
+    riff(&x->file); fmt_ext(&x->file, 1, 48000, 16, 24, 0, WAVE_FORMAT_PCM, true);
+    data(&x->file, 400, 400); finish(&x->file);
+    x->expect = ESP_ERR_NOT_SUPPORTED;
+
+    x = &s[n++];
+    x->name = "LIST chunk past end of file";
+    riff(&x->file); fmt_pcm(&x->file, 1, 8000, 16); chunk(&x->file, "LIST", 10, 5000);
+    data(&x->file, 100, 100); finish(&x->file);
+    x->expect = ESP_ERR_INVALID_SIZE;
+
+    x = &s[n++];
+    x->name = "no data chunk";
+    riff(&x->file); fmt_pcm(&x->file, 1, 8000, 16); chunk(&x->file, "LIST", 10, 10); finish(&x->file);
+    x->expect = ESP_ERR_NOT_FOUND;
+
+    x = &s[n++];
+    x->name = "short fmt";
+    riff(&x->file); chunk(&x->file, "fmt ", 12, 12); data(&x->file, 100, 100); finish(&x->file);
+    x->expect = ESP_ERR_NOT_SUPPORTED;
+
+    x = &s[n++];
+    x->name = "not riff";
+    riff(&x->file); memcpy(x->file.b + 8, "AVI ", 4); fmt_pcm(&x->file, 1, 8000, 16);
+    data(&x->file, 100, 100); finish(&x->file);
+    x->expect = ESP_ERR_INVALID_ARG;
+
+    return n;
+}
+
+//--------------------------------------------------------
+// 解析 + 不变量
+//--------------------------------------------------------
+static esp_err_t parse(const wav_buf_t *w, wav_info_t *info, long *pos)
+{
+    FILE *fp = fmemopen((void *)w->b, w->len ? w->len : 1, "rb");
+    if (!fp) {
+        perror("fmemopen");
+        exit(1);
+    }
+    esp_err_t err = wav_info_parse(fp, (uint32_t)w->len, info);
+    *pos = ftell(fp);
+    fclose(fp);
+    return err;
+}
+
+static const char *check_invariants(const wav_buf_t *w, const wav_info_t *in, long pos)
+{
+    if (in->num_channels == 0 || in->sample_rate == 0 || in->block_align == 0) return "zero fmt field";
+    if (in->data_offset < 20 || in->data_offset > w->len) return "data offset outside file";
+    if ((uint64_t)in->data_offset + in->data_size > w->len) return "data range past end of file";
+    if (pos != (long)in->data_offset) return "file position not at data start";
+    if (in->audio_format != 0x544C && in->data_size % in->block_align) return "data not block aligned";
+    if (in->audio_format == WAVE_FORMAT_PCM && in->frames != in->data_size / in->block_align) {
+        return "pcm frame count";
+    }
+    if (in->duration_ms != (uint32_t)((uint64_t)in->frames * 1000 / in->sample_rate)) return "duration";
+    if (in->valid_bits == 0 || in->valid_bits > in->bits_per_sample) return "valid bits";
+    return NULL;
+}
+
+static void mutate(wav_buf_t *w)
+{
+    int ops = 1 + next_rand() % 4;
+    for (int k = 0; k < ops && w->len > 0; k++) {
+        uint32_t at = next_rand() % w->len;
+        switch (next_rand() % 6) {
+        case 0:                                     // 翻一个字节
+            w->b[at] ^= (uint8_t)(1 + next_rand() % 255);
+            break;
+        case 1: {                                   // 长度 / 字段改成极端值
+            static const uint32_t v[] = { 0, 1, 2, 3, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0xFFFFFFFE, 40, 16 };
+            uint32_t x = v[next_rand() % (sizeof(v) / sizeof(v[0]))];
+            at &= ~1u;
+            if (at + 4 <= w->len) memcpy(w->b + at, &x, 4);
+            break;
+        }
+        case 2:                                     // 截断
+            w->len = at;
+            break;
+        case 3: {                                   // 插入随机块
+            uint32_t len = next_rand() % 64;
+            if (w->len + 8 + len + 1 > MAX_FILE) break;
+            memmove(w->b + at + 8 + len, w->b + at, w->len - at);
+            static const char *ids[] = { "LIST", "fact", "fmt ", "data", "cue ", "JUNK" };
+            memcpy(w->b + at, ids[next_rand() % 6], 4);
+            uint32_t hdr = next_rand() % 4 ? len : next_rand();
+            memcpy(w->b + at + 4, &hdr, 4);
+            for (uint32_t i = 0; i < len; i++) w->b[at + 8 + i] = (uint8_t)next_rand();
+            w->len += 8 + len;
+            break;
+        }
+        case 4:                                     // 随机 16 位字段
+            if (at + 2 <= w->len) {
+                uint16_t x = (uint16_t)next_rand();
+                memcpy(w->b + at, &x, 2);
+            }
+            break;
+        default:                                    // 复制一段（重复块）
+            if (w->len * 2 <= MAX_FILE) {
+                uint32_t n = next_rand() % (w->len - at + 1);
+                memmove(w->b + at + n, w->b + at, w->len - at);
+                w->len += n;
+            }
+            break;
+        }
+    }
+}
+
+//--------------------------------------------------------
+// 缓存
+//--------------------------------------------------------
+static bool write_file(const char *path, const wav_buf_t *w)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool ok = fwrite(w->b, 1, w->len, fp) == w->len;
+    return fclose(fp) == 0 && ok;
+}
+
+static bool check_cache(const seed_t *seed)
+{
+    const char *path = "fuzz_wav.tmp";
+    wav_info_t a, b;
+    wav_info_stats_t st0, st;
+    bool ok = true;
+
+    wav_info_get_stats(&st0);
+    ok = ok && write_file(path, &seed->file);
+    ok = ok && wav_info_load(path, NULL, &a) == ESP_OK;
+    ok = ok && wav_info_load(path, NULL, &b) == ESP_OK && memcmp(&a, &b, sizeof(a)) == 0;
+    wav_info_get_stats(&st);
+    bool hit = st.hits == st0.hits + 1 && st.misses == st0.misses + 1;
+
+    // 录音还在写（data 长度未回填）：文件变长后键不同，重新解析出新的 data 长度
+    wav_buf_t longer = seed->file;
+    for (int i = 0; i < 100; i++) longer.b[longer.len++] = (uint8_t)next_rand();
+    ok = ok && write_file(path, &longer);
+    ok = ok && wav_info_load(path, NULL, &b) == ESP_OK;
+    wav_info_get_stats(&st0);
+    bool resized = st0.misses == st.misses + 1 && b.data_size == a.data_size + 100;
+
+    wav_info_forget(path);
+    ok = ok && wav_info_load(path, NULL, &b) == ESP_OK;
+    wav_info_get_stats(&st);
+    bool forgot = st.misses == st0.misses + 1;
+
+    remove(path);
+    printf("cache   : second load %s, resized file %s, forget %s\n",
+           hit ? "hit" : "MISSED", resized ? "re-parsed" : "STALE", forgot ? "re-parsed" : "STALE");
+    return ok && hit && resized && forgot;
+}
+
+// 与 wav_info.c 的路径哈希相同（FNV-1a）
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+// 两个路径哈希相撞、长度和修改时间都相同、采样率不同的文件
+static bool check_collision(const seed_t *seed)
+{
+    const char *pa = "fuzz_wav.338ab.tmp", *pb = "fuzz_wav.78978.tmp";
+    wav_buf_t fa = seed->file, fb = seed->file;
+    fb.b[24] ^= 0x01;                                   // fmt 采样率的低字节
+    wav_info_t a, b, c;
+    wav_info_stats_t st0, st;
+    struct utimbuf t = { .actime = 1000000000, .modtime = 1000000000 };
+    bool ok = fnv1a(pa) == fnv1a(pb);
+
+    ok = ok && write_file(pa, &fa) && write_file(pb, &fb) && utime(pa, &t) == 0 && utime(pb, &t) == 0;
+    wav_info_get_stats(&st0);
+    ok = ok && wav_info_load(pa, NULL, &a) == ESP_OK;
+    ok = ok && wav_info_load(pb, NULL, &b) == ESP_OK;
+    ok = ok && wav_info_load(pa, NULL, &c) == ESP_OK;
+    wav_info_get_stats(&st);
+    bool apart = ok && a.sample_rate != b.sample_rate && c.sample_rate == a.sample_rate &&
+                 st.misses == st0.misses + 2 && st.hits == st0.hits + 1;
+
+    wav_info_forget(pb);
+    ok = ok && wav_info_load(pa, NULL, &c) == ESP_OK;
+    wav_info_get_stats(&st0);
+    bool kept = ok && st0.hits == st.hits + 1;
+
+    remove(pa);
+    remove(pb);
+    printf("cache   : hash collision %s, forget of the other path %s\n",
+           apart ? "kept apart" : "MIXED UP", kept ? "kept this one" : "DROPPED IT");
+    return ok && apart && kept;
+}
+
+//--------------------------------------------------------
+// 无损块解码器：卡上文件的解析边界
+//--------------------------------------------------------
+#define LL_SEEDS    4
+
+static uint32_t ll_seeds(uint8_t blocks[LL_SEEDS][LOSSLESS_MAX_BLOCK_BYTES], uint32_t *lens,
+                         int16_t pcm[LL_SEEDS][LOSSLESS_BLOCK_SAMPLES], uint32_t *counts)
+{
+    static const uint32_t n[LL_SEEDS] = { LOSSLESS_BLOCK_SAMPLES, LOSSLESS_BLOCK_SAMPLES, 517, 3 };
+    for (int k = 0; k < LL_SEEDS; k++) {
+        for (uint32_t i = 0; i < n[k]; i++) {
+            double v = k == 1 ? (int16_t)next_rand() : 9000 * sin(i * (0.05 + 0.07 * k)) + (next_rand() % 64);
+            pcm[k][i] = (int16_t)v;
+        }
+        counts[k] = n[k];
+        lens[k] = lossless_encode_block(pcm[k], n[k], blocks[k]);
+    }
+    return LL_SEEDS;
+}
+
+// 与播放器一样：先解析块头，再按块头读块体，文件里不够就放弃
+static uint32_t ll_decode(const uint8_t *b, uint32_t len, lossless_block_info_t *info, int16_t **out)
+{
+    *out = NULL;
+    if (len < LOSSLESS_HEADER_BYTES || !lossless_parse_header(b, info)) return UINT32_MAX;
+    if (LOSSLESS_HEADER_BYTES + (uint32_t)info->body_bytes > len) return UINT32_MAX;
+
+    uint8_t *body = malloc(info->body_bytes ? info->body_bytes : 1);
+    memcpy(body, b + LOSSLESS_HEADER_BYTES, info->body_bytes);
+    *out = malloc(info->num_samples * sizeof(int16_t));
+    uint32_t got = lossless_decode_block(info, body, *out);
+    free(body);
+    return got;
+}
+
+static bool fuzz_lossless(long iters)
+{
+    static uint8_t blocks[LL_SEEDS][LOSSLESS_MAX_BLOCK_BYTES];
+    static int16_t pcm[LL_SEEDS][LOSSLESS_BLOCK_SAMPLES];
+    uint32_t lens[LL_SEEDS], counts[LL_SEEDS];
+    uint32_t n = ll_seeds(blocks, lens, pcm, counts);
+    bool ok = true;
+
+    for (uint32_t k = 0; k < n; k++) {
+        lossless_block_info_t info;
+        int16_t *out;
+        uint32_t got = ll_decode(blocks[k], lens[k], &info, &out);
+        if (got != counts[k] || memcmp(out, pcm[k], got * sizeof(int16_t)) != 0) {
+            printf("lossless: seed %u (order %u) does not round-trip\n", k, blocks[k][4]);
+            ok = false;
+        }
+        free(out);
+    }
+
+    uint32_t hdr_bad = 0, short_body = 0, rejected = 0, decoded = 0, failures = 0;
+    for (long it = 0; it < iters; it++) {
+        uint32_t k = next_rand() % n;
+        uint8_t b[LOSSLESS_MAX_BLOCK_BYTES];
+        uint32_t len = lens[k];
+        memcpy(b, blocks[k], len);
+
+        int ops = 1 + next_rand() % 3;
+        for (int op = 0; op < ops; op++) {
+            uint32_t at = next_rand() % len;
+            switch (next_rand() % 5) {
+            case 0: b[at] ^= (uint8_t)(1 + next_rand() % 255); break;         // 块体 / 块头翻字节
+            case 1: b[2 + next_rand() % 6] = (uint8_t)next_rand(); break;     // 块头字段
+            case 2: len = at > 0 ? at : 1; break;                           // 截断
+            case 3: b[at] = 0; break;
+            default: {                                                      // 块体长度与实际不符
+                uint16_t body = (uint16_t)(next_rand() % (LOSSLESS_MAX_BODY_BYTES + 2));
+                b[6] = (uint8_t)body;
+                b[7] = (uint8_t)(body >> 8);
+                break;
+            }
+            }
+        }
+
+        lossless_block_info_t i1, i2;
+        int16_t *o1, *o2;
+        uint32_t g1 = ll_decode(b, len, &i1, &o1);
+        uint32_t g2 = ll_decode(b, len, &i2, &o2);
+
+        const char *why = NULL;
+        if (g1 != g2 || (g1 != UINT32_MAX && g1 && memcmp(o1, o2, g1 * sizeof(int16_t)) != 0)) {
+            why = "not deterministic";
+        } else if (g1 == UINT32_MAX) {
+            if (len >= LOSSLESS_HEADER_BYTES && lossless_parse_header(b, &i1)) short_body++;
+            else hdr_bad++;
+        } else if (g1 != 0 && g1 != i1.num_samples) {
+            why = "partial sample count";
+        } else if (g1) {
+            decoded++;
+        } else {
+            rejected++;
+        }
+        free(o1);
+        free(o2);
+        if (why) {
+            if (failures++ < 10) printf("lossless iter %ld: %s\n", it, why);
+            ok = false;
+        }
+    }
+    printf("lossless: %ld blocks, bad header %lu, body past end %lu, body rejected %lu, decoded %lu, "
+           "%lu failures\n", iters, (unsigned long)hdr_bad, (unsigned long)short_body,
+           (unsigned long)rejected, (unsigned long)decoded, (unsigned long)failures);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    long iters = 200000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n': iters = atol(optarg); break;
+        case 's': s_rand = (uint32_t)strtoul(optarg, NULL, 0) | 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n ITERATIONS] [-s SEED]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static seed_t seeds[32];
+    int n_seeds = build_seeds(seeds);
+    bool ok = true;
+
+    for (int i = 0; i < n_seeds; i++) {
+        const seed_t *x = &seeds[i];
+        wav_info_t info;
+        long pos;
+        esp_err_t err = parse(&x->file, &info, &pos);
+        bool good = err == x->expect;
+        if (good && err == ESP_OK) {
+            good = info.audio_format == x->format && info.data_offset == x->data_offset &&
+                   info.data_size == x->data_size && info.frames == x->frames &&
+                   check_invariants(&x->file, &info, pos) == NULL;
+        }
+        if (!good) {
+            printf("seed    : %s -> %s (offset %lu, size %lu, frames %lu), expected %s\n", x->name,
+                   esp_err_to_name(err), (unsigned long)info.data_offset, (unsigned long)info.data_size,
+                   (unsigned long)info.frames, esp_err_to_name(x->expect));
+            ok = false;
+        }
+    }
+    printf("seeds   : %d %s\n", n_seeds, ok ? "ok" : "FAILED");
+
+    ok = check_cache(&seeds[5]) && ok;     // data 长度未回填的录音
+    ok = check_collision(&seeds[0]) && ok;
+
+    uint32_t hist[5] = { 0 };
+    static const esp_err_t codes[] = { ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NOT_FOUND,
+                                       ESP_ERR_INVALID_SIZE, ESP_ERR_NOT_SUPPORTED };
+    uint32_t failures = 0;
+    for (long it = 0; it < iters; it++) {
+        static wav_buf_t w;
+        w = seeds[next_rand() % n_seeds].file;
+        mutate(&w);
+
+        wav_info_t a, b;
+        long pos_a, pos_b;
+        esp_err_t ea = parse(&w, &a, &pos_a);
+        esp_err_t eb = parse(&w, &b, &pos_b);
+
+        const char *why = NULL;
+        if (ea != eb || (ea == ESP_OK && memcmp(&a, &b, sizeof(a)) != 0)) why = "not deterministic";
+        else if (ea == ESP_OK) why = check_invariants(&w, &a, pos_a);
+
+        int k = 0;
+        while (k < 5 && codes[k] != ea) k++;
+        if (k == 5) why = why ? why : "unexpected error code";
+        else hist[k]++;
+
+        if (why) {
+            if (failures++ < 10) printf("iter %ld: %s (%s, %zu bytes)\n", it, why, esp_err_to_name(ea), w.len);
+            ok = false;
+        }
+    }
+    printf("fuzz    : %ld inputs, ok %lu, not riff %lu, missing chunk %lu, bad size %lu, bad fmt %lu, "
+           "%lu invariant failures\n", iters, (unsigned long)hist[0], (unsigned long)hist[1],
+           (unsigned long)hist[2], (unsigned long)hist[3], (unsigned long)hist[4], (unsigned long)failures);
+
+    ok = fuzz_lossless(iters / 2) && ok;
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC     (-1)
+#define GPIO_NUM_1      1
+#define GPIO_NUM_2      2
+#define GPIO_NUM_3      3
+#define GPIO_NUM_4      4
+#define GPIO_NUM_5      5
+#define GPIO_NUM_6      6
+#define GPIO_NUM_11     11
+#define GPIO_NUM_12     12
+#define GPIO_NUM_13     13
+#define GPIO_NUM_14     14
+#define GPIO_NUM_45     45
+#define GPIO_NUM_46     46
@@ -0,0 +1,108 @@
+#pragma once
+// 主机仿真：I2S 标准模式的子集
+// 接收通道按真实采样率节拍产生信号（sim_i2s_set_source），DMA 环满时丢弃最旧的帧；
+// 发送通道按真实采样率节拍消耗数据，写入来得太晚时记一次欠载
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef struct sim_i2s_chan *i2s_chan_handle_t;
+typedef int i2s_port_t;
+
+#define I2S_NUM_0                   0
+#define I2S_NUM_1                   1
+#define I2S_ROLE_MASTER             0
+#define I2S_DATA_BIT_WIDTH_16BIT    16
+#define I2S_DATA_BIT_WIDTH_24BIT    24
+#define I2S_DATA_BIT_WIDTH_32BIT    32
+#define I2S_SLOT_MODE_MONO          1
+#define I2S_SLOT_MODE_STEREO        2
+#define I2S_STD_SLOT_LEFT           1
+#define I2S_STD_SLOT_RIGHT          2
+#define I2S_STD_SLOT_BOTH           3
+#define I2S_GPIO_UNUSED             GPIO_NUM_NC
+#define I2S_MCLK_MULTIPLE_256       256
+
+typedef int i2s_data_bit_width_t;
+typedef int i2s_slot_mode_t;
+
+typedef struct {
+    i2s_port_t id;
+    int role;
+    uint32_t dma_desc_num;
+    uint32_t dma_frame_num;
+    bool auto_clear;
+    bool auto_clear_after_cb;
+    bool auto_clear_before_cb;
+    int intr_priority;
+} i2s_chan_config_t;
+
+#define I2S_CHANNEL_DEFAULT_CONFIG(i2s_num, i2s_role) { \
+    .id = (i2s_num), .role = (i2s_role), .dma_desc_num = 6, .dma_frame_num = 240, \
+    .auto_clear = false, .auto_clear_after_cb = false, .auto_clear_before_cb = false, .intr_priority = 0 }
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    int clk_src;
+    int mclk_multiple;
+} i2s_std_clk_config_t;
+
+typedef struct {
+    i2s_data_bit_width_t data_bit_width;
+    int slot_bit_width;
+    i2s_slot_mode_t slot_mode;
+    int slot_mask;
+    uint32_t ws_width;
+    bool ws_pol;
+    bool bit_shift;
+} i2s_std_slot_config_t;
+
+typedef struct {
+    bool mclk_inv;
+    bool bclk_inv;
+    bool ws_inv;
+} i2s_std_gpio_invert_t;
+
+typedef struct {
+    gpio_num_t mclk, bclk, ws, dout, din;
+    i2s_std_gpio_invert_t invert_flags;
+} i2s_std_gpio_config_t;
+
+typedef struct {
+    i2s_std_clk_config_t clk_cfg;
+    i2s_std_slot_config_t slot_cfg;
+    i2s_std_gpio_config_t gpio_cfg;
+} i2s_std_config_t;
+
+#define I2S_STD_CLK_DEFAULT_CONFIG(rate) { .sample_rate_hz = (rate), .clk_src = 0, .mclk_multiple = I2S_MCLK_MULTIPLE_256 }
+#define I2S_STD_MSB_SLOT_DEFAULT_CONFIG(bits, mode)     { .data_bit_width = (bits), .slot_mode = (mode), .slot_mask = I2S_STD_SLOT_BOTH }
+#define I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bits, mode) { .data_bit_width = (bits), .slot_mode = (mode), .slot_mask = I2S_STD_SLOT_BOTH, .bit_shift = true }
+
+typedef struct {
+    void *data;
+    size_t size;
+    void *dma_buf;
+} i2s_event_data_t;
+
+typedef bool (*i2s_isr_callback_t)(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+
+typedef struct {
+    i2s_isr_callback_t on_recv;
+    i2s_isr_callback_t on_recv_q_ovf;
+    i2s_isr_callback_t on_sent;
+    i2s_isr_callback_t on_send_q_ovf;
+} i2s_event_callbacks_t;
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *chan_cfg, i2s_chan_handle_t *ret_tx, i2s_chan_handle_t *ret_rx);
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t *std_cfg);
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t handle, const i2s_std_clk_config_t *clk_cfg);
+esp_err_t i2s_channel_reconfig_std_slot(i2s_chan_handle_t handle, const i2s_std_slot_config_t *slot_cfg);
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read, uint32_t timeout_ms);
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written, uint32_t timeout_ms);
+esp_err_t i2s_channel_preload_data(i2s_chan_handle_t tx_handle, const void *src, size_t size, size_t *bytes_loaded);
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t *callbacks, void *user_data);
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// 按当前线程的 CPU 时间折算成 240 MHz 周期数
+uint32_t esp_cpu_get_cycle_count(void);
@@ -0,0 +1,21 @@
+#pragma once
+// 主机仿真：ESP-IDF esp_err.h 的最小子集
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_INVALID_SIZE    0x104
+#define ESP_ERR_NOT_FOUND       0x105
+#define ESP_ERR_NOT_SUPPORTED   0x106
+#define ESP_ERR_TIMEOUT         0x107
+#define ESP_ERR_INVALID_CRC     0x109
+
+const char *esp_err_to_name(esp_err_t err);
+
+#define ESP_ERROR_CHECK(x) do { esp_err_t err_ = (x); if (err_ != ESP_OK) sim_abort_on_error(err_, #x, __FILE__, __LINE__); } while (0)
+void sim_abort_on_error(esp_err_t err, const char *expr, const char *file, int line);
@@ -0,0 +1,14 @@
+#pragma once
+// 主机仿真：日志输出到 stderr，级别由 sim_log_level 控制（0 错误 ... 3 信息）
+#include <stdio.h>
+
+extern int sim_log_level;
+
+#define SIM_LOG(lvl, c, tag, fmt, ...) \
+    do { if (sim_log_level >= (lvl)) fprintf(stderr, c " (%s) " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) SIM_LOG(0, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) SIM_LOG(1, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) SIM_LOG(2, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) SIM_LOG(3, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) SIM_LOG(4, "V", tag, fmt, ##__VA_ARGS__)
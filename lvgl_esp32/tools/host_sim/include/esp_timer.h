@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// 单调时钟，微秒
+int64_t esp_timer_get_time(void);
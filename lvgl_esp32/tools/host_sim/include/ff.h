@@ -0,0 +1,57 @@
+#pragma once
+// 主机仿真：FatFs 直接 API 的子集，文件落在 sim_sd_root() 目录下，
+// 写入 / 同步按 sim_sd_config_t 注入延迟
+#include <stdint.h>
+
+typedef unsigned int UINT;
+typedef uint8_t BYTE;
+typedef uint32_t FSIZE_t;
+
+#define FF_MIN_SS           512
+#define FF_MAX_SS           512
+
+typedef struct {
+    uint16_t csize;              // 每簇扇区数
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+} FFOBJID;
+
+typedef struct {
+    FFOBJID obj;
+    int fd;
+    FSIZE_t fptr;
+    FSIZE_t objsize;
+} FIL;
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+} FRESULT;
+
+#define FA_READ             0x01
+#define FA_WRITE            0x02
+#define FA_OPEN_EXISTING    0x00
+#define FA_CREATE_NEW       0x04
+#define FA_CREATE_ALWAYS    0x08
+#define FA_OPEN_ALWAYS      0x10
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_truncate(FIL *fp);
+FRESULT f_sync(FIL *fp);
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_unlink(const char *path);
+
+#define f_tell(fp) ((fp)->fptr)
+#define f_size(fp) ((fp)->objsize)
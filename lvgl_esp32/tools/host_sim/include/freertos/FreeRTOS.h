@@ -0,0 +1,34 @@
+#pragma once
+// 主机仿真：FreeRTOS 子集，任务为 pthread，1 tick = 1 ms
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdFAIL              0
+#define portMAX_DELAY       ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS  1
+#define configTICK_RATE_HZ  1000
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define tskNO_AFFINITY      0x7fffffff
+#define configASSERT(x)     do { if (!(x)) sim_assert_failed(#x, __FILE__, __LINE__); } while (0)
+
+void sim_assert_failed(const char *expr, const char *file, int line);
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)     ((void)(mux), sim_critical_enter())
+#define portEXIT_CRITICAL(mux)      ((void)(mux), sim_critical_exit())
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)  portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(x)       ((void)(x))
+#define IRAM_ATTR
+
+void sim_critical_enter(void);
+void sim_critical_exit(void);
@@ -0,0 +1,8 @@
+#pragma once
+#include <stdio.h>
+
+typedef struct sdmmc_card {
+    int pdrv;
+} sdmmc_card_t;
+
+static inline void sdmmc_card_print_info(FILE *stream, const sdmmc_card_t *c) { (void)stream; (void)c; }
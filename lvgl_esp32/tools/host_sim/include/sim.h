@@ -0,0 +1,95 @@
+#pragma once
+//--------------------------------------------------------
+// 主机仿真公共接口
+//
+// 时间：所有 ESP-IDF / FreeRTOS 时间都是虚拟时间 = 实际时间 × sim_time_scale，
+//       scale > 1 时仿真快于实时（I2S 节拍、SD 延迟、任务延时一起加速）
+// I2S：接收通道按采样率节拍从 source 取样点，发送通道按节拍把数据交给 sink
+// SD ：FatFs 直接 API 与 stdio（/sdcard/...）都落在 root 目录下，按配置注入延迟
+//--------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "driver/i2s_std.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ 时间 ------------------------------
+extern double sim_time_scale;
+
+int64_t sim_now_us(void);                 // 虚拟时间（微秒）
+void sim_sleep_until_us(int64_t t_us);    // 睡到虚拟时间 t_us
+void sim_sleep_us(int64_t us);            // 睡眠虚拟时间 us
+double sim_process_cpu_us(void);          // 进程 CPU 时间（实际微秒）
+
+//------------------------------ I2S -------------------------------
+// 返回第 frame 帧 slot 声道的样点（按通道位宽截取）
+typedef int32_t (*sim_i2s_source_t)(uint64_t frame, int slot, void *ctx);
+// 发送通道每次实际“播出”的数据；first_frame 为这段数据在输出流中的帧号
+typedef void (*sim_i2s_sink_t)(uint64_t first_frame, const void *data, size_t bytes, void *ctx);
+
+typedef struct {
+    uint64_t rx_frames;          // 接收通道交付的帧数
+    uint64_t rx_dropped;         // 读取不及时、DMA 环满被覆盖的帧数
+    uint32_t rx_overflows;       // 发生覆盖的次数
+    uint64_t tx_frames;          // 发送通道写入的帧数
+    uint64_t tx_gap_frames;      // 写入来得太晚、DAC 输出静音的帧数
+    uint32_t tx_underruns;       // 欠载次数
+    uint64_t tx_discarded;       // 关闭发送通道时 DMA 中尚未播出而被丢弃的帧数
+    uint32_t tx_restarts;        // 关闭后重新开始发送的次数
+    int64_t tx_restart_gap_us;   // 每次重新开始前 DAC 静音时长之和
+    int64_t tx_restart_gap_max_us;
+} sim_i2s_stats_t;
+
+void sim_i2s_set_source(sim_i2s_source_t source, void *ctx);
+void sim_i2s_set_sink(sim_i2s_sink_t sink, void *ctx);
+void sim_i2s_get_stats(sim_i2s_stats_t *out);
+// 发送通道最近一轮（通道关闭后仍是刚结束的那一轮）里第 frame 帧到达 DAC 的时刻
+int64_t sim_i2s_tx_time(uint64_t frame);
+
+//------------------------------ SD --------------------------------
+typedef struct {
+    const char *root;            // 映射为 /sdcard 的主机目录
+    uint32_t write_kbps;         // 写带宽（KB/s，0 为不限）
+    uint32_t read_kbps;          // 读带宽（KB/s，0 为不限）
+    uint32_t op_latency_us;      // 每次读 / 写 / 同步的固定延迟
+    uint32_t spike_us;           // 延迟尖峰时长（模拟卡内部擦除 / 垃圾回收）
+    uint32_t spike_permille;     // 每次读 / 写出现尖峰的概率（千分比）
+    unsigned seed;
+    uint32_t cluster_bytes;      // 卷的簇大小（0 为 32 KB）
+} sim_sd_config_t;
+
+typedef struct {
+    uint64_t writes, write_bytes;
+    uint64_t reads, read_bytes;
+    uint32_t syncs;
+    uint32_t spikes;
+    uint32_t max_op_us;          // 单次操作最大（虚拟）耗时
+    uint32_t cross_cluster;      // 跨越簇边界的 f_write 次数
+} sim_sd_stats_t;
+
+// 每次数据落到“卡”上时回调（直写 f_write 与 stdio 写入都会回调）
+typedef void (*sim_sd_write_hook_t)(const char *path, uint32_t offset, const void *data, uint32_t len, void *ctx);
+
+void sim_sd_init(const sim_sd_config_t *cfg);                  // 可重复调用，统计清零
+void sim_sd_set_write_hook(sim_sd_write_hook_t hook, void *ctx);
+void sim_sd_get_stats(sim_sd_stats_t *out);
+const char *sim_sd_host_path(const char *vfs_path, char *out, size_t len);   // /sdcard/x → 主机路径
+
+// stdio 重定向（sim_vfs.h 在编译固件源文件时强制包含）
+FILE *sim_fopen(const char *path, const char *mode);
+size_t sim_fread(void *ptr, size_t size, size_t n, FILE *fp);
+size_t sim_fwrite(const void *ptr, size_t size, size_t n, FILE *fp);
+int sim_fclose(FILE *fp);
+int sim_remove(const char *path);
+DIR *sim_opendir(const char *path);
+int sim_stat(const char *path, struct stat *st);
+
+#ifdef __cplusplus
+}
+#endif
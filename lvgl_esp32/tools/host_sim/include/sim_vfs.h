@@ -0,0 +1,13 @@
+#pragma once
+// 编译固件源文件时用 -include 强制包含：/sdcard 下的 stdio 访问改走仿真 SD
+#include <stdio.h>
+#include <sys/stat.h>
+#include "sim.h"
+
+#define fopen   sim_fopen
+#define fread   sim_fread
+#define fwrite  sim_fwrite
+#define fclose  sim_fclose
+#define remove  sim_remove
+#define opendir sim_opendir
+#define stat(path, st) sim_stat(path, st)
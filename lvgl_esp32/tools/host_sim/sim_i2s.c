@@ -0,0 +1,382 @@
+//--------------------------------------------------------
+// 主机仿真：I2S 通道
+//
+// 接收：启用时刻起按采样率“产生”帧，DMA 环（desc_num × frame_num 帧）装满后
+//       最旧的帧被覆盖，与真实 DMA 一样丢帧；read 在所需的帧产生之前阻塞
+// 发送：启用后第一次写入时刻起按采样率“播出”（启用前预载了数据时从启用时刻起），
+//       DMA 环满时 write 阻塞；写入落后于播出位置时，中间的帧输出静音，记一次欠载；
+//       关闭通道时 DMA 中还没播出的帧被丢弃；关闭后再次开始发送时，
+//       记录 DAC 从上次停止到重新出声之间的静音时长。
+//       注册了 on_sent 时，开始播出后由一个线程充当 DMA 中断，
+//       每播完一个描述符（dma_frame_num 帧，有没有数据都算）调用一次
+//--------------------------------------------------------
+#include "sim.h"
+#include "driver/i2s_std.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct sim_i2s_chan {
+    bool is_tx;
+    bool enabled;
+    uint32_t rate;
+    uint32_t bits;               // 每个声道容器位宽
+    uint32_t slots;              // 每帧声道数
+    uint32_t dma_frames;         // DMA 环容量（帧）
+    uint32_t desc_frames;        // 每个描述符的帧数
+    int64_t t_start;             // 帧 0 的虚拟时刻
+    bool started;
+    uint64_t pos;                // 接收：已读出的帧；发送：已写入的帧
+    int64_t t_stop;              // 发送：上次关闭时 DAC 停止出声的时刻
+    bool stopped;
+    uint32_t run;                // 每次开始播出加一，旧的中断线程据此退出
+    i2s_event_callbacks_t cbs;
+    void *cb_ctx;
+};
+
+static struct sim_i2s_chan *s_tx_chan;  // 最近创建的发送通道（sim_i2s_tx_time 用）
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_i2s_source_t s_source;
+static void *s_source_ctx;
+static sim_i2s_sink_t s_sink;
+static void *s_sink_ctx;
+static sim_i2s_stats_t s_stats;
+
+void sim_i2s_set_source(sim_i2s_source_t source, void *ctx)
+{
+    s_source = source;
+    s_source_ctx = ctx;
+}
+
+void sim_i2s_set_sink(sim_i2s_sink_t sink, void *ctx)
+{
+    s_sink = sink;
+    s_sink_ctx = ctx;
+}
+
+void sim_i2s_get_stats(sim_i2s_stats_t *out)
+{
+    pthread_mutex_lock(&s_lock);
+    *out = s_stats;
+    pthread_mutex_unlock(&s_lock);
+}
+
+static uint32_t frame_bytes(const struct sim_i2s_chan *ch)
+{
+    return ch->bits / 8 * ch->slots;
+}
+
+// 虚拟时刻 t 对应的帧号
+static uint64_t frames_at(const struct sim_i2s_chan *ch, int64_t t)
+{
+    if (t <= ch->t_start) return 0;
+    return (uint64_t)(t - ch->t_start) * ch->rate / 1000000;
+}
+
+static int64_t time_of(const struct sim_i2s_chan *ch, uint64_t frame)
+{
+    return ch->t_start + (int64_t)(frame * 1000000 / ch->rate);
+}
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *cfg, i2s_chan_handle_t *ret_tx, i2s_chan_handle_t *ret_rx)
+{
+    for (int i = 0; i < 2; i++) {
+        i2s_chan_handle_t *ret = i == 0 ? ret_tx : ret_rx;
+        if (!ret) continue;
+        struct sim_i2s_chan *ch = calloc(1, sizeof(*ch));
+        if (!ch) return ESP_ERR_NO_MEM;
+        ch->is_tx = i == 0;
+        ch->rate = 48000;
+        ch->bits = 16;
+        ch->slots = 2;
+        ch->dma_frames = cfg->dma_desc_num * cfg->dma_frame_num;
+        ch->desc_frames = cfg->dma_frame_num;
+        if (ch->is_tx) s_tx_chan = ch;
+        *ret = ch;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t ch)
+{
+    if (ch == s_tx_chan) s_tx_chan = NULL;
+    free(ch);
+    return ESP_OK;
+}
+
+int64_t sim_i2s_tx_time(uint64_t frame)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t t = s_tx_chan ? time_of(s_tx_chan, frame) : -1;
+    pthread_mutex_unlock(&s_lock);
+    return t;
+}
+
+//--------------------------------------------------------
+// 发送 DMA“中断”：描述符 k 在帧 (k + 1) × desc_frames 播出时完成。
+// 回调在 s_lock 内调用，通道关闭返回后不会再有旧一轮的回调
+//--------------------------------------------------------
+typedef struct {
+    struct sim_i2s_chan *ch;
+    uint32_t run;
+} isr_arg_t;
+
+static void *tx_isr_thread(void *p)
+{
+    isr_arg_t a = *(isr_arg_t *)p;
+    free(p);
+    struct sim_i2s_chan *ch = a.ch;
+    for (uint64_t k = 1;; k++) {
+        pthread_mutex_lock(&s_lock);
+        bool live = ch->enabled && ch->run == a.run;
+        int64_t t = time_of(ch, k * ch->desc_frames);
+        pthread_mutex_unlock(&s_lock);
+        if (!live) break;
+
+        sim_sleep_until_us(t);
+
+        pthread_mutex_lock(&s_lock);
+        if (ch->enabled && ch->run == a.run) {
+            i2s_event_data_t ev = { .data = NULL, .size = ch->desc_frames * frame_bytes(ch), .dma_buf = NULL };
+            ch->cbs.on_sent(ch, &ev, ch->cb_ctx);
+        }
+        pthread_mutex_unlock(&s_lock);
+    }
+    return NULL;
+}
+
+// 开始播出（在 s_lock 内调用）：记录重新出声前的静音，启动中断线程
+static void tx_begin(struct sim_i2s_chan *ch, int64_t now)
+{
+    ch->started = true;
+    ch->t_start = now;
+    ch->run++;
+    if (ch->stopped) {
+        int64_t gap = now - ch->t_stop;
+        s_stats.tx_restarts++;
+        s_stats.tx_restart_gap_us += gap;
+        if (gap > s_stats.tx_restart_gap_max_us) s_stats.tx_restart_gap_max_us = gap;
+    }
+    if (ch->cbs.on_sent) {
+        isr_arg_t *a = malloc(sizeof(*a));
+        pthread_t th;
+        pthread_attr_t attr;
+        a->ch = ch;
+        a->run = ch->run;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&th, &attr, tx_isr_thread, a) != 0) free(a);
+        pthread_attr_destroy(&attr);
+    }
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t ch, const i2s_std_config_t *cfg)
+{
+    ch->rate = cfg->clk_cfg.sample_rate_hz;
+    ch->bits = cfg->slot_cfg.data_bit_width;
+    ch->slots = cfg->slot_cfg.slot_mode == I2S_SLOT_MODE_MONO ? 1 : 2;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t ch, const i2s_std_clk_config_t *clk)
+{
+    if (ch->enabled) return ESP_ERR_INVALID_STATE;
+    ch->rate = clk->sample_rate_hz;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_slot(i2s_chan_handle_t ch, const i2s_std_slot_config_t *slot)
+{
+    if (ch->enabled) return ESP_ERR_INVALID_STATE;
+    ch->bits = slot->data_bit_width;
+    ch->slots = slot->slot_mode == I2S_SLOT_MODE_MONO ? 1 : 2;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t ch)
+{
+    if (ch->enabled) return ESP_ERR_INVALID_STATE;
+    pthread_mutex_lock(&s_lock);
+    ch->enabled = true;
+    if (ch->is_tx && ch->pos > 0) {
+        // 预载了数据：启用时刻开始播出
+        tx_begin(ch, sim_now_us());
+    } else {
+        ch->started = !ch->is_tx;
+        ch->t_start = sim_now_us();
+        ch->pos = 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t ch)
+{
+    if (!ch->enabled) return ESP_ERR_INVALID_STATE;
+    pthread_mutex_lock(&s_lock);
+    if (ch->is_tx && ch->started) {
+        int64_t now = sim_now_us();
+        uint64_t played = frames_at(ch, now);
+        if (ch->pos > played) s_stats.tx_discarded += ch->pos - played;
+        // 数据先播完就停在最后一帧，否则在关闭时刻被截断
+        int64_t t_end = time_of(ch, ch->pos);
+        ch->t_stop = t_end < now ? t_end : now;
+        ch->stopped = true;
+    }
+    ch->enabled = false;
+    if (ch->is_tx) {
+        // 下次预载 / 写入从帧 0 开始
+        ch->started = false;
+        ch->pos = 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t ch, const i2s_event_callbacks_t *cbs, void *ctx)
+{
+    if (ch->enabled) return ESP_ERR_INVALID_STATE;
+    ch->cbs = cbs ? *cbs : (i2s_event_callbacks_t){0};
+    ch->cb_ctx = ctx;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 接收
+//--------------------------------------------------------
+static void put_sample(uint8_t *p, uint32_t bits, int32_t v)
+{
+    if (bits == 16) {
+        int16_t s = (int16_t)v;
+        memcpy(p, &s, 2);
+    } else {
+        memcpy(p, &v, 4);
+    }
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t ch, void *dest, size_t size, size_t *bytes_read, uint32_t timeout_ms)
+{
+    if (bytes_read) *bytes_read = 0;
+    if (ch->is_tx || !ch->enabled) return ESP_ERR_INVALID_STATE;
+
+    uint32_t fb = frame_bytes(ch);
+    uint64_t frames = size / fb;
+
+    // 读得太晚：DMA 环里只剩最近 dma_frames 帧
+    uint64_t avail = frames_at(ch, sim_now_us());
+    if (avail > ch->pos + ch->dma_frames) {
+        uint64_t lost = avail - ch->dma_frames - ch->pos;
+        pthread_mutex_lock(&s_lock);
+        s_stats.rx_dropped += lost;
+        s_stats.rx_overflows++;
+        pthread_mutex_unlock(&s_lock);
+        if (ch->cbs.on_recv_q_ovf) {
+            ch->cbs.on_recv_q_ovf(ch, NULL, ch->cb_ctx);
+        }
+        ch->pos += lost;
+    }
+
+    int64_t ready = time_of(ch, ch->pos + frames);
+    if (timeout_ms != UINT32_MAX && ready - sim_now_us() > (int64_t)timeout_ms * 1000) {
+        sim_sleep_us((int64_t)timeout_ms * 1000);
+        return ESP_ERR_TIMEOUT;
+    }
+    sim_sleep_until_us(ready);
+
+    uint8_t *p = dest;
+    for (uint64_t i = 0; i < frames; i++) {
+        for (uint32_t s = 0; s < ch->slots; s++) {
+            int32_t v = s_source ? s_source(ch->pos + i, (int)s, s_source_ctx) : 0;
+            put_sample(p, ch->bits, v);
+            p += ch->bits / 8;
+        }
+    }
+    ch->pos += frames;
+
+    pthread_mutex_lock(&s_lock);
+    s_stats.rx_frames += frames;
+    pthread_mutex_unlock(&s_lock);
+
+    if (bytes_read) *bytes_read = frames * fb;
+    return ESP_OK;
+}
+
+//--------------------------------------------------------
+// 发送
+//--------------------------------------------------------
+static void tx_accept(i2s_chan_handle_t ch, const void *src, uint64_t frames)
+{
+    if (s_sink) {
+        s_sink(ch->pos, src, frames * frame_bytes(ch), s_sink_ctx);
+    }
+    ch->pos += frames;
+    pthread_mutex_lock(&s_lock);
+    s_stats.tx_frames += frames;
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t i2s_channel_preload_data(i2s_chan_handle_t ch, const void *src, size_t size, size_t *bytes_loaded)
+{
+    if (!ch->is_tx || ch->enabled) return ESP_ERR_INVALID_STATE;
+    uint64_t frames = size / frame_bytes(ch);
+    if (frames > ch->dma_frames - ch->pos) frames = ch->dma_frames - ch->pos;
+    tx_accept(ch, src, frames);
+    if (bytes_loaded) *bytes_loaded = frames * frame_bytes(ch);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_write(i2s_chan_handle_t ch, const void *src, size_t size, size_t *bytes_written, uint32_t timeout_ms)
+{
+    if (bytes_written) *bytes_written = 0;
+    if (!ch->is_tx || !ch->enabled) return ESP_ERR_INVALID_STATE;
+
+    uint32_t fb = frame_bytes(ch);
+    uint64_t frames = size / fb;
+    const uint8_t *p = src;
+    int64_t now = sim_now_us();
+
+    if (!ch->started) {
+        // 第一次写入开始计时
+        pthread_mutex_lock(&s_lock);
+        ch->pos = 0;
+        tx_begin(ch, now);
+        pthread_mutex_unlock(&s_lock);
+    }
+
+    uint64_t played = frames_at(ch, now);
+    if (played > ch->pos) {
+        // DAC 已经把写入的数据播完，中间输出的是静音
+        uint64_t gap = played - ch->pos;
+        pthread_mutex_lock(&s_lock);
+        s_stats.tx_gap_frames += gap;
+        s_stats.tx_underruns++;
+        pthread_mutex_unlock(&s_lock);
+        if (ch->cbs.on_send_q_ovf) {
+            ch->cbs.on_send_q_ovf(ch, NULL, ch->cb_ctx);
+        }
+        ch->pos = played;
+    }
+
+    // DMA 环满：等到有足够空间（按 DMA 环的节拍分批写入）
+    while (frames > 0) {
+        uint64_t room = ch->pos < played + ch->dma_frames ? played + ch->dma_frames - ch->pos : 0;
+        if (room == 0) {
+            int64_t t = time_of(ch, ch->pos - ch->dma_frames + 1);
+            if (timeout_ms != UINT32_MAX && t - now > (int64_t)timeout_ms * 1000) {
+                sim_sleep_us((int64_t)timeout_ms * 1000);
+                return ESP_ERR_TIMEOUT;
+            }
+            sim_sleep_until_us(t);
+            now = sim_now_us();
+            played = frames_at(ch, now);
+            continue;
+        }
+        uint64_t n = frames < room ? frames : room;
+        tx_accept(ch, p, n);
+        p += n * fb;
+        frames -= n;
+        if (bytes_written) *bytes_written += n * fb;
+    }
+    return ESP_OK;
+}
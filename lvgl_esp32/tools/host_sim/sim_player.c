@@ -0,0 +1,666 @@
+//--------------------------------------------------------
+// 播放链路主机仿真
+//
+// 在假卡上生成一个 PCM16 测试 WAV（1 kHz 正弦，采样率 / 声道可选），
+// 或者播放假卡上已有的文件（例如 sim_recorder 录出的 ADPCM / 无损文件），
+// 用 speaker.c 原样播放到假 I2S 发送通道，统计：
+//   - 起播延迟（调用 wav_player_play → 第一帧送进 DMA）
+//   - 欠载次数和 DAC 输出静音的帧数（读卡 / 解码没跟上）
+//   - 结束时 DMA 中还没播出就被丢弃的尾部帧数
+//   - 送出的总帧数（PCM 文件时与 data 块帧数比对）、读卡统计和 CPU 占用
+// -U 时主线程扮演 LVGL 线程：按 30 fps 节拍循环，第一帧里像按钮回调一样发起播放，
+// 统计播放期间的 UI 帧间隔（-B 时在帧里直接调用阻塞播放，对照旧的做法）。
+// -P 时生成 N 首曲目放进一个目录，按目录播放列表，统计曲目之间 DAC 的静音
+// （I2S 重启前后的空档 + 欠载静音）；-Q 改为逐首调用阻塞播放，对照旧的做法。
+// -n 时同一文件连续播放 N 次，统计文件头缓存命中和每次播放的读卡次数。
+// -E 时在播放过程中触发 N 次提示音（单击 / 刷卡两声叠加），播完后通道关闭时再触发一次，
+// 统计混音任务按发声声部数的 CPU 耗时、触发 → DAC 的延迟（播放中 / 空闲）。
+// 返回值：0 通过，1 失败（欠载超过 -u 允许的次数、帧数不对或播放失败），2 参数错误
+//--------------------------------------------------------
+#include "sim.h"
+#include "speaker.h"
+#include "wav_info.h"
+#include "mixer.h"
+#include "esp_log.h"
+#include <dirent.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SIM_PLAY";
+
+typedef struct {
+    int64_t t_call;              // 调用 wav_player_play 的时刻
+    int64_t t_first;             // 第一帧送进 DMA 的时刻（0 为还没有）
+    uint64_t frames;             // 送出的总帧数
+    int64_t t_restart;           // 最近一次通道重新启用后第一帧送进 DMA 的时刻
+    uint64_t at_restart;         // 当时已经送出的帧数
+    bool heard;                  // 送出过非零样点
+    uint64_t first_nz;           // 第一个 / 最后一个非零样点的帧号（当轮通道内）
+    uint64_t last_nz;
+    int32_t head_peak;           // 第一个非零样点起 EDGE_FRAMES 帧内的峰值
+    int32_t peak;
+    int64_t t_idle;              // 报告 IDLE 的时刻
+    volatile bool done;          // 播放器回到空闲
+    uint32_t state_changes;
+    uint32_t tracks;             // 以新路径报告 PLAYING 的次数
+    char last[PLAYER_PATH_MAX];
+} sim_ctx_t;
+
+#define LIST_DIR        "/sdcard/sim_list"
+
+#define UI_FRAME_US     33333    // 30 fps
+#define EDGE_FRAMES     24       // 起止 0.5 ms：没有淡入淡出时 1 kHz 正弦在这么短内就到峰值
+#define HIST_FRAMES     4096     // 最近送出的样点（2 的幂），停止后查尾部用
+
+static sim_ctx_t s_ctx;
+static int16_t s_hist[HIST_FRAMES];
+
+static void sink(uint64_t first_frame, const void *data, size_t bytes, void *ctx)
+{
+    sim_ctx_t *c = ctx;
+    if (c->t_first == 0 && bytes > 0) {
+        c->t_first = sim_now_us();
+    }
+    if (first_frame == 0 && bytes > 0) {
+        c->at_restart = c->frames;
+        c->t_restart = sim_now_us();
+    }
+    const int16_t *pcm = data;
+    for (size_t i = 0; i < bytes / 2; i++) {
+        uint64_t f = first_frame + i;
+        int32_t a = abs(pcm[i]);
+        s_hist[f & (HIST_FRAMES - 1)] = pcm[i];
+        if (a == 0) continue;
+        if (!c->heard) {
+            c->heard = true;
+            c->first_nz = f;
+        }
+        if (f < c->first_nz + EDGE_FRAMES && a > c->head_peak) c->head_peak = a;
+        if (a > c->peak) c->peak = a;
+        c->last_nz = f;
+    }
+    c->frames += bytes / 2;      // speaker.c 输出 16 bit 单声道
+}
+
+static void on_state(player_state_t state, const char *path, void *ctx)
+{
+    sim_ctx_t *c = ctx;
+    ESP_LOGI(TAG, "state %d: %s", state, path);
+    c->state_changes++;
+    if (state == PLAYER_STATE_PLAYING && strcmp(path, c->last) != 0) {
+        c->tracks++;
+        snprintf(c->last, sizeof(c->last), "%s", path);
+    }
+    if (state == PLAYER_STATE_IDLE) {
+        c->last[0] = '\0';
+        c->t_idle = sim_now_us();
+        c->done = true;
+    }
+}
+
+typedef struct {
+    uint32_t frames;
+    int64_t max_us;
+    int64_t sum_us;
+} ui_stats_t;
+
+//--------------------------------------------------------
+// 假 UI 线程：固定帧率循环，直到播放结束
+//--------------------------------------------------------
+static void ui_run(const char *path, bool blocking, int64_t seek_ms, ui_stats_t *ui)
+{
+    int64_t start = sim_now_us();
+    int64_t prev = start;
+    bool seeked = seek_ms < 0;
+
+    while (true) {
+        int64_t now = sim_now_us();
+        if (ui->frames) {
+            int64_t gap = now - prev;
+            ui->sum_us += gap;
+            if (gap > ui->max_us) ui->max_us = gap;
+        }
+        prev = now;
+        if (ui->frames && s_ctx.done) break;
+
+        if (ui->frames == 0) {
+            if (blocking) {
+                wav_player_play(path);
+            } else if (wav_player_play_async(path) != ESP_OK) {
+                return;
+            }
+        } else if (!seeked && now - start >= 1000000) {
+            wav_player_seek((uint32_t)seek_ms);
+            seeked = true;
+        }
+        ui->frames++;
+        sim_sleep_until_us(now + UI_FRAME_US);
+    }
+}
+
+//--------------------------------------------------------
+// 播放中均匀触发 n 次提示音，奇数次单击和刷卡同时触发（3 个声部一起发声）；
+// 播完等通道关闭后再触发一次，单独记下空闲时的延迟。返回触发次数，idle_us 为空闲延迟
+//--------------------------------------------------------
+static uint32_t beeps_run(const char *path, int n, double seconds, int64_t *idle_us)
+{
+    uint32_t triggers = 0;
+    if (wav_player_play_async(path) != ESP_OK) return 0;
+
+    int64_t start = sim_now_us();
+    int64_t step = (int64_t)(seconds * 1e6) / (n + 1);
+    for (int i = 0; i < n; i++) {
+        sim_sleep_until_us(start + step * (i + 1));
+        if (wav_player_beep(PLAYER_BEEP_CLICK) == ESP_OK) triggers++;
+        if ((i & 1) && wav_player_beep(PLAYER_BEEP_CARD) == ESP_OK) triggers++;
+    }
+    while (!s_ctx.done) sim_sleep_us(10000);
+
+    mixer_stats_t before, after;
+    sim_sleep_us(100000);
+    mixer_get_stats(&before);
+    if (wav_player_beep(PLAYER_BEEP_CLICK) == ESP_OK) triggers++;
+    sim_sleep_us(100000);
+    mixer_get_stats(&after);
+    *idle_us = after.latency_count > before.latency_count ? (int64_t)(after.latency_sum_us - before.latency_sum_us) : -1;
+    return triggers;
+}
+
+//--------------------------------------------------------
+// 播放中每隔 SCRUB_STEP_US 跳转一次，共 n 次，位置在全长的 0.6 / 0.2 / 0.8 / 0.4 之间
+// 来回并错开 37 ms（不落在块边界上）。跳转截断 DMA，新位置的第一帧送进 DMA 时
+// 通道重新计数，按此算每次的延迟。返回最后一次跳转的目标帧（文件采样率下）
+//--------------------------------------------------------
+#define SCRUB_STEP_US   700000
+
+typedef struct {
+    uint32_t seeks;
+    uint32_t heard;              // 新位置在下一次跳转前出声的次数
+    int64_t sum_us;
+    int64_t max_us;
+    uint64_t base;               // 最后一次跳转后重新启用时已经送出的帧数
+} scrub_stats_t;
+
+static uint64_t scrub_run(const char *path, int n, const wav_info_t *info, scrub_stats_t *st)
+{
+    static const int pct[] = { 60, 20, 80, 40 };
+    uint64_t target = 0;
+    if (wav_player_play_async(path) != ESP_OK) return 0;
+
+    int64_t start = sim_now_us();
+    for (int i = 0; i < n && !s_ctx.done; i++) {
+        sim_sleep_until_us(start + SCRUB_STEP_US * (i + 1));
+        uint32_t ms = info->duration_ms * pct[i % 4] / 100 + 37;
+        target = (uint64_t)ms * info->sample_rate / 1000;
+
+        int64_t t_seek = sim_now_us();
+        if (wav_player_seek(ms) != ESP_OK) break;
+        st->seeks++;
+        while (s_ctx.t_restart <= t_seek && sim_now_us() - t_seek < SCRUB_STEP_US / 2) sim_sleep_us(200);
+        if (s_ctx.t_restart > t_seek) {
+            int64_t lat = s_ctx.t_restart - t_seek;
+            st->base = s_ctx.at_restart;
+            st->heard++;
+            st->sum_us += lat;
+            if (lat > st->max_us) st->max_us = lat;
+        }
+    }
+    while (!s_ctx.done) sim_sleep_us(10000);
+    return target;
+}
+
+// 最后一个非零样点之前 EDGE_FRAMES 帧内的峰值（停止后调用，样点还在 s_hist 里）
+static int32_t tail_peak(void)
+{
+    int32_t peak = 0;
+    for (uint64_t i = 0; i < EDGE_FRAMES && i <= s_ctx.last_nz; i++) {
+        int32_t a = abs(s_hist[(s_ctx.last_nz - i) & (HIST_FRAMES - 1)]);
+        if (a > peak) peak = a;
+    }
+    return peak;
+}
+
+//--------------------------------------------------------
+// 起停：播放 STOP_AFTER_US 后停止，重复 n 次。
+// 起始延迟 = 调用 → 第一个非零样点到达 DAC；停止延迟 = 调用 → 最后一个非零样点播完；
+// 报告 IDLE 与最后一个样点播完的差；起止 EDGE_FRAMES 内的峰值看有没有淡入淡出
+//--------------------------------------------------------
+#define STOP_AFTER_US   400000
+
+typedef struct {
+    uint32_t cycles;
+    int64_t start_sum, start_max;
+    int64_t stop_sum, stop_max;
+    int64_t idle_min, idle_max;
+    int32_t edge_max;
+} startstop_stats_t;
+
+static void startstop_run(const char *path, int n, startstop_stats_t *st)
+{
+    st->idle_min = INT64_MAX;
+    st->idle_max = INT64_MIN;
+    for (int i = 0; i < n; i++) {
+        s_ctx.heard = false;
+        s_ctx.head_peak = 0;
+        s_ctx.done = false;
+
+        int64_t t_call = sim_now_us();
+        if (wav_player_play_async(path) != ESP_OK) break;
+        sim_sleep_until_us(t_call + STOP_AFTER_US);
+        if (!s_ctx.heard) break;
+        int64_t t_first = sim_i2s_tx_time(s_ctx.first_nz);
+
+        int64_t t_stop = sim_now_us();
+        wav_player_stop();
+        while (!s_ctx.done) sim_sleep_us(1000);
+        int64_t t_last = sim_i2s_tx_time(s_ctx.last_nz + 1);
+
+        int64_t start = t_first - t_call, stop = t_last - t_stop, idle = s_ctx.t_idle - t_last;
+        st->cycles++;
+        st->start_sum += start;
+        st->stop_sum += stop;
+        if (start > st->start_max) st->start_max = start;
+        if (stop > st->stop_max) st->stop_max = stop;
+        if (idle < st->idle_min) st->idle_min = idle;
+        if (idle > st->idle_max) st->idle_max = idle;
+        int32_t edge = s_ctx.head_peak > tail_peak() ? s_ctx.head_peak : tail_peak();
+        if (edge > st->edge_max) st->edge_max = edge;
+
+        sim_sleep_us(50000);    // 两轮之间通道关闭
+    }
+}
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t *p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+//--------------------------------------------------------
+// 生成测试文件：44 字节头 + 1 kHz 正弦
+//--------------------------------------------------------
+static bool make_test_wav(const char *vfs_path, uint32_t rate, uint16_t channels, double seconds)
+{
+    char host[256];
+    FILE *fp = fopen(sim_sd_host_path(vfs_path, host, sizeof(host)), "wb");
+    if (!fp) {
+        ESP_LOGE(TAG, "cannot create %s", host);
+        return false;
+    }
+
+    uint32_t frames = (uint32_t)(seconds * rate);
+    uint32_t data_size = frames * channels * 2;
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4);
+    put32(h + 4, 36 + data_size);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, 16);
+    put16(h + 20, 1);
+    put16(h + 22, channels);
+    put32(h + 24, rate);
+    put32(h + 28, rate * channels * 2);
+    put16(h + 32, channels * 2);
+    put16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put32(h + 40, data_size);
+    fwrite(h, 1, sizeof(h), fp);
+
+    int16_t buf[1024];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        int16_t v = (int16_t)(16384 * sin(2 * 3.14159265358979 * 1000 * i / rate));
+        for (uint16_t c = 0; c < channels; c++) {
+            buf[n++] = v;
+        }
+        if (n + channels > 1024 || i + 1 == frames) {
+            fwrite(buf, 2, n, fp);
+            n = 0;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+// PCM16 文件 data 块的帧数和采样率（压缩格式返回 0，不做比对）
+static uint64_t pcm_frames(const char *vfs_path, uint32_t *rate_out)
+{
+    char host[256];
+    FILE *fp = fopen(sim_sd_host_path(vfs_path, host, sizeof(host)), "rb");
+    if (!fp) return 0;
+
+    uint8_t riff[12], ck[8];
+    uint16_t format = 0, channels = 1;
+    uint32_t rate = 0;
+    uint64_t frames = 0;
+    if (fread(riff, 1, 12, fp) == 12) {
+        while (fread(ck, 1, 8, fp) == 8) {
+            uint32_t size = ck[4] | ck[5] << 8 | ck[6] << 16 | (uint32_t)ck[7] << 24;
+            if (!memcmp(ck, "fmt ", 4)) {
+                uint8_t f[8];
+                if (fread(f, 1, 8, fp) != 8) break;
+                format = f[0] | f[1] << 8;
+                channels = f[2] | f[3] << 8;
+                rate = f[4] | f[5] << 8 | f[6] << 16 | (uint32_t)f[7] << 24;
+                fseek(fp, size - 8 + (size & 1), SEEK_CUR);
+            } else if (!memcmp(ck, "data", 4)) {
+                if (format == 1 && channels && rate) frames = size / (2u * channels);
+                break;
+            } else {
+                fseek(fp, size + (size & 1), SEEK_CUR);
+            }
+        }
+    }
+    fclose(fp);
+    *rate_out = rate;
+    return frames;
+}
+
+// 升采样到 48 kHz 后的帧数（升采样器排空后输出 ceil(N × 48000 / rate)）
+static uint64_t out_frames(uint64_t frames, uint32_t rate)
+{
+    return rate ? (frames * 48000 + rate - 1) / rate : 0;
+}
+
+// 在 LIST_DIR 下生成 n 首曲目（-M 时奇数曲目用 22050 Hz），清掉上次留下的文件
+static bool make_list(int n, uint32_t rate, bool mixed, uint16_t channels, double seconds,
+                      char paths[][PLAYER_PATH_MAX])
+{
+    char host[256];
+    sim_sd_host_path(LIST_DIR, host, sizeof(host));
+    mkdir(host, 0755);
+    DIR *dir = opendir(host);
+    if (dir) {
+        struct dirent *e;
+        char f[512];
+        while ((e = readdir(dir)) != NULL) {
+            if (e->d_name[0] == '.') continue;
+            snprintf(f, sizeof(f), "%s/%s", host, e->d_name);
+            unlink(f);
+        }
+        closedir(dir);
+    }
+    for (int i = 0; i < n; i++) {
+        snprintf(paths[i], PLAYER_PATH_MAX, LIST_DIR "/track%02d.wav", i);
+        if (!make_test_wav(paths[i], mixed && (i & 1) ? 22050 : rate, channels, seconds)) return false;
+    }
+    return true;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -t SEC        test file length in seconds (default 10)\n"
+            "  -x SCALE      time scale, >1 runs faster than real time (default 1)\n"
+            "  -R RATE       test file sample rate (default 44100)\n"
+            "  -C CH         test file channels, 1 or 2 (default 2)\n"
+            "  -i NAME       play NAME from the fake card instead of generating a file\n"
+            "  -k KBPS       SD read bandwidth (default 4000)\n"
+            "  -l US         SD per-operation latency (default 300)\n"
+            "  -s MS         SD latency spike length (default 0)\n"
+            "  -r PERMILLE   SD spike probability per read (default 0)\n"
+            "  -u N          underruns allowed before failing (default 0)\n"
+            "  -U            start playback from a fake 30 fps UI loop and report frame times\n"
+            "  -B            with -U, call the blocking player from the UI loop\n"
+            "  -j MS         with -U, seek to MS one second into playback\n"
+            "  -P N          play a folder of N generated tracks as one gapless playlist\n"
+            "  -M            with -P, odd tracks use 22050 Hz (rate change between tracks)\n"
+            "  -Q            with -P, play the tracks one by one with blocking calls (old behaviour)\n"
+            "  -n N          play the file N times in a row (header cache check)\n"
+            "  -E N          trigger N UI beeps during playback and one after it (mixer check)\n"
+            "  -K N          seek N times during playback, report seek latency (any format)\n"
+            "  -L MS         with -K, seek latency allowed before failing (default 50)\n"
+            "  -T N          start and stop playback N times, report start / stop latency and edges\n"
+            "  -o DIR        host directory for the fake card (default sim_sd)\n"
+            "  -v            verbose firmware logs\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 10;
+    uint32_t rate = 44100, allowed = 0;
+    uint16_t channels = 2;
+    const char *input = NULL;
+    bool ui_mode = false, ui_blocking = false;
+    int64_t seek_ms = -1;
+    int list_n = 0, repeat = 1, beeps = 0, scrubs = 0, scrub_limit_ms = 50, stops = 0;
+    bool mixed = false, sequential = false;
+    static char tracks[PLAYER_PLAYLIST_MAX][PLAYER_PATH_MAX];
+    ui_stats_t ui = {0};
+    sim_sd_config_t sd = { .root = "sim_sd", .read_kbps = 4000, .op_latency_us = 300, .seed = 1 };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:x:R:C:i:k:l:s:r:u:UBj:P:MQn:E:K:L:T:o:vh")) != -1) {
+        switch (opt) {
+        case 't': seconds = atof(optarg); break;
+        case 'x': sim_time_scale = atof(optarg); break;
+        case 'R': rate = atoi(optarg); break;
+        case 'C': channels = atoi(optarg); break;
+        case 'i': input = optarg; break;
+        case 'k': sd.read_kbps = atoi(optarg); break;
+        case 'l': sd.op_latency_us = atoi(optarg); break;
+        case 's': sd.spike_us = atoi(optarg) * 1000; break;
+        case 'r': sd.spike_permille = atoi(optarg); break;
+        case 'u': allowed = atoi(optarg); break;
+        case 'U': ui_mode = true; break;
+        case 'B': ui_blocking = true; break;
+        case 'j': seek_ms = atoi(optarg); break;
+        case 'P': list_n = atoi(optarg); break;
+        case 'M': mixed = true; break;
+        case 'Q': sequential = true; break;
+        case 'n': repeat = atoi(optarg); break;
+        case 'E': beeps = atoi(optarg); break;
+        case 'K': scrubs = atoi(optarg); break;
+        case 'L': scrub_limit_ms = atoi(optarg); break;
+        case 'T': stops = atoi(optarg); break;
+        case 'o': sd.root = optarg; break;
+        case 'v': sim_log_level = 2; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (sim_time_scale <= 0 || seconds <= 0 || rate == 0 || channels < 1 || channels > 2 ||
+        list_n < 0 || list_n > PLAYER_PLAYLIST_MAX || repeat < 1 || beeps < 0 || scrubs < 0 || stops < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char path[160];
+    snprintf(path, sizeof(path), "%s", list_n ? LIST_DIR : "/sdcard/");
+    if (!list_n) strncat(path, input ? input : "sim_play.wav", sizeof(path) - strlen(path) - 1);
+
+    // 生成测试文件时不计入读卡统计
+    sim_sd_config_t quiet = { .root = sd.root };
+    sim_sd_init(&quiet);
+    uint64_t expected = 0;
+    if (list_n) {
+        if (!make_list(list_n, rate, mixed, channels, seconds, tracks)) return 1;
+        // 列表里相邻同采样率的曲目共用升采样器状态，按连续的一段计算输出帧数
+        uint64_t run = 0;
+        uint32_t run_rate = 0, r;
+        for (int i = 0; i < list_n; i++) {
+            uint64_t f = pcm_frames(tracks[i], &r);
+            if (r != run_rate || sequential) {
+                expected += out_frames(run, run_rate);
+                run = 0;
+                run_rate = r;
+            }
+            run += f;
+        }
+        expected += out_frames(run, run_rate);
+    } else {
+        if (!input && !make_test_wav(path, rate, channels, seconds)) return 1;
+        uint32_t r = 0;
+        uint64_t f = pcm_frames(path, &r);
+        expected = out_frames(f, r) * repeat;
+    }
+    // 跳转模式按文件头算帧数，压缩格式（-i 录出来的 ADPCM / 无损）也能比对
+    wav_info_t info = {0};
+    if (scrubs && (wav_info_load(path, NULL, &info) != ESP_OK || !info.frames)) {
+        fprintf(stderr, "%s: no frame count in header\n", path);
+        return 1;
+    }
+    sim_sd_init(&sd);
+    sim_i2s_set_sink(sink, &s_ctx);
+
+    if (!wav_player_init()) return 1;
+    wav_player_set_callback(on_state, &s_ctx);
+
+    sim_sd_stats_t sd_first = {0};
+    uint32_t beep_triggers = 0;
+    int64_t idle_latency = -1;
+    scrub_stats_t scrub = {0};
+    startstop_stats_t ss = {0};
+    uint64_t scrub_target = 0;
+    double cpu0 = sim_process_cpu_us();
+    s_ctx.t_call = sim_now_us();
+    if (beeps) {
+        beep_triggers = beeps_run(path, beeps, seconds, &idle_latency);
+    } else if (scrubs) {
+        scrub_target = scrub_run(path, scrubs, &info, &scrub);
+    } else if (stops) {
+        startstop_run(path, stops, &ss);
+    } else if (ui_mode) {
+        ui_run(path, ui_blocking, seek_ms, &ui);
+    } else if (list_n && sequential) {
+        for (int i = 0; i < list_n; i++) wav_player_play(tracks[i]);
+    } else {
+        for (int i = 0; i < repeat; i++) {
+            wav_player_play(path);
+            if (i == 0) sim_sd_get_stats(&sd_first);
+        }
+    }
+    int64_t t_end = sim_now_us();
+    double cpu = sim_process_cpu_us() - cpu0;
+    double wall_real = (t_end - s_ctx.t_call) / sim_time_scale;
+
+    sim_i2s_stats_t i2s;
+    sim_i2s_get_stats(&i2s);
+    sim_sd_stats_t sds;
+    sim_sd_get_stats(&sds);
+
+    printf("player  : %s, %.2f s from call to return\n", path, (t_end - s_ctx.t_call) / 1e6);
+    if (s_ctx.t_first) {
+        printf("start   : first frame queued %lld us after play call\n",
+               (long long)(s_ctx.t_first - s_ctx.t_call));
+    }
+    printf("i2s     : %llu frames queued, %lu underruns (%llu silent frames), %llu tail frames discarded\n",
+           (unsigned long long)i2s.tx_frames, (unsigned long)i2s.tx_underruns,
+           (unsigned long long)i2s.tx_gap_frames, (unsigned long long)i2s.tx_discarded);
+    read_ahead_stats_t ra;
+    wav_player_get_read_stats(&ra);
+    printf("prefetch: %lu blocks, %lu underruns (max wait %lu us), low water %lu/%d, max read %lu us\n",
+           (unsigned long)ra.blocks, (unsigned long)ra.underruns, (unsigned long)ra.max_wait_us,
+           (unsigned long)ra.low_water, READ_AHEAD_BLOCKS, (unsigned long)ra.max_read_us);
+    printf("sd      : %llu reads, %llu KB, %lu spikes, max op %lu us\n",
+           (unsigned long long)sds.reads, (unsigned long long)(sds.read_bytes / 1024),
+           (unsigned long)sds.spikes, (unsigned long)sds.max_op_us);
+    wav_info_stats_t hdr;
+    wav_info_get_stats(&hdr);
+    printf("header  : cache %lu hits, %lu misses\n", (unsigned long)hdr.hits, (unsigned long)hdr.misses);
+    if (repeat > 1) {
+        printf("repeat  : %d plays, SD reads first play %llu, later plays avg %.1f\n", repeat,
+               (unsigned long long)sd_first.reads, (double)(sds.reads - sd_first.reads) / (repeat - 1));
+    }
+    if (list_n) {
+        printf("tracks  : %lu of %d started, %lu I2S restarts, silence at restarts max %lld us (total %lld us)\n",
+               (unsigned long)s_ctx.tracks, list_n, (unsigned long)i2s.tx_restarts,
+               (long long)i2s.tx_restart_gap_max_us, (long long)i2s.tx_restart_gap_us);
+    }
+    mixer_stats_t mix;
+    mixer_get_stats(&mix);
+    printf("mixer   : %lu periods, %lu underruns, %lu clips (%lu dropped), %lu soft-clipped samples, %lu restarts\n",
+           (unsigned long)mix.periods, (unsigned long)mix.underruns, (unsigned long)mix.triggers,
+           (unsigned long)mix.dropped, (unsigned long)mix.soft_clipped, (unsigned long)mix.restarts);
+    if (beeps) {
+        // 每周期混音 + 削波的耗时（周期数折算成 240 MHz 下的微秒），按同时发声的声部数分开
+        printf("mix cpu :");
+        for (int i = 1; i <= MIXER_VOICES; i++) {
+            if (!mix.mix_periods[i]) continue;
+            double us = (double)mix.mix_cycles[i] / mix.mix_periods[i] / 240;
+            printf(" %d voice%s %.1f us (%.2f%%)", i, i > 1 ? "s" : "", us,
+                   us * 100 * MIXER_SAMPLE_RATE / MIXER_PERIOD / 1e6);
+        }
+        printf(" per %d-frame period\n", MIXER_PERIOD);
+        if (mix.latency_count) {
+            printf("latency : trigger to DAC avg %llu us, min %lu us, max %lu us; idle channel %lld us\n",
+                   (unsigned long long)(mix.latency_sum_us / mix.latency_count),
+                   (unsigned long)mix.latency_min_us, (unsigned long)mix.latency_max_us, (long long)idle_latency);
+        }
+    }
+    if (scrubs) {
+        // 最后一次跳转之后的输出只能是新位置到结尾，一帧不多一帧不少
+        printf("seek    : %lu seeks, %lu heard, latency avg %lld us, max %lld us; %lu DMA cuts, %llu queued frames dropped\n",
+               (unsigned long)scrub.seeks, (unsigned long)scrub.heard,
+               (long long)(scrub.heard ? scrub.sum_us / scrub.heard : 0), (long long)scrub.max_us,
+               (unsigned long)mix.cuts, (unsigned long long)mix.cut_frames);
+    }
+    if (ui_mode && ui.frames) {
+        printf("ui      : %lu frames, interval avg %lld us, max %lld us (target %d us)\n",
+               (unsigned long)ui.frames, (long long)(ui.sum_us / ui.frames),
+               (long long)ui.max_us, UI_FRAME_US);
+    }
+    printf("cpu     : %.0f ms for %.0f ms real (%.1f%%)\n",
+           cpu / 1000, wall_real / 1000, wall_real > 0 ? cpu * 100 / wall_real : 0.0);
+
+    bool ok = s_ctx.frames > 0 && i2s.tx_underruns <= allowed;
+    if (ui_mode && !ui_blocking) {
+        ok = ok && ui.max_us < 2 * UI_FRAME_US;
+    }
+    if (repeat > 1) {
+        ok = ok && hdr.hits == (uint32_t)repeat - 1;
+    }
+    if (list_n) {
+        ok = ok && s_ctx.tracks == (uint32_t)list_n && (sequential || i2s.tx_restarts == 0);
+    }
+    if (beeps) {
+        // 播放中最多等 DMA 排满 + 一个周期；空闲时通道重新启用，几乎没有排队
+        uint32_t want = (uint32_t)(beeps + beeps / 2 + 1);
+        ok = ok && beep_triggers == want && mix.triggers == want && mix.dropped == 0 &&
+             mix.latency_count == want && mix.underruns == 0 && idle_latency >= 0 &&
+             mix.latency_max_us < (MIXER_DMA_DESC + 2) * MIXER_PERIOD * 1000000ull / MIXER_SAMPLE_RATE &&
+             idle_latency < 2 * MIXER_PERIOD * 1000000ll / MIXER_SAMPLE_RATE;
+    }
+    if (scrubs) {
+        // 最后一次跳转之后的输出只能是新位置到结尾，一帧不多一帧不少；
+        // 跳转后等预读重新读满 + 攒够开始发声的数据，不再排在旧位置 20 ms 的 DMA 后面
+        // （无损第一次跳出已建索引的范围时还要读一遍中间的块头，用 -L 放宽）
+        uint64_t tail = out_frames(info.frames - scrub_target, info.sample_rate);
+        uint64_t after = s_ctx.frames - scrub.base;
+        printf("frames  : %llu after last seek, %llu expected\n",
+               (unsigned long long)after, (unsigned long long)tail);
+        ok = ok && scrub.seeks == (uint32_t)scrubs && scrub.heard == scrub.seeks &&
+             mix.cuts == scrub.seeks && mix.underruns == 0 && scrub.max_us < scrub_limit_ms * 1000ll &&
+             after == tail;
+    }
+    if (stops) {
+        // 停止：播放任务看到命令（一个周期）+ 混音任务手上已经混好的一个周期
+        //       + DMA 里排队的 MIXER_DMA_DESC 个周期 + 淡出的一个周期，再留一个周期余量
+        printf("start   : %lu cycles, play call to first sound at DAC avg %lld us, max %lld us\n",
+               (unsigned long)ss.cycles, (long long)(ss.cycles ? ss.start_sum / ss.cycles : 0),
+               (long long)ss.start_max);
+        printf("stop    : stop call to last sound at DAC avg %lld us, max %lld us; idle reported %lld..%lld us after it\n",
+               (long long)(ss.cycles ? ss.stop_sum / ss.cycles : 0), (long long)ss.stop_max,
+               (long long)ss.idle_min, (long long)ss.idle_max);
+        printf("edges   : peak within %d frames of start / end %ld of %ld\n",
+               EDGE_FRAMES, (long)ss.edge_max, (long)s_ctx.peak);
+        ok = ok && ss.cycles == (uint32_t)stops && i2s.tx_discarded == 0 &&
+             ss.stop_max < (MIXER_DMA_DESC + 4) * MIXER_PERIOD * 1000000ll / MIXER_SAMPLE_RATE &&
+             ss.idle_min >= 0 && ss.idle_max < 2 * MIXER_PERIOD * 1000000ll / MIXER_SAMPLE_RATE &&
+             ss.edge_max * 8 < s_ctx.peak;
+    } else if (seek_ms < 0 && !beeps && !scrubs && s_ctx.heard) {
+        // 自然播完：最后一帧播完才报告空闲，DMA 里的尾巴没有被截掉
+        int64_t idle = s_ctx.t_idle - sim_i2s_tx_time(s_ctx.last_nz + 1);
+        printf("end     : idle reported %lld us after the last sound left the DAC, tail edge %ld of %ld\n",
+               (long long)idle, (long)tail_peak(), (long)s_ctx.peak);
+        ok = ok && i2s.tx_discarded == 0 && idle >= 0 &&
+             idle < 2 * MIXER_PERIOD * 1000000ll / MIXER_SAMPLE_RATE;
+    }
+    if (expected && seek_ms < 0 && !beeps && !scrubs && !stops) {
+        printf("frames  : %llu of %llu expected\n",
+               (unsigned long long)s_ctx.frames, (unsigned long long)expected);
+        ok = ok && s_ctx.frames == expected;
+    }
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
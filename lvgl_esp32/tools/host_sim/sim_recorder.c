@@ -0,0 +1,344 @@
+//--------------------------------------------------------
+// 录音链路主机仿真
+//
+// 假 I2S 按 48 kHz 节拍送出一个递增计数（每个样点 = 帧号的低 16 位），
+// 录音结束后把各段 WAV 的 data 拼起来检查计数是否连续：
+// 任何丢帧、重复、分段衔接错误都会表现为计数跳变。
+// 同时统计 I2S DMA 丢帧、环形缓冲区溢出、采集→落盘延迟和 CPU 占用。
+//
+// 计数校验只在 PCM16 / 48 kHz / 关闭 AGC 与门控时有效（其它配置只报告统计）。
+// 计数跳变缺失的样点必须都能由假 I2S 报告的 DMA 覆盖解释，否则说明录音链路自己丢了数据；
+// DMA 覆盖本身（采集任务没有及时读）在主机上常由调度抖动引起，默认只报告，-z 时也算失败。
+// 返回值：0 通过，1 校验失败，2 参数错误
+//--------------------------------------------------------
+#include "sim.h"
+#include "recorder.h"
+#include "esp_log.h"
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "SIM_REC";
+
+typedef struct {
+    bool ramp;                   // 计数信号（可校验）
+    uint32_t rate;
+    // 采集→落盘延迟（写入时已交付的帧 - 写入数据中最后一帧）
+    uint64_t lat_sum_us;
+    uint32_t lat_max_us;
+    uint32_t lat_count;
+} sim_ctx_t;
+
+static sim_ctx_t s_ctx;
+
+//--------------------------------------------------------
+// 信号源：计数或 1 kHz 正弦（32 bit 左对齐，与 INMP441 一样）
+//--------------------------------------------------------
+static int32_t source(uint64_t frame, int slot, void *ctx)
+{
+    sim_ctx_t *c = ctx;
+    (void)slot;
+    int16_t v;
+    if (c->ramp) {
+        v = (int16_t)(frame & 0xFFFF);
+    } else {
+        static const int16_t sine[48] = {
+                0,  2139,  4240,  6269,  8192,  9974, 11585, 12998, 14189, 15137, 15826, 16244,
+            16384, 16244, 15826, 15137, 14189, 12998, 11585,  9974,  8192,  6269,  4240,  2139,
+                0, -2139, -4240, -6269, -8192, -9974,-11585,-12998,-14189,-15137,-15826,-16244,
+           -16384,-16244,-15826,-15137,-14189,-12998,-11585, -9974, -8192, -6269, -4240, -2139,
+        };
+        v = sine[frame % 48];
+    }
+    return (int32_t)v << PCM_SHIFT;
+}
+
+static void write_hook(const char *path, uint32_t offset, const void *data, uint32_t len, void *ctx)
+{
+    sim_ctx_t *c = ctx;
+    size_t pl = strlen(path);
+    if (!c->ramp || pl < 4 || strcmp(path + pl - 4, ".wav") != 0) return;
+
+    uint32_t end = offset + len;
+    if (end < 44 + 2 || offset > end - 2 || (end - 44) % 2) return;
+
+    int16_t v;
+    memcpy(&v, (const uint8_t *)data + len - 2, 2);
+
+    sim_i2s_stats_t st;
+    sim_i2s_get_stats(&st);
+    uint64_t delivered = st.rx_frames + st.rx_dropped;   // 计数按帧号递增，含被覆盖的帧
+    uint64_t back = (delivered - (uint16_t)v) & 0xFFFF;
+    uint32_t us = (uint32_t)(back * 1000000 / c->rate);
+
+    c->lat_sum_us += us;
+    c->lat_count++;
+    if (us > c->lat_max_us) c->lat_max_us = us;
+}
+
+//--------------------------------------------------------
+// 校验
+//--------------------------------------------------------
+typedef struct {
+    bool have_prev;
+    uint16_t prev;
+    uint64_t samples;
+    uint32_t jumps;
+    uint64_t missing;            // 跳变处缺失的样点数（按计数差估算）
+    uint32_t bad_headers;
+    uint32_t files;
+} verify_t;
+
+static uint32_t rd32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+static void verify_file(const char *vfs_path, verify_t *v, bool check_ramp)
+{
+    char host[256];
+    sim_sd_host_path(vfs_path, host, sizeof(host));
+    FILE *fp = fopen(host, "rb");
+    if (!fp) {
+        ESP_LOGE(TAG, "missing %s", host);
+        v->bad_headers++;
+        return;
+    }
+    v->files++;
+
+    uint8_t hdr[12];
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || rd32(hdr + 4) != (uint32_t)fsize - 8) {
+        ESP_LOGE(TAG, "%s: bad RIFF size (%lu vs file %ld)", host, (unsigned long)rd32(hdr + 4), fsize);
+        v->bad_headers++;
+    }
+
+    // 找 data 块
+    uint8_t ck[8];
+    uint32_t data_size = 0;
+    while (fread(ck, 1, 8, fp) == 8) {
+        uint32_t size = rd32(ck + 4);
+        if (!memcmp(ck, "data", 4)) {
+            data_size = size;
+            break;
+        }
+        fseek(fp, size + (size & 1), SEEK_CUR);
+    }
+    if (data_size == 0 || ftell(fp) + (long)data_size != fsize) {
+        ESP_LOGE(TAG, "%s: bad data size %lu", host, (unsigned long)data_size);
+        v->bad_headers++;
+    }
+
+    int16_t buf[4096];
+    size_t n;
+    uint64_t seg_samples = 0;
+    while (check_ramp && (n = fread(buf, 2, 4096, fp)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            uint16_t s = (uint16_t)buf[i];
+            if (v->have_prev && s != (uint16_t)(v->prev + 1)) {
+                v->jumps++;
+                v->missing += (uint16_t)(s - v->prev - 1);
+                if (v->jumps <= 5) {
+                    ESP_LOGE(TAG, "%s: jump %u -> %u at sample %llu", host, v->prev, s,
+                             (unsigned long long)seg_samples);
+                }
+            }
+            v->prev = s;
+            v->have_prev = true;
+            seg_samples++;
+        }
+    }
+    v->samples += check_ramp ? seg_samples : data_size / 2;
+    ESP_LOGI(TAG, "%s: %ld bytes", host, fsize);
+    fclose(fp);
+}
+
+static void verify_recording(const char *name, bool segmented, verify_t *v, bool check_ramp)
+{
+    char vfs[160];
+    if (!segmented) {
+        snprintf(vfs, sizeof(vfs), SD_MOUNT_POINT "/%s", name);
+        verify_file(vfs, v, check_ramp);
+        return;
+    }
+
+    // 按清单顺序拼接各段
+    char base[128], host[256];
+    const char *dot = strrchr(name, '.');
+    snprintf(base, sizeof(base), "%.*s", dot ? (int)(dot - name) : (int)strlen(name), name);
+    snprintf(vfs, sizeof(vfs), SD_MOUNT_POINT "/%s.m3u", base);
+    FILE *m = fopen(sim_sd_host_path(vfs, host, sizeof(host)), "r");
+    if (!m) {
+        ESP_LOGE(TAG, "missing manifest %s", host);
+        v->bad_headers++;
+        return;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), m)) {
+        line[strcspn(line, "\r\n")] = 0;
+        if (!line[0] || line[0] == '#') continue;
+        snprintf(vfs, sizeof(vfs), SD_MOUNT_POINT "/%s", line);
+        verify_file(vfs, v, check_ramp);
+    }
+    fclose(m);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -t SEC        recording length in device seconds (default 20)\n"
+            "  -x SCALE      time scale, >1 runs faster than real time (default 1)\n"
+            "  -f FMT        pcm | adpcm | lossless (default pcm)\n"
+            "  -p RATE       48 | 16 | 8 kHz profile (default 48)\n"
+            "  -a            enable AGC      -g  enable VAD gate\n"
+            "  -S MB         rotate segments every MB      -M MIN  every MIN minutes\n"
+            "  -P SEC        pre-allocate SEC seconds      -c MS   checkpoint interval\n"
+            "  -w KBPS       SD write bandwidth (default 4000)\n"
+            "  -l US         SD per-operation latency (default 300)\n"
+            "  -s MS         SD latency spike length (default 0)\n"
+            "  -r PERMILLE   SD spike probability per write (default 0)\n"
+            "  -k KB         cluster size of the fake card's volume (default 32)\n"
+            "  -o DIR        host directory for the fake card (default sim_sd)\n"
+            "  -z            also fail on I2S DMA overflows\n"
+            "  -v            verbose firmware logs\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    static inmp441_recorder_t rec = INMP441_RECORDER_DEFAULTS;
+    double seconds = 20;
+    rec_format_t format = REC_FORMAT_PCM16;
+    rec_profile_t profile = REC_PROFILE_48K;
+    bool agc = false, vad = false, strict = false;
+    uint32_t seg_mb = 0, seg_min = 0, prealloc = 0, checkpoint = CHECKPOINT_INTERVAL_MS, preroll_ms = 0;
+    sim_sd_config_t sd = { .root = "sim_sd", .write_kbps = 4000, .op_latency_us = 300, .seed = 1 };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:x:f:p:agS:M:P:c:R:w:l:s:r:k:o:zvh")) != -1) {
+        switch (opt) {
+        case 't': seconds = atof(optarg); break;
+        case 'x': sim_time_scale = atof(optarg); break;
+        case 'f': format = !strcmp(optarg, "adpcm") ? REC_FORMAT_IMA_ADPCM :
+                           !strcmp(optarg, "lossless") ? REC_FORMAT_LOSSLESS : REC_FORMAT_PCM16; break;
+        case 'p': profile = atoi(optarg) == 16 ? REC_PROFILE_16K :
+                            atoi(optarg) == 8 ? REC_PROFILE_8K : REC_PROFILE_48K; break;
+        case 'a': agc = true; break;
+        case 'g': vad = true; break;
+        case 'S': seg_mb = atoi(optarg); break;
+        case 'M': seg_min = atoi(optarg); break;
+        case 'P': prealloc = atoi(optarg); break;
+        case 'c': checkpoint = atoi(optarg); break;
+        case 'R': preroll_ms = atoi(optarg); break;
+        case 'w': sd.write_kbps = atoi(optarg); break;
+        case 'l': sd.op_latency_us = atoi(optarg); break;
+        case 's': sd.spike_us = atoi(optarg) * 1000; break;
+        case 'r': sd.spike_permille = atoi(optarg); break;
+        case 'k': sd.cluster_bytes = atoi(optarg) * 1024; break;
+        case 'o': sd.root = optarg; break;
+        case 'z': strict = true; break;
+        case 'v': sim_log_level = 2; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (sim_time_scale <= 0 || seconds <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *name = "sim.wav";
+    bool segmented = seg_mb || seg_min;
+    bool check = format == REC_FORMAT_PCM16 && profile == REC_PROFILE_48K && !agc && !vad;
+
+    s_ctx.ramp = check;
+    s_ctx.rate = SAMPLE_RATE_HZ;
+    sim_sd_init(&sd);
+    sim_sd_set_write_hook(write_hook, &s_ctx);
+    sim_i2s_set_source(source, &s_ctx);
+
+    if (inmp441_init(&rec) != ESP_OK) return 1;
+    inmp441_set_format(&rec, format);
+    inmp441_set_agc(&rec, agc);
+    inmp441_set_vad(&rec, vad, 0);
+    inmp441_set_segment(&rec, seg_min, seg_mb);
+    inmp441_set_prealloc(&rec, prealloc);
+    inmp441_set_checkpoint(&rec, checkpoint);
+
+    // 预录：先让采集任务空转一段时间（环形缓冲区写满后开始丢旧数据），再开始录音
+    if (preroll_ms) {
+        if (inmp441_preroll_enable(&rec, preroll_ms) != ESP_OK) return 1;
+        sim_sleep_us((int64_t)preroll_ms * 2000);
+    }
+
+    double cpu0 = sim_process_cpu_us();
+    int64_t t0 = sim_now_us();
+
+    if (inmp441_start_record(&rec, name, profile) != ESP_OK) return 1;
+    sim_sleep_us((int64_t)(seconds * 1e6));
+    int64_t t_stop = sim_now_us();
+    inmp441_stop_record(&rec);
+    int64_t t_end = sim_now_us();
+
+    double cpu = sim_process_cpu_us() - cpu0;
+    double wall_real = (t_end - t0) / sim_time_scale;
+
+    inmp441_rec_stats_t st;
+    inmp441_get_stats(&rec, &st);
+    sim_i2s_stats_t i2s;
+    sim_i2s_get_stats(&i2s);
+    sim_sd_stats_t sds;
+    sim_sd_get_stats(&sds);
+
+    verify_t v = {0};
+    verify_recording(name, segmented, &v, check);
+
+    printf("recorder: %.1f s, format %d, profile %d, agc %d, vad %d, segments %lu (late %lu, max switch %lu us)\n",
+           seconds, format, profile, agc, vad, (unsigned long)(segmented ? st.segments : 1),
+           (unsigned long)st.segment_late_opens, (unsigned long)st.segment_switch_max_us);
+    printf("i2s     : %llu frames delivered, %llu dropped in %lu DMA overflows\n",
+           (unsigned long long)i2s.rx_frames, (unsigned long long)i2s.rx_dropped, (unsigned long)i2s.rx_overflows);
+    printf("ring    : overruns %lu (%lu bytes), high water %lu / %lu\n",
+           (unsigned long)st.overruns, (unsigned long)st.dropped_bytes,
+           (unsigned long)st.high_water, (unsigned long)rec.ring.size);
+    printf("sd      : %llu writes, %llu KB, %lu syncs, %lu spikes, max op %lu us, max write call %lu us\n",
+           (unsigned long long)sds.writes, (unsigned long long)(sds.write_bytes / 1024),
+           (unsigned long)sds.syncs, (unsigned long)sds.spikes, (unsigned long)sds.max_op_us,
+           (unsigned long)st.write_max_us);
+    // 直写缓冲区按卷的簇大小分配：整块写入不能跨簇
+    printf("align   : %lu writes crossed a cluster boundary (cluster %lu KB, write buffer %lu KB)\n",
+           (unsigned long)sds.cross_cluster, (unsigned long)(sd.cluster_bytes ? sd.cluster_bytes : 32 * 1024) / 1024,
+           (unsigned long)rec.file.chunk / 1024);
+    if (s_ctx.lat_count) {
+        printf("latency : capture->card avg %llu us, max %lu us (%lu writes)\n",
+               (unsigned long long)(s_ctx.lat_sum_us / s_ctx.lat_count),
+               (unsigned long)s_ctx.lat_max_us, (unsigned long)s_ctx.lat_count);
+    }
+    bool preroll_ok = true;
+    if (preroll_ms) {
+        // 预录已经写满：提交的长度最多差一个 DMA 块
+        uint32_t want = (uint32_t)((uint64_t)preroll_ms * SAMPLE_RATE_HZ / 1000) * sizeof(int16_t);
+        preroll_ok = st.preroll_committed + BUFFER_SIZE / 2 >= want;
+        printf("preroll : %lu of %lu bytes committed at start%s\n", (unsigned long)st.preroll_committed,
+               (unsigned long)want, check ? ", join checked by the counter below" : "");
+    }
+    printf("stop    : %lld us\n", (long long)(t_end - t_stop));
+    printf("cpu     : %.0f ms for %.0f ms real (%.1f%%), capture busy %llu us over %lu blocks\n",
+           cpu / 1000, wall_real / 1000, wall_real > 0 ? cpu * 100 / wall_real : 0.0,
+           (unsigned long long)st.capture_busy_us, (unsigned long)st.capture_blocks);
+    printf("files   : %lu, %llu samples, bad headers %lu",
+           (unsigned long)v.files, (unsigned long long)v.samples, (unsigned long)v.bad_headers);
+    bool lost = false;
+    if (check) {
+        lost = v.missing != i2s.rx_dropped;
+        printf(", discontinuities %lu (%llu samples missing, %llu not explained by DMA overflow)\n",
+               (unsigned long)v.jumps, (unsigned long long)v.missing,
+               (unsigned long long)(v.missing > i2s.rx_dropped ? v.missing - i2s.rx_dropped : 0));
+    } else {
+        printf(" (continuity not checked for this configuration)\n");
+    }
+
+    bool ok = v.bad_headers == 0 && !lost && preroll_ok && st.overruns == 0 && sds.cross_cluster == 0 &&
+              (!strict || i2s.rx_dropped == 0);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,593 @@
+//--------------------------------------------------------
+// 主机仿真：FreeRTOS / esp_timer / heap_caps（pthread 实现）
+//--------------------------------------------------------
+#define _GNU_SOURCE
+#include "sim.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+double sim_time_scale = 1.0;
+int sim_log_level = 1;
+
+//------------------------------ 时间 ------------------------------
+static struct timespec s_t0;
+static pthread_once_t s_time_once = PTHREAD_ONCE_INIT;
+
+static void time_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &s_t0);
+}
+
+static int64_t real_us(void)
+{
+    pthread_once(&s_time_once, time_init);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)(ts.tv_sec - s_t0.tv_sec) * 1000000 + (ts.tv_nsec - s_t0.tv_nsec) / 1000;
+}
+
+int64_t sim_now_us(void)
+{
+    return (int64_t)(real_us() * sim_time_scale);
+}
+
+// 虚拟时间 → 实际时间的绝对时刻（用于 pthread_cond_timedwait）
+static struct timespec deadline_after(TickType_t ticks)
+{
+    pthread_once(&s_time_once, time_init);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t ns = (int64_t)((double)ticks * 1000000.0 / sim_time_scale);
+    ts.tv_sec += ns / 1000000000;
+    ts.tv_nsec += ns % 1000000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+void sim_sleep_us(int64_t us)
+{
+    if (us <= 0) return;
+    int64_t ns = (int64_t)(us * 1000.0 / sim_time_scale);
+    struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void sim_sleep_until_us(int64_t t_us)
+{
+    sim_sleep_us(t_us - sim_now_us());
+}
+
+double sim_process_cpu_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_now_us();
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 240000000ull + (uint64_t)ts.tv_nsec * 240 / 1000);
+}
+
+//------------------------------ 错误 ------------------------------
+const char *esp_err_to_name(esp_err_t err)
+{
+    switch (err) {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_FAIL:              return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+    default:                    return "ESP_ERR_UNKNOWN";
+    }
+}
+
+void sim_abort_on_error(esp_err_t err, const char *expr, const char *file, int line)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: %s (%s) at %s:%d\n", esp_err_to_name(err), expr, file, line);
+    abort();
+}
+
+void sim_assert_failed(const char *expr, const char *file, int line)
+{
+    fprintf(stderr, "assert failed: %s at %s:%d\n", expr, file, line);
+    abort();
+}
+
+//------------------------------ 内存 ------------------------------
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = NULL;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) == 0 ? p : NULL;
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 8 * 1024 * 1024;
+}
+
+//------------------------------ 临界区 ----------------------------
+static pthread_mutex_t s_critical = PTHREAD_MUTEX_INITIALIZER;
+
+void sim_critical_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void sim_critical_exit(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+//------------------------------ 任务 ------------------------------
+static pthread_condattr_t s_cond_attr;
+static pthread_once_t s_cond_once = PTHREAD_ONCE_INIT;
+
+static void cond_attr_init(void)
+{
+    pthread_condattr_init(&s_cond_attr);
+    pthread_condattr_setclock(&s_cond_attr, CLOCK_MONOTONIC);
+}
+
+static void init_cond(pthread_cond_t *c)
+{
+    pthread_once(&s_cond_once, cond_attr_init);
+    pthread_cond_init(c, &s_cond_attr);
+}
+
+struct sim_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    bool notified;
+    char name[16];
+};
+
+static __thread struct sim_task *s_current;
+
+static void *task_entry(void *p)
+{
+    struct sim_task *t = p;
+    s_current = t;
+    t->fn(t->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core)
+{
+    (void)stack;
+    (void)prio;
+    (void)core;
+    struct sim_task *t = calloc(1, sizeof(*t));
+    if (!t) return pdFAIL;
+    t->fn = fn;
+    t->arg = arg;
+    pthread_mutex_init(&t->lock, NULL);
+    init_cond(&t->cond);
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "task");
+    if (out) *out = t;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&t->thread, &attr, task_entry, t);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        if (out) *out = NULL;
+        free(t);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *out)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, out, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // 只支持任务删除自己（固件里的用法都是 vTaskDelete(NULL)）
+    if (task == NULL || task == s_current) {
+        pthread_exit(NULL);
+    }
+    fprintf(stderr, "sim: deleting another task is not supported\n");
+    abort();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_sleep_us((int64_t)ticks * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now_us() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    // 主线程（相当于 app_main 所在的任务）第一次用到任务句柄时补建一个
+    if (!s_current) {
+        struct sim_task *t = calloc(1, sizeof(*t));
+        if (!t) abort();
+        t->thread = pthread_self();
+        pthread_mutex_init(&t->lock, NULL);
+        init_cond(&t->cond);
+        snprintf(t->name, sizeof(t->name), "main");
+        s_current = t;
+    }
+    return s_current;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    if (!task) return pdFAIL;
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+    case eSetBits:                  task->notify |= value; break;
+    case eIncrement:                task->notify++; break;
+    case eSetValueWithOverwrite:
+    case eSetValueWithoutOverwrite: task->notify = value; break;
+    default: break;
+    }
+    task->notified = true;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken) *woken = pdFALSE;
+}
+
+static bool wait_cond(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *dl)
+{
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, dl) != ETIMEDOUT;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct sim_task *t = xTaskGetCurrentTaskHandle();
+    struct timespec dl = deadline_after(ticks);
+    pthread_mutex_lock(&t->lock);
+    while (t->notify == 0) {
+        if (ticks == 0 || !wait_cond(&t->cond, &t->lock, ticks, &dl)) break;
+    }
+    uint32_t v = t->notify;
+    if (v) {
+        t->notify = clear ? 0 : v - 1;
+    }
+    t->notified = false;
+    pthread_mutex_unlock(&t->lock);
+    return v;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks)
+{
+    struct sim_task *t = xTaskGetCurrentTaskHandle();
+    struct timespec dl = deadline_after(ticks);
+    pthread_mutex_lock(&t->lock);
+    if (!t->notified) {
+        t->notify &= ~clear_on_entry;
+    }
+    while (!t->notified) {
+        if (ticks == 0 || !wait_cond(&t->cond, &t->lock, ticks, &dl)) break;
+    }
+    BaseType_t got = t->notified ? pdTRUE : pdFALSE;
+    if (value) *value = t->notify;
+    if (got) {
+        t->notify &= ~clear_on_exit;
+        t->notified = false;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return got;
+}
+
+//------------------------------ 事件组 ----------------------------
+struct sim_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct sim_event_group *g = calloc(1, sizeof(*g));
+    if (!g) return NULL;
+    pthread_mutex_init(&g->lock, NULL);
+    init_cond(&g->cond);
+    return g;
+}
+
+void vEventGroupDelete(EventGroupHandle_t g)
+{
+    free(g);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits)
+{
+    pthread_mutex_lock(&g->lock);
+    g->bits |= bits;
+    EventBits_t v = g->bits;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->lock);
+    return v;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits)
+{
+    pthread_mutex_lock(&g->lock);
+    EventBits_t v = g->bits;
+    g->bits &= ~bits;
+    pthread_mutex_unlock(&g->lock);
+    return v;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t g)
+{
+    pthread_mutex_lock(&g->lock);
+    EventBits_t v = g->bits;
+    pthread_mutex_unlock(&g->lock);
+    return v;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_all, TickType_t ticks)
+{
+    struct timespec dl = deadline_after(ticks);
+    pthread_mutex_lock(&g->lock);
+    while (true) {
+        bool ok = wait_all ? (g->bits & bits) == bits : (g->bits & bits) != 0;
+        if (ok) {
+            EventBits_t v = g->bits;
+            if (clear_on_exit) g->bits &= ~bits;
+            pthread_mutex_unlock(&g->lock);
+            return v;
+        }
+        if (ticks == 0 || !wait_cond(&g->cond, &g->lock, ticks, &dl)) break;
+    }
+    EventBits_t v = g->bits;
+    pthread_mutex_unlock(&g->lock);
+    return v;
+}
+
+//------------------------------ 队列 / 信号量 ---------------------
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *items;
+    UBaseType_t len, size;
+    UBaseType_t head, count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->items = calloc(length, item_size ? item_size : 1);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    q->len = length;
+    q->size = item_size;
+    pthread_mutex_init(&q->lock, NULL);
+    init_cond(&q->cond);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q) return;
+    free(q->items);
+    free(q);
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front, bool overwrite)
+{
+    struct timespec dl = deadline_after(ticks);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->len && !overwrite) {
+        if (ticks == 0 || !wait_cond(&q->cond, &q->lock, ticks, &dl)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFAIL;
+        }
+    }
+    if (overwrite && q->count == q->len) {
+        q->count = 0;
+    }
+    UBaseType_t slot;
+    if (front) {
+        q->head = (q->head + q->len - 1) % q->len;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->len;
+    }
+    if (q->size && item) memcpy(q->items + slot * q->size, item, q->size);
+    q->count++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    return queue_send(q, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    return queue_send(q, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    return queue_send(q, item, ticks, true, false);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (woken) *woken = pdFALSE;
+    return queue_send(q, item, 0, false, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item)
+{
+    return queue_send(q, item, 0, false, true);
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *item, TickType_t ticks, bool peek)
+{
+    struct timespec dl = deadline_after(ticks);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        if (ticks == 0 || !wait_cond(&q->cond, &q->lock, ticks, &dl)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFAIL;
+        }
+    }
+    if (q->size && item) memcpy(item, q->items + q->head * q->size, q->size);
+    if (!peek) {
+        q->head = (q->head + 1) % q->len;
+        q->count--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    return queue_receive(q, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    return queue_receive(q, item, ticks, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->head = 0;
+    q->count = 0;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+// 信号量 = 元素大小为 0 的队列
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    QueueHandle_t q = xQueueCreate(max, 0);
+    if (q) q->count = initial;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return queue_receive(sem, NULL, ticks, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return queue_send(sem, NULL, 0, false, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    vQueueDelete(sem);
+}
@@ -0,0 +1,331 @@
+//--------------------------------------------------------
+// 主机仿真：SD 卡（FatFs 直接 API + /sdcard 下的 stdio）
+//
+// 文件落在 cfg.root 目录；每次写入 / 读取 / 同步按带宽和固定延迟阻塞调用者，
+// 读写还会按概率出现长延迟尖峰，模拟卡内部擦除、垃圾回收和重试
+//--------------------------------------------------------
+#define _GNU_SOURCE
+#include "sim.h"
+#include "ff.h"
+#include "diskio_sdmmc.h"
+#include "sdcard.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIM_MAX_FILES 64
+
+sdmmc_card_t *card;
+static sdmmc_card_t s_card;
+
+static sim_sd_config_t s_cfg = { .root = "sim_sd" };
+static sim_sd_stats_t s_stats;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static sim_sd_write_hook_t s_hook;
+static void *s_hook_ctx;
+static unsigned s_rand;
+
+// fd / FILE* → 路径（写入回调用）
+static struct {
+    int fd;
+    FILE *fp;
+    char path[160];
+} s_files[SIM_MAX_FILES];
+
+static FATFS s_fs;
+
+static uint32_t cluster_bytes(void)
+{
+    return (uint32_t)s_fs.csize * FF_MAX_SS;
+}
+
+void sim_sd_init(const sim_sd_config_t *cfg)
+{
+    if (cfg) s_cfg = *cfg;
+    s_fs.csize = (uint16_t)((s_cfg.cluster_bytes ? s_cfg.cluster_bytes : 32 * 1024) / FF_MAX_SS);
+    pthread_mutex_lock(&s_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    pthread_mutex_unlock(&s_lock);
+    s_rand = s_cfg.seed ? s_cfg.seed : 1;
+    card = &s_card;
+    if (mkdir(s_cfg.root, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "sim: cannot create %s\n", s_cfg.root);
+    }
+}
+
+void sim_sd_set_write_hook(sim_sd_write_hook_t hook, void *ctx)
+{
+    s_hook = hook;
+    s_hook_ctx = ctx;
+}
+
+void sim_sd_get_stats(sim_sd_stats_t *out)
+{
+    pthread_mutex_lock(&s_lock);
+    *out = s_stats;
+    pthread_mutex_unlock(&s_lock);
+}
+
+BYTE ff_diskio_get_pdrv_card(const sdmmc_card_t *c)
+{
+    (void)c;
+    return 0;
+}
+
+const char *sim_sd_host_path(const char *vfs_path, char *out, size_t len)
+{
+    size_t mp = strlen(SD_MOUNT_POINT);
+    if (strncmp(vfs_path, SD_MOUNT_POINT, mp) == 0) {
+        snprintf(out, len, "%s%s", s_cfg.root, vfs_path + mp);
+    } else if (vfs_path[0] && vfs_path[1] == ':') {
+        snprintf(out, len, "%s%s", s_cfg.root, vfs_path + 2);   // "0:/x"
+    } else {
+        snprintf(out, len, "%s", vfs_path);
+    }
+    return out;
+}
+
+//--------------------------------------------------------
+// 延迟注入
+//--------------------------------------------------------
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return (s_rand >> 16) & 0x7FFF;
+}
+
+static void io_delay(uint64_t bytes, uint32_t kbps, bool is_write, bool is_sync)
+{
+    int64_t us = s_cfg.op_latency_us;
+    if (kbps) us += (int64_t)(bytes * 1000000 / ((uint64_t)kbps * 1024));
+
+    pthread_mutex_lock(&s_lock);
+    bool spike = !is_sync && s_cfg.spike_permille && next_rand() % 1000 < s_cfg.spike_permille;
+    if (spike) {
+        us += s_cfg.spike_us;
+        s_stats.spikes++;
+    }
+    if (is_sync) {
+        s_stats.syncs++;
+    } else if (is_write) {
+        s_stats.writes++;
+        s_stats.write_bytes += bytes;
+    } else {
+        s_stats.reads++;
+        s_stats.read_bytes += bytes;
+    }
+    if (us > s_stats.max_op_us) s_stats.max_op_us = (uint32_t)us;
+    pthread_mutex_unlock(&s_lock);
+
+    sim_sleep_us(us);
+}
+
+static void track(int fd, FILE *fp, const char *path)
+{
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < SIM_MAX_FILES; i++) {
+        if (!s_files[i].path[0]) {
+            s_files[i].fd = fd;
+            s_files[i].fp = fp;
+            snprintf(s_files[i].path, sizeof(s_files[i].path), "%s", path);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void untrack(int fd, FILE *fp)
+{
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < SIM_MAX_FILES; i++) {
+        if (s_files[i].path[0] && (fp ? s_files[i].fp == fp : s_files[i].fd == fd && !s_files[i].fp)) {
+            s_files[i].path[0] = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void call_hook(int fd, FILE *fp, uint32_t offset, const void *data, uint32_t len)
+{
+    if (!s_hook) return;
+    const char *path = NULL;
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < SIM_MAX_FILES; i++) {
+        if (s_files[i].path[0] && (fp ? s_files[i].fp == fp : s_files[i].fd == fd && !s_files[i].fp)) {
+            path = s_files[i].path;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    if (path) s_hook(path, offset, data, len, s_hook_ctx);
+}
+
+//--------------------------------------------------------
+// FatFs
+//--------------------------------------------------------
+FRESULT f_open(FIL *fp, const char *path, BYTE mode)
+{
+    char host[256];
+    sim_sd_host_path(path, host, sizeof(host));
+
+    int flags = (mode & FA_WRITE) ? ((mode & FA_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+    if (mode & FA_CREATE_ALWAYS) flags |= O_CREAT | O_TRUNC;
+    if (mode & (FA_OPEN_ALWAYS | FA_CREATE_NEW)) flags |= O_CREAT;
+    if (mode & FA_CREATE_NEW) flags |= O_EXCL;
+
+    fp->obj.fs = &s_fs;
+    fp->fd = open(host, flags, 0644);
+    if (fp->fd < 0) return FR_NO_FILE;
+    fp->fptr = 0;
+    fp->objsize = (FSIZE_t)lseek(fp->fd, 0, SEEK_END);
+    track(fp->fd, NULL, host);
+    io_delay(0, 0, false, true);
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+    untrack(fp->fd, NULL);
+    int rc = close(fp->fd);
+    fp->fd = -1;
+    return rc == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+    ssize_t n = pread(fp->fd, buff, btr, fp->fptr);
+    if (n < 0) return FR_DISK_ERR;
+    io_delay((uint64_t)n, s_cfg.read_kbps, false, false);
+    fp->fptr += (FSIZE_t)n;
+    *br = (UINT)n;
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+    ssize_t n = pwrite(fp->fd, buff, btw, fp->fptr);
+    if (n < 0) return FR_DISK_ERR;
+    if (n > 0 && fp->fptr / cluster_bytes() != (fp->fptr + n - 1) / cluster_bytes()) {
+        pthread_mutex_lock(&s_lock);
+        s_stats.cross_cluster++;
+        pthread_mutex_unlock(&s_lock);
+    }
+    call_hook(fp->fd, NULL, fp->fptr, buff, (uint32_t)n);
+    io_delay((uint64_t)n, s_cfg.write_kbps, true, false);
+    fp->fptr += (FSIZE_t)n;
+    if (fp->fptr > fp->objsize) fp->objsize = fp->fptr;
+    *bw = (UINT)n;
+    return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+    // 与 FatFs 一样：写模式下 seek 到文件末尾之后会扩展文件
+    if (ofs > fp->objsize) {
+        if (ftruncate(fp->fd, ofs) != 0) return FR_DISK_ERR;
+        fp->objsize = ofs;
+    }
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+FRESULT f_truncate(FIL *fp)
+{
+    if (ftruncate(fp->fd, fp->fptr) != 0) return FR_DISK_ERR;
+    fp->objsize = fp->fptr;
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp)
+{
+    (void)fp;
+    io_delay(0, 0, false, true);
+    return FR_OK;
+}
+
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt)
+{
+    (void)opt;
+    if (fp->objsize != 0) return FR_DENIED;
+    if (ftruncate(fp->fd, fsz) != 0) return FR_DISK_ERR;
+    fp->objsize = fsz;
+    return FR_OK;
+}
+
+FRESULT f_unlink(const char *path)
+{
+    char host[256];
+    return unlink(sim_sd_host_path(path, host, sizeof(host))) == 0 ? FR_OK : FR_NO_FILE;
+}
+
+//--------------------------------------------------------
+// stdio
+//--------------------------------------------------------
+#undef fopen
+#undef fread
+#undef fwrite
+#undef fclose
+#undef remove
+#undef opendir
+#undef stat
+
+FILE *sim_fopen(const char *path, const char *mode)
+{
+    char host[256];
+    sim_sd_host_path(path, host, sizeof(host));
+    FILE *fp = fopen(host, mode);
+    if (fp) {
+        track(-1, fp, host);
+        io_delay(0, 0, false, true);
+    }
+    return fp;
+}
+
+size_t sim_fread(void *ptr, size_t size, size_t n, FILE *fp)
+{
+    size_t got = fread(ptr, size, n, fp);
+    io_delay((uint64_t)got * size, s_cfg.read_kbps, false, false);
+    return got;
+}
+
+size_t sim_fwrite(const void *ptr, size_t size, size_t n, FILE *fp)
+{
+    long off = ftell(fp);
+    size_t put = fwrite(ptr, size, n, fp);
+    call_hook(-1, fp, (uint32_t)off, ptr, (uint32_t)(put * size));
+    io_delay((uint64_t)put * size, s_cfg.write_kbps, true, false);
+    return put;
+}
+
+int sim_fclose(FILE *fp)
+{
+    untrack(-1, fp);
+    return fclose(fp);
+}
+
+int sim_remove(const char *path)
+{
+    char host[256];
+    return remove(sim_sd_host_path(path, host, sizeof(host)));
+}
+
+DIR *sim_opendir(const char *path)
+{
+    char host[256];
+    DIR *dir = opendir(sim_sd_host_path(path, host, sizeof(host)));
+    if (dir) io_delay(0, 0, false, true);
+    return dir;
+}
+
+int sim_stat(const char *path, struct stat *st)
+{
+    char host[256];
+    int rc = stat(sim_sd_host_path(path, host, sizeof(host)), st);
+    if (rc == 0) io_delay(0, 0, false, true);
+    return rc;
+}
@@ -0,0 +1,261 @@
+//--------------------------------------------------------
+// IMA-ADPCM 编码 → 解码往返测试（主机）
+//
+// 校验：
+//   - 每块样点数：单声道 / 立体声公式，块太小返回 0
+//   - SNR：1 kHz -6 dBFS 正弦、多音 + 噪声（类语音）、低电平正弦，按录音块大小连续编码，
+//     解码后与原始信号比较，不低于各自的下限
+//   - 块衔接：块头的预测值 = 该块第一个原始样点，步长索引 = 上一块结束时编码器的索引，
+//     编码器结束时的预测值 = 解码出的最后一个样点
+//   - 短块（文件末尾 len < block_align）：返回 1 + 8 × 完整组数，解码结果是完整块的前缀，
+//     不完整的组忽略，不写出返回值之外的样点
+//   - 立体声：两个单声道块按 4 字节交错拼成一个立体声块，解码后左右声道分别与单声道解码一致
+// 耗时：编码 / 解码每样点 ns
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "ima_adpcm.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_ALIGN     1024        // 与 recorder.h 的 ADPCM_BLOCK_ALIGN 一致
+#define RATE            48000
+#define SIGNAL_SECONDS  4
+#define MAX_SPB         2048
+#define GUARD           16
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf(__VA_ARGS__); printf("\n"); return false; } } while (0)
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int16_t clip16(double v)
+{
+    long r = lrint(v);
+    return (int16_t)(r > 32767 ? 32767 : r < -32768 ? -32768 : r);
+}
+
+//--------------------------------------------------------
+// 测试信号
+//--------------------------------------------------------
+typedef enum { SIG_SINE, SIG_SPEECH, SIG_QUIET } signal_t;
+
+static void make_signal(signal_t sig, int16_t *x, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / RATE;
+        double v;
+        switch (sig) {
+        case SIG_SINE:
+            v = 16384 * sin(2 * M_PI * 1000 * t);
+            break;
+        case SIG_SPEECH: {
+            // 200 Hz 基音 + 共振峰附近的谐波，4 Hz 音节包络，再加白噪声
+            double env = 0.55 + 0.45 * sin(2 * M_PI * 4 * t);
+            v = env * (6000 * sin(2 * M_PI * 200 * t) + 4000 * sin(2 * M_PI * 600 * t) +
+                       2500 * sin(2 * M_PI * 1400 * t) + 1200 * sin(2 * M_PI * 2600 * t));
+            v += ((int32_t)(next_rand() >> 16) - 32768) / 40.0;
+            break;
+        }
+        default:
+            v = 300 * sin(2 * M_PI * 440 * t);
+            break;
+        }
+        x[i] = clip16(v);
+    }
+}
+
+//--------------------------------------------------------
+// 单声道连续编码 + 解码，检查块衔接，返回 SNR（dB）
+//--------------------------------------------------------
+static bool round_trip(const int16_t *x, size_t n, double *snr_db)
+{
+    uint32_t spb = ima_adpcm_samples_per_block(BLOCK_ALIGN, 1);
+    static uint8_t block[BLOCK_ALIGN];
+    static int16_t dec[MAX_SPB + GUARD];
+    ima_adpcm_state_t st = { 0, 0 };
+    double sig = 0, err = 0;
+
+    for (size_t pos = 0; pos + spb <= n; pos += spb) {
+        uint8_t index_in = st.index;
+        ima_adpcm_encode_block(&st, x + pos, block, BLOCK_ALIGN);
+
+        int16_t h_pred = (int16_t)(block[0] | block[1] << 8);
+        CHECK(h_pred == x[pos] && block[2] == index_in && block[3] == 0,
+              "block %zu: header %d/%u, expected %d/%u", pos / spb, h_pred, block[2], x[pos], index_in);
+
+        uint32_t got = ima_adpcm_decode_block(block, BLOCK_ALIGN, 1, dec);
+        CHECK(got == spb, "block %zu: decoded %u samples, expected %u", pos / spb, got, spb);
+        CHECK(dec[0] == x[pos], "block %zu: first sample %d, expected %d", pos / spb, dec[0], x[pos]);
+        CHECK(st.predictor == dec[spb - 1], "block %zu: encoder ends at %d, decoder at %d",
+              pos / spb, st.predictor, dec[spb - 1]);
+
+        for (uint32_t i = 0; i < spb; i++) {
+            double d = (double)x[pos + i] - dec[i];
+            sig += (double)x[pos + i] * x[pos + i];
+            err += d * d;
+        }
+    }
+    *snr_db = 10 * log10(sig / (err > 0 ? err : 1e-9));
+    return true;
+}
+
+static bool check_samples_per_block(void)
+{
+    CHECK(ima_adpcm_samples_per_block(BLOCK_ALIGN, 1) == 2041, "spb mono %u",
+          ima_adpcm_samples_per_block(BLOCK_ALIGN, 1));
+    CHECK(ima_adpcm_samples_per_block(BLOCK_ALIGN, 2) == 1017, "spb stereo %u",
+          ima_adpcm_samples_per_block(BLOCK_ALIGN, 2));
+    CHECK(ima_adpcm_samples_per_block(256, 1) == 505, "spb 256 mono");
+    CHECK(ima_adpcm_samples_per_block(3, 1) == 0 && ima_adpcm_samples_per_block(7, 2) == 0 &&
+          ima_adpcm_samples_per_block(BLOCK_ALIGN, 0) == 0, "spb: undersized block accepted");
+    printf("layout  : %u samples per %d-byte block (mono), %u (stereo)\n",
+           ima_adpcm_samples_per_block(BLOCK_ALIGN, 1), BLOCK_ALIGN, ima_adpcm_samples_per_block(BLOCK_ALIGN, 2));
+    return true;
+}
+
+static bool check_snr(void)
+{
+    static const struct { signal_t sig; const char *name; double min_db; } cases[] = {
+        { SIG_SINE,   "sine 1k -6 dBFS", 30.0 },
+        { SIG_SPEECH, "speech-like",     25.0 },
+        { SIG_QUIET,  "sine 440 -40 dBFS", 20.0 },
+    };
+    size_t n = SIGNAL_SECONDS * RATE;
+    int16_t *x = malloc(n * sizeof(int16_t));
+    bool ok = true;
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]) && ok; c++) {
+        double snr;
+        make_signal(cases[c].sig, x, n);
+        ok = round_trip(x, n, &snr);
+        if (!ok) break;
+        printf("snr     : %-18s %5.1f dB (min %.0f)\n", cases[c].name, snr, cases[c].min_db);
+        if (snr < cases[c].min_db) {
+            printf("snr below bound\n");
+            ok = false;
+        }
+    }
+    free(x);
+    return ok;
+}
+
+//--------------------------------------------------------
+// 短块：文件末尾的不完整块
+//--------------------------------------------------------
+static bool check_short_block(void)
+{
+    uint32_t spb = ima_adpcm_samples_per_block(BLOCK_ALIGN, 1);
+    static int16_t x[MAX_SPB], full[MAX_SPB + GUARD], part[MAX_SPB + GUARD];
+    static uint8_t block[BLOCK_ALIGN];
+    ima_adpcm_state_t st = { 0, 0 };
+
+    make_signal(SIG_SPEECH, x, spb);
+    ima_adpcm_encode_block(&st, x, block, BLOCK_ALIGN);
+    ima_adpcm_decode_block(block, BLOCK_ALIGN, 1, full);
+
+    uint32_t lens = 0;
+    for (uint32_t len = 0; len < BLOCK_ALIGN; len += (len < 64 ? 1 : 61)) {
+        for (int i = 0; i < MAX_SPB + GUARD; i++) part[i] = 0x5A5A;
+        uint32_t got = ima_adpcm_decode_block(block, len, 1, part);
+        uint32_t expect = len < 4 ? 0 : 1 + (len - 4) / 4 * 8;
+        CHECK(got == expect, "short: len %u decoded %u samples, expected %u", len, got, expect);
+        CHECK(memcmp(part, full, got * sizeof(int16_t)) == 0, "short: len %u differs from full block", len);
+        for (uint32_t i = got; i < MAX_SPB + GUARD; i++) {
+            CHECK(part[i] == 0x5A5A, "short: len %u wrote sample %u past %u", len, i, got);
+        }
+        lens++;
+    }
+    printf("short   : %u lengths below %d bytes decode to a prefix of the full block\n", lens, BLOCK_ALIGN);
+    return true;
+}
+
+//--------------------------------------------------------
+// 立体声交错：块头 L、R，之后每 4 字节一组 L、R 交替
+//--------------------------------------------------------
+static bool check_stereo(uint32_t len)
+{
+    uint32_t spb = ima_adpcm_samples_per_block(BLOCK_ALIGN, 2);
+    uint32_t mono_align = (spb - 1) / 2 + 4;     // 同样样点数的单声道块
+    static int16_t l[MAX_SPB], r[MAX_SPB], dl[MAX_SPB], dr[MAX_SPB], dec[2 * MAX_SPB + GUARD];
+    static uint8_t bl[BLOCK_ALIGN], br[BLOCK_ALIGN], bs[BLOCK_ALIGN];
+    ima_adpcm_state_t sl = { 0, 10 }, sr = { 0, 40 };
+
+    make_signal(SIG_SPEECH, l, spb);
+    make_signal(SIG_SINE, r, spb);
+    ima_adpcm_encode_block(&sl, l, bl, mono_align);
+    ima_adpcm_encode_block(&sr, r, br, mono_align);
+    ima_adpcm_decode_block(bl, mono_align, 1, dl);
+    ima_adpcm_decode_block(br, mono_align, 1, dr);
+
+    memcpy(bs, bl, 4);
+    memcpy(bs + 4, br, 4);
+    for (uint32_t g = 0; g < (mono_align - 4) / 4; g++) {
+        memcpy(bs + 8 + g * 8, bl + 4 + g * 4, 4);
+        memcpy(bs + 8 + g * 8 + 4, br + 4 + g * 4, 4);
+    }
+
+    for (int i = 0; i < 2 * MAX_SPB + GUARD; i++) dec[i] = 0x5A5A;
+    uint32_t got = ima_adpcm_decode_block(bs, len, 2, dec);
+    uint32_t expect = 1 + (len - 8) / 8 * 8;
+    CHECK(got == expect, "stereo: len %u decoded %u frames, expected %u", len, got, expect);
+    for (uint32_t i = 0; i < got; i++) {
+        CHECK(dec[2 * i] == dl[i] && dec[2 * i + 1] == dr[i],
+              "stereo: frame %u is %d/%d, mono decode %d/%d", i, dec[2 * i], dec[2 * i + 1], dl[i], dr[i]);
+    }
+    CHECK(dec[2 * got] == 0x5A5A, "stereo: wrote past frame %u", got);
+    printf("stereo  : %u-byte block, %u frames match the per-channel mono decode\n", len, got);
+    return true;
+}
+
+//--------------------------------------------------------
+// 耗时
+//--------------------------------------------------------
+static void bench(void)
+{
+    uint32_t spb = ima_adpcm_samples_per_block(BLOCK_ALIGN, 1);
+    size_t blocks = SIGNAL_SECONDS * RATE / spb;
+    int16_t *x = malloc(blocks * spb * sizeof(int16_t));
+    uint8_t *enc = malloc(blocks * BLOCK_ALIGN);
+    static int16_t dec[MAX_SPB];
+    volatile int16_t sink = 0;
+    ima_adpcm_state_t st = { 0, 0 };
+
+    make_signal(SIG_SPEECH, x, blocks * spb);
+    double t0 = now_ns();
+    for (size_t b = 0; b < blocks; b++) ima_adpcm_encode_block(&st, x + b * spb, enc + b * BLOCK_ALIGN, BLOCK_ALIGN);
+    double t1 = now_ns();
+    for (size_t b = 0; b < blocks; b++) sink += dec[ima_adpcm_decode_block(enc + b * BLOCK_ALIGN, BLOCK_ALIGN, 1, dec) - 1];
+    double t2 = now_ns();
+    (void)sink;
+
+    double samples = (double)blocks * spb;
+    printf("speed   : encode %.2f ns, decode %.2f ns per sample (host); %.0fx real time at 48 kHz\n",
+           (t1 - t0) / samples, (t2 - t1) / samples, samples / RATE * 1e9 / (t1 - t0));
+    free(x);
+    free(enc);
+}
+
+int main(void)
+{
+    bool ok = check_samples_per_block() && check_snr() && check_short_block() &&
+              check_stereo(BLOCK_ALIGN) && check_stereo(8 + 8 * 37 + 5);
+    bench();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+//--------------------------------------------------------
+// 无损块编码 → 解码往返测试（主机）
+//
+// 校验：
+//   - 往返逐位一致：随机、静音、正 / 负满幅常数、±32768 交替、正弦、
+//     各种块长（1 ~ LOSSLESS_BLOCK_SAMPLES，含 ≤ 预测阶数的短块）
+//   - 退回未压缩：随机和 ±32768 交替必须是 verbatim 块（体积 = 原始大小），
+//     任何块都不超过 LOSSLESS_MAX_BLOCK_BYTES；静音 / 正弦必须真正压缩
+//   - 块头：同步字、样点数、阶数、Rice 参数、块体长度的非法值都被拒绝
+//   - 截断：压缩块的块体长度每少 1 字节，lossless_decode_block 都返回 0
+//   - 乱码：全 0 块体返回 0；随机块体只会返回 0 或 num_samples，不写出 num_samples 之外
+//     （块体按实际长度单独分配；越界读在 fuzz_wav 的 ASan 构建里检查）
+// 耗时：各种信号编码 / 解码每块 us（主机）
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "lossless.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N       LOSSLESS_BLOCK_SAMPLES
+#define GUARD   16
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf(__VA_ARGS__); printf("\n"); return false; } } while (0)
+
+static uint32_t s_rand = 12345;
+
+static uint32_t next_rand(void)
+{
+    s_rand = s_rand * 1664525u + 1013904223u;
+    return s_rand;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//--------------------------------------------------------
+// 测试信号
+//--------------------------------------------------------
+typedef enum { SIG_RANDOM, SIG_SILENT, SIG_MAX, SIG_MIN, SIG_ALTERNATE, SIG_SINE, SIG_COUNT } signal_t;
+
+static const char *const s_names[SIG_COUNT] = {
+    "random", "silent", "+full scale", "-full scale", "+-32768 alternate", "sine",
+};
+
+static void make_signal(signal_t sig, int16_t *x, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        switch (sig) {
+        case SIG_RANDOM:    x[i] = (int16_t)(next_rand() >> 16); break;
+        case SIG_SILENT:    x[i] = 0; break;
+        case SIG_MAX:       x[i] = INT16_MAX; break;
+        case SIG_MIN:       x[i] = INT16_MIN; break;
+        case SIG_ALTERNATE: x[i] = (i & 1) ? INT16_MAX : INT16_MIN; break;
+        default:            x[i] = (int16_t)lrint(12000 * sin(2 * M_PI * 440 * i / 48000.0)); break;
+        }
+    }
+}
+
+// 编码后按块头解码（块体按实际长度单独分配，越界写由哨兵发现）
+static bool round_trip(const int16_t *x, uint32_t n, uint8_t *enc, uint32_t *enc_len)
+{
+    static int16_t dec[N + GUARD];
+    lossless_block_info_t info;
+
+    memset(enc, 0xA5, LOSSLESS_MAX_BLOCK_BYTES + GUARD);
+    uint32_t len = lossless_encode_block(x, n, enc);
+    CHECK(len >= LOSSLESS_HEADER_BYTES && len <= LOSSLESS_MAX_BLOCK_BYTES, "encode: %u bytes for %u samples", len, n);
+    CHECK(enc[len] == 0xA5, "encode: wrote past the %u bytes it reported", len);
+    CHECK(lossless_parse_header(enc, &info), "parse: own header rejected (n %u)", n);
+    CHECK(info.num_samples == n && LOSSLESS_HEADER_BYTES + (uint32_t)info.body_bytes == len,
+          "parse: %u samples / %u body bytes, block is %u samples / %u bytes", info.num_samples,
+          info.body_bytes, n, len);
+
+    uint8_t *body = malloc(info.body_bytes ? info.body_bytes : 1);
+    memcpy(body, enc + LOSSLESS_HEADER_BYTES, info.body_bytes);
+    for (int i = 0; i < N + GUARD; i++) dec[i] = 0x5A5A;
+    uint32_t got = lossless_decode_block(&info, body, dec);
+    free(body);
+
+    CHECK(got == n, "decode: %u samples, expected %u", got, n);
+    CHECK(memcmp(dec, x, n * sizeof(int16_t)) == 0, "decode: not bit-exact (n %u, order %u)", n, info.order);
+    CHECK(dec[n] == 0x5A5A, "decode: wrote past sample %u", n);
+    *enc_len = len;
+    return true;
+}
+
+static bool check_round_trip(void)
+{
+    static int16_t x[N];
+    static uint8_t enc[LOSSLESS_MAX_BLOCK_BYTES + GUARD];
+    uint32_t len;
+
+    for (int s = 0; s < SIG_COUNT; s++) {
+        make_signal((signal_t)s, x, N);
+        if (!round_trip(x, N, enc, &len)) return false;
+
+        bool verbatim = enc[4] == LOSSLESS_ORDER_VERBATIM;
+        char order[12];
+        snprintf(order, sizeof(order), verbatim ? "verbatim" : "%u", enc[4]);
+        printf("block   : %-18s %4u bytes (%5.1f%%), order %s, k %u\n", s_names[s], len,
+               100.0 * len / (LOSSLESS_HEADER_BYTES + 2 * N), order, enc[5]);
+        if (s == SIG_RANDOM || s == SIG_ALTERNATE) {
+            CHECK(verbatim && len == LOSSLESS_HEADER_BYTES + 2 * N, "%s: expected a verbatim block", s_names[s]);
+        }
+        if (s == SIG_SILENT || s == SIG_MAX || s == SIG_MIN || s == SIG_SINE) {
+            CHECK(!verbatim && len < LOSSLESS_HEADER_BYTES + N, "%s: not compressed", s_names[s]);
+        }
+    }
+
+    // 各种块长，含短块和奇数长度（录音结束时的最后一块）
+    uint32_t lengths = 0;
+    for (uint32_t n = 1; n <= N; n += (n < 16 ? 1 : 1 + next_rand() % 97)) {
+        for (int s = 0; s < SIG_COUNT; s++) {
+            make_signal((signal_t)s, x, n);
+            if (!round_trip(x, n, enc, &len)) return false;
+            if (n <= 3) CHECK(enc[4] == LOSSLESS_ORDER_VERBATIM, "n %u: short block not verbatim", n);
+            lengths++;
+        }
+    }
+    printf("lengths : %u blocks of 1..%d samples bit-exact\n", lengths, N);
+    return true;
+}
+
+//--------------------------------------------------------
+// 块头合法性
+//--------------------------------------------------------
+static bool check_headers(void)
+{
+    static const struct { uint8_t h[8]; bool ok; const char *what; } cases[] = {
+        { { 0xF5, 0x4C, 0x00, 0x04, 2, 5, 0x00, 0x02 }, true,  "valid" },
+        { { 0xF5, 0x4C, 0x00, 0x04, 0xFF, 0, 0x00, 0x08 }, true,  "valid verbatim" },
+        { { 0xF4, 0x4C, 0x00, 0x04, 2, 5, 0x00, 0x02 }, false, "bad sync" },
+        { { 0xF5, 0x4C, 0x00, 0x00, 2, 5, 0x00, 0x02 }, false, "0 samples" },
+        { { 0xF5, 0x4C, 0x01, 0x04, 2, 5, 0x00, 0x02 }, false, "1025 samples" },
+        { { 0xF5, 0x4C, 0x00, 0x04, 4, 5, 0x00, 0x02 }, false, "order 4" },
+        { { 0xF5, 0x4C, 0x02, 0x00, 2, 5, 0x00, 0x02 }, false, "order >= samples" },
+        { { 0xF5, 0x4C, 0x00, 0x04, 2, 16, 0x00, 0x02 }, false, "rice k 16" },
+        { { 0xF5, 0x4C, 0x00, 0x04, 2, 5, 0x01, 0x08 }, false, "body too long" },
+        { { 0xF5, 0x4C, 0x00, 0x04, 0xFF, 0, 0xFF, 0x07 }, false, "verbatim size mismatch" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        lossless_block_info_t info;
+        CHECK(lossless_parse_header(cases[i].h, &info) == cases[i].ok, "header: %s %s", cases[i].what,
+              cases[i].ok ? "rejected" : "accepted");
+    }
+    printf("headers : %zu valid / invalid headers classified\n", sizeof(cases) / sizeof(cases[0]));
+    return true;
+}
+
+//--------------------------------------------------------
+// 截断 / 乱码块体
+//--------------------------------------------------------
+static uint32_t decode_copy(const lossless_block_info_t *info, const uint8_t *src, int16_t *out)
+{
+    uint8_t *body = malloc(info->body_bytes ? info->body_bytes : 1);
+    memcpy(body, src, info->body_bytes);
+    uint32_t got = lossless_decode_block(info, body, out);
+    free(body);
+    return got;
+}
+
+static bool check_corrupt(void)
+{
+    static int16_t x[N], dec[N + GUARD];
+    static uint8_t enc[LOSSLESS_MAX_BLOCK_BYTES + GUARD], junk[LOSSLESS_MAX_BODY_BYTES];
+    uint32_t len, truncs = 0, junk_ok = 0, junk_zero = 0;
+
+    for (int s = 0; s < SIG_COUNT; s++) {
+        make_signal((signal_t)s, x, N);
+        if (!round_trip(x, N, enc, &len)) return false;
+        if (enc[4] == LOSSLESS_ORDER_VERBATIM) continue;
+
+        // 块体每少一个字节：最后一个字节里至少有 1 位有效码，缺了就必须解不出来
+        lossless_block_info_t info;
+        lossless_parse_header(enc, &info);
+        uint16_t full = info.body_bytes;
+        for (uint32_t cut = 0; cut < full; cut++) {
+            info.body_bytes = (uint16_t)cut;
+            CHECK(decode_copy(&info, enc + LOSSLESS_HEADER_BYTES, dec) == 0,
+                  "truncated: %s body cut to %u of %u bytes still decoded", s_names[s], cut, full);
+            truncs++;
+        }
+    }
+
+    // 全 0：一元码永远不结束
+    lossless_block_info_t zero = { .num_samples = N, .order = 2, .rice_k = 4, .body_bytes = 600 };
+    memset(junk, 0, sizeof(junk));
+    CHECK(decode_copy(&zero, junk, dec) == 0, "garbage: all-zero body decoded");
+
+    // 随机块头字段 + 随机块体
+    for (int round = 0; round < 20000; round++) {
+        lossless_block_info_t info = {
+            .num_samples = (uint16_t)(1 + next_rand() % N),
+            .order = (uint8_t)(next_rand() % 4),
+            .rice_k = (uint8_t)(next_rand() % 16),
+            .body_bytes = (uint16_t)(next_rand() % (LOSSLESS_MAX_BODY_BYTES + 1)),
+        };
+        if (info.order >= info.num_samples) info.order = 0;
+        for (uint32_t i = 0; i < info.body_bytes; i++) junk[i] = (uint8_t)next_rand();
+        for (int i = 0; i < N + GUARD; i++) dec[i] = 0x5A5A;
+
+        uint32_t got = decode_copy(&info, junk, dec);
+        CHECK(got == 0 || got == info.num_samples, "garbage: returned %u of %u samples", got, info.num_samples);
+        CHECK(dec[info.num_samples] == 0x5A5A, "garbage: wrote past sample %u", info.num_samples);
+        if (got) junk_ok++;
+        else junk_zero++;
+    }
+    printf("corrupt : %u truncated bodies rejected; random bodies: %u rejected, %u decoded in bounds\n",
+           truncs, junk_zero, junk_ok);
+    return true;
+}
+
+//--------------------------------------------------------
+// 耗时：编码耗时必须有上界（最坏是压缩到一半才退回未压缩的块）
+//--------------------------------------------------------
+static void bench(void)
+{
+    static int16_t x[N], dec[N];
+    static uint8_t enc[LOSSLESS_MAX_BLOCK_BYTES];
+    volatile uint32_t sink = 0;
+
+    printf("speed   : %-18s %10s %10s   (us per %d-sample block, host)\n", "signal", "encode", "decode", N);
+    for (int s = 0; s < SIG_COUNT; s++) {
+        make_signal((signal_t)s, x, N);
+        lossless_block_info_t info;
+        uint32_t len = lossless_encode_block(x, N, enc);
+        lossless_parse_header(enc, &info);
+
+        double t0 = now_ns();
+        for (int r = 0; r < 2000; r++) sink += lossless_encode_block(x, N, enc);
+        double t1 = now_ns();
+        for (int r = 0; r < 2000; r++) sink += lossless_decode_block(&info, enc + LOSSLESS_HEADER_BYTES, dec);
+        double t2 = now_ns();
+        (void)len;
+        printf("          %-18s %10.2f %10.2f\n", s_names[s], (t1 - t0) / 2000 / 1000, (t2 - t1) / 2000 / 1000);
+    }
+    (void)sink;
+}
+
+int main(void)
+{
+    bool ok = check_round_trip() && check_headers() && check_corrupt();
+    bench();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
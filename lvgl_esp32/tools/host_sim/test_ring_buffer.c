@@ -0,0 +1,205 @@
+//--------------------------------------------------------
+// 录音环形缓冲区（SPSC）单元测试（主机）
+//
+// 单线程：
+//   - 容量不是 2 的幂时初始化失败
+//   - 空：read / peek 返回 0，used = 0，free = size
+//   - 满：正好写满成功，再多 1 字节整块拒绝且不改变内容
+//   - 回绕：写入 / read / peek 跨过存储区末尾，索引跨过 UINT32_MAX
+// 双线程：生产者按随机块长写入递增计数，消费者交替用 read 和 peek / consume
+//         随机块长取出，逐字节校验顺序；满时生产者重试（统计次数），不丢不重
+// 返回值：0 通过，1 失败
+//--------------------------------------------------------
+#include "ring_buffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RB_SIZE         1024
+#define STRESS_BYTES    (64u * 1024 * 1024)
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf(__VA_ARGS__); printf("\n"); return false; } } while (0)
+
+static uint32_t next_rand(uint32_t *s)
+{
+    *s = *s * 1664525u + 1013904223u;
+    return *s >> 8;
+}
+
+//--------------------------------------------------------
+// 单线程
+//--------------------------------------------------------
+static bool check_init(void)
+{
+    static uint8_t mem[RB_SIZE];
+    ring_buffer_t rb;
+    CHECK(!ring_buffer_init(&rb, mem, 0), "init: size 0 accepted");
+    CHECK(!ring_buffer_init(&rb, mem, 1000), "init: size 1000 accepted");
+    CHECK(!ring_buffer_init(&rb, NULL, RB_SIZE), "init: NULL storage accepted");
+    CHECK(ring_buffer_init(&rb, mem, RB_SIZE), "init: size %d rejected", RB_SIZE);
+    printf("init    : non power of two / NULL rejected\n");
+    return true;
+}
+
+static bool check_empty_full(void)
+{
+    static uint8_t mem[RB_SIZE], in[RB_SIZE + 1], out[RB_SIZE + 1];
+    ring_buffer_t rb;
+    const uint8_t *p;
+    ring_buffer_init(&rb, mem, RB_SIZE);
+    for (int i = 0; i <= RB_SIZE; i++) in[i] = (uint8_t)(i * 7 + 3);
+
+    CHECK(ring_buffer_used(&rb) == 0 && ring_buffer_free(&rb) == RB_SIZE, "empty: used/free wrong");
+    CHECK(ring_buffer_read(&rb, out, sizeof(out)) == 0, "empty: read returned data");
+    CHECK(ring_buffer_peek(&rb, &p) == 0, "empty: peek returned data");
+
+    CHECK(!ring_buffer_write(&rb, in, RB_SIZE + 1), "full: oversized write accepted");
+    CHECK(ring_buffer_used(&rb) == 0, "full: rejected write changed used");
+    CHECK(ring_buffer_write(&rb, in, RB_SIZE), "full: exact-size write rejected");
+    CHECK(ring_buffer_used(&rb) == RB_SIZE && ring_buffer_free(&rb) == 0, "full: used/free wrong");
+    CHECK(!ring_buffer_write(&rb, in, 1), "full: write into full ring accepted");
+    CHECK(ring_buffer_peek(&rb, &p) == RB_SIZE && p == mem, "full: peek length wrong");
+    CHECK(ring_buffer_read(&rb, out, sizeof(out)) == RB_SIZE, "full: read length wrong");
+    CHECK(memcmp(in, out, RB_SIZE) == 0, "full: content changed");
+    CHECK(ring_buffer_used(&rb) == 0, "full: not empty after read");
+    CHECK(ring_buffer_write(&rb, in, 0), "empty: zero-length write rejected");
+    printf("empty   : read / peek return 0; full: exact fit accepted, +1 byte rejected\n");
+    return true;
+}
+
+// 从索引 start 开始（可接近 UINT32_MAX），每轮写 w、读 r，跨过存储区末尾和索引回绕
+static bool check_wrap(uint32_t start)
+{
+    static uint8_t mem[RB_SIZE], in[RB_SIZE], out[RB_SIZE];
+    ring_buffer_t rb;
+    ring_buffer_init(&rb, mem, RB_SIZE);
+    rb.head = rb.tail = start;
+
+    uint8_t wv = 0, rv = 0;
+    uint32_t wraps = 0;
+    for (int round = 0; round < 2000; round++) {
+        uint32_t w = 1 + (round * 37) % 700;
+        uint32_t before = rb.head & rb.mask;
+        if (ring_buffer_free(&rb) >= w) {
+            for (uint32_t i = 0; i < w; i++) in[i] = wv++;
+            CHECK(ring_buffer_write(&rb, in, w), "wrap: write %u rejected with %u free", w, ring_buffer_free(&rb));
+            if (before + w > RB_SIZE) wraps++;
+        } else {
+            CHECK(!ring_buffer_write(&rb, in, w), "wrap: write %u accepted with %u free", w, ring_buffer_free(&rb));
+        }
+
+        // 偶数轮用 peek / consume（只取到存储区末尾），奇数轮用 read（跨末尾拷贝）
+        uint32_t used = ring_buffer_used(&rb);
+        uint32_t n;
+        if (round & 1) {
+            n = ring_buffer_read(&rb, out, 1 + (round * 53) % 600);
+        } else {
+            const uint8_t *p;
+            n = ring_buffer_peek(&rb, &p);
+            uint32_t contig = RB_SIZE - (rb.tail & rb.mask);
+            CHECK(n == (used < contig ? used : contig), "wrap: peek %u, used %u contig %u", n, used, contig);
+            if (n > 300) n = 300;
+            memcpy(out, p, n);
+            ring_buffer_consume(&rb, n);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            CHECK(out[i] == rv, "wrap: byte %u of round %d is %u, expected %u", i, round, out[i], rv);
+            rv++;
+        }
+        CHECK(ring_buffer_used(&rb) == used - n, "wrap: used not reduced by %u", n);
+    }
+    CHECK(wraps > 10, "wrap: only %u writes crossed the end", wraps);
+    printf("wrap    : start index 0x%08x, %u writes across the end, order kept\n", start, wraps);
+    return true;
+}
+
+//--------------------------------------------------------
+// 双线程：合成生产者 / 消费者
+//--------------------------------------------------------
+typedef struct {
+    ring_buffer_t rb;
+    uint32_t full_retries;
+    uint32_t empty_polls;
+    volatile uint64_t bad_at;    // 首个错误字节位置 + 1，0 表示无误
+} stress_t;
+
+static void *producer(void *arg)
+{
+    stress_t *s = arg;
+    uint8_t chunk[512];
+    uint32_t seed = 1, sent = 0;
+    while (sent < STRESS_BYTES) {
+        uint32_t n = 1 + next_rand(&seed) % sizeof(chunk);
+        if (n > STRESS_BYTES - sent) n = STRESS_BYTES - sent;
+        for (uint32_t i = 0; i < n; i++) chunk[i] = (uint8_t)((sent + i) * 131 >> 3);
+        while (!ring_buffer_write(&s->rb, chunk, n)) {
+            if (s->bad_at) return NULL;
+            s->full_retries++;
+            sched_yield();
+        }
+        sent += n;
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    stress_t *s = arg;
+    uint8_t chunk[700];
+    uint32_t seed = 2, got = 0;
+    while (got < STRESS_BYTES) {
+        const uint8_t *p = chunk;
+        uint32_t n;
+        if (next_rand(&seed) & 1) {
+            n = ring_buffer_read(&s->rb, chunk, 1 + next_rand(&seed) % sizeof(chunk));
+        } else {
+            n = ring_buffer_peek(&s->rb, &p);
+            uint32_t max = 1 + next_rand(&seed) % sizeof(chunk);
+            if (n > max) n = max;
+        }
+        if (n == 0) {
+            s->empty_polls++;
+            sched_yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (p[i] != (uint8_t)((got + i) * 131 >> 3)) {
+                s->bad_at = (uint64_t)got + i + 1;
+                return NULL;
+            }
+        }
+        if (p != chunk) ring_buffer_consume(&s->rb, n);
+        got += n;
+    }
+    return NULL;
+}
+
+static bool check_threads(void)
+{
+    static uint8_t mem[RB_SIZE];
+    static stress_t s;
+    ring_buffer_init(&s.rb, mem, RB_SIZE);
+
+    pthread_t tp, tc;
+    pthread_create(&tc, NULL, consumer, &s);
+    pthread_create(&tp, NULL, producer, &s);
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+
+    CHECK(s.bad_at == 0, "threads: byte %llu out of order", (unsigned long long)(s.bad_at - 1));
+    CHECK(ring_buffer_used(&s.rb) == 0, "threads: %u bytes left over", ring_buffer_used(&s.rb));
+    printf("threads : %u MB in order, producer hit full %u times, consumer found empty %u times\n",
+           STRESS_BYTES >> 20, s.full_retries, s.empty_polls);
+    return true;
+}
+
+int main(void)
+{
+    bool ok = check_init() && check_empty_full() && check_wrap(0) && check_wrap(0xFFFFF000u) &&
+              check_threads();
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+//--------------------------------------------------------
+// 主机工具：为已有 WAV 生成波形峰值旁路文件（xxx.pk），并对比缩略波形耗时
+//
+// 编译（在 lvgl_esp32 目录下）：
+//   cc -O2 -Imain/recorder -o wav_peaks tools/wav_peaks.c main/recorder/peak_file.c
+// 用法：
+//   ./wav_peaks [-w 宽度] a.wav b.wav ...
+//
+// 只支持 16 bit PCM（多声道取第一声道）；ADPCM / 无损文件由录音机在录音时生成旁路文件。
+// 每个文件打印两种缩略波形的耗时：
+//   scan  —— 扫描整个 WAV 的 data 块（旁路文件出现前 UI 只能这样做）
+//   peaks —— 读取旁路文件中合适的一层，读取量与宽度成正比，与录音长度无关
+//--------------------------------------------------------
+#include "peak_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SCAN_CHUNK_SAMPLES  4096
+#define THUMB_MAX_WIDTH     4096
+
+typedef struct {
+    uint16_t format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t bits;
+    long data_offset;
+    uint32_t data_size;
+} wav_info_t;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t rd_u32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t rd_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+//--------------------------------------------------------
+// 逐块遍历 RIFF，找到 fmt 和 data
+//--------------------------------------------------------
+static int wav_open(FILE *fp, wav_info_t *info)
+{
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        return -1;
+    }
+
+    memset(info, 0, sizeof(*info));
+    bool have_fmt = false;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, fp) == 8) {
+        uint32_t size = rd_u32(ck + 4);
+        long body = ftell(fp);
+        if (!memcmp(ck, "fmt ", 4) && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, 16, fp) != 16) return -1;
+            info->format = rd_u16(fmt);
+            info->channels = rd_u16(fmt + 2);
+            info->sample_rate = rd_u32(fmt + 4);
+            info->bits = rd_u16(fmt + 14);
+            have_fmt = true;
+        } else if (!memcmp(ck, "data", 4)) {
+            if (!have_fmt) return -1;
+            info->data_offset = body;
+            info->data_size = size;
+            return 0;
+        }
+        fseek(fp, body + size + (size & 1), SEEK_SET);
+    }
+    return -1;
+}
+
+//--------------------------------------------------------
+// 从 WAV 生成旁路文件
+//--------------------------------------------------------
+static int build_peaks(FILE *fp, const wav_info_t *info, const char *pk_path)
+{
+    peak_writer_t w;
+    if (!peak_writer_open(&w, pk_path, info->sample_rate)) {
+        fprintf(stderr, "cannot create %s\n", pk_path);
+        return -1;
+    }
+
+    static int16_t in[SCAN_CHUNK_SAMPLES * 8];
+    static int16_t mono[SCAN_CHUNK_SAMPLES];
+    uint32_t frames = info->data_size / (2u * info->channels);
+    fseek(fp, info->data_offset, SEEK_SET);
+
+    while (frames > 0) {
+        uint32_t n = frames < SCAN_CHUNK_SAMPLES ? frames : SCAN_CHUNK_SAMPLES;
+        size_t got = fread(in, 2u * info->channels, n, fp);
+        if (got == 0) break;
+        for (size_t i = 0; i < got; i++) {
+            mono[i] = in[i * info->channels];
+        }
+        peak_writer_feed(&w, mono, got);
+        frames -= got;
+    }
+    return peak_writer_close(&w) ? 0 : -1;
+}
+
+//--------------------------------------------------------
+// 对照：扫描整个 data 块生成同样宽度的缩略波形
+//--------------------------------------------------------
+static size_t scan_thumbnail(FILE *fp, const wav_info_t *info, size_t width, peak_entry_t *out)
+{
+    static int16_t in[SCAN_CHUNK_SAMPLES * 8];
+    uint64_t frames = info->data_size / (2u * info->channels);
+    if (frames == 0) return 0;
+    size_t cols = frames < width ? (size_t)frames : width;
+
+    fseek(fp, info->data_offset, SEEK_SET);
+    uint64_t idx = 0;
+    size_t c = 0;
+    int16_t mn = INT16_MAX, mx = INT16_MIN;
+    uint64_t end = frames / cols;
+
+    while (idx < frames) {
+        size_t got = fread(in, 2u * info->channels, SCAN_CHUNK_SAMPLES, fp);
+        if (got == 0) break;
+        for (size_t i = 0; i < got; i++, idx++) {
+            int16_t s = in[i * info->channels];
+            if (s < mn) mn = s;
+            if (s > mx) mx = s;
+            if (idx + 1 == end) {
+                out[c].min = (int8_t)(mn >> 8);
+                out[c].max = (int8_t)(mx >> 8);
+                mn = INT16_MAX;
+                mx = INT16_MIN;
+                if (++c == cols) return cols;
+                end = (uint64_t)(c + 1) * frames / cols;
+            }
+        }
+    }
+    return c;
+}
+
+static int process(const char *wav_path, size_t width)
+{
+    FILE *fp = fopen(wav_path, "rb");
+    if (!fp) {
+        fprintf(stderr, "cannot open %s\n", wav_path);
+        return -1;
+    }
+
+    wav_info_t info;
+    if (wav_open(fp, &info) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", wav_path);
+        fclose(fp);
+        return -1;
+    }
+    if (info.format != 1 || info.bits != 16 || info.channels == 0 || info.channels > 8) {
+        fprintf(stderr, "%s: only 16-bit PCM is supported (format 0x%04x, %u bit)\n",
+                wav_path, info.format, info.bits);
+        fclose(fp);
+        return -1;
+    }
+
+    char pk_path[1024];
+    peak_file_path(wav_path, pk_path, sizeof(pk_path));
+
+    double t0 = now_us();
+    int ret = build_peaks(fp, &info, pk_path);
+    double t_build = now_us() - t0;
+    if (ret != 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    static peak_entry_t a[THUMB_MAX_WIDTH], b[THUMB_MAX_WIDTH];
+    t0 = now_us();
+    size_t na = scan_thumbnail(fp, &info, width, a);
+    double t_scan = now_us() - t0;
+    fclose(fp);
+
+    t0 = now_us();
+    size_t nb = peak_file_thumbnail(pk_path, width, b);
+    double t_peaks = now_us() - t0;
+
+    // 两种方式的列边界不完全一致，只统计差异较大的列作为粗略校验
+    size_t diff = 0;
+    for (size_t i = 0; i < na && i < nb; i++) {
+        if (abs(a[i].min - b[i].min) > 16 || abs(a[i].max - b[i].max) > 16) diff++;
+    }
+
+    uint32_t frames = info.data_size / (2u * info.channels);
+    printf("%s: %u samples @ %u Hz (%.1f s) -> %s\n", wav_path, frames, info.sample_rate,
+           info.sample_rate ? (double)frames / info.sample_rate : 0.0, pk_path);
+    printf("  build %.0f us | thumbnail %zu px: scan %.0f us, peaks %.0f us (%zu cols differ)\n",
+           t_build, width, t_scan, t_peaks, diff);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t width = 320;
+    int i = 1;
+    if (i + 1 < argc && !strcmp(argv[i], "-w")) {
+        width = (size_t)atoi(argv[i + 1]);
+        if (width == 0 || width > THUMB_MAX_WIDTH) width = 320;
+        i += 2;
+    }
+    if (i >= argc) {
+        fprintf(stderr, "usage: %s [-w width] file.wav ...\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (; i < argc; i++) {
+        if (process(argv[i], width) != 0) failed++;
+    }
+    return failed ? 1 : 0;
+}